@@ -0,0 +1 @@
+#define OO_CP_INTF_VER 92b1fd7df624f451f8c4aae135f425e2
@@ -0,0 +1 @@
+#define EFCH_INTF_VER  "1842aec4857ef779ce28ad4c8297216f"
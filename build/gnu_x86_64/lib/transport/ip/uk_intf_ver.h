@@ -0,0 +1 @@
+#define OO_UK_INTF_VER  "a05717a3e8de6d70d9713f5b59a4e2b3"
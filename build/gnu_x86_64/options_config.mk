@@ -0,0 +1,10 @@
+
+
+
+
+
+
+
+VPATH_ENABLED := 1
+
+
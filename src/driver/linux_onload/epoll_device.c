@@ -554,15 +554,18 @@ static unsigned oo_epoll2_poll(struct oo_epoll_private* priv,
 /*************************************************************
  * EPOLL1-specific code
  *************************************************************/
-static void oo_epoll1_set_shared_flag(struct oo_epoll1_private* priv, int set)
+static void oo_epoll1_set_shared_flag(struct oo_epoll1_private* priv,
+                                      ci_uint32 set)
 {
   ci_uint32 tmp, new;
   do {
     tmp = priv->sh->flag;
-    if( set )
-      new = (tmp + (1 << OO_EPOLL1_FLAG_SEQ_SHIFT)) | OO_EPOLL1_FLAG_EVENT;
+    if( set & OO_EPOLL1_FLAG_EVENT )
+      new = (tmp + (1 << OO_EPOLL1_FLAG_SEQ_SHIFT)) | set;
+    else if( set )
+      new = tmp | set;
     else
-      new = tmp & ~OO_EPOLL1_FLAG_EVENT;
+      new = tmp & ~(OO_EPOLL1_FLAG_EVENT | OO_EPOLL1_FLAG_LT);
   } while( ci_cas32u_fail(&priv->sh->flag, tmp, new) );
 }
 
@@ -572,7 +575,7 @@ static int oo_epoll1_callback(wait_queue_entry_t *wait, unsigned mode,
   struct oo_epoll1_private* priv = container_of(wait,
                                                 struct oo_epoll1_private,
                                                 wait);
-  oo_epoll1_set_shared_flag(priv, 1/*set*/);
+  oo_epoll1_set_shared_flag(priv, OO_EPOLL1_FLAG_EVENT);
   return 0;
 }
 static void oo_epoll1_queue_proc(struct file *file,
@@ -688,7 +691,7 @@ static int oo_epoll1_wait(struct oo_epoll1_private *priv,
   int rc = 0;
 
   /* We are going to handle all EPOLLET and EPOLLONESHOT events -
-   * remove OO_EPOLL1_FLAG_EVENT flag from the shared page. */
+   * remove the flags from the shared page. */
   oo_epoll1_set_shared_flag(priv, 0/*unset*/);
 
   op->rc = efab_linux_sys_epoll_wait(priv->sh->epfd,
@@ -698,10 +701,13 @@ static int oo_epoll1_wait(struct oo_epoll1_private *priv,
     rc = op->rc;
 
   /* We have not handled all events because they are level-triggered or
-   * because maxevents valus is too small. Set the OO_EPOLL1_FLAG_EVENT
-   * flag back. */
+   * because maxevents valus is too small.  Set a flag back.  Events left
+   * behind by maxevents have never been reported, so they count as a state
+   * change; otherwise UL may defer re-checking the level-triggered fds,
+   * see EF_EPOLL_OS_LT_USEC. */
   if( priv->os_file->f_op->poll(priv->os_file, NULL) )
-    oo_epoll1_set_shared_flag(priv, 1/*set*/);
+    oo_epoll1_set_shared_flag(priv, op->rc == op->maxevents ?
+                                    OO_EPOLL1_FLAG_EVENT : OO_EPOLL1_FLAG_LT);
 
   return rc;
 }
@@ -778,6 +784,9 @@ struct oo_epoll_poll_table {
   struct task_struct* task;
   struct file* filp;
   int rc;
+  int exclusive;
+  /* Flags of the home ready list, when waiting exclusively on it */
+  volatile ci_uint32* ready_list_flags;
 };
 
 static void oo_epoll1_block_on_callback(struct file* filp,
@@ -792,7 +801,10 @@ static void oo_epoll1_block_on_callback(struct file* filp,
     i = 1;
 
   ept->w[i] = w;
-  add_wait_queue(w, &ept->wq[i]);
+  if( ept->exclusive )
+    add_wait_queue_exclusive(w, &ept->wq[i]);
+  else
+    add_wait_queue(w, &ept->wq[i]);
 }
 
 static inline int oo_epoll1_wake_home_callback(wait_queue_entry_t* wait,
@@ -800,10 +812,17 @@ static inline int oo_epoll1_wake_home_callback(wait_queue_entry_t* wait,
                                                void* key)
 {
   struct oo_epoll_poll_table* ept;
+  int rc;
 
   ept = container_of(wait, struct oo_epoll_poll_table, wq[0]);
   ept->rc |= OO_EPOLL1_EVENT_ON_HOME;
-  return wake_up_process(ept->task);
+  rc = wake_up_process(ept->task);
+  /* efab_tcp_helper_ready_list_wakeup() clears the wake flag and wakes one
+   * exclusive waiter.  Set the flag again so that the next event wakes
+   * another one while we are busy. */
+  if( rc && ept->ready_list_flags != NULL )
+    ci_atomic32_or(ept->ready_list_flags, CI_NI_READY_LIST_FLAG_WAKE);
+  return rc;
 }
 static inline int oo_epoll1_wake_other_callback(wait_queue_entry_t* wait,
                                                 unsigned mode, int sync,
@@ -816,10 +835,15 @@ static inline int oo_epoll1_wake_other_callback(wait_queue_entry_t* wait,
   return wake_up_process(ept->task);
 }
 
-/* this is essentially sys_poll([home_filp,other_filp], timeout_ms) */
+/* this is essentially sys_poll([home_filp,other_filp], timeout_ms)
+ *
+ * With exclusive=1 we are added to the wait queues as exclusive waiters,
+ * so that each event wakes only one of the threads blocking on this epoll
+ * set with OO_EPOLL1_WAKE_ONE.
+ */
 static int oo_epoll1_block_on(struct file* home_filp,
                               struct file* other_filp,
-                              ci_uint64 timeout_us)
+                              ci_uint64 timeout_us, int exclusive)
 {
   struct oo_epoll_poll_table ept;
   int rc, ret = 0;
@@ -828,8 +852,17 @@ static int oo_epoll1_block_on(struct file* home_filp,
   ept.filp = home_filp;
   ept.task = current;
   ept.w[0] = ept.w[1] = NULL;
+  ept.exclusive = exclusive;
+  ept.ready_list_flags = NULL;
   init_poll_funcptr(&ept.pt, oo_epoll1_block_on_callback);
 #if CI_CFG_EPOLL3
+  if( exclusive ) {
+    struct oo_epoll1_private* priv1 =
+      &((struct oo_epoll_private*) home_filp->private_data)->p.p1;
+    if( priv1->home_stack != NULL )
+      ept.ready_list_flags = &priv1->home_stack->netif.state->
+                                             ready_list_flags[priv1->ready_list];
+  }
   init_waitqueue_func_entry(&ept.wq[0], oo_epoll1_wake_home_callback);
 
   rc = oo_epoll1_poll(home_filp, &ept.pt);
@@ -911,6 +944,8 @@ static int oo_epoll1_spin_on(struct file* home_filp,
   ept.rc = 0;
   ept.filp = home_filp;
   ept.task = current;
+  ept.exclusive = 0;
+  ept.ready_list_flags = NULL;
   end = ktime_to_ns(ktime_add_us(ktime_get(), timeout_us));
 
 again:
@@ -1186,7 +1221,8 @@ static long oo_epoll_fop_unlocked_ioctl(struct file* filp,
     priv->p.p1.flags = 0;
 #endif
 
-    rc = oo_epoll1_block_on(filp, other_filp, local_arg.timeout_us);
+    rc = oo_epoll1_block_on(filp, other_filp, local_arg.timeout_us,
+                            local_arg.flags & OO_EPOLL1_WAKE_ONE);
     fput(other_filp);
 
     if( signal_pending(current) )
@@ -181,6 +181,23 @@ extern void ci_pmtu_update_slow(ci_netif *ni, ci_pmtu_state_t *pmtus,
   ci_pmtu_discover_timer( (ni), (p), CI_PMTU_IMMEDIATE_TIMEOUT )
 
 
+/*********************************************************************
+************************** IPv4 Reassembly ***************************
+*********************************************************************/
+
+/*! Adds an IPv4 UDP fragment to the reassembly table.  Returns the first
+ * fragment of the datagram once all of it has arrived, or NULL. */
+extern ci_ip_pkt_fmt* ci_ip_reasm_rx(ci_netif* ni, ci_ip_pkt_fmt* pkt) CI_HF;
+/*! Passes a datagram returned by ci_ip_reasm_rx() to the kernel as the
+ * fragments it was received in.  Returns 0, leaving [pkt] as it was, if
+ * that is not possible. */
+extern int ci_ip_reasm_pass_to_kernel(ci_netif* ni, ci_ip_pkt_fmt* pkt) CI_HF;
+/*! IP timer callback to expire incomplete datagrams */
+extern void ci_ip_reasm_timeout(ci_netif* ni) CI_HF;
+/*! Releases every fragment held for reassembly */
+extern void ci_ip_reasm_flush(ci_netif* ni) CI_HF;
+
+
 
 /*! Initializes an IP cache
  *  (to use this macro include <ci/internal/cplane_ops.h>)
@@ -231,19 +248,26 @@ ci_ip_cache_invalidate(ci_ip_cached_hdrs*  ipcache)
 
 
 static inline int
-oo_cp_ipcache_is_valid(ci_netif* ni, ci_ip_cached_hdrs* ipcache)
+oo_cp_fwd_ver_is_valid(ci_netif* ni, cicp_verinfo_t* fwd_ver,
+                       cicp_verinfo_t* fwd_ver_init_net)
 {
-  int rc = oo_cp_verinfo_is_valid(ni->cplane, &ipcache->fwd_ver,
+  int rc = oo_cp_verinfo_is_valid(ni->cplane, fwd_ver,
                                   ci_ni_fwd_table_id(ni));
-  if( rc && ipcache->fwd_ver_init_net.id != CICP_MAC_ROWID_UNUSED ) {
+  if( rc && fwd_ver_init_net->id != CICP_MAC_ROWID_UNUSED ) {
     rc = ni->cplane_init_net != NULL &&
-         oo_cp_verinfo_is_valid(ni->cplane_init_net,
-                                &ipcache->fwd_ver_init_net,
+         oo_cp_verinfo_is_valid(ni->cplane_init_net, fwd_ver_init_net,
                                 ci_ni_fwd_table_id(ni));
   }
   return rc;
 }
 
+static inline int
+oo_cp_ipcache_is_valid(ci_netif* ni, ci_ip_cached_hdrs* ipcache)
+{
+  return oo_cp_fwd_ver_is_valid(ni, &ipcache->fwd_ver,
+                                &ipcache->fwd_ver_init_net);
+}
+
 
 /*********************************************************************
 *************************** Packet buffers ***************************
@@ -369,6 +393,11 @@ static inline ci_uint16 ci_tx_pkt_ipx_tcp_payload_len(int af, ci_ip_pkt_fmt* pkt
 /*! Get re-order buffer structure from TCP packet */
 #define PKT_TCP_RX_ROB(pkt) (&(pkt)->pf.tcp_rx.misc.rob)
 
+/*! Slot in ci_tcp_rob_index [ri] of the [i]th indexed re-order buffer
+ * block */
+#define CI_TCP_ROB_INDEX_SLOT(ri, i)                                    \
+  (((ri)->first + (i)) & (CI_CFG_TCP_ROB_INDEX_SIZE - 1))
+
 /*! Get tsval from timestamp option.  This had better be a TCP packet with
 ** a timestamp option!  (Horribly inefficient; only use for logging). */
 #define PKT_TCP_TSO_TSVAL(pkt)                                          \
@@ -411,6 +440,10 @@ typedef struct {
   ci_int32      sack_blocks;
   ci_uint32     ack,seq;         /* ACK and SEQ values in host endian */
   ci_uint32     hash;            /* hash for l/r addr/port */
+  /* Fast Open option of a SYN or SYN-ACK; valid if [flags] has
+   * CI_TCPT_FLAG_FASTOPEN. */
+  const ci_uint8* fastopen_cookie;
+  ci_int32      fastopen_cookie_len;
 } ciip_tcp_rx_pkt;
 
 
@@ -922,8 +955,12 @@ struct cmsg_state {
 
 extern void ci_put_cmsg(struct cmsg_state *cmsg_state, int level, int type,
                         socklen_t len, const void *data) CI_HF;
-/* info_out contains a pointer to struct in_pktinfo or struct in6_pktinfo */
-extern int ci_ip_cmsg_send(const struct msghdr*, void** info_out) CI_HF;
+/* info_out contains a pointer to struct in_pktinfo or struct in6_pktinfo,
+ * gso_size_out is set if a UDP_SEGMENT cmsg is present and txtime_out if
+ * an SCM_TXTIME cmsg is present. */
+extern int ci_ip_cmsg_send(const struct msghdr*, void** info_out,
+                           ci_uint16* gso_size_out,
+                           ci_uint64* txtime_out) CI_HF;
 extern void ci_ip_cmsg_finish(struct cmsg_state* cmsg_state) CI_HF;
 
 #ifndef __KERNEL__
@@ -992,6 +1029,8 @@ extern int ci_udp_recvmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
                            unsigned int vlen, int flags, 
                            const struct timespec* timeout
                            CI_KERNEL_ARG(ci_addr_spc_t addr_spc)) CI_HF;
+extern int ci_udp_sendmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
+                           unsigned int vlen, int flags) CI_HF;
 
 struct onload_zc_mmsg;
 extern int ci_tcp_zc_send(ci_netif* ni, ci_tcp_state* ts, 
@@ -1020,15 +1059,30 @@ ci_netif_raw_send(ci_netif* ni, int intf_i,
 
 extern void ci_ip_cmsg_recv(ci_netif*, ci_udp_state*, const ci_ip_pkt_fmt*,
                             struct msghdr*, int netif_locked,
-                            int *p_msg_flags) CI_HF;
+                            int *p_msg_flags, int gro_size) CI_HF;
 #if OO_DO_STACK_POLL
 extern void ci_udp_all_fds_gone(ci_netif* netif, oo_sp, int do_free);
 #endif
 extern void ci_udp_state_free(ci_netif*, ci_udp_state*) CI_HF;
 extern void ci_udp_state_try_free(ci_netif*, ci_udp_state*) CI_HF;
 extern int ci_udp_csum_correct(ci_ip_pkt_fmt* pkt, ci_udp_hdr* udp) CI_HF;
+/* Redundant feed arbitration: returns true if [pkt] is to be dropped as a
+ * copy of a datagram already delivered to [us]. */
+extern int ci_udp_arb_drop(ci_udp_state* us, ci_ip_pkt_fmt* pkt) CI_HF;
 
 extern void ci_udp_sendmsg_send_async_q(ci_netif*, ci_udp_state*) CI_HF;
+/* SO_TXTIME: returns true if [pkt] has been held until its launch time or
+ * dropped, or false if it should be sent now. */
+extern int ci_udp_txtime_hold(ci_netif*, ci_udp_state*, ci_ip_pkt_fmt* pkt,
+                              int flags) CI_HF;
+extern void ci_udp_timeout_txtime(ci_netif*, ci_udp_state*) CI_HF;
+extern void ci_udp_txtime_flush(ci_netif*, ci_udp_state*) CI_HF;
+/* Sends a datagram that ci_udp_txtime_hold() held. */
+extern void ci_udp_sendmsg_send_held(ci_netif*, ci_udp_state*,
+                                     ci_ip_pkt_fmt* pkt, int flags) CI_HF;
+/* Undoes the accounting for ci_netif_send() of a datagram not sent. */
+extern void ci_udp_fixup_pkt_not_transmitted(ci_netif*, ci_ip_pkt_fmt*) CI_HF;
+extern void ci_udp_dest_cache_flush(ci_netif*, ci_udp_state*) CI_HF;
 extern void ci_udp_perform_deferred_socket_work(ci_netif*, ci_udp_state*)CI_HF;
 extern int ci_udp_try_to_free_pkts(ci_netif*, ci_udp_state*,
                                     int desperation) CI_HF;
@@ -1513,6 +1567,16 @@ ci_tcp_syncookie_ack(ci_netif* netif, ci_tcp_socket_listen* tls,
                      ciip_tcp_rx_pkt* rxp,
                      ci_tcp_state_synrecv **tsr_p);
 
+/* Length of the TCP Fast Open cookies we generate */
+#define CI_TCP_FASTOPEN_COOKIE_LEN 8
+extern void
+ci_tcp_fastopen_cookie(ci_netif* netif, ci_addr_t raddr, ci_uint8* cookie);
+extern int
+ci_tcp_fastopen_cache_get(ci_netif* netif, ci_addr_t raddr, ci_uint8* cookie);
+extern void
+ci_tcp_fastopen_cache_put(ci_netif* netif, ci_addr_t raddr,
+                          const ci_uint8* cookie, int len);
+
 extern void ci_tcp_set_sndbuf(ci_netif* ni, ci_tcp_state* ts);
 extern void ci_tcp_set_sndbuf_from_sndbuf_pkts(ci_netif* ni, ci_tcp_state* ts);
 
@@ -1654,13 +1718,22 @@ extern const char* ci_tcp_congstate_str(unsigned state) CI_HF;
 
 extern void ci_tcp_handle_rx(ci_netif*, struct ci_netif_poll_state*,
                              ci_ip_pkt_fmt*, ci_tcp_hdr*, int ip_paylen) CI_HF;
+extern void ci_tcp_handle_rx_lro(ci_netif*, struct ci_netif_poll_state*,
+                                 ci_ip_pkt_fmt*, ci_tcp_hdr*,
+                                 int ip_paylen) CI_HF;
+extern void ci_tcp_rx_lro_flush(ci_netif*, struct ci_netif_poll_state*) CI_HF;
 extern void ci_tcp_rx_deliver2(ci_tcp_state*,ci_netif*,ciip_tcp_rx_pkt*) CI_HF;
+extern int ci_tcp_rx_enqueue_ooo(ci_netif*, ci_tcp_state*,
+                                 ciip_tcp_rx_pkt*) CI_HF;
 extern void ci_tcp_rx_plugin_meta(ci_netif*, struct ci_netif_poll_state*,
                                   ci_ip_pkt_fmt* pkt) CI_HF;
 
 extern void ci_tcp_tx_change_mss(ci_netif*, ci_tcp_state*) CI_HF;
 extern void ci_tcp_enqueue_no_data(ci_tcp_state* ts, ci_netif* netif,
                                    ci_ip_pkt_fmt* pkt) CI_HF;
+extern int ci_tcp_enqueue_syn_data(ci_tcp_state* ts, ci_netif* netif,
+                                   ci_ip_pkt_fmt* pkt, const ci_iovec* iov,
+                                   int iovlen) CI_HF;
 extern int ci_tcp_send_sim_synack(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern int ci_tcp_synrecv_send(ci_netif* netif, ci_tcp_socket_listen* tls,
                                ci_tcp_state_synrecv* tsr, 
@@ -1678,7 +1751,46 @@ ci_tcp_maybe_enter_fast_recovery(ci_netif* ni, ci_tcp_state* ts) CI_HF;
 
 extern void ci_tcp_recovered(ci_netif* ni, ci_tcp_state* ts) CI_HF;
 
+/* RACK loss detection (tcp_rack.c) */
+extern void ci_tcp_rack_init(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_rack_on_delivered(ci_netif* ni, ci_tcp_state* ts,
+                                     ci_ip_pkt_fmt* pkt) CI_HF;
+extern void ci_tcp_rack_on_idle(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_rack_on_dsack(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_rack_on_recovered(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern int ci_tcp_rack_detect_loss(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_rack_recover_lost(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+
+ci_inline int ci_tcp_rack_enabled(const ci_netif* ni, const ci_tcp_state* ts)
+{
+  return NI_OPTS(ni).tcp_loss_detection == EF_TCP_LOSS_DETECTION_RACK &&
+         (ts->tcpflags & CI_TCPT_FLAG_SACK) && OO_P_NOT_NULL(ts->cc_state);
+}
+
 extern void ci_tcp_clear_sacks(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
+                                   ciip_tcp_rx_pkt* rxp) CI_HF;
+
+/* Returns the last packet of the retransmit queue block containing [pkt],
+ * which must not be in the trailing unSACKed region.
+ *
+ * Within a SACKed block [block_end] may point at any later packet of the
+ * block, because extending a block only updates the pointer in its old last
+ * packet.  The last packet of every block points at itself.  The pointer in
+ * [pkt] is updated so that the next lookup from it is direct.
+ */
+ci_inline ci_ip_pkt_fmt* ci_tcp_rtq_block_end(ci_netif* ni,
+                                              ci_ip_pkt_fmt* pkt)
+{
+  ci_ip_pkt_fmt* end;
+
+  ci_assert(OO_PP_NOT_NULL(pkt->pf.tcp_tx.block_end));
+  end = PKT_CHK(ni, pkt->pf.tcp_tx.block_end);
+  while( ! OO_PP_EQ(end->pf.tcp_tx.block_end, OO_PKT_P(end)) )
+    end = PKT_CHK(ni, end->pf.tcp_tx.block_end);
+  pkt->pf.tcp_tx.block_end = OO_PKT_P(end);
+  return end;
+}
 extern void ci_tcp_retrans_init_ptrs(ci_netif* ni, ci_tcp_state* ts,
                                      unsigned* recover_seq_out) CI_HF;
 extern void ci_tcp_get_fack(ci_netif* ni, ci_tcp_state* ts,
@@ -1696,6 +1808,9 @@ extern void ci_tcp_tx_insert_option_space(ci_netif* ni, ci_tcp_state* ts,
 extern int ci_tcp_tx_split(ci_netif* ni, ci_tcp_state* ts, ci_ip_pkt_queue* qu,
                            ci_ip_pkt_fmt* pkt, int new_paylen, 
                            ci_boolean_t is_sendq) CI_HF;
+extern int ci_tcp_tx_gso_segment(ci_netif* ni, ci_tcp_state* ts,
+                                 ci_ip_pkt_fmt* pkt) CI_HF;
+extern void ci_tcp_sendq_gso_segment_all(ci_netif* ni, ci_tcp_state* ts) CI_HF;
 
 
 extern void ci_tcp_tx_advance(ci_tcp_state* ts, ci_netif* netif) CI_HF;
@@ -1909,6 +2024,8 @@ extern void ci_tcp_timeout_zwin(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_timeout_delack(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_timeout_rto(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_timeout_cork(ci_netif* netif, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_timeout_pace(ci_netif* netif, ci_tcp_state* ts) CI_HF;
+extern void ci_tcp_timeout_rack(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_timeout_recycle(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_stop_timers(ci_netif* netif, ci_tcp_state* ts) CI_HF;
 extern void ci_tcp_send_corked_packets(ci_netif* netif, ci_tcp_state* ts) CI_HF;
@@ -3668,6 +3785,19 @@ ci_inline void ci_udp_dec_tx_count(ci_udp_state* us, ci_ip_pkt_fmt* pkt) {
 }
 
 
+ci_inline int ci_udp_tx_datagram_level(ci_netif* ni, ci_ip_pkt_fmt* pkt,
+                                       ci_boolean_t ni_locked)
+{
+  /* Sum the contributions from each IP fragment. */
+  int level = 0;
+  for( ; ; pkt = PKT_CHK_NML(ni, pkt->next, ni_locked) ) {
+    level += pkt->pf.udp.tx_length;
+    if( OO_PP_IS_NULL(pkt->next) )
+      return level;
+  }
+}
+
+
 /* Returns true if there is sufficient space in the send queue that it is
 ** worth telling the app.  ie. Used to decide when to wake a thread, and
 ** when to indicate writable in select() and poll().
@@ -3896,7 +4026,8 @@ ci_inline void ci_tcp_delack_soon(ci_netif* netif, ci_tcp_state* ts)
 ci_inline int ci_tcp_taildrop_probe_enabled(const ci_netif* ni,
                                             const ci_tcp_state* ts)
 {
-  return NI_OPTS(ni).tail_drop_probe &&
+  return (NI_OPTS(ni).tail_drop_probe ||
+          NI_OPTS(ni).tcp_loss_detection == EF_TCP_LOSS_DETECTION_RACK) &&
          (ts->tcpflags & CI_TCPT_FLAG_SACK) &&
          ts->congstate == CI_TCP_CONG_OPEN &&
          (ts->s.b.state & CI_TCP_STATE_SYNCHRONISED);
@@ -4113,6 +4244,9 @@ ci_inline int ci_tcp_sendq_not_empty(ci_tcp_state* ts)
 
 ci_inline void ci_tcp_sendq_drop(ci_netif* ni, ci_tcp_state* ts)
 { 
+  /* Split super-segments so that send.num counts every buffer. */
+  if( NI_OPTS(ni).tcp_gso )
+    ci_tcp_sendq_gso_segment_all(ni, ts);
   ts->send_out += ts->send.num;
   ci_ip_queue_drop(ni, &ts->send);
 }
@@ -4345,6 +4479,137 @@ ci_inline ci_uint32 ci_tcp_base_dupack_thresh(ci_tcp_state *ts) {
 
 /* congestion control functions */
 
+/* Congestion control algorithms are selected per socket by [c.cc_alg],
+ * which indexes [ci_tcp_cong_ops_tbl].  The table lives in each address
+ * space, so that shared state holds no pointers.  See tcp_cong.c. */
+typedef struct {
+  const char* name;
+  unsigned flags;
+#define CI_TCP_CONG_FLAG_NEEDS_ECN 0x1  /* always negotiate ECN */
+  /* Called when cwnd and ssthresh have been (re)initialised.  Optional. */
+  void (*init)(ci_netif* ni, ci_tcp_state* ts);
+  /* Called when [acked] bytes of new data have been acknowledged and added
+   * to [bytes_acked].  [rtt] is an RTT sample in ticks, or negative if the
+   * ACK did not give one. */
+  void (*on_ack)(ci_netif* ni, ci_tcp_state* ts, unsigned acked, int rtt);
+  /* Called when loss is detected.  Returns the new ssthresh. */
+  ci_uint32 (*on_loss)(ci_netif* ni, ci_tcp_state* ts);
+  /* Called for each ACK of new data on a connection that negotiated ECN,
+   * after [snd_una] is advanced.  [ece] is set if the ACK echoed
+   * congestion.  Optional. */
+  void (*on_ecn)(ci_netif* ni, ci_tcp_state* ts, unsigned acked, int ece);
+  /* Returns the new ssthresh in response to ECN.  Optional: by default
+   * ECN is treated as loss (RFC 3168). */
+  ci_uint32 (*ecn_ssthresh)(ci_netif* ni, ci_tcp_state* ts);
+  /* Called when the RTO timer fires, after cwnd is collapsed.  Optional. */
+  void (*on_rto)(ci_netif* ni, ci_tcp_state* ts);
+  /* Called when transmit resumes with nothing in flight.  Optional. */
+  void (*on_idle)(ci_netif* ni, ci_tcp_state* ts);
+  /* Returns the rate at which to pace transmits, in CI_TCP_PACE_SHIFT
+   * units, or 0 to not pace.  Optional. */
+  ci_uint32 (*pacing_rate)(ci_netif* ni, ci_tcp_state* ts);
+  /* Dumps the algorithm's private state.  Optional. */
+  void (*dump)(ci_netif* ni, ci_tcp_state* ts, const char* pf,
+               oo_dump_log_fn_t logger, void* log_arg);
+} ci_tcp_cong_ops;
+
+#define CI_TCP_CONG_NUM 4
+#define CI_TCP_CONG_NAME_MAX 16   /* as TCP_CA_NAME_MAX in Linux */
+extern const ci_tcp_cong_ops* const ci_tcp_cong_ops_tbl[CI_TCP_CONG_NUM];
+
+/* Returns the EF_TCP_CONGESTION_* value for algorithm [name], which need
+ * not be NUL-terminated, or -ENOENT. */
+extern int ci_tcp_cong_find(const char* name, int len) CI_HF;
+extern void ci_tcp_cong_set(ci_netif* ni, ci_tcp_state* ts, int alg) CI_HF;
+/* Allocates [ts->cc_state].  Returns false if there is no aux buffer. */
+extern int ci_tcp_cc_state_alloc(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+
+/* Pacing rates are held as bytes per tick of the usec clock (see
+ * ci_ip_time_get_us()), shifted left by CI_TCP_PACE_SHIFT. */
+#define CI_TCP_PACE_SHIFT 12
+#define CI_TCP_PACING_RATE_UNLIMITED (~(ci_uint64) 0)
+
+/* Sets [pace_rate] from the congestion control algorithm and
+ * SO_MAX_PACING_RATE. */
+extern void ci_tcp_pace_update(ci_netif* ni, ci_tcp_state* ts) CI_HF;
+
+ci_inline ci_uint32 ci_tcp_pace_usticks_per_sec(ci_netif* ni)
+{
+  ci_ip_timer_state* its = IPTIMER_STATE(ni);
+  return ((ci_uint64) its->khz * 1000) >> its->ci_ip_time_frc2us;
+}
+
+ci_inline ci_uint32 ci_tcp_pace_rate_from_bps(ci_netif* ni, ci_uint64 bps)
+{
+  ci_uint64 rate;
+  if( bps >= (1ull << (64 - CI_TCP_PACE_SHIFT)) )
+    return 0xffffffff;
+  rate = (bps << CI_TCP_PACE_SHIFT) / ci_tcp_pace_usticks_per_sec(ni);
+  return (ci_uint32) CI_MIN(CI_MAX(rate, 1), 0xffffffffull);
+}
+
+ci_inline ci_uint64 ci_tcp_pace_rate_to_bps(ci_netif* ni, ci_uint32 rate)
+{
+  return ((ci_uint64) rate * ci_tcp_pace_usticks_per_sec(ni)) >>
+         CI_TCP_PACE_SHIFT;
+}
+
+ci_inline const ci_tcp_cong_ops* ci_tcp_cong(const ci_tcp_socket_cmn* c)
+{
+  /* [cc_alg] is in shared memory, so don't trust it. */
+  unsigned alg = c->cc_alg;
+  if(CI_UNLIKELY( alg >= CI_TCP_CONG_NUM ))
+    alg = EF_TCP_CONGESTION_RENO;
+  return ci_tcp_cong_ops_tbl[alg];
+}
+
+ci_inline int ci_tcp_cong_needs_ecn(const ci_tcp_socket_cmn* c)
+{
+  return ci_tcp_cong(c)->flags & CI_TCP_CONG_FLAG_NEEDS_ECN;
+}
+
+/* The algorithms with an init hook keep their private state in the
+ * [cc_state] aux buffer.  Until ci_tcp_cong_init() has allocated it, or if
+ * it could not, the connection uses Reno. */
+ci_inline const ci_tcp_cong_ops* ci_tcp_cong_ts(const ci_tcp_state* ts)
+{
+  if( OO_P_IS_NULL(ts->cc_state) )
+    return ci_tcp_cong_ops_tbl[EF_TCP_CONGESTION_RENO];
+  return ci_tcp_cong(&ts->c);
+}
+
+ci_inline void ci_tcp_cong_init(ci_netif* ni, ci_tcp_state* ts)
+{
+  const ci_tcp_cong_ops* ops;
+  if( OO_P_IS_NULL(ts->cc_state) &&
+      (ci_tcp_cong(&ts->c)->init != NULL ||
+       NI_OPTS(ni).tcp_loss_detection == EF_TCP_LOSS_DETECTION_RACK) )
+    ci_tcp_cc_state_alloc(ni, ts);
+  ops = ci_tcp_cong_ts(ts);
+  if( ops->init != NULL )
+    ops->init(ni, ts);
+  ci_tcp_pace_update(ni, ts);
+}
+
+ci_inline ci_uint32 ci_tcp_cong_on_loss(ci_netif* ni, ci_tcp_state* ts)
+{
+  return ci_tcp_cong_ts(ts)->on_loss(ni, ts);
+}
+
+ci_inline void ci_tcp_cong_on_rto(ci_netif* ni, ci_tcp_state* ts)
+{
+  const ci_tcp_cong_ops* ops = ci_tcp_cong_ts(ts);
+  if( ops->on_rto != NULL )
+    ops->on_rto(ni, ts);
+}
+
+ci_inline void ci_tcp_cong_on_idle(ci_netif* ni, ci_tcp_state* ts)
+{
+  const ci_tcp_cong_ops* ops = ci_tcp_cong_ts(ts);
+  if( ops->on_idle != NULL )
+    ops->on_idle(ni, ts);
+}
+
 /* set the initial congestion window as in rfc3390/rfc2581/rfc2001 */ 
 ci_inline void ci_tcp_set_initialcwnd(ci_netif* ni, ci_tcp_state* ts) {
   if( NI_OPTS(ni).initial_cwnd == 0 ) {
@@ -4382,6 +4647,7 @@ ci_inline void ci_tcp_set_initialcwnd(ci_netif* ni, ci_tcp_state* ts) {
    * processed the options, so this is OK. */
   ci_assert_le(ts->snd_wscl, CI_TCP_WSCL_MAX);
   ts->ssthresh = 65535 << ts->snd_wscl;
+  ci_tcp_cong_init(ni, ts);
 }
 
 /*! ?? \TODO should we use fackets to make things more exact ? */ 
@@ -4432,12 +4698,23 @@ ci_inline int ci_tcp_sendq_n_pkts(ci_tcp_state* ts) {
   return n >= 0 ? n : 0;
 }
 
+/* TCP_NOTSENT_LOWAT: true if the data queued but not yet sent has reached
+ * the socket's limit.
+ */
+ci_inline int ci_tcp_notsent_over_lowat(ci_tcp_state* ts) {
+  return ts->c.notsent_lowat != 0 &&
+         (ci_uint32) SEQ_SUB(tcp_enq_nxt(ts), tcp_snd_nxt(ts)) >=
+         ts->c.notsent_lowat;
+}
+
 /* This test is used to decide whether we should indicate to the app that
 ** it can enqueue more data on a socket.  ie. It is used to decide when to
 ** wake a blocking thread, and to decide whether to indicate the socket is
 ** writable in select() and poll().
 */
 ci_inline int ci_tcp_tx_advertise_space(ci_netif* ni, ci_tcp_state* ts) {
+  if( ci_tcp_notsent_over_lowat(ts) )
+    return 0;
   if( NI_OPTS(ni).tcp_sndbuf_mode ) {
     int pkts_queued = ci_tcp_sendq_n_pkts(ts)
 #if CI_CFG_TIMESTAMPING
@@ -4459,6 +4736,8 @@ ci_inline int ci_tcp_tx_advertise_space(ci_netif* ni, ci_tcp_state* ts) {
  */
 ci_inline int ci_tcp_tx_send_space(ci_netif* ni, ci_tcp_state* ts)
 {
+  if( ci_tcp_notsent_over_lowat(ts) )
+    return 0;
   if( NI_OPTS(ni).tcp_sndbuf_mode ) {
     return ts->so_sndbuf_pkts -
         (ci_tcp_sendq_n_pkts(ts)
@@ -4492,6 +4771,42 @@ ci_inline void ci_tcp_tx_pkt_set_end(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt) {
 }
 
 
+/* Number of payload bytes in [pkt]'s own buffer.  For the head of a
+ * super-segment (EF_TCP_GSO) that is only its first segment.  The headers
+ * of the packet must be initialised.
+ */
+ci_inline int ci_tcp_tx_pkt_own_paylen(int af, ci_ip_pkt_fmt* pkt) {
+  const ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
+  return oo_tx_l3_len(pkt) - CI_IPX_HDR_SIZE(af) - CI_TCP_HDR_LEN(tcp);
+}
+
+
+/* EF_TCP_GSO: true if [pkt] on the send queue is the head of a
+ * super-segment, i.e. it covers more sequence space than its own payload.
+ * The headers of the packet must be initialised.
+ */
+ci_inline int ci_tcp_tx_pkt_is_gso(int af, ci_ip_pkt_fmt* pkt) {
+  const ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
+  int seq_space = PKT_TCP_TX_SEQ_SPACE(pkt);
+  seq_space -= (tcp->tcp_flags & CI_TCP_FLAG_SYN) ? 1 : 0;
+  seq_space -= (tcp->tcp_flags & CI_TCP_FLAG_FIN) ? 1 : 0;
+  return seq_space > ci_tcp_tx_pkt_own_paylen(af, pkt);
+}
+
+
+/* End of the first segment on the send queue, which must not be empty.
+ * When the head is a super-segment this is the end of its first segment,
+ * not of the whole super-segment.
+ */
+ci_inline unsigned ci_tcp_sendq_head_end_seq(ci_netif* ni, ci_tcp_state* ts) {
+  ci_ip_pkt_fmt* pkt = PKT_CHK(ni, ts->send.head);
+  int af = ipcache_af(&ts->s.pkt);
+  if( NI_OPTS(ni).tcp_gso && ci_tcp_tx_pkt_is_gso(af, pkt) )
+    return pkt->pf.tcp_tx.start_seq + ci_tcp_tx_pkt_own_paylen(af, pkt);
+  return pkt->pf.tcp_tx.end_seq;
+}
+
+
 /* Sets up the offbuf end pointer correctly for a zero-copy
  * (CI_PKT_FLAG_INDIRECT) packet, prior to populating the ci_pkt_zc_header.
  * See the diagram above ci_pkt_zc_header. This function may only be called
@@ -4704,6 +5019,12 @@ static inline const char* ci_tcp_aux_type2str(int type)
     case CI_TCP_AUX_TYPE_SYNRECV: return "syn-recv state";
     case CI_TCP_AUX_TYPE_BUCKET:  return "syn-recv bucket";
     case CI_TCP_AUX_TYPE_EPOLL: return "epoll3 state";
+    case CI_TCP_AUX_TYPE_PMTUS: return "pmtu state";
+    case CI_TCP_AUX_TYPE_UDP_DEST: return "udp dest cache";
+    case CI_TCP_AUX_TYPE_MCAST: return "mcast index";
+    case CI_TCP_AUX_TYPE_UDP_DEST_TABLE: return "udp dest table";
+    case CI_TCP_AUX_TYPE_ROB_INDEX: return "tcp rob index";
+    case CI_TCP_AUX_TYPE_TCP_CC: return "tcp cc state";
     default: return "unknown";
   }
 }
@@ -4738,6 +5059,38 @@ ci_inline ci_pmtu_state_t* ci_ni_aux_p2pmtus(ci_netif* ni, oo_p oop)
   ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_PMTUS);
   return &aux->u.pmtus;
 }
+ci_inline ci_udp_dest_cache_entry*
+ci_ni_aux_p2udp_dest(ci_netif* ni, oo_p oop)
+{
+  ci_ni_aux_mem* aux = ci_ni_aux_p2aux(ni, oop);
+  ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_UDP_DEST);
+  return &aux->u.udp_dest;
+}
+ci_inline ci_udp_dest_cache*
+ci_ni_aux_p2udp_dest_table(ci_netif* ni, oo_p oop)
+{
+  ci_ni_aux_mem* aux = ci_ni_aux_p2aux(ni, oop);
+  ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_UDP_DEST_TABLE);
+  return &aux->u.udp_dest_table;
+}
+ci_inline ci_mcast_index_entry* ci_ni_aux_p2mcast(ci_netif* ni, oo_p oop)
+{
+  ci_ni_aux_mem* aux = ci_ni_aux_p2aux(ni, oop);
+  ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_MCAST);
+  return &aux->u.mcast;
+}
+ci_inline ci_tcp_rob_index* ci_ni_aux_p2rob_index(ci_netif* ni, oo_p oop)
+{
+  ci_ni_aux_mem* aux = ci_ni_aux_p2aux(ni, oop);
+  ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_ROB_INDEX);
+  return &aux->u.rob_index;
+}
+ci_inline ci_tcp_cc_state* ci_ni_aux_p2tcp_cc(ci_netif* ni, oo_p oop)
+{
+  ci_ni_aux_mem* aux = ci_ni_aux_p2aux(ni, oop);
+  ci_assert_equal(aux->type, CI_TCP_AUX_TYPE_TCP_CC);
+  return &aux->u.tcp_cc;
+}
 
 ci_inline citp_waitable*
 ci_ni_aux2container_w(ci_ni_aux_mem* aux)
@@ -4777,6 +5130,23 @@ ci_inline void ci_sb_epoll_free(ci_netif* ni, ci_sb_epoll_state* epoll) {
 ci_inline void ci_pmtu_state_free(ci_netif* ni, ci_pmtu_state_t* pmtus) {
   ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.pmtus, pmtus));
 }
+ci_inline void ci_udp_dest_cache_entry_free(ci_netif* ni,
+                                            ci_udp_dest_cache_entry* e) {
+  ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.udp_dest, e));
+}
+ci_inline void ci_udp_dest_cache_free(ci_netif* ni, ci_udp_dest_cache* dc) {
+  ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.udp_dest_table, dc));
+}
+ci_inline void ci_mcast_index_entry_free(ci_netif* ni,
+                                         ci_mcast_index_entry* e) {
+  ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.mcast, e));
+}
+ci_inline void ci_tcp_rob_index_free(ci_netif* ni, ci_tcp_rob_index* ri) {
+  ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.rob_index, ri));
+}
+ci_inline void ci_tcp_cc_state_free(ci_netif* ni, ci_tcp_cc_state* cc) {
+  ci_ni_aux_free(ni, CI_CONTAINER(ci_ni_aux_mem, u.tcp_cc, cc));
+}
 
 extern void ci_ni_aux_more_bufs(ci_netif* ni);
 ci_inline int/*bool*/ ci_ni_aux_can_alloc(ci_netif* ni, int type)
@@ -4842,6 +5212,12 @@ ci_inline ci_tcp_state_synrecv* ci_tcp_link2synrecv(struct oo_p_dllink* link) {
   return &CI_CONTAINER(ci_ni_aux_mem, link, link)->u.synrecv;
 }
 
+/* Congestion control and RACK state; [ts->cc_state] must be allocated. */
+ci_inline ci_tcp_cc_state* ci_tcp_cc(ci_netif* ni, ci_tcp_state* ts)
+{
+  return ci_ni_aux_p2tcp_cc(ni, ts->cc_state);
+}
+
 /* finc current Path MTU */
 ci_inline unsigned ci_tcp_get_pmtu(ci_netif* netif, ci_tcp_state* ts)
 {
@@ -204,7 +204,7 @@
  */
 
 #define CI_TCP_SOCKET_FLAGS_FMT                                        \
-  "%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s"
+  "%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s"
 #define CI_TCP_SOCKET_FLAGS_PRI_ARG(ts)                                \
   ((ts)->tcpflags & CI_TCPT_FLAG_TSO    ? "TSO " :""),                 \
   ((ts)->tcpflags & CI_TCPT_FLAG_WSCL   ? "WSCL ":""),                 \
@@ -226,7 +226,12 @@
   ((ts)->tcpflags & CI_TCPT_FLAG_LOOP_FAKE        ? "LOOP_FAKE ":""),   \
   ((ts)->tcpflags & CI_TCPT_FLAG_TAIL_DROP_TIMING ? "TLP_TIMER ":""),   \
   ((ts)->tcpflags & CI_TCPT_FLAG_TAIL_DROP_MARKED ? "TLP_SENT ":""),    \
-  ((ts)->tcpflags & CI_TCPT_FLAG_FIN_PENDING      ? "FIN_PENDING ":"")
+  ((ts)->tcpflags & CI_TCPT_FLAG_FIN_PENDING      ? "FIN_PENDING ":""), \
+  ((ts)->tcpflags & CI_TCPT_FLAG_ECN_ECE          ? "ECE ":""),         \
+  ((ts)->tcpflags & CI_TCPT_FLAG_ECN_CWR          ? "CWR ":""),         \
+  ((ts)->tcpflags & CI_TCPT_FLAG_FASTOPEN         ? "TFO ":""),         \
+  ((ts)->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER   ? "TFO_DEFER ":""),   \
+  ((ts)->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA    ? "TFO_DATA ":"")
 
 
 #define CI_SOCK_FLAGS_FMT \
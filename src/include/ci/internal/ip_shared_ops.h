@@ -234,7 +234,7 @@ ci_inline char* oo_state_off_to_ptr(ci_netif* ni, unsigned off)
 #define EP_BUF_SIZE        CI_CFG_EP_BUF_SIZE
 #define EP_BUF_PER_PAGE    (CI_PAGE_SIZE / EP_BUF_SIZE)
 
-#define EP_BUF_PER_CHUNK    2048
+#define EP_BUF_PER_CHUNK    ((1u << 21) / EP_BUF_SIZE)
 #ifdef __KERNEL__
   CI_BUILD_ASSERT(OO_SHARED_BUFFER_CHUNK_SIZE / CI_CFG_EP_BUF_SIZE ==
                   EP_BUF_PER_CHUNK);
@@ -349,6 +349,9 @@ struct ci_ip_pkt_fmt_s {
       ci_int32          intf_swap;
 #endif
     } tx;
+    /* Next of the packets that make up a TCP super-segment on the send
+     * queue (EF_TCP_GSO).  See ci_tcp_tx_gso_segment(). */
+    oo_pkt_p            tcp_gso_next;
   } netif;
 
   /*! These flags can only be used by (i) netif lock holder, or (ii)
@@ -841,9 +844,30 @@ typedef struct {
 # define CI_IP_TIMER_NETIF_STATS        0xa  /* netif statistics timer   */
 # define CI_IP_TIMER_TCP_CORK           0xb  /* TCP_CORK timer           */
 # define CI_IP_TIMER_NETIF_TCP_RECYCLE  0xc  /* EF100 plugin recycling   */
+# define CI_IP_TIMER_TCP_PACE           0xd  /* TCP pacing timer         */
+# define CI_IP_TIMER_TCP_RACK           0xe  /* TCP RACK reordering timer*/
+# define CI_IP_TIMER_UDP_TXTIME         0xf  /* UDP SO_TXTIME launch     */
+# define CI_IP_TIMER_NETIF_REASM        0x10 /* IP reassembly expiry     */
 } ci_ip_timer;
 
 
+/*!
+** ci_ip_reasm_slot: An IPv4 datagram being reassembled from fragments.
+** The fragments are chained through [frag_next] in order of offset, and
+** each has its [buf] set to its IP payload.
+*/
+typedef struct {
+  ci_uint32             saddr_be32;
+  ci_uint32             daddr_be32;
+  ci_uint16             id_be16;
+  ci_uint16             n_frags;  /* number of fragments held; 0 if free */
+  ci_uint16             bytes;    /* IP payload bytes held */
+  ci_uint16             total;    /* IP payload length; 0 until known */
+  ci_iptime_t           expiry;
+  oo_pkt_p              frags;
+} ci_ip_reasm_slot;
+
+
 /*!
 ** ci_pio_buddy_allocator:  A buddy allocator to allow a pio region linked to
 ** a vi to be divided up into smaller chunks.
@@ -1106,6 +1130,14 @@ typedef struct {
 } ci_netif_state_nic_t;
 
 
+/* A TCP Fast Open cookie that a server has given us. */
+typedef struct {
+  ci_addr_t             raddr;
+  ci_uint8              cookie_len;   /* zero if the entry is unused */
+  ci_uint8              cookie[CI_TCP_FASTOPEN_COOKIE_MAX];
+} ci_tcp_fastopen_cache_entry;
+
+
 struct ci_netif_state_s {
 
   ci_netif_state_nic_t  nic[CI_CFG_MAX_INTERFACES];
@@ -1279,6 +1311,7 @@ struct ci_netif_state_s {
 #endif
   CI_ULCONST ci_uint32  seq_table_ofs;   /**< offset of seq no table */
   CI_ULCONST ci_uint32  deferred_pkts_ofs; /**< offset of deferred pkts array */
+  CI_ULCONST ci_uint32  mcast_index_ofs; /**< offset of mcast index buckets */
   CI_ULCONST ci_uint32  buf_ofs;         /**< offset of packet metadata */
   CI_ULCONST ci_uint32  dma_ofs;         /**< offset of dma_addrs */
 
@@ -1346,7 +1379,12 @@ struct ci_netif_state_s {
 #define CI_TCP_AUX_TYPE_BUCKET  1
 #define CI_TCP_AUX_TYPE_EPOLL   2
 #define CI_TCP_AUX_TYPE_PMTUS   3
-#define CI_TCP_AUX_TYPE_NUM     4
+#define CI_TCP_AUX_TYPE_UDP_DEST 4
+#define CI_TCP_AUX_TYPE_MCAST   5
+#define CI_TCP_AUX_TYPE_UDP_DEST_TABLE 6
+#define CI_TCP_AUX_TYPE_ROB_INDEX 7
+#define CI_TCP_AUX_TYPE_TCP_CC  8
+#define CI_TCP_AUX_TYPE_NUM     9
   struct oo_p_dllink    free_aux_mem;    /**< Free list of synrecv bufs. */
   ci_uint32             n_free_aux_bufs; /**< Number of free aux bufs */
   ci_uint32             n_aux_bufs[CI_TCP_AUX_TYPE_NUM];
@@ -1354,6 +1392,24 @@ struct ci_netif_state_s {
   CI_ULCONST ci_uint32  max_aux_bufs[CI_TCP_AUX_TYPE_NUM];
                         /**< Maximum number of aux bufs we can use */
 
+  /* Index of the IPv4 UDP multicast filters in the software filter table
+   * (EF_UDP_MCAST_INDEX): chains of ci_mcast_index_entry aux buffers,
+   * hashed by group and port, from the CI_CFG_MCAST_INDEX_BUCKETS heads at
+   * [mcast_index_ofs].  [mcast_index_missing] counts filters that could
+   * not be added to the index; while it is non-zero the filter table is
+   * searched instead.  Protected by the stack lock.
+   */
+  ci_uint32             mcast_index_missing;
+
+  /* IPv4 datagrams being reassembled from fragments (EF_IP_REASM).
+   * [reasm_tid] fires when the first of them expires, and [reasm_n_pkts]
+   * counts the packet buffers held in the table.  Protected by the stack
+   * lock.
+   */
+  ci_ip_timer           reasm_tid CI_ALIGN(8);
+  ci_uint32             reasm_n_pkts;
+  ci_ip_reasm_slot      reasm[CI_CFG_IP_REASM_SLOTS];
+
 #if CI_CFG_FD_CACHING
   /**< Num entries available on the passive socket cache */
   ci_uint32             passive_cache_avail_stack;
@@ -1495,6 +1551,9 @@ struct ci_netif_state_s {
   struct oo_p_dllink deferred_list;
   struct oo_p_dllink deferred_list_free;
 
+  /* TCP Fast Open client cookie cache, direct-mapped by remote address. */
+  ci_tcp_fastopen_cache_entry tcp_fastopen_cache[CI_CFG_TCP_FASTOPEN_CACHE_SIZE];
+
 
   /* events are in shared state for poll_in_kernel mode,
    * in which events are acquired in kernel, stored here,
@@ -2069,6 +2128,7 @@ struct ci_sock_cmn_s {
 # define CI_IPV6_CMSG_PKTINFO    0x0100
 # define CI_IPV6_CMSG_HOPLIMIT   0x0200
 # define CI_IPV6_CMSG_TCLASS     0x0400
+# define CI_UDP_CMSG_GRO         0x0800  /* UDP_GRO: coalesce on receive */
 
 #if CI_CFG_TIMESTAMPING
   /* timestamping_flags relate to flags provided with socket option
@@ -2228,6 +2288,15 @@ typedef struct {
   ci_uint32 n_tx_msg_confirm; /* onload send with MSG_CONFIRM          */
   ci_uint32 n_tx_os_late;     /* sent via OS, after copying            */
   ci_uint32 n_tx_unconnect_late; /* concurrent send and unconnect      */
+  ci_uint32 n_tx_txtime_early; /* SO_TXTIME: sent before launch time  */
+  ci_uint32 n_tx_txtime_late; /* SO_TXTIME: sent after launch time     */
+  ci_uint32 n_tx_txtime_drop; /* SO_TXTIME: dropped, too late or close */
+  ci_uint32 n_tx_cp_dest_hit; /* unconnected, matched dest cache       */
+  ci_uint32 n_rx_arb_dup;     /* arbitration: duplicates dropped       */
+  ci_uint32 n_rx_arb_late;    /* arbitration: gap filled late          */
+  ci_uint32 n_rx_arb_gap;     /* arbitration: sequence numbers lost    */
+  ci_uint32 n_rx_arb_old;     /* arbitration: too old, dropped         */
+  ci_uint32 n_rx_arb_reset;   /* arbitration: feed restarted           */
 } ci_udp_socket_stats;
 
 struct  ci_udp_state_s {
@@ -2253,9 +2322,53 @@ struct  ci_udp_state_s {
 #define CI_UDPF_MCAST_FILTER    0x00010000  /*!< mcast filter added */
 #define CI_UDPF_NO_UCAST_FILTER 0x00020000  /*!< don't add unicast filters */
 #define CI_UDPF_LAST_SEND_NOMAC 0x00040000  /*!< last send was via nomac path */
+#define CI_UDPF_TXTIME          0x00080000  /*!< SO_TXTIME */
 
   ci_uint32 future_intf_i; /* Interface to check for incoming future packets */
 
+  /* UDP_SEGMENT: payload size of each datagram that a send is split into,
+   * or 0 if not set. */
+  ci_uint32 tx_gso_size;
+
+  /* SO_TXTIME: clock that launch times are given against, and flags. */
+  ci_int32  txtime_clockid;
+  ci_uint32 txtime_flags;
+#define CI_UDP_TXTIME_DEADLINE_MODE  0x1  /* SOF_TXTIME_DEADLINE_MODE */
+#define CI_UDP_TXTIME_REPORT_ERRORS  0x2  /* SOF_TXTIME_REPORT_ERRORS */
+
+  /* SO_TXTIME: datagrams waiting for their launch time, in launch time
+   * order.  Launch time (FRC) is in [pkt->tstamp_frc] of the first
+   * packet of each datagram and the link field is
+   * [pkt->netif.tx.dmaq_next].  [txtime_tid] fires when the head is due.
+   * Held datagrams are charged to [tx_count], and are dropped on close.
+   * Protected by the stack lock.
+   */
+  oo_pkt_p    txtime_head;
+  oo_pkt_p    txtime_tail;
+  ci_ip_timer txtime_tid;
+
+  /* Resolved headers of recent destinations of unconnected sends, so that
+   * a send to a destination other than [ephemeral_pkt] need not go to the
+   * control plane.  A ci_udp_dest_cache aux buffer, allocated on first
+   * use, or OO_P_NULL.  Protected by the stack lock.
+   */
+  oo_p      dest_cache;
+
+  /* Redundant feed arbitration (onload_set_recv_arbitration()): where to
+   * find the sequence number in the payload ([arb_seq_len] is 0 when
+   * arbitration is off), the highest sequence number delivered, and
+   * which of the CI_UDP_ARB_WINDOW sequence numbers up to and including
+   * that one have been delivered (bit i for [arb_last] - i).  The window
+   * is 0 until the first datagram arrives.  Protected by the stack lock.
+   */
+  ci_uint16 arb_seq_offset;
+  ci_uint8  arb_seq_len;
+  ci_uint8  arb_flags;
+#define CI_UDP_ARB_LITTLE_ENDIAN  0x1  /* ONLOAD_RECV_ARB_LITTLE_ENDIAN */
+  ci_uint64 arb_last CI_ALIGN(8);
+  ci_uint64 arb_window;
+#define CI_UDP_ARB_WINDOW  64
+
 #if CI_CFG_ZC_RECV_FILTER
   /* Only safe to use these at user-level in context of caller who set them */
   ci_uint64     recv_q_filter CI_ALIGN(8);
@@ -2480,6 +2593,136 @@ typedef struct {
   oo_p bucket[CI_TCP_LISTEN_BUCKET_SIZE];
 } ci_tcp_listen_bucket;
 
+/* Entry of the UDP multicast filter index: sockets with a filter for
+ * [group_be32]:[port_be16].  A group with more members than fit here has
+ * further entries in the same chain. */
+#define CI_MCAST_INDEX_SOCKS 20
+typedef struct {
+  oo_p      next;
+  ci_uint32 group_be32;
+  ci_uint16 port_be16;
+  ci_uint16 n_socks;
+  oo_sp     socks[CI_MCAST_INDEX_SOCKS];
+} ci_mcast_index_entry;
+
+/* Entry of the per-socket cache of unconnected UDP destinations: the
+ * destination, and those fields of ci_ip_cached_hdrs that the control
+ * plane resolved for it.  A whole ci_ip_cached_hdrs does not fit in an aux
+ * buffer with IPv6.  Only successful lookups are cached. */
+typedef struct {
+  oo_p            next;    /* next entry in the hash chain */
+  ci_addr_t       raddr;
+  ci_addr_t       laddr;
+  ci_addr_t       nexthop;
+  cicp_verinfo_t  fwd_ver;
+  cicp_verinfo_t  fwd_ver_init_net;
+  cicp_encap_t    encap;
+  ci_uint16       dport_be16;
+  ci_uint16       ether_type;
+  ci_mtu_t        mtu;
+  ci_ifid_t       ifindex;
+  ci_ifid_t       iif_ifindex;
+  ci_int16        intf_i;
+  ci_hwport_id_t  hwport;
+  ci_uint8        ether_offset;
+  ci_uint8        flags;
+  ci_uint8        ttl;
+  ci_uint8        ether_header[2 * ETH_ALEN + ETH_VLAN_HLEN];
+} ci_udp_dest_cache_entry;
+
+/* Hash table of a socket's cache of unconnected UDP destinations: chains
+ * of ci_udp_dest_cache_entry, hashed by remote address and port.  [cp] is
+ * the socket's [s.cp] that the entries were resolved with; the cache is
+ * flushed when that changes. */
+typedef struct {
+  oo_p            bucket[CI_CFG_UDP_DEST_CACHE_BUCKETS];
+  ci_uint32       n;
+  struct oo_sock_cplane cp;
+} ci_udp_dest_cache;
+
+/* Some of the blocks of a TCP re-order buffer in sequence order, kept in a
+ * ring so that delivering the head block is O(1).  See
+ * ci_tcp_rx_enqueue_ooo(). */
+typedef struct {
+  ci_uint32         seq[CI_CFG_TCP_ROB_INDEX_SIZE]; /**< block start seq */
+  oo_pkt_p          blk[CI_CFG_TCP_ROB_INDEX_SIZE]; /**< block first pkt */
+  ci_uint16         first;      /**< slot of the lowest block */
+  ci_uint16         n;          /**< number of indexed blocks */
+  ci_uint32         blocks;     /**< number of blocks in the ROB */
+} ci_tcp_rob_index;
+
+/* TCP state that only some connections use, kept out of ci_tcp_state. */
+typedef struct {
+  /* Private state of the congestion control algorithm selected by
+   * [c.cc_alg].  See tcp_cong.c. */
+  union {
+    struct oo_tcp_cubic {
+      ci_uint32        last_max_cwnd; /* W_max, in segments               */
+      ci_uint32        origin_point;  /* origin of the cubic curve, segs  */
+      ci_iptime_t      epoch_start;   /* start of epoch, 0 if none        */
+      ci_uint32        K;             /* time to reach W_max, in ms       */
+      ci_uint32        cnt;           /* acked segs per cwnd increment    */
+      ci_uint32        ack_bytes;     /* bytes acked for Reno estimate    */
+      ci_uint32        tcp_cwnd;      /* Reno-friendly cwnd, in segments  */
+      ci_uint32        last_cwnd;     /* cwnd (segs) when [cnt] computed  */
+      ci_iptime_t      last_time;     /* time when [cnt] computed         */
+      /* HyStart; times are in units of the usec clock */
+      ci_uint32        delay_min;     /* minimum RTT seen                 */
+      ci_uint32        curr_rtt;      /* minimum RTT of current round     */
+      ci_uint32        round_start;   /* start of current round           */
+      ci_uint32        last_ack;      /* time of last ACK in ack train    */
+      ci_uint32        end_seq;       /* snd_nxt at start of round        */
+      ci_uint8         sample_cnt;    /* RTT samples in current round     */
+      ci_uint8         found;         /* slow start exit point found      */
+    } cubic;
+    /* Rates are in CI_TCP_PACE_SHIFT units, times on the usec clock
+     * unless noted. */
+    struct oo_tcp_bbr {
+      ci_uint32        bw[2];         /* max delivery rate over the current
+                                       * and previous half of the window */
+      ci_uint32        pacing_rate;   /* rate given by the model          */
+      ci_uint32        min_rtt;       /* min RTT in window, ~0 if none    */
+      ci_iptime_t      min_rtt_stamp; /* when [min_rtt] set, in ticks     */
+      ci_uint32        rs_start;      /* start of current rate sample     */
+      ci_uint32        rs_una;        /* snd_una at start of rate sample  */
+      ci_uint32        round_end;     /* snd_nxt at start of round        */
+      ci_uint32        full_bw;       /* bw when full pipe last checked   */
+      ci_uint32        cycle_start;   /* start of gain cycle phase        */
+      ci_iptime_t      probe_rtt_done;/* end of PROBE_RTT in ticks, or 0  */
+      ci_uint32        prior_cwnd;    /* cwnd on entering PROBE_RTT       */
+      ci_uint16        rounds;        /* round trips counted              */
+      ci_uint8         mode;          /* CI_TCP_BBR_* in tcp_cong.c       */
+      ci_uint8         cycle_idx;     /* phase of PROBE_BW gain cycle     */
+      ci_uint8         full_bw_cnt;   /* rounds without bw growth         */
+      ci_uint8         flags;
+    } bbr;
+    struct oo_tcp_dctcp {
+      ci_uint32        alpha;         /* fraction of bytes marked, <<10   */
+      ci_uint32        acked;         /* bytes acked in this window       */
+      ci_uint32        acked_ce;      /* ... of which ECE was echoed      */
+      ci_uint32        window_end;    /* snd_nxt at start of window       */
+    } dctcp;
+  } cc;
+
+  /* RACK loss detection (RFC 8985), with EF_TCP_LOSS_DETECTION=rack.  Times
+   * are on the usec clock.  See tcp_rack.c. */
+  struct oo_tcp_rack {
+    ci_uint32          xmit_ts;       /* latest send time of a delivered
+                                       * segment                          */
+    ci_uint32          end_seq;       /* end_seq of that segment          */
+    ci_uint32          rtt;           /* RTT measured from that segment   */
+    ci_uint32          min_rtt;       /* minimum RTT seen, ~0 if none     */
+    ci_uint32          fack;          /* highest end_seq delivered        */
+    ci_uint32          dsack_round;   /* snd_nxt when reo_wnd last grown  */
+    ci_uint8           reo_wnd_mult;  /* reo_wnd in units of min_rtt/4    */
+    ci_uint8           reo_wnd_persist; /* recoveries until mult reset   */
+    ci_uint8           flags;
+# define CI_TCP_RACK_FLAG_VALID        0x1  /* [xmit_ts] etc. are set     */
+# define CI_TCP_RACK_FLAG_REORDER_SEEN 0x2  /* reordering was observed    */
+# define CI_TCP_RACK_FLAG_DSACK_ROUND  0x4  /* [dsack_round] is set       */
+  } rack;
+} ci_tcp_cc_state;
+
 /* This memory is cacheline-aligned for performance reasons. */
 #define CI_AUX_MEM_SIZE 128
 #define CI_AUX_HEADER_SIZE CI_CACHE_LINE_SIZE
@@ -2492,6 +2735,11 @@ typedef struct {
     ci_tcp_listen_bucket bucket;
     ci_sb_epoll_state    epoll;
     ci_pmtu_state_t      pmtus;
+    ci_udp_dest_cache_entry udp_dest;
+    ci_mcast_index_entry mcast;
+    ci_udp_dest_cache    udp_dest_table;
+    ci_tcp_rob_index     rob_index;
+    ci_tcp_cc_state      tcp_cc;
   } u;
 
   /* This is not a real member.  It just brings the sizeof(ci_ni_aux_mem)
@@ -2514,6 +2762,14 @@ typedef struct {
   ci_uint16            user_mss;            /* user-provided maximum MSS */
   ci_uint8             tcp_defer_accept;    /* TCP_DEFER_ACCEPT sockopt  */
 #define OO_TCP_DEFER_ACCEPT_OFF 0xff
+  ci_uint8             cc_alg;              /* TCP_CONGESTION sockopt:
+                                             * EF_TCP_CONGESTION_* */
+  ci_uint8             fastopen_connect;    /* TCP_FASTOPEN_CONNECT sockopt */
+  ci_uint32            fastopen_qlen;       /* TCP_FASTOPEN sockopt */
+  ci_uint32            notsent_lowat;       /* TCP_NOTSENT_LOWAT sockopt,
+                                             * 0 for no limit */
+  ci_uint64            max_pacing_rate CI_ALIGN(8); /* SO_MAX_PACING_RATE
+                                                     * in bytes/s */
 
 } ci_tcp_socket_cmn;
 
@@ -2528,6 +2784,9 @@ struct oo_tcp_socket_stats {
 #if CI_CFG_BURST_CONTROL
   ci_uint32  tx_stop_burst;   /* TX stopped by burst control       */
 #endif
+  ci_uint32  tx_stop_pace;    /* TX stopped by pacing              */
+  ci_uint32  rack_lost;       /* segments RACK marked lost         */
+  ci_uint32  tlp_probes;      /* tail loss probes sent             */
   ci_uint32  tx_nomac_defer;  /* Deferred send waiting for ARP     */
   ci_uint32  tx_defer;        /* Deferred send to avoid lock contention */
   ci_uint32  tx_msg_warm_abort;/* Number of MSG_WARM aborted early */
@@ -2608,6 +2867,28 @@ struct ci_tcp_state_s {
    * because packet allocation failed.  Must send FIN, really. */
 #define CI_TCPT_FLAG_FIN_PENDING        0x800000
 
+  /* ECN state, when CI_TCPT_FLAG_ECN has been negotiated.  ECE is set on
+   * segments we send while ECN_ECE is set, and CWR on the next new data
+   * segment when ECN_CWR is set.  ECN_REDUCED is set from a cwnd reduction
+   * until [ecn_cwr_seq] is acked. */
+#define CI_TCPT_FLAG_ECN_ECE            0x1000000
+#define CI_TCPT_FLAG_ECN_CWR            0x2000000
+#define CI_TCPT_FLAG_ECN_REDUCED        0x4000000
+
+  /* TCP Fast Open (RFC 7413).  FASTOPEN is set on a connecting socket
+   * whose SYN carries the Fast Open option, and on a synrecv whose SYN-ACK
+   * must carry a cookie.  FASTOPEN_DEFER is set on a socket that has
+   * connected with TCP_FASTOPEN_CONNECT and holds its SYN back until the
+   * first send.  FASTOPEN_DATA is set while a SYN carrying data is
+   * outstanding. */
+#define CI_TCPT_FLAG_FASTOPEN           0x8000000
+#define CI_TCPT_FLAG_FASTOPEN_DEFER     0x40000
+#define CI_TCPT_FLAG_FASTOPEN_DATA      0x40000000
+
+  /* Set while a small segment on the send queue is held back by
+   * EF_TCP_AUTOCORK until the previous segment's TX completion. */
+#define CI_TCPT_FLAG_AUTOCORK           0x10000000
+
   /* flags advertised on SYN */
 # define CI_TCPT_SYN_FLAGS \
         (CI_TCPT_FLAG_WSCL | CI_TCPT_FLAG_TSO | CI_TCPT_FLAG_SACK)
@@ -2642,6 +2923,9 @@ struct ci_tcp_state_s {
    * Does not include Ethernet header len any more! */
 
   ci_ip_pkt_queue     rob;        /**< Re-order buffer. */
+  /* ci_tcp_rob_index aux buffer indexing the blocks of [rob], or null.
+   * See ci_tcp_rx_enqueue_ooo(). */
+  oo_p                rob_index;
   oo_pkt_p            last_sack[CI_TCP_SACK_MAX_BLOCKS + 1];  
                                   /**< First packets of last-received
                                    * block (in [0]) and last-sent 
@@ -2749,12 +3033,29 @@ struct ci_tcp_state_s {
   ci_uint32            congrecover; /* snd_nxt when loss detected         */
   oo_pkt_p             retrans_ptr; /* next packet to retransmit          */
   ci_uint32            retrans_seq; /* seq of next packet to retransmit   */
+  oo_pkt_p             sack_hint;   /* SACKed pkt where last SACK was put */
+  ci_uint32            sack_hint_seq; /* start seq of [sack_hint]         */
 
   ci_uint32            cwnd;        /* congestion window                  */
   ci_uint32            cwnd_extra;  /* adjustments when congested         */
   ci_uint32            ssthresh;    /* slow-start threshold               */
   ci_uint32            bytes_acked; /* bytes acked but not yet added to cwnd */
-  
+
+  /* ci_tcp_cc_state aux buffer, while [c.cc_alg] or RACK needs it.  See
+   * ci_tcp_cc_state_alloc(). */
+  oo_p                 cc_state;
+
+
+  /* snd_nxt when cwnd was last reduced in response to ECN.  Valid while
+   * CI_TCPT_FLAG_ECN_REDUCED is set. */
+  ci_uint32            ecn_cwr_seq;
+
+  /* Software pacing: [pace_rate] is in bytes per usec clock tick, shifted
+   * by CI_TCP_PACE_SHIFT, or zero if the connection is not paced.
+   * [pace_next] is the usec clock time at which the next segment may go. */
+  ci_uint32            pace_rate;
+  ci_uint32            pace_next;
+
 #if CI_CFG_TCP_FASTSTART  
   ci_uint32            faststart_acks; /* Bytes to ack before leaving faststart */
 #endif
@@ -2852,6 +3153,8 @@ struct ci_tcp_state_s {
   ci_ip_timer          stats_tid;   /* Statistics report timer            */
 #endif
   ci_ip_timer          cork_tid;    /* TCP timer for TCP_CORK/MSG_MORE   */
+  ci_ip_timer          pace_tid;    /* software pacing timer              */
+  ci_ip_timer          rack_tid;    /* RACK reordering timer              */
 
 #if CI_CFG_TCP_OFFLOAD_RECYCLER
   /* Technically a timer, but it always has a single-tick expiry so we save
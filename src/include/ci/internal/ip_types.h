@@ -189,6 +189,7 @@ struct ci_netif_s {
   ci_tcp_prev_seq_t*   seq_table;
 
   struct oo_deferred_pkt* deferred_pkts;
+  oo_p*                mcast_index;  /* NULL without EF_UDP_MCAST_INDEX */
 
 #ifdef __ci_driver__
   unsigned             pkt_sets_n;
@@ -380,6 +381,17 @@ struct ci_netif_poll_state {
   oo_pkt_p  tx_pkt_free_list;
   oo_pkt_p* tx_pkt_free_list_insert;
   int       tx_pkt_free_list_n;
+
+  /* Software LRO: in-order segments of one TCP connection held back to be
+   * delivered together.  [lro_head] is the first segment, the rest are
+   * linked through [next] from [lro_rest] to [lro_tail]. */
+  ci_ip_pkt_fmt* lro_head;
+  ci_ip_pkt_fmt* lro_rest;
+  ci_ip_pkt_fmt* lro_tail;
+  ci_tcp_hdr*    lro_tcp;
+  int            lro_ip_paylen;
+  int            lro_n;
+  ci_uint32      lro_next_seq;
 };
 
 
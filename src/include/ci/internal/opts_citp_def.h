@@ -155,6 +155,36 @@ CI_CFG_OPT("EF_EPOLL_MT_SAFE", ul_epoll_mt_safe, ci_uint32,
 "EF_UL_EPOLL=2 and EF_EPOLL_CTL_FAST=1.",
            1, , 0, 0, 1, yesno)
 
+CI_CFG_OPT("EF_EPOLL_WAKE_ONE", ul_epoll_wake_one, ci_uint32,
+"When EF_UL_EPOLL=1 or 3 and several threads wait on the same epoll set, "
+"wake only one of them for each event, and let only one of them spin at a "
+"time while the others block.  This avoids waking every waiting thread "
+"for each event in applications with pools of worker threads."
+"\n"
+"Events are not partitioned between the waiters.  Each thread that is "
+"woken takes events from the epoll set's single ready list, so a "
+"level-triggered file descriptor may still be reported to more than one "
+"thread."
+"\n"
+"This behaviour is also turned on for an epoll set when a file descriptor is "
+"added to it with EPOLLEXCLUSIVE.",
+           1, , 0, 0, 1, yesno)
+
+CI_CFG_OPT("EF_EPOLL_OS_LT_USEC", ul_epoll_os_lt_usec, ci_uint32,
+"When EF_UL_EPOLL=1 or 3, Onload only checks non-accelerated file "
+"descriptors in an epoll set when the kernel notifies it that one of them "
+"has changed state.  Level-triggered file descriptors that were still ready "
+"after they were last reported have to be checked again, and if an "
+"epoll_wait() call has events on accelerated sockets to return, this option "
+"causes those file descriptors to be checked only every N usecs.  Changes of "
+"state are always checked at once, as are level-triggered file descriptors "
+"when there are no accelerated events."
+"\n"
+"This reduces the number of system calls in epoll_wait(), possibly at the "
+"expense of latency on non-accelerated file descriptors.  Set this option to "
+"zero to check them on every call.",
+           , , 32, MIN, MAX, time:usec)
+
 CI_CFG_OPT("EF_WODA_SINGLE_INTERFACE", woda_single_if, ci_uint32,
 "This option alters the behaviour of onload_ordered_epoll_wait().  This "
 "function would normally ensure correct ordering across multiple interfaces. "
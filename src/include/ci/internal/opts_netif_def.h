@@ -292,6 +292,44 @@ CI_CFG_OPT("EF_UDP_SEND_UNLOCKED", udp_send_unlocked, ci_uint32,
 "concurrency when multiple threads are performing UDP sends.",
            1, , 1, 0, 1, yesno)
 
+CI_CFG_OPT("EF_UDP_SEND_DEST_CACHE", udp_send_dest_cache, ci_uint32,
+"Maximum number of destinations for which each UDP socket keeps the "
+"headers resolved by the control plane for unconnected sends (sendto() "
+"and similar).  Sends that alternate between several destinations then "
+"avoid a control plane lookup for each datagram.  Entries are checked "
+"against the control plane version before use.  Each entry uses an aux "
+"buffer, as does the hash table of each socket that uses the cache.  0 "
+"disables the cache.",
+           16, , 0, 0, 4096, count)
+
+CI_CFG_OPT("EF_UDP_MCAST_INDEX", udp_mcast_index, ci_uint32,
+"Keep an index of the sockets that receive each UDP multicast group and "
+"port, so that received multicast datagrams are delivered without "
+"searching the software filter table.  This helps when many groups are "
+"joined and many sockets share ports.  IPv4 only.  Each index entry uses "
+"an aux buffer.",
+           1, , 1, 0, 1, yesno)
+
+CI_CFG_OPT("EF_IP_REASM", ip_reasm, ci_uint32,
+"Reassemble fragmented IPv4 UDP datagrams in the stack, so that they are "
+"delivered to Onload sockets without going through the kernel.  This only "
+"helps when every fragment is received by the stack, as with "
+"EF_SCALABLE_FILTERS or on NICs that share the receive queue with the "
+"kernel.  Fragments of a datagram that is not completed within "
+"EF_IP_REASM_TIMEOUT are passed to the kernel.",
+           1, , 0, 0, 1, yesno)
+
+CI_CFG_OPT("EF_IP_REASM_TIMEOUT", ip_reasm_timeout, ci_uint32,
+"Time to wait for the rest of a fragmented datagram (EF_IP_REASM) before "
+"passing the fragments received so far to the kernel.",
+           16, , 100, 1, 30000, time:msec)
+
+CI_CFG_OPT("EF_IP_REASM_MAX_FRACTION", ip_reasm_max_fraction, ci_uint32,
+"Limits the packet buffers held for IP reassembly (EF_IP_REASM) to "
+"EF_MAX_RX_PACKETS/(2^N), where N is specified here.  When the limit is "
+"reached the oldest incomplete datagrams are passed to the kernel.",
+           4, , 3, 1, 10, count)
+
 CI_CFG_OPT("EF_UNCONFINE_SYN", unconfine_syn, ci_uint32,
 "Accept TCP connections that cross into or out-of a private network.",
            1, , 1, 0, 1, yesno)
@@ -495,7 +533,12 @@ CI_CFG_OPT("EF_TCP_RCVBUF_MODE", tcp_rcvbuf_mode, ci_uint32,
 	   1, , 0, 0, 1, yesno)
 
 CI_CFG_OPT("EF_HIGH_THROUGHPUT_MODE", rx_merge_mode, ci_uint32,
-"This option causes onload to optimise for throughput at the cost of latency.",
+"This option causes onload to optimise for throughput at the cost of latency.  "
+"Among other things it enables software LRO: in-order IPv4 TCP segments of "
+"a connection that arrive in the same poll are delivered to the socket "
+"together, with a single state update and ACK decision.  The stack "
+"statistics tcp_lro_trains and tcp_lro_segs count merged deliveries and "
+"the segments within them.",
            1, , 0, 0, 1, yesno)
 
 CI_CFG_OPT("EF_TCP_TIME_WAIT_ASSASSINATION", time_wait_assassinate, ci_uint32,
@@ -677,9 +720,10 @@ CI_CFG_OPT("EF_TCP_SYN_OPTS", syn_opts, ci_uint32,
 "bit 0 (0x1) is set to 1 to enable PAWS and RTTM timestamps (RFC1323),\n"
 "bit 1 (0x2) is set to 1 to enable window scaling (RFC1323),\n"
 "bit 2 (0x4) is set to 1 to enable SACK (RFC2018),\n"
-"bit 3 (0x8) is set to 1 to enable ECN (RFC3128).\n"
+"bit 3 (0x8) is set to 1 to enable ECN (RFC3168).\n"
 "The values from /proc/sys/net/ipv4/tcp_{sack,timestamp,window_scaling} "
-"are used to find the default.",
+"are used to find the default, and ECN is enabled if "
+"/proc/sys/net/ipv4/tcp_ecn is 1.",
            4, , CI_TCPT_SYN_FLAGS, MIN, MAX, bitmask)
 
 CI_CFG_OPT("EF_TCP_ADV_WIN_SCALE_MAX", tcp_adv_win_scale_max, ci_uint32,
@@ -1267,6 +1311,68 @@ CI_CFG_OPT("EF_TCP_EARLY_RETRANSMIT", tcp_early_retransmit, ci_uint32,
 "the default.",
            1, , 1, 0, 1, yesno)
 
+#define EF_TCP_LOSS_DETECTION_DUPACK 0
+#define EF_TCP_LOSS_DETECTION_RACK   1
+CI_CFG_OPT("EF_TCP_LOSS_DETECTION", tcp_loss_detection, ci_uint32,
+"Selects how TCP detects lost segments on connections that use SACK.\n"
+"dupack - a segment is lost once three later segments have been SACKed or "
+"three duplicate ACKs received (RFC 6675), or sooner with "
+"EF_TCP_EARLY_RETRANSMIT.\n"
+"rack   - RACK-TLP (RFC 8985).  A segment is lost once a segment sent after "
+"it has been delivered and a reordering window has since passed, so "
+"reordering in the network does not trigger spurious retransmits.  Lost "
+"retransmissions are also detected without waiting for the retransmit "
+"timeout.  This also enables tail loss probes as EF_TAIL_DROP_PROBE.",
+           1, , EF_TCP_LOSS_DETECTION_DUPACK, 0, 1, oneof:dupack;rack)
+
+#define EF_TCP_CONGESTION_RENO  0
+#define EF_TCP_CONGESTION_CUBIC 1
+#define EF_TCP_CONGESTION_BBR   2
+#define EF_TCP_CONGESTION_DCTCP 3
+CI_CFG_OPT("EF_TCP_CONGESTION", tcp_cong_alg, ci_uint32,
+"Selects the default TCP congestion control algorithm for sockets in this "
+"stack.  It may be overridden per socket with the TCP_CONGESTION socket "
+"option.\n"
+"reno  - NewReno with Appropriate Byte Counting (RFC 3465).\n"
+"cubic - CUBIC (RFC 8312) with HyStart slow start exit.\n"
+"bbr   - BBR, which models the bottleneck bandwidth and round-trip time "
+"of the path and paces transmits in software at the modelled rate.\n"
+"dctcp - DCTCP (RFC 8257), which reduces cwnd in proportion to the "
+"fraction of ECN-marked segments.  Sockets using it negotiate ECN "
+"whether or not it is enabled in EF_TCP_SYN_OPTS.",
+           2, , EF_TCP_CONGESTION_RENO, 0, 3, oneof:reno;cubic;bbr;dctcp)
+
+#define EF_TCP_FASTOPEN_CLIENT 0x1
+#define EF_TCP_FASTOPEN_SERVER 0x2
+CI_CFG_OPT("EF_TCP_FASTOPEN", tcp_fastopen, ci_uint32,
+"A bitmask enabling TCP Fast Open (RFC 7413), which carries data in the "
+"SYN of a connection to a server that has previously handed out a cookie.\n"
+"bit 0 (0x1) is set to 1 to enable the client side: sendto() with "
+"MSG_FASTOPEN and the TCP_FASTOPEN_CONNECT socket option,\n"
+"bit 1 (0x2) is set to 1 to enable the server side on listening sockets "
+"that set the TCP_FASTOPEN socket option.\n"
+"The value from /proc/sys/net/ipv4/tcp_fastopen is used to find the default.",
+           2, , EF_TCP_FASTOPEN_CLIENT, 0, 3, bitmask)
+
+CI_CFG_OPT("EF_TCP_AUTOCORK", tcp_autocork, ci_uint32,
+"When enabled, a small send on a TCP socket with TCP_NODELAY is held back "
+"while the socket's previous segment is still waiting for transmit "
+"completion from the NIC.  Further small sends are added to the held "
+"segment, which is sent when that completion arrives.  This reduces the "
+"number of segments sent by applications that make many small writes, as "
+"Linux does with net.ipv4.tcp_autocorking.  Sockets without TCP_NODELAY "
+"already combine small sends with Nagle's algorithm.",
+           1, , 0, 0, 1, yesno)
+
+CI_CFG_OPT("EF_TCP_GSO", tcp_gso, ci_uint32,
+"When enabled, full-sized segments written to an established TCP socket "
+"in one send call are put on the send queue as super-segments of up to "
+"64KB, rather than as individual segments.  The headers of all but the "
+"first segment are not built until the super-segment is transmitted, when "
+"it is split back into MSS-sized packets.  This moves work out of the "
+"sending thread and shortens the send queue for bulk transfers.",
+           1, , 0, 0, 1, yesno)
+
 CI_CFG_OPT("EF_RFC_RTO_INITIAL", rto_initial, ci_iptime_t,
 "Initial retransmit timeout in milliseconds.  i.e. The number of "
 "milliseconds to wait for an ACK before retransmitting packets.",
@@ -314,6 +314,79 @@ OO_STAT("Number of tail-drop probes that were probably unnecessary.",
 OO_STAT("Number of tail-drop probes that probably recovered loss.",
         ci_uint32, tail_drop_probe_success, count)
 #endif
+OO_STAT("Number of segments marked lost by RACK loss detection.",
+        ci_uint32, tcp_rack_lost, count)
+OO_STAT("Number of lost retransmissions detected and resent by RACK.",
+        ci_uint32, tcp_rack_lost_retrans, count)
+OO_STAT("Number of times the RACK reordering timer expired.",
+        ci_uint32, tcp_rack_reo_timeouts, count)
+OO_STAT("Number of TCP data segments received with a Congestion Experienced "
+        "mark.",
+        ci_uint32, tcp_ecn_ce_rx, count)
+OO_STAT("Number of times a TCP sender reduced its congestion window in "
+        "response to ECN-Echo.",
+        ci_uint32, tcp_ecn_cwnd_reduced, count)
+OO_STAT("Number of TCP Fast Open cookies sent in SYN-ACKs in reply to a "
+        "cookie request or an invalid cookie.",
+        ci_uint32, tcp_fastopen_cookie_sent, count)
+OO_STAT("Number of TCP Fast Open SYNs whose data was accepted by a listening "
+        "socket.",
+        ci_uint32, tcp_fastopen_passive, count)
+OO_STAT("Number of TCP Fast Open SYNs with a valid cookie whose data was "
+        "not accepted because the accept queue was over the TCP_FASTOPEN "
+        "limit or no packet buffer was available.",
+        ci_uint32, tcp_fastopen_passive_fail, count)
+OO_STAT("Number of SYNs sent with data and a TCP Fast Open cookie.",
+        ci_uint32, tcp_fastopen_active, count)
+OO_STAT("Number of TCP Fast Open SYNs whose data was not acknowledged by "
+        "the SYN-ACK and had to be retransmitted.",
+        ci_uint32, tcp_fastopen_active_fail, count)
+OO_STAT("Number of times a small TCP send was held back by EF_TCP_AUTOCORK "
+        "until the previous segment completed transmission.",
+        ci_uint32, tcp_autocork_held, count)
+OO_STAT("Number of small TCP sends added to a segment held back by "
+        "EF_TCP_AUTOCORK, each saving a segment.",
+        ci_uint32, tcp_autocork_coalesced, count)
+OO_STAT("Number of TCP super-segments put on send queues by EF_TCP_GSO.",
+        ci_uint32, tcp_gso_super_segs, count)
+OO_STAT("Number of segments in TCP super-segments put on send queues by "
+        "EF_TCP_GSO.  Divide by tcp_gso_super_segs for the average size.",
+        ci_uint32, tcp_gso_segs, count)
+OO_STAT("Number of UDP sends split into several datagrams by UDP_SEGMENT.",
+        ci_uint32, udp_tx_gso_sends, count)
+OO_STAT("Number of datagrams sent by UDP sends split by UDP_SEGMENT.",
+        ci_uint32, udp_tx_gso_segs, count)
+OO_STAT("Number of UDP receives that returned several datagrams coalesced "
+        "by UDP_GRO.",
+        ci_uint32, udp_rx_gro_recvs, count)
+OO_STAT("Number of datagrams returned by UDP receives coalesced by UDP_GRO.",
+        ci_uint32, udp_rx_gro_segs, count)
+OO_STAT("Number of datagrams that recvmmsg() took straight from the receive "
+        "queue as part of a batch.",
+        ci_uint32, udp_rx_mmsg_batched, count)
+OO_STAT("Number of datagrams that sendmmsg() queued for DMA without ringing "
+        "the doorbell for each of them.",
+        ci_uint32, udp_tx_mmsg_batched, count)
+OO_STAT("Number of multicast UDP datagrams matched to sockets through the "
+        "multicast filter index rather than the software filter table.",
+        ci_uint32, udp_rx_mcast_index_lookups, count)
+OO_STAT("Number of IPv4 fragments held for reassembly in the stack "
+        "(EF_IP_REASM).",
+        ci_uint32, ip_reasm_frags, count)
+OO_STAT("Number of UDP datagrams reassembled from fragments in the stack.",
+        ci_uint32, ip_reasm_oks, count)
+OO_STAT("Number of incomplete datagrams whose fragments were passed to the "
+        "kernel after EF_IP_REASM_TIMEOUT.",
+        ci_uint32, ip_reasm_timeouts, count)
+OO_STAT("Number of incomplete datagrams whose fragments were passed to the "
+        "kernel to make room in the reassembly table.",
+        ci_uint32, ip_reasm_evictions, count)
+OO_STAT("Number of datagrams not reassembled because their fragments were "
+        "malformed or overlapped, or had a bad UDP checksum.",
+        ci_uint32, ip_reasm_fails, count)
+OO_STAT("Number of times HyStart ended slow start of a CUBIC connection "
+        "before any loss.",
+        ci_uint32, tcp_cubic_hystart_exits, count)
 OO_STAT("Number of times a connection has been reset while in accept queue; "
         "not yet a fully-connected socket.",
         ci_uint32, rst_recv_acceptq, count)
@@ -474,6 +547,14 @@ OO_STAT("Number of TCP segments received in-order when ROB is non-empty.  "
         "indicate a higher latency connection where packets had already "
         "been sent ahead of the re-ordering being detected.",
         ci_uint32, rx_rob_non_empty, count)
+OO_STAT("Number of times a TCP socket re-spaced the index of its re-order "
+        "buffer because too many blocks lay between indexed ones.",
+        ci_uint32, tcp_rob_index_rebuilds, count)
+OO_STAT("Number of merged deliveries made by TCP software LRO.",
+        ci_uint32, tcp_lro_trains, count)
+OO_STAT("Number of TCP segments delivered by software LRO as part of a "
+        "merged delivery.  Divide by tcp_lro_trains for the merge ratio.",
+        ci_uint32, tcp_lro_segs, count)
 OO_STAT("Number of TCP segments retransmited.",
         ci_uint32, retransmits, count)
 OO_STAT("Number of ACK packets not sent in response of invalid incoming TCP "
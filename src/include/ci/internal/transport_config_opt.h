@@ -156,6 +156,61 @@
 /* Default MSS value */
 #define CI_CFG_TCP_DEFAULT_MSS		536
 
+/* Number of remote hosts whose TCP Fast Open cookies are remembered by a
+ * stack.  Must be a power of 2. */
+#define CI_CFG_TCP_FASTOPEN_CACHE_SIZE	64
+
+/* Number of re-order buffer blocks a TCP socket indexes by sequence
+ * number.  Blocks between indexed ones are found by walking the block
+ * list.  Must be a power of 2, and the index must fit in an aux buffer. */
+#define CI_CFG_TCP_ROB_INDEX_SIZE	8
+
+/* Maximum number of TCP segments merged into one delivery by software LRO
+ * (EF_HIGH_THROUGHPUT_MODE). */
+#define CI_CFG_TCP_LRO_MAX_SEGS		32
+
+/* Maximum number of payload bytes in a TCP super-segment on the send queue
+ * (EF_TCP_GSO). */
+#define CI_CFG_TCP_GSO_MAX_BYTES	65535
+
+/* Maximum number of datagrams that one UDP_SEGMENT send is split into.
+ * This matches Linux's UDP_MAX_SEGMENTS. */
+#define CI_CFG_UDP_GSO_MAX_SEGS		64
+
+/* Maximum number of datagrams that one UDP_GRO receive coalesces. */
+#define CI_CFG_UDP_GRO_MAX_SEGS		64
+
+/* sendmmsg(): number of datagrams queued for DMA before the doorbell is
+ * rung, if the end of the batch has not been reached first. */
+#define CI_CFG_UDP_SENDMMSG_PUSH	32
+
+/* SO_TXTIME: a datagram whose launch time passed more than this many
+ * microseconds ago is dropped rather than sent. */
+#define CI_CFG_UDP_TXTIME_LATE_US	2000
+
+/* SO_TXTIME: launch times further than this many microseconds in the
+ * future are not held; the datagram is sent through the OS. */
+#define CI_CFG_UDP_TXTIME_HORIZON_US	10000000
+
+/* Number of hash buckets in the per-socket cache of unconnected UDP
+ * destinations (EF_UDP_SEND_DEST_CACHE).  Must be a power of 2, and small
+ * enough for the buckets to fit in an aux buffer. */
+#define CI_CFG_UDP_DEST_CACHE_BUCKETS	16
+
+/* Number of hash buckets in the per-stack index of UDP multicast filters
+ * (EF_UDP_MCAST_INDEX).  Must be a power of 2.  The buckets are only
+ * allocated in stacks that have the index enabled. */
+#define CI_CFG_MCAST_INDEX_BUCKETS	4096
+
+/* UDP feed arbitration: a sequence number this far behind the highest one
+ * delivered is taken as a restart of the feed rather than a duplicate. */
+#define CI_CFG_UDP_ARB_RESET		16384
+
+/* Number of IPv4 datagrams that can be reassembled from fragments at the
+ * same time, and the most fragments held for one of them (EF_IP_REASM). */
+#define CI_CFG_IP_REASM_SLOTS		16
+#define CI_CFG_IP_REASM_MAX_FRAGS	64
+
 /* How many RX descriptors to push at a time. */
 #define CI_CFG_RX_DESC_BATCH		16
 
@@ -604,8 +659,10 @@
 
 /* Size of socket shared state buffer.  Must be 1024 or 2048.  Larger
  * value is needed if you enable too many CI_CFG_* options, such as
- * CI_CFG_TCP_SOCK_STATS. */
+ * CI_CFG_TCP_SOCK_STATS.  A build profile may override it. */
+#ifndef CI_CFG_EP_BUF_SIZE
 #define CI_CFG_EP_BUF_SIZE              1024
+#endif
 
 #if CI_CFG_IPV6 && !CI_CFG_FAKE_IPV6
 #error "CI_CFG_FAKE_IPV6 should be enabled to support IPv6"
@@ -25,4 +25,8 @@
 #undef CI_CFG_TX_CRC_OFFLOAD
 #define CI_CFG_TX_CRC_OFFLOAD 1
 
+/* The plugin state leaves no room in ci_tcp_state for the congestion
+ * control state. */
+#define CI_CFG_EP_BUF_SIZE 2048
+
 #endif /* __CI_INTERNAL_TRANSPORT_CONFIG_OPT_CLOUD_H__ */
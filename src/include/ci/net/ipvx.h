@@ -420,6 +420,19 @@ ipx_hdr_tos_tclass(int af, const ci_ipx_hdr_t* hdr)
       hdr->ip4.ip_tos;
 }
 
+ci_inline void
+ipx_hdr_set_ecn(int af, ci_ipx_hdr_t* hdr, ci_uint8 ecn)
+{
+#if CI_CFG_IPV6
+  if( IS_AF_INET6(af) ) {
+    ci_ip6_set_tclass(&hdr->ip6,
+                      (ci_ip6_tclass(&hdr->ip6) & ~CI_IP_ECN_MASK) | ecn);
+    return;
+  }
+#endif
+  hdr->ip4.ip_tos = (hdr->ip4.ip_tos & ~CI_IP_ECN_MASK) | ecn;
+}
+
 ci_inline ci_addr_t
 ci_ipx_addr_xor(int af, ci_addr_t* a, ci_addr_t* b)
 {
@@ -83,14 +83,20 @@ struct oo_epoll1_block_on_arg {
 #define OO_EPOLL1_EVENT_ON_OTHER 2 /* OUT */
 #define OO_EPOLL1_HAS_SIGMASK    4 /* IN */
 #define OO_EPOLL1_EVENT_ON_EVQ   8 /* OUT */
+#define OO_EPOLL1_WAKE_ONE      16 /* IN: wait exclusively */
 };
 
 struct oo_epoll1_shared {
   ci_fixed_descriptor_t epfd; /**< OS epoll fd; UL should use it for
                                    closing only */
-  ci_uint32             flag; /**< seq << 1 | event */
+  ci_uint32             flag; /**< seq << 2 | lt | event */
+/* A kernel fd has changed state since the last OO_EPOLL1_IOC_WAIT, or that
+ * wait did not report everything that was ready because of maxevents. */
 #define OO_EPOLL1_FLAG_EVENT     1
-#define OO_EPOLL1_FLAG_SEQ_SHIFT 1
+/* Nothing has changed, but level-triggered fds reported by the last
+ * OO_EPOLL1_IOC_WAIT were still ready when it returned. */
+#define OO_EPOLL1_FLAG_LT        2
+#define OO_EPOLL1_FLAG_SEQ_SHIFT 2
 };
 
 #define OO_EPOLL_IOC_BASE 99
@@ -667,6 +667,42 @@ extern int
 onload_get_tcp_info(int fd, struct onload_tcp_info* info, int* len_in_out);
 
 
+/**********************************************************************
+ * onload_set_recv_arbitration: drop duplicates from redundant UDP feeds
+ *
+ * When the same messages are published on two or more feeds (for example
+ * "A" and "B" multicast lines) and a UDP socket receives all of them,
+ * Onload can deliver the first copy of each message and drop the others
+ * before they are queued on the socket.
+ *
+ * Each datagram must carry a sequence number at seq_offset bytes into the
+ * UDP payload, seq_len (2, 4 or 8) bytes long, in network byte order
+ * unless ONLOAD_RECV_ARB_LITTLE_ENDIAN is given.  Sequence numbers wrap
+ * at seq_len bytes.  A datagram whose sequence number has already been
+ * delivered is dropped.  One that fills a gap in the last 64 sequence
+ * numbers is delivered late; one that is older than that is dropped.  A
+ * sequence number that goes back by much more than that is taken to be a
+ * restart of the feed.  Datagrams too short to hold the sequence number
+ * are delivered as normal.  The counters are shown by onload_stackdump.
+ *
+ * Pass arb=NULL to turn arbitration off.
+ *
+ * Returns 0 on success, or -1 with errno set to EBADF if the fd is not
+ * an Onload fd, or EINVAL if it is not an accelerated UDP socket or the
+ * arguments are invalid.
+ */
+#define ONLOAD_RECV_ARB_LITTLE_ENDIAN 0x1
+
+struct onload_recv_arb {
+  uint16_t seq_offset;
+  uint8_t  seq_len;
+  uint8_t  flags;
+};
+
+extern int
+onload_set_recv_arbitration(int fd, const struct onload_recv_arb* arb);
+
+
 /**********************************************************************
  * onload_socket_nonaccel: create a non-accelerated socket
  *
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_HEADER >
+**  \brief  Onload handle-based socket API
+** </L5_PRIVATE>
+**
+** Send, receive and poll on an accelerated socket through a handle that
+** refers to the socket directly, rather than through its file descriptor.
+*//*
+\**************************************************************************/
+
+#ifndef __ONLOAD_EXTENSIONS_HANDLE_H__
+#define __ONLOAD_EXTENSIONS_HANDLE_H__
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Each intercepted socket call looks the file descriptor up in Onload's
+ * table, dispatches through the socket type's operations and saves and
+ * restores errno.  The functions here skip all of that: a handle is
+ * obtained for a socket once, and the calls made on it go straight to the
+ * TCP or UDP implementation.
+ *
+ * Calls on a handle behave as the corresponding socket calls on its file
+ * descriptor, including blocking, except that they return a negative
+ * errno value on failure and leave errno unchanged.
+ *
+ * A handle keeps the socket alive until it is closed with
+ * onload_h_close(), even if the file descriptor is closed first.  Calls
+ * on the handle then fail with -EBADF.  A handle must not be used after
+ * onload_h_close().
+ */
+typedef struct onload_h_sock* onload_h;
+
+
+/* Gets a handle for fd, which must be an accelerated TCP or UDP socket.
+ *
+ * Returns zero on success, or <0 to indicate an error.
+ */
+extern int onload_h_open(int fd, onload_h* h_out);
+
+/* Releases a handle.  The file descriptor is not closed.
+ *
+ * Returns zero on success, or <0 to indicate an error.
+ */
+extern int onload_h_close(onload_h h);
+
+/* As send(), sendmsg(), recv() and recvmsg(). */
+extern ssize_t onload_h_send(onload_h h, const void* buf, size_t len,
+                             int flags);
+extern ssize_t onload_h_sendmsg(onload_h h, const struct msghdr* msg,
+                                int flags);
+extern ssize_t onload_h_recv(onload_h h, void* buf, size_t len, int flags);
+extern ssize_t onload_h_recvmsg(onload_h h, struct msghdr* msg, int flags);
+
+/* Waits for any of the poll() events in events, or an error or hangup,
+ * for up to timeout_ms milliseconds.  A negative timeout waits
+ * indefinitely.  Waiting busy-polls the socket's stack for EF_SPIN_USEC
+ * if EF_POLL_SPIN is set, as poll() does, and then blocks.
+ *
+ * Returns the events that are ready, zero on timeout, or <0 to indicate
+ * an error.  Returns -EINTR if a signal arrives while waiting.
+ */
+extern int onload_h_poll(onload_h h, short events, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ONLOAD_EXTENSIONS_HANDLE_H__ */
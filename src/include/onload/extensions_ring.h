@@ -0,0 +1,226 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_HEADER >
+**  \brief  Onload submission/completion ring API
+** </L5_PRIVATE>
+**
+** Lets an application queue socket operations on many sockets and have
+** Onload run them in batches, without going through the intercepted
+** socket calls for each one.
+*//*
+\**************************************************************************/
+
+#ifndef __ONLOAD_EXTENSIONS_RING_H__
+#define __ONLOAD_EXTENSIONS_RING_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/******************************************************************************
+ * Overview
+ ******************************************************************************/
+
+/* A ring is bound to one Onload stack and holds two queues shared between
+ * the application and Onload: a submission queue of operations and a
+ * completion queue of their results.
+ *
+ * The application registers the sockets it will use with
+ * onload_ring_register_fds() and refers to them in submissions by the
+ * index of their registration.  It obtains submission queue entries with
+ * onload_ring_get_sqe(), fills them in, and calls onload_ring_enter() to
+ * have Onload start the operations.  Operations that can be done at once
+ * complete there; the rest are retried each time the application enters
+ * the ring, after the stack has been polled once for all of them.  Results
+ * are read with onload_ring_peek_cqe() and released with
+ * onload_ring_cqe_seen().
+ *
+ * What a ring saves is the cost of the intercepted calls: the fd lookup
+ * and the library entry for each operation, and a stack poll for each
+ * wait.  Each operation still runs through the socket's own send or
+ * receive path, which takes the stack lock as an ordinary call would.  The
+ * lock is not held across a batch.
+ *
+ * Operations on the same socket in the same direction (sends, or receives
+ * and accepts) complete in the order they were submitted.  There is no
+ * ordering between sockets, or between sends and receives.
+ *
+ * A ring must not be used by more than one thread at a time.  Sockets
+ * registered with a ring should not be used through other calls while
+ * ring operations on them are outstanding.
+ */
+
+
+/******************************************************************************
+ * Queue entries
+ ******************************************************************************/
+
+enum onload_ring_op {
+  ONLOAD_RING_OP_NOP = 0,
+  /* Send len bytes from buf.  Completes with the number of bytes sent,
+   * which may be less than len for a stream socket. */
+  ONLOAD_RING_OP_SEND,
+  /* Receive up to len bytes into buf.  Completes with the number of
+   * bytes received. */
+  ONLOAD_RING_OP_RECV,
+  /* As SEND and RECV, taking a struct msghdr* in msg. */
+  ONLOAD_RING_OP_SENDMSG,
+  ONLOAD_RING_OP_RECVMSG,
+  /* Accept a connection on a listening socket, as accept4(), filling in
+   * addr and addrlen if they are not NULL.  msg_flags are the accept4()
+   * flags.  Completes with the new file descriptor. */
+  ONLOAD_RING_OP_ACCEPT,
+  /* Connect to the addrlen bytes of address at addr.  Completes with 0
+   * once the connection is established. */
+  ONLOAD_RING_OP_CONNECT,
+};
+
+struct onload_ring_sqe {
+  uint8_t  opcode;         /* enum onload_ring_op */
+  uint8_t  flags;          /* must be zero */
+  uint16_t reserved;
+  /* Index of a socket registered with onload_ring_register_fds() */
+  uint32_t fd_index;
+  union {
+    void*            buf;
+    struct msghdr*   msg;
+    struct sockaddr* addr;
+    uint64_t         addr_u64;
+  };
+  union {
+    uint32_t         len;
+    uint32_t         addrlen;
+  };
+  /* MSG_* flags for SEND and RECV, SOCK_* flags for ACCEPT */
+  int32_t  msg_flags;
+  union {
+    uint32_t*        accept_addrlen;  /* socklen_t* for ACCEPT */
+    uint64_t         addr2_u64;
+  };
+  /* Passed back unchanged in the completion */
+  uint64_t user_data;
+};
+
+struct onload_ring_cqe {
+  uint64_t user_data;
+  /* Result of the operation on success, or a negative errno value */
+  int32_t  res;
+  uint32_t flags;
+};
+
+
+/******************************************************************************
+ * Ring
+ ******************************************************************************/
+
+struct onload_ring_queue_sq {
+  struct onload_ring_sqe* sqes;
+  /* Onload advances head as it takes entries, and the application
+   * advances tail as it adds them. */
+  unsigned head;
+  unsigned tail;
+  unsigned mask;
+};
+
+struct onload_ring_queue_cq {
+  struct onload_ring_cqe* cqes;
+  /* The application advances head as it consumes entries, and Onload
+   * advances tail as it adds them. */
+  unsigned head;
+  unsigned tail;
+  unsigned mask;
+};
+
+struct onload_ring_priv;
+
+struct onload_ring {
+  struct onload_ring_queue_sq sq;
+  struct onload_ring_queue_cq cq;
+  struct onload_ring_priv* priv;
+};
+
+
+/* Sets up a ring bound to the stack of fd, which can be any accelerated
+ * socket on that stack.  entries is the size of the submission queue and
+ * must be a power of two; the completion queue is twice as large, and at
+ * most entries operations may be outstanding.  flags must be zero.
+ *
+ * Returns zero on success, or <0 to indicate an error.
+ */
+extern int onload_ring_init(int fd, unsigned entries, unsigned flags,
+                            struct onload_ring* ring);
+
+/* Tears down a ring.  Operations that have not completed are abandoned,
+ * and references to registered sockets are dropped.
+ *
+ * Returns zero on success, or <0 to indicate an error.
+ */
+extern int onload_ring_free(struct onload_ring* ring);
+
+/* Registers n_fds sockets for use with the ring.  They must be accelerated
+ * TCP or UDP sockets in the ring's stack.  Their file status flags are
+ * left as they are: ring operations never block, whatever the socket's
+ * mode.  The ring keeps a reference to each socket until it is freed.
+ * Once a registered socket is closed, operations on it complete with
+ * -EBADF.
+ *
+ * Returns the index given to fds[0], the others following in order, or
+ * <0 to indicate an error, in which case none are registered.
+ */
+extern int onload_ring_register_fds(struct onload_ring* ring,
+                                    const int* fds, int n_fds);
+
+/* Starts operations added to the submission queue, retries those still
+ * outstanding, and waits until at least min_complete completions are
+ * available or timeout_ms milliseconds have passed.  A negative timeout
+ * waits indefinitely.  Waiting spins on the ring's stack for as long as
+ * poll() would (see EF_SPIN_USEC and EF_POLL_SPIN), and then blocks.
+ *
+ * Returns the number of completions available, which may be fewer than
+ * min_complete if no operations are outstanding, or <0 to indicate an
+ * error.  Returns -EINTR if a signal arrives while waiting with no
+ * completions available.
+ */
+extern int onload_ring_enter(struct onload_ring* ring, unsigned min_complete,
+                             int timeout_ms);
+
+
+/* Returns a zeroed submission queue entry to fill in, or NULL if the
+ * submission queue is full. */
+static inline struct onload_ring_sqe*
+onload_ring_get_sqe(struct onload_ring* ring)
+{
+  struct onload_ring_sqe* sqe;
+  if( ring->sq.tail - ring->sq.head > ring->sq.mask )
+    return NULL;
+  sqe = &ring->sq.sqes[ring->sq.tail++ & ring->sq.mask];
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+/* Returns the oldest completion, or NULL if there are none. */
+static inline struct onload_ring_cqe*
+onload_ring_peek_cqe(struct onload_ring* ring)
+{
+  if( ring->cq.head == ring->cq.tail )
+    return NULL;
+  return &ring->cq.cqes[ring->cq.head & ring->cq.mask];
+}
+
+/* Releases the completion returned by onload_ring_peek_cqe(). */
+static inline void
+onload_ring_cqe_seen(struct onload_ring* ring)
+{
+  ++ring->cq.head;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ONLOAD_EXTENSIONS_RING_H__ */
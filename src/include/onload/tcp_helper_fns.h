@@ -402,7 +402,10 @@ efab_tcp_helper_ready_list_wakeup(tcp_helper_resource_t* trs,
 #if CI_CFG_EPOLL3
   ci_atomic32_and(&trs->netif.state->ready_list_flags[ready_list],
                   ~CI_NI_READY_LIST_FLAG_WAKE);
-  ci_waitable_wakeup_all(&trs->ready_list_waitqs[ready_list]);
+  /* Wakes all ordinary waiters, but only one of those waiting with
+   * OO_EPOLL1_WAKE_ONE.  The ready list itself is shared by all the
+   * waiters, and is not partitioned between them. */
+  ci_waitable_wakeup_one(&trs->ready_list_waitqs[ready_list]);
 #endif
 }
 
@@ -78,8 +78,13 @@ ci_tcp_poll_events_nolisten(ci_netif *ni, ci_tcp_state *ts)
       revents |= POLLIN | POLLRDNORM;
 
   }
-  else if( ts->s.b.state == CI_TCP_SYN_SENT )
-    revents = 0;
+  else if( ts->s.b.state == CI_TCP_SYN_SENT ) {
+    /* A deferred Fast Open connect is waiting for data to send. */
+    if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER )
+      revents = POLLOUT | POLLWRNORM;
+    else
+      revents = 0;
+  }
 
   return revents;
 }
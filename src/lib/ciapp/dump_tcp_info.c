@@ -66,6 +66,14 @@ void ci_dump_tcp_info(ci_log_fn_t l, const struct ci_tcp_info* i)
   dump(tcpi_rcv_rtt);
   dump(tcpi_rcv_space);
   dump(tcpi_total_retrans);
+
+#define dump64(x)  do {                                               \
+    snprintf(s, sizeof(s), "%20s: %llu", #x, (unsigned long long) i->x); \
+    l(s);                                                             \
+  } while(0)
+
+  dump64(tcpi_pacing_rate);
+  dump64(tcpi_max_pacing_rate);
 }
 
 #endif
@@ -75,6 +75,8 @@ static int efab_file_move_supported_tcp(ci_netif *ni, ci_tcp_state *ts,
       ci_ip_timer_pending(ni, &ts->rto_tid) ||
       ci_ip_timer_pending(ni, &ts->zwin_tid) ||
       ci_ip_timer_pending(ni, &ts->cork_tid) ||
+      ci_ip_timer_pending(ni, &ts->pace_tid) ||
+      ci_ip_timer_pending(ni, &ts->rack_tid) ||
       OO_PP_NOT_NULL(ts->pmtus) ) {
     if( do_assert ) {
       ci_assert(ci_ip_queue_is_empty(&ts->send));
@@ -84,6 +86,8 @@ static int efab_file_move_supported_tcp(ci_netif *ni, ci_tcp_state *ts,
       ci_assert(! ci_ip_timer_pending(ni, &ts->rto_tid));
       ci_assert(! ci_ip_timer_pending(ni, &ts->zwin_tid));
       ci_assert(! ci_ip_timer_pending(ni, &ts->cork_tid));
+      ci_assert(! ci_ip_timer_pending(ni, &ts->pace_tid));
+      ci_assert(! ci_ip_timer_pending(ni, &ts->rack_tid));
       ci_assert(OO_PP_IS_NULL(ts->pmtus));
     }
     return false;
@@ -132,13 +136,15 @@ static int efab_file_move_supported_udp(ci_netif *ni, ci_udp_state *us,
   if( ci_udp_recv_q_not_empty(&us->recv_q) ||
       us->zc_kernel_datagram != OO_PP_ID_NULL ||
       us->zc_kernel_datagram_count != 0 ||
-      us->tx_count != 0 || us->tx_async_q != CI_ILL_END ) {
+      us->tx_count != 0 || us->tx_async_q != CI_ILL_END ||
+      OO_PP_NOT_NULL(us->txtime_head) ) {
     if( do_assert ) {
       ci_assert(! ci_udp_recv_q_not_empty(&us->recv_q));
       ci_assert_equal(us->zc_kernel_datagram, OO_PP_ID_NULL);
       ci_assert_equal(us->zc_kernel_datagram_count, 0);
       ci_assert_equal(us->tx_count, 0);
       ci_assert_equal(us->tx_async_q, CI_ILL_END);
+      ci_assert(OO_PP_IS_NULL(us->txtime_head));
     }
     return false;
   }
@@ -343,6 +349,16 @@ int efab_file_move_to_alien_stack(ci_private_t *priv, ci_netif *alien_ni,
     mid_ts->zwin_tid = new_ts->zwin_tid;
     mid_ts->kalive_tid = new_ts->kalive_tid;
     mid_ts->cork_tid = new_ts->cork_tid;
+    mid_ts->pace_tid = new_ts->pace_tid;
+    mid_ts->rack_tid = new_ts->rack_tid;
+    /* The ROB is dropped below, and its index is an aux buffer of the old
+     * stack.  So is the congestion control state, which is copied. */
+    mid_ts->rob_index = OO_P_NULL;
+    mid_ts->cc_state = OO_P_NULL;
+    if( OO_P_NOT_NULL(SOCK_TO_TCP(old_s)->cc_state) &&
+        ci_tcp_cc_state_alloc(alien_ni, mid_ts) )
+      *ci_tcp_cc(alien_ni, mid_ts) = *ci_tcp_cc(&old_thr->netif,
+                                                SOCK_TO_TCP(old_s));
 #if CI_CFG_TCP_SOCK_STATS
     mid_ts->stats_tid = new_ts->stats_tid;
 #endif
@@ -375,6 +391,9 @@ int efab_file_move_to_alien_stack(ci_private_t *priv, ci_netif *alien_ni,
   else {
     ci_udp_state *mid_us = SOCK_TO_UDP(mid_s);
 
+    mid_us->txtime_tid = SOCK_TO_UDP(new_s)->txtime_tid;
+    /* The destination cache is aux buffers of the old stack. */
+    mid_us->dest_cache = OO_P_NULL;
     *SOCK_TO_UDP(new_s) = *mid_us;
     CI_FREE_OBJ(mid_us);
   }
@@ -1187,7 +1187,7 @@ efab_os_wakeup_epoll3_locked(tcp_helper_resource_t* trs,
     oo_p_dllink_del(ni, link);
     oo_p_dllink_add_tail(ni, oo_p_dllink_ptr(ni, &ni->state->ready_lists[i]),
                          link);
-    ci_waitable_wakeup_all(&trs->ready_list_waitqs[i]);
+    ci_waitable_wakeup_one(&trs->ready_list_waitqs[i]);
   }
 
   tcp_helper_defer_dl2work(trs, OO_THR_AFLAG_UNLOCK_TRUSTED);
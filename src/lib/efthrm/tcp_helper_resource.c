@@ -319,7 +319,7 @@ oo_trusted_lock_drop(tcp_helper_resource_t* trs,
         if( ! oo_p_dllink_is_empty(&trs->netif,
                 oo_p_dllink_ptr(&trs->netif,
                                 &trs->netif.state->ready_lists[i])) )
-          ci_waitable_wakeup_all(&trs->ready_list_waitqs[i]);
+          ci_waitable_wakeup_one(&trs->ready_list_waitqs[i]);
       }
 #endif
 
@@ -2247,6 +2247,7 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
   int no_seq_table_entries;
   unsigned vi_state_bytes;
   unsigned dma_addrs_bytes;
+  unsigned mcast_index_bytes;
 #if CI_CFG_PIO
   unsigned pio_bufs_ofs = 0;
 #endif
@@ -2333,6 +2334,9 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
   ip6_filter_table_size = sizeof(ci_ip6_netif_filter_table) +
     sizeof(ci_ip6_netif_filter_table_entry) * (no_table_entries - 1);
 #endif
+  /* The multicast index is only there if it is wanted. */
+  mcast_index_bytes = NI_OPTS(ni).udp_mcast_index ?
+                      sizeof(oo_p) * CI_CFG_MCAST_INDEX_BUCKETS : 0;
 
   /* Allocate shmbuf for netif state.  When calculating the size, it's
    * important that the sizes of the sub-buffers are accumulated in the order
@@ -2363,6 +2367,8 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
   sz += sizeof(ci_tcp_prev_seq_t) * no_seq_table_entries;
   sz = CI_ROUND_UP(sz, __alignof__(struct oo_deferred_pkt));
   sz += sizeof(struct oo_deferred_pkt) * NI_OPTS(ni).defer_arp_pkts;
+  sz = CI_ROUND_UP(sz, __alignof__(oo_p));
+  sz += mcast_index_bytes;
   sz = CI_ROUND_UP(sz, __alignof__(ci_netif_filter_table));
   sz += filter_table_size;
   sz = CI_ROUND_UP(sz, __alignof__(ci_netif_filter_table_entry_ext));
@@ -2478,6 +2484,10 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
   ns->deferred_pkts_ofs = ns_ofs;
   ns_ofs += sizeof(struct oo_deferred_pkt) * NI_OPTS(ni).defer_arp_pkts;
 
+  ns_ofs = CI_ROUND_UP(ns_ofs, __alignof__(oo_p));
+  ns->mcast_index_ofs = ns_ofs;
+  ns_ofs += mcast_index_bytes;
+
   ns_ofs = CI_ROUND_UP(ns_ofs, __alignof__(ci_netif_filter_table));
   ns->table_ofs = ns_ofs;
   ns_ofs += filter_table_size;
@@ -2515,6 +2525,8 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
 #endif
   ni->seq_table = (void*) ((char*) ns + ns->seq_table_ofs);
   ni->deferred_pkts = (void*) ((char*) ns + ns->deferred_pkts_ofs);
+  ni->mcast_index = mcast_index_bytes == 0 ? NULL :
+                    (void*) ((char*) ns + ns->mcast_index_ofs);
   ni->filter_table = (void*) ((char*) ns + ns->table_ofs);
   ni->filter_table_ext = (void*) ((char*) ns + ns->table_ext_ofs);
 
@@ -2546,6 +2558,11 @@ allocate_netif_resources(ci_resource_onload_alloc_t* alloc,
   ns->max_aux_bufs[CI_TCP_AUX_TYPE_BUCKET] = ni->opts.max_ep_bufs;
   ns->max_aux_bufs[CI_TCP_AUX_TYPE_EPOLL] = ni->opts.max_ep_bufs;
   ns->max_aux_bufs[CI_TCP_AUX_TYPE_PMTUS] = ni->opts.max_ep_bufs;
+  ns->max_aux_bufs[CI_TCP_AUX_TYPE_UDP_DEST] = ni->opts.max_ep_bufs;
+  ns->max_aux_bufs[CI_TCP_AUX_TYPE_MCAST] = ni->opts.max_ep_bufs;
+  ns->max_aux_bufs[CI_TCP_AUX_TYPE_UDP_DEST_TABLE] = ni->opts.max_ep_bufs;
+  ns->max_aux_bufs[CI_TCP_AUX_TYPE_ROB_INDEX] = ni->opts.max_ep_bufs;
+  ns->max_aux_bufs[CI_TCP_AUX_TYPE_TCP_CC] = ni->opts.max_ep_bufs;
 
   /* The shared netif-state buffer and EP buffers are part of the mem mmap */
   trs->mem_mmap_bytes += ns->netif_mmap_bytes;
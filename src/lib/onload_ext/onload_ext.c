@@ -16,6 +16,8 @@
 #include <onload/extensions.h>
 #include <onload/extensions_zc.h>
 #include <onload/extensions_zc_hlrx.h>
+#include <onload/extensions_ring.h>
+#include <onload/extensions_handle.h>
 
 unsigned int onload_ext_version[] = 
   {ONLOAD_EXT_VERSION_MAJOR,
@@ -333,6 +335,89 @@ onload_get_tcp_info(int fd, struct onload_tcp_info* info, int* len_in_out)
   return -1;
 }
 
+__attribute__((weak))
+int
+onload_set_recv_arbitration(int fd, const struct onload_recv_arb* arb)
+{
+  errno = EINVAL;
+  return -1;
+}
+
+/**************************************************************************/
+
+__attribute__((weak))
+int onload_ring_init(int fd, unsigned entries, unsigned flags,
+                     struct onload_ring* ring)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+int onload_ring_free(struct onload_ring* ring)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+int onload_ring_register_fds(struct onload_ring* ring,
+                             const int* fds, int n_fds)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+int onload_ring_enter(struct onload_ring* ring, unsigned min_complete,
+                      int timeout_ms)
+{
+  return -ENOSYS;
+}
+
+/**************************************************************************/
+
+__attribute__((weak))
+int onload_h_open(int fd, onload_h* h_out)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+int onload_h_close(onload_h h)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+ssize_t onload_h_send(onload_h h, const void* buf, size_t len, int flags)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+ssize_t onload_h_sendmsg(onload_h h, const struct msghdr* msg, int flags)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+ssize_t onload_h_recv(onload_h h, void* buf, size_t len, int flags)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+ssize_t onload_h_recvmsg(onload_h h, struct msghdr* msg, int flags)
+{
+  return -ENOSYS;
+}
+
+__attribute__((weak))
+int onload_h_poll(onload_h h, short events, int timeout_ms)
+{
+  return -ENOSYS;
+}
+
+/**************************************************************************/
+
 __attribute__((weak))
 int
 onload_socket_nonaccel(int domain, int type, int protocol)
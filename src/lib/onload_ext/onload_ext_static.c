@@ -15,6 +15,8 @@
 #include <onload/extensions.h>
 #include <onload/extensions_zc.h>
 #include <onload/extensions_zc_hlrx.h>
+#include <onload/extensions_ring.h>
+#include <onload/extensions_handle.h>
 #include <dlfcn.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -259,6 +261,45 @@ wrap_with_errno(int, onload_get_tcp_info,
                 (int fd, struct onload_tcp_info* info, int* len),
                 (fd, info, len), -1, EINVAL)
 
+wrap_with_errno(int, onload_set_recv_arbitration,
+                (int fd, const struct onload_recv_arb* arb),
+                (fd, arb), -1, EINVAL)
+
+wrap(int, onload_ring_init, (int fd, unsigned entries, unsigned flags,
+                             struct onload_ring* ring),
+     (fd, entries, flags, ring), -ENOSYS)
+
+wrap(int, onload_ring_free, (struct onload_ring* ring), (ring), -ENOSYS)
+
+wrap(int, onload_ring_register_fds, (struct onload_ring* ring,
+                                     const int* fds, int n_fds),
+     (ring, fds, n_fds), -ENOSYS)
+
+wrap(int, onload_ring_enter, (struct onload_ring* ring,
+                              unsigned min_complete, int timeout_ms),
+     (ring, min_complete, timeout_ms), -ENOSYS)
+
+wrap(int, onload_h_open, (int fd, onload_h* h_out), (fd, h_out), -ENOSYS)
+
+wrap(int, onload_h_close, (onload_h h), (h), -ENOSYS)
+
+wrap(ssize_t, onload_h_send, (onload_h h, const void* buf, size_t len,
+                              int flags),
+     (h, buf, len, flags), -ENOSYS)
+
+wrap(ssize_t, onload_h_sendmsg, (onload_h h, const struct msghdr* msg,
+                                 int flags),
+     (h, msg, flags), -ENOSYS)
+
+wrap(ssize_t, onload_h_recv, (onload_h h, void* buf, size_t len, int flags),
+     (h, buf, len, flags), -ENOSYS)
+
+wrap(ssize_t, onload_h_recvmsg, (onload_h h, struct msghdr* msg, int flags),
+     (h, msg, flags), -ENOSYS)
+
+wrap(int, onload_h_poll, (onload_h h, short events, int timeout_ms),
+     (h, events, timeout_ms), -ENOSYS)
+
 wrap_with_fn(int, onload_socket_nonaccel,
              (int domain, int type, int protocol),
              (domain, type, protocol), socket)
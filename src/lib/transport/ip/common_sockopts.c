@@ -43,6 +43,7 @@
 #ifndef __KERNEL__
 #include <limits.h>
 #include <net/if.h>
+#include <netinet/tcp.h>
 
 /* Emulate Linux mapping between priority and TOS field */
 #include <linux/types.h>
@@ -1880,6 +1881,12 @@ int ci_setsockopt_os_fail_ignore(ci_netif* ni, ci_sock_cmn* s, int err,
            optname == ONLOAD_TCP_OFFLOAD && optlen >= sizeof(int) )
     return 1;
 #endif
+  /* The kernel may not have the congestion control module loaded, but we
+   * implement the algorithm ourselves. */
+  else if( s->b.state & CI_TCP_STATE_TCP && level == IPPROTO_TCP &&
+           optname == TCP_CONGESTION && err == ENOENT &&
+           ci_tcp_cong_find(optval, strnlen(optval, optlen)) >= 0 )
+    return 1;
   return 0;
 }
 
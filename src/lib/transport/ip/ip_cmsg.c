@@ -15,6 +15,11 @@
 
 #include "ip_internal.h"
 #include <ci/internal/ip_timestamp.h>
+#ifdef __KERNEL__
+#include <linux/udp.h>
+#else
+#include <netinet/udp.h>
+#endif
 
 
 #define LPF "IP CMSG "
@@ -384,9 +389,13 @@ void ci_ip_cmsg_finish(struct cmsg_state* cmsg_state)
 /**
  * Fill in the msg ancillary data buffer with all control messages
  * according to cmsg_flags the user has set beforehand.
+ *
+ * [gro_size] is the size of the datagrams coalesced by UDP_GRO into this
+ * receive, or 0 if there was no coalescing.
  */
 void ci_ip_cmsg_recv(ci_netif* ni, ci_udp_state* us, const ci_ip_pkt_fmt *pkt,
-                     struct msghdr *msg, int netif_locked, int *p_msg_flags)
+                     struct msghdr *msg, int netif_locked, int *p_msg_flags,
+                     int gro_size)
 {
   unsigned flags = us->s.cmsg_flags;
   struct cmsg_state cmsg_state;
@@ -400,6 +409,11 @@ void ci_ip_cmsg_recv(ci_netif* ni, ci_udp_state* us, const ci_ip_pkt_fmt *pkt,
   if( pkt->flags & CI_PKT_FLAG_INDIRECT )
     pkt = PKT_CHK_NML(ni, pkt->frag_next, netif_locked);
 
+#ifdef UDP_GRO
+  if( gro_size != 0 )
+    ci_put_cmsg(&cmsg_state, SOL_UDP, UDP_GRO, sizeof(gro_size), &gro_size);
+#endif
+
   if( (af == AF_INET) && (flags & CI_IP_CMSG_PKTINFO) ) {
     ++us->stats.n_rx_pktinfo;
     ip_cmsg_recv_pktinfo(ni, us, pkt, af, &cmsg_state);
@@ -443,8 +457,11 @@ void ci_ip_cmsg_recv(ci_netif* ni, ci_udp_state* us, const ci_ip_pkt_fmt *pkt,
  *
  * \param info_out    Must be a valid pointer. Contains a pointer to
  * struct in_pktinfo or struct in6_pktinfo.
+ * \param gso_size_out  Must be a valid pointer. Set to the segment size
+ * given by a UDP_SEGMENT control message, and not changed otherwise.
  */
-int ci_ip_cmsg_send(const struct msghdr* msg, void** info_out)
+int ci_ip_cmsg_send(const struct msghdr* msg, void** info_out,
+                    ci_uint16* gso_size_out, ci_uint64* txtime_out)
 {
   struct cmsghdr *cmsg;
 
@@ -470,6 +487,26 @@ int ci_ip_cmsg_send(const struct msghdr* msg, void** info_out)
         return -EINVAL;
     }
     else
+#endif
+#ifdef UDP_SEGMENT
+    if( cmsg->cmsg_level == IPPROTO_UDP ) {
+      if( cmsg->cmsg_type == UDP_SEGMENT ) {
+        if( cmsg->cmsg_len != CMSG_LEN(sizeof(ci_uint16)) )
+          return -EINVAL;
+        memcpy(gso_size_out, CMSG_DATA(cmsg), sizeof(ci_uint16));
+      }
+      else
+        return -EINVAL;
+    }
+    else
+#endif
+#ifdef SCM_TXTIME
+    if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TXTIME ) {
+      if( cmsg->cmsg_len != CMSG_LEN(sizeof(ci_uint64)) )
+        return -EINVAL;
+      memcpy(txtime_out, CMSG_DATA(cmsg), sizeof(ci_uint64));
+    }
+    else
 #endif
     if( cmsg->cmsg_level == IPPROTO_IP ) {
       if( cmsg->cmsg_type == IP_RETOPTS )
@@ -402,6 +402,10 @@ ci_tcp_ep_mcast_add_del(ci_netif*         ni,
 # define SO_REUSEPORT   15
 #endif
 
+#ifndef SO_MAX_PACING_RATE
+# define SO_MAX_PACING_RATE 47
+#endif
+
 #if CI_CFG_TIMESTAMPING
 /* The following value needs to match its counterpart
  * in kernel headers.
@@ -422,6 +426,12 @@ struct oo_sock_extended_err {
   ci_uint32 ee_data;
 };
 
+/* Replica of sock_txtime from linux/net_tstamp.h, for SO_TXTIME. */
+struct oo_sock_txtime {
+  ci_int32  clockid;
+  ci_uint32 flags;
+};
+
 /* SO_EE_ORIGIN_TIMESTAMPING could be undefined. */
 #ifndef SO_EE_ORIGIN_TIMESTAMPING
 #define SO_EE_ORIGIN_TIMESTAMPING 4
@@ -0,0 +1,387 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_SOURCE>
+**  \brief  Reassembly of fragmented IPv4 UDP datagrams
+** </L5_PRIVATE>
+*//*
+\**************************************************************************/
+
+/*! \cidoxg_lib_transport_ip */
+
+#include "ip_internal.h"
+#include <ci/tools/ipcsum_base.h>
+
+
+#define LPF "ip_reasm: "
+
+#if OO_DO_STACK_POLL
+
+ci_inline int frag_offset(ci_ip4_hdr* ip)
+{
+  return CI_IP4_FRAG_OFFSET(ip) << 3;
+}
+
+ci_inline int frag_len(ci_ip4_hdr* ip)
+{
+  return CI_BSWAP_BE16(ip->ip_tot_len_be16) - CI_IP4_IHL(ip);
+}
+
+
+/* Restore a fragment taken from a chain to the way it was received. */
+static void ci_ip_reasm_unchain(ci_ip_pkt_fmt* pkt)
+{
+  pkt->frag_next = OO_PP_NULL;
+  pkt->n_buffers = 1;
+  pkt->pay_len = oo_pre_l3_len(pkt) +
+                 CI_BSWAP_BE16(oo_ip_hdr(pkt)->ip_tot_len_be16);
+}
+
+
+/* Hand a fragment to the kernel, which reassembles the datagram if it has
+ * the rest of it.
+ */
+static void ci_ip_reasm_pass_frag(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  ci_ip_reasm_unchain(pkt);
+  /* The kernel has already seen fragments from a shared receive queue. */
+  if( (pkt->rx_flags & CI_PKT_RX_FLAG_RX_SHARED) ||
+      ! ci_netif_pkt_pass_to_kernel(ni, pkt) )
+    ci_netif_pkt_release_rx_1ref(ni, pkt);
+}
+
+
+static void ci_ip_reasm_pass_chain(ci_netif* ni, oo_pkt_p pp)
+{
+  ci_ip_pkt_fmt* pkt;
+
+  while( OO_PP_NOT_NULL(pp) ) {
+    pkt = PKT_CHK(ni, pp);
+    pp = pkt->frag_next;
+    ci_ip_reasm_pass_frag(ni, pkt);
+  }
+}
+
+
+static void ci_ip_reasm_slot_free(ci_netif* ni, ci_ip_reasm_slot* slot)
+{
+  ci_assert_ge(ni->state->reasm_n_pkts, slot->n_frags);
+  ni->state->reasm_n_pkts -= slot->n_frags;
+  slot->n_frags = 0;
+  slot->frags = OO_PP_NULL;
+}
+
+
+/* Give up on [slot] and pass the fragments it holds to the kernel. */
+static void ci_ip_reasm_abandon(ci_netif* ni, ci_ip_reasm_slot* slot)
+{
+  oo_pkt_p frags = slot->frags;
+
+  LOG_IPP(log(LPF "[%d] abandon id=%u "CI_IP_PRINTF_FORMAT" bytes=%u/%u "
+              "frags=%u", NI_ID(ni), (unsigned) CI_BSWAP_BE16(slot->id_be16),
+              CI_IP_PRINTF_ARGS(&slot->saddr_be32), slot->bytes, slot->total,
+              slot->n_frags));
+  ci_ip_reasm_slot_free(ni, slot);
+  ci_ip_reasm_pass_chain(ni, frags);
+}
+
+
+/* Arm the timer for the first slot to expire, if any. */
+static void ci_ip_reasm_timer_update(ci_netif* ni)
+{
+  ci_netif_state* ns = ni->state;
+  ci_ip_reasm_slot* first = NULL;
+  int i;
+
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i )
+    if( ns->reasm[i].n_frags != 0 &&
+        (first == NULL || TIME_LT(ns->reasm[i].expiry, first->expiry)) )
+      first = &ns->reasm[i];
+
+  if( first == NULL )
+    ci_ip_timer_clear(ni, &ns->reasm_tid);
+  else if( ci_ip_timer_pending(ni, &ns->reasm_tid) )
+    ci_ip_timer_modify(ni, &ns->reasm_tid, first->expiry);
+  else
+    ci_ip_timer_set(ni, &ns->reasm_tid, first->expiry);
+}
+
+
+static ci_ip_reasm_slot* ci_ip_reasm_oldest(ci_netif* ni,
+                                            ci_ip_reasm_slot* except)
+{
+  ci_netif_state* ns = ni->state;
+  ci_ip_reasm_slot* oldest = NULL;
+  int i;
+
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i )
+    if( ns->reasm[i].n_frags != 0 && &ns->reasm[i] != except &&
+        (oldest == NULL || TIME_LT(ns->reasm[i].expiry, oldest->expiry)) )
+      oldest = &ns->reasm[i];
+  return oldest;
+}
+
+
+/* Find the slot for the datagram that [ip] is a fragment of, or take a
+ * free one, evicting the oldest datagram if the table is full.
+ */
+static ci_ip_reasm_slot* ci_ip_reasm_lookup(ci_netif* ni, ci_ip4_hdr* ip)
+{
+  ci_netif_state* ns = ni->state;
+  ci_ip_reasm_slot* slot;
+  ci_ip_reasm_slot* free_slot = NULL;
+  int i;
+
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i ) {
+    slot = &ns->reasm[i];
+    if( slot->n_frags == 0 ) {
+      if( free_slot == NULL )
+        free_slot = slot;
+    }
+    else if( slot->id_be16 == ip->ip_id_be16 &&
+             slot->saddr_be32 == ip->ip_saddr_be32 &&
+             slot->daddr_be32 == ip->ip_daddr_be32 ) {
+      return slot;
+    }
+  }
+
+  if( free_slot == NULL ) {
+    free_slot = ci_ip_reasm_oldest(ni, NULL);
+    CITP_STATS_NETIF_INC(ni, ip_reasm_evictions);
+    ci_ip_reasm_abandon(ni, free_slot);
+  }
+
+  free_slot->saddr_be32 = ip->ip_saddr_be32;
+  free_slot->daddr_be32 = ip->ip_daddr_be32;
+  free_slot->id_be16 = ip->ip_id_be16;
+  free_slot->bytes = 0;
+  free_slot->total = 0;
+  free_slot->expiry = ci_ip_time_now(ni) +
+                      ci_ip_time_ms2ticks(ni, NI_OPTS(ni).ip_reasm_timeout);
+  return free_slot;
+}
+
+
+/* Check the UDP checksum of a reassembled datagram, which the NIC does not
+ * do for fragments.  Each fragment's [buf] holds its IP payload.
+ */
+static int ci_ip_reasm_udp_csum_correct(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  ci_ip4_hdr* ip = oo_ip_hdr(pkt);
+  ci_udp_hdr* udp = (ci_udp_hdr*) oo_offbuf_ptr(&pkt->buf);
+  int left = CI_BSWAP_BE16(udp->udp_len_be16);
+  unsigned sum;
+  int n;
+
+  if( udp->udp_check_be16 == 0 )
+    return 1;  /* RFC768: csum not computed */
+
+  sum = ci_ip_csum_partial(0, &ip->ip_saddr_be32, 8);
+  sum += CI_BSWAPC_BE16(IPPROTO_UDP) + udp->udp_len_be16;
+  while( 1 ) {
+    n = CI_MIN(left, oo_offbuf_left(&pkt->buf));
+    sum = ci_ip_csum_fold(ci_ip_csum_partial(sum, oo_offbuf_ptr(&pkt->buf),
+                                             n));
+    left -= n;
+    if( left == 0 || OO_PP_IS_NULL(pkt->frag_next) )
+      break;
+    pkt = PKT_CHK(ni, pkt->frag_next);
+  }
+  return ci_ip_hdr_csum_finish(sum) == 0;
+}
+
+
+/* All of the datagram held in [slot] has arrived.  Free the slot and turn
+ * the fragments into a chain that the UDP receive path can consume.
+ */
+static ci_ip_pkt_fmt* ci_ip_reasm_complete(ci_netif* ni,
+                                           ci_ip_reasm_slot* slot)
+{
+  ci_ip_pkt_fmt* head = PKT_CHK(ni, slot->frags);
+  ci_ip_pkt_fmt* pkt = head;
+  int n_buffers = slot->n_frags;
+  int total = slot->total;
+  ci_ip4_hdr* ip;
+
+  ci_ip_reasm_slot_free(ni, slot);
+  ci_ip_reasm_timer_update(ni);
+
+  while( 1 ) {
+    ip = oo_ip_hdr(pkt);
+    oo_offbuf_init(&pkt->buf, (char*) ip + CI_IP4_IHL(ip), frag_len(ip));
+    pkt->n_buffers = n_buffers--;
+    if( OO_PP_IS_NULL(pkt->frag_next) )
+      break;
+    pkt = PKT_CHK(ni, pkt->frag_next);
+  }
+  ci_assert_equal(n_buffers, 0);
+
+  if(CI_UNLIKELY( ! ci_ip_reasm_udp_csum_correct(ni, head) )) {
+    ip = oo_ip_hdr(head);
+    LOG_U(CI_RLLOG(10, LPF "[%d] bad UDP checksum id=%u "CI_IP_PRINTF_FORMAT,
+                   NI_ID(ni), (unsigned) CI_BSWAP_BE16(ip->ip_id_be16),
+                   CI_IP_PRINTF_ARGS(&ip->ip_saddr_be32)));
+    CITP_STATS_NETIF_INC(ni, ip_reasm_fails);
+    CI_UDP_STATS_INC_IN_ERRS(ni);
+    ci_netif_pkt_release_rx_1ref(ni, head);
+    return NULL;
+  }
+
+  /* [pay_len] of the first buffer covers the whole frame, as for a
+   * received frame that spans several buffers.  The IP header is left as
+   * received; ci_ip_reasm_pass_to_kernel() relies on that. */
+  head->pay_len = oo_pre_l3_len(head) + CI_IP4_IHL(oo_ip_hdr(head)) + total;
+  CITP_STATS_NETIF_INC(ni, ip_reasm_oks);
+  return head;
+}
+
+
+ci_ip_pkt_fmt* ci_ip_reasm_rx(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  ci_netif_state* ns = ni->state;
+  ci_ip4_hdr* ip = oo_ip_hdr(pkt);
+  int off = frag_offset(ip);
+  int len = frag_len(ip);
+  int more = (ip->ip_frag_off_be16 & CI_IP4_FRAG_MORE) != 0;
+  ci_uint32 max_pkts;
+  ci_ip_reasm_slot* slot;
+  ci_ip_reasm_slot* old;
+  ci_ip_pkt_fmt* frag;
+  ci_ip4_hdr* fip;
+  oo_pkt_p* pp;
+  int new_slot;
+
+  ci_assert(ci_netif_is_locked(ni));
+  ci_assert_equal(ip->ip_protocol, IPPROTO_UDP);
+  ci_assert_equal(pkt->n_buffers, 1);
+  ci_assert(OO_PP_IS_NULL(pkt->frag_next));
+
+  /* Every fragment but the last carries a non-zero multiple of 8 bytes. */
+  if( len <= 0 || (more && (len & 7)) ||
+      off + len > 0xffff - CI_IP4_IHL(ip) ) {
+    CITP_STATS_NETIF_INC(ni, ip_reasm_fails);
+    ci_ip_reasm_pass_frag(ni, pkt);
+    return NULL;
+  }
+
+  slot = ci_ip_reasm_lookup(ni, ip);
+  new_slot = slot->n_frags == 0;
+
+  /* Keep within the share of receive buffers given to reassembly by
+   * making room at the expense of the oldest datagrams. */
+  max_pkts = NI_OPTS(ni).max_rx_packets >> NI_OPTS(ni).ip_reasm_max_fraction;
+  if( ns->mem_pressure & OO_MEM_PRESSURE_CRITICAL )
+    max_pkts = 0;
+  while( ns->reasm_n_pkts >= max_pkts &&
+         (old = ci_ip_reasm_oldest(ni, slot)) != NULL ) {
+    CITP_STATS_NETIF_INC(ni, ip_reasm_evictions);
+    ci_ip_reasm_abandon(ni, old);
+  }
+  if( ns->reasm_n_pkts >= max_pkts ||
+      slot->n_frags >= CI_CFG_IP_REASM_MAX_FRAGS )
+    goto fail;
+
+  if( ! more ) {
+    if( slot->total != 0 && slot->total != off + len )
+      goto fail;
+    slot->total = off + len;
+  }
+  else if( slot->total != 0 && off + len > slot->total ) {
+    goto fail;
+  }
+
+  /* Insert in order of offset.  An exact duplicate of a fragment we hold
+   * is dropped; any other overlap ends reassembly. */
+  for( pp = &slot->frags; OO_PP_NOT_NULL(*pp); pp = &frag->frag_next ) {
+    frag = PKT_CHK(ni, *pp);
+    fip = oo_ip_hdr(frag);
+    if( frag_offset(fip) >= off + len )
+      break;
+    if( frag_offset(fip) + frag_len(fip) <= off )
+      continue;
+    if( frag_offset(fip) == off && frag_len(fip) == len ) {
+      ci_netif_pkt_release_rx_1ref(ni, pkt);
+      return NULL;
+    }
+    goto fail;
+  }
+  pkt->frag_next = *pp;
+  *pp = OO_PKT_P(pkt);
+  slot->bytes += len;
+  ++slot->n_frags;
+  ++ns->reasm_n_pkts;
+  CITP_STATS_NETIF_INC(ni, ip_reasm_frags);
+
+  /* Fragments do not overlap, so we have them all once the bytes held add
+   * up to the length given by the last one. */
+  if( slot->total != 0 && slot->bytes == slot->total )
+    return ci_ip_reasm_complete(ni, slot);
+  if( new_slot )
+    ci_ip_reasm_timer_update(ni);
+  return NULL;
+
+ fail:
+  CITP_STATS_NETIF_INC(ni, ip_reasm_fails);
+  if( slot->n_frags != 0 ) {
+    ci_ip_reasm_abandon(ni, slot);
+    ci_ip_reasm_timer_update(ni);
+  }
+  ci_ip_reasm_pass_frag(ni, pkt);
+  return NULL;
+}
+
+
+int ci_ip_reasm_pass_to_kernel(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  oo_pkt_p next = pkt->frag_next;
+  ci_int32 pay_len = pkt->pay_len;
+  ci_int8 n_buffers = pkt->n_buffers;
+
+  ci_assert(CI_IP4_IS_FIRST_FRAG(oo_ip_hdr(pkt)));
+
+  ci_ip_reasm_unchain(pkt);
+  if( ! ci_netif_pkt_pass_to_kernel(ni, pkt) ) {
+    pkt->frag_next = next;
+    pkt->pay_len = pay_len;
+    pkt->n_buffers = n_buffers;
+    return 0;
+  }
+  ci_ip_reasm_pass_chain(ni, next);
+  return 1;
+}
+
+
+void ci_ip_reasm_timeout(ci_netif* ni)
+{
+  ci_netif_state* ns = ni->state;
+  ci_iptime_t now = ci_ip_time_now(ni);
+  int i;
+
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i )
+    if( ns->reasm[i].n_frags != 0 && TIME_LE(ns->reasm[i].expiry, now) ) {
+      CITP_STATS_NETIF_INC(ni, ip_reasm_timeouts);
+      ci_ip_reasm_abandon(ni, &ns->reasm[i]);
+    }
+  ci_ip_reasm_timer_update(ni);
+}
+
+
+void ci_ip_reasm_flush(ci_netif* ni)
+{
+  ci_netif_state* ns = ni->state;
+  oo_pkt_p frags;
+  int i;
+
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i )
+    if( ns->reasm[i].n_frags != 0 ) {
+      frags = ns->reasm[i].frags;
+      ci_ip_reasm_slot_free(ni, &ns->reasm[i]);
+      /* Releasing the first fragment releases the ones chained to it. */
+      ci_netif_pkt_release_rx_1ref(ni, PKT_CHK(ni, frags));
+    }
+  ci_ip_timer_clear(ni, &ns->reasm_tid);
+}
+
+#endif
+/*! \cidoxg_end */
@@ -336,12 +336,27 @@ static void ci_ip_timer_docallback(ci_netif *netif, ci_ip_timer* ts)
     sp = oo_statep_to_sockp(netif, ts->statep);
     ci_tcp_timeout_cork(netif, SP_TO_TCP(netif, sp));
     break;
+  case CI_IP_TIMER_TCP_PACE:
+    sp = oo_statep_to_sockp(netif, ts->statep);
+    ci_tcp_timeout_pace(netif, SP_TO_TCP(netif, sp));
+    break;
+  case CI_IP_TIMER_TCP_RACK:
+    sp = oo_statep_to_sockp(netif, ts->statep);
+    ci_tcp_timeout_rack(netif, SP_TO_TCP(netif, sp));
+    break;
+  case CI_IP_TIMER_UDP_TXTIME:
+    sp = oo_statep_to_sockp(netif, ts->statep);
+    ci_udp_timeout_txtime(netif, SP_TO_UDP(netif, sp));
+    break;
   case CI_IP_TIMER_NETIF_TCP_RECYCLE:
     ci_ip_timer_do_recycle(netif);
     break;
   case CI_IP_TIMER_NETIF_TIMEOUT:
     ci_netif_timeout_state(netif);
     break;
+  case CI_IP_TIMER_NETIF_REASM:
+    ci_ip_reasm_timeout(netif);
+    break;
   case CI_IP_TIMER_PMTU_DISCOVER:
   {
     oo_p pmtu_p = ts->statep;
@@ -582,7 +597,11 @@ static const char* ci_ip_timer_dump(const ci_ip_timer* ts)
     MAKECASE(CI_IP_TIMER_TCP_KALIVE,   "kalive")
     MAKECASE(CI_IP_TIMER_TCP_LISTEN,   "listen")
     MAKECASE(CI_IP_TIMER_TCP_CORK,     "cork")
+    MAKECASE(CI_IP_TIMER_TCP_PACE,     "pace")
+    MAKECASE(CI_IP_TIMER_TCP_RACK,     "rack")
+    MAKECASE(CI_IP_TIMER_UDP_TXTIME,   "txtime")
     MAKECASE(CI_IP_TIMER_NETIF_TIMEOUT, "netif")
+    MAKECASE(CI_IP_TIMER_NETIF_REASM,   "reasm")
     MAKECASE(CI_IP_TIMER_PMTU_DISCOVER, "pmtu")
 #if CI_CFG_SUPPORT_STATS_COLLECTION
     MAKECASE(CI_IP_TIMER_TCP_STATS,     "tcp-stats")
@@ -13,6 +13,8 @@ LIB_SRCS	:=		\
 		netif_pkt.c	\
 		tcp_misc.c	\
 		tcp_rx.c	\
+		tcp_cong.c	\
+		tcp_rack.c	\
 		tcp_sleep.c	\
 		tcp_synrecv.c	\
 		tcp_tx.c	\
@@ -21,6 +23,7 @@ LIB_SRCS	:=		\
 		tcp_close.c	\
 		tcp_init_shared.c \
 		pmtu.c		\
+		ip_reasm.c	\
 		ip_tx.c		\
 		udp.c		\
 		udp_rx.c	\
@@ -43,6 +46,7 @@ LIB_SRCS	:=		\
 		eplock_slow.c	\
 		udp_recv.c	\
 		udp_send.c	\
+		udp_txtime.c	\
 		os_sock.c	\
 		pkt_filler.c	\
 		pio_buddy.c	\
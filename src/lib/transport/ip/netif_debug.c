@@ -969,6 +969,12 @@ void ci_netif_dump_to_logger(ci_netif* ni, oo_dump_log_fn_t logger,
     logger(log_arg, "  aux_bufs[%s]: n=%d max=%d",
            ci_tcp_aux_type2str(i), ns->n_aux_bufs[i], ns->max_aux_bufs[i]);
   }
+  if( NI_OPTS(ni).udp_mcast_index )
+    logger(log_arg, "  mcast_index: entries=%u missing=%u",
+           ns->n_aux_bufs[CI_TCP_AUX_TYPE_MCAST], ns->mcast_index_missing);
+  if( NI_OPTS(ni).ip_reasm )
+    logger(log_arg, "  ip_reasm: held_pkts=%u max=%u", ns->reasm_n_pkts,
+           NI_OPTS(ni).max_rx_packets >> NI_OPTS(ni).ip_reasm_max_fraction);
   ci_netif_dump_pkt_summary(ni, logger, log_arg);
 
   its = *IPTIMER_STATE(ni);
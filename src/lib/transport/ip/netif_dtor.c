@@ -80,6 +80,7 @@ void oo_netif_dtor_pkts(ci_netif* ni)
   oo_inject_packets_kernel(netif2tcp_helper_resource(ni), 1);
 #endif
   oo_deferred_free(ni);
+  ci_ip_reasm_flush(ni);
 
   /* Check for packet leak */
   ci_assert_equal(ni->packets->n_pkts_allocated,
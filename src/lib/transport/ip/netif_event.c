@@ -309,6 +309,32 @@ static void handle_rx_pkt(ci_netif* netif, struct ci_netif_poll_state* ps,
 
     hdr_size = CI_IP4_IHL(ip);
 
+    /* Fragments of UDP datagrams may be reassembled here (EF_IP_REASM).
+     * Those with IP options or spanning several buffers take the slow
+     * path, as do any that end up being abandoned.
+     */
+    if(CI_UNLIKELY( not_fast && NI_OPTS(netif).ip_reasm &&
+                    (ip->ip_frag_off_be16 &
+                     (CI_IP4_OFFSET_MASK | CI_IP4_FRAG_MORE)) &&
+                    ip->ip_protocol == IPPROTO_UDP &&
+                    hdr_size == sizeof(ci_ip4_hdr) &&
+                    ip_tot_len <= pkt->pay_len - oo_pre_l3_len(pkt) &&
+                    pkt->n_buffers == 1 )) {
+      get_rx_timestamp(netif, pkt);
+      if( oo_tcpdump_check(netif, pkt, pkt->intf_i) )
+        oo_tcpdump_dump_pkt(netif, pkt);
+
+      pkt = ci_ip_reasm_rx(netif, pkt);
+      if( pkt == NULL )
+        return;
+      ip = oo_ip_hdr(pkt);
+      ip_paylen = pkt->pay_len - oo_pre_l3_len(pkt) - hdr_size;
+      ci_udp_handle_rx(netif, pkt, (ci_udp_hdr*) ((char*) ip + hdr_size),
+                       ip_paylen);
+      CI_IPV4_STATS_INC_IN_DELIVERS( netif );
+      return;
+    }
+
     /* Accepting but ignoring IP options.
     ** Quick parse to check there is no badness
      */
@@ -336,7 +362,11 @@ static void handle_rx_pkt(ci_netif* netif, struct ci_netif_poll_state* ps,
 
       /* Demux to appropriate protocol. */
       if( ip->ip_protocol == IPPROTO_TCP ) {
-        ci_tcp_handle_rx(netif, ps, pkt, (ci_tcp_hdr*) payload, ip_paylen);
+        if( NI_OPTS(netif).rx_merge_mode )
+          ci_tcp_handle_rx_lro(netif, ps, pkt, (ci_tcp_hdr*) payload,
+                               ip_paylen);
+        else
+          ci_tcp_handle_rx(netif, ps, pkt, (ci_tcp_hdr*) payload, ip_paylen);
         CI_IPV4_STATS_INC_IN_DELIVERS( netif );
         return;
       }
@@ -771,6 +801,7 @@ ci_inline int handle_rx_pre_future(ci_netif* ni, ci_ip_pkt_fmt* pkt,
     void* payload = (char*)ip + hdr_size;
 
     if( ip_payload_offset > valid_bytes ||
+        (ip->ip_frag_off_be16 & (CI_IP4_OFFSET_MASK | CI_IP4_FRAG_MORE)) ||
         (hdr_size > sizeof(ci_ip4_hdr) &&
          ci_ip_options_parse(ni, ip, hdr_size)) )
       goto no_future;
@@ -1656,10 +1687,36 @@ static void ci_netif_tx_pkt_complete_udp(ci_netif* netif,
 }
 
 
+/* Release a send queue held back by EF_TCP_AUTOCORK on the TX completion
+ * of one of the socket's segments.  [sock_id] is not set on every TCP
+ * packet, so it is validated before use; releasing the wrong socket's cork
+ * early does no harm.
+ */
+static void ci_netif_tx_pkt_complete_autocork(ci_netif* ni,
+                                              ci_ip_pkt_fmt* pkt)
+{
+  oo_sp sp = pkt->pf.tcp_tx.sock_id;
+  citp_waitable_obj* wo;
+
+  if( OO_SP_IS_NULL(sp) || ! IS_VALID_SOCK_P(ni, sp) )
+    return;
+  wo = SP_TO_WAITABLE_OBJ(ni, sp);
+  if( (wo->waitable.state & CI_TCP_STATE_TCP_CONN) &&
+      (wo->tcp.tcpflags & CI_TCPT_FLAG_AUTOCORK) &&
+      ci_tcp_sendq_not_empty(&wo->tcp) ) {
+    wo->waitable.sb_flags |= CI_SB_FLAG_TCP_POST_POLL;
+    ci_netif_put_on_post_poll(ni, &wo->waitable);
+  }
+}
+
+
 static void ci_netif_rx_pkt_complete_tcp(ci_netif* ni,
                                          struct ci_netif_poll_state* ps,
                                          ci_ip_pkt_fmt* pkt)
 {
+  if(CI_UNLIKELY( NI_OPTS(ni).tcp_autocork ))
+    ci_netif_tx_pkt_complete_autocork(ni, pkt);
+
 #if CI_CFG_TIMESTAMPING
   if( pkt->flags & (CI_PKT_FLAG_TX_TIMESTAMPED | CI_PKT_FLAG_INDIRECT) ) {
     /* This packet is destined for the timestamp_q. We need to check if our
@@ -1995,6 +2052,7 @@ have_events:
 
       else if( EF_EVENT_TYPE(ev[i]) == EF_EVENT_TYPE_OFLOW ) {
         LOG_E(CI_RLLOG(1, LPF "***** EVENT QUEUE OVERFLOW *****"));
+        ci_tcp_rx_lro_flush(ni, ps);
         return 0;
       }
 
@@ -2026,6 +2084,10 @@ have_events:
     total_evs += n_evs;
   } while( total_evs < NI_OPTS(ni).evs_per_poll );
 
+  /* Deliver any segments held back for software LRO before the post-poll
+   * processing of this batch. */
+  ci_tcp_rx_lro_flush(ni, ps);
+
   /* If we've drained the TXQ, we can start trying CTPIO again. */
   if( completed_tx &&
       ef_vi_transmit_fill_level(ci_netif_vi(ni, intf_i)) == 0 )
@@ -2054,6 +2116,7 @@ static int ci_netif_poll_intf(ci_netif* ni, int intf_i, int max_evs)
   ci_assert(ci_netif_is_locked(ni));
   ps.tx_pkt_free_list_insert = &ps.tx_pkt_free_list;
   ps.tx_pkt_free_list_n = 0;
+  ps.lro_head = NULL;
 
   do {
     rc = ci_netif_poll_evq(ni, &ps, intf_i, 0);
@@ -2156,6 +2219,7 @@ int ci_netif_poll_intf_future(ci_netif* ni, int intf_i, ci_uint64 start_frc)
 
   ps.tx_pkt_free_list_insert = &ps.tx_pkt_free_list;
   ps.tx_pkt_free_list_n = 0;
+  ps.lro_head = NULL;
 
   /* We expect the completion event within a microsecond or so. The timeout
    * of 10us is to avoid wedging the stack in the case of hardware
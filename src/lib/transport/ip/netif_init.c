@@ -120,6 +120,16 @@ void ci_netif_state_init(ci_netif* ni, int cpu_khz, const char* name)
 
   nis->timeout_tid.fn = CI_IP_TIMER_NETIF_TIMEOUT;
 
+  ci_ip_timer_init(ni, &nis->reasm_tid,
+                   oo_ptr_to_statep(ni, &nis->reasm_tid),
+                   "reas");
+  nis->reasm_tid.fn = CI_IP_TIMER_NETIF_REASM;
+  nis->reasm_n_pkts = 0;
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i ) {
+    nis->reasm[i].n_frags = 0;
+    nis->reasm[i].frags = OO_PP_NULL;
+  }
+
 #if CI_CFG_TCP_OFFLOAD_RECYCLER
   ci_ip_timer_init(ni, &nis->recycle_tid,
                    oo_ptr_to_statep(ni, &nis->recycle_tid),
@@ -205,6 +215,7 @@ void ci_netif_state_init(ci_netif* ni, int cpu_khz, const char* name)
 
   /* hash_salt is used for TCP syncookies and IPv6 flowlabel generation */
   get_random_bytes(&nis->hash_salt, sizeof(nis->hash_salt));
+  memset(nis->tcp_fastopen_cache, 0, sizeof(nis->tcp_fastopen_cache));
 
 #if CI_CFG_EPOLL3
   nis->ready_lists_in_use = 0;
@@ -295,6 +306,7 @@ static ci_uint32 citp_syn_opts = CI_TCPT_SYN_FLAGS;
 static ci_uint32 citp_tcp_dsack = CI_CFG_TCP_DSACK;
 static ci_uint32 citp_tcp_time_wait_assassinate = CI_CFG_TIME_WAIT_ASSASSINATE;
 static ci_uint32 citp_tcp_early_retransmit = 3;  /* default as of 3.10 */
+static ci_uint32 citp_tcp_fastopen = EF_TCP_FASTOPEN_CLIENT;
 static ci_uint32 citp_tcp_invalid_ratelimit =
                         CI_CFG_TCP_OUT_OF_WINDOW_ACK_RATELIMIT;
 
@@ -441,6 +453,14 @@ ci_setup_ipstack_params(void)
     else
       citp_syn_opts &=~ CI_TCPT_FLAG_WSCL;
   }
+  /* tcp_ecn=2 (the kernel default) means accept ECN but don't request it,
+   * which we don't distinguish, so only enable ECN for 1. */
+  if (ci_sysctl_get_values("net/ipv4/tcp_ecn", opt, 1) == 0) {
+    if( opt[0] == 1 )
+      citp_syn_opts |= CI_TCPT_FLAG_ECN;
+    else
+      citp_syn_opts &=~ CI_TCPT_FLAG_ECN;
+  }
 
   if (ci_sysctl_get_values("net/ipv4/tcp_dsack", opt, 1) == 0)
     citp_tcp_dsack = opt[0];
@@ -454,6 +474,12 @@ ci_setup_ipstack_params(void)
   if (ci_sysctl_get_values("net/ipv4/tcp_invalid_ratelimit", opt, 1) == 0)
     citp_tcp_invalid_ratelimit = opt[0];
 
+  /* Only the client and server enable bits are honoured; the kernel's
+   * cookie-less and per-socket-default modes are not supported. */
+  if (ci_sysctl_get_values("net/ipv4/tcp_fastopen", opt, 1) == 0)
+    citp_tcp_fastopen = opt[0] & (EF_TCP_FASTOPEN_CLIENT |
+                                  EF_TCP_FASTOPEN_SERVER);
+
 #if CI_CFG_IPV6
   if( ci_sysctl_get_values("net/ipv6/auto_flowlabels", opt, 1) == 0 )
     citp_auto_flowlabels = opt[0];
@@ -530,6 +556,7 @@ void ci_netif_config_opts_defaults(ci_netif_config_opts* opts)
                                  citp_tcp_early_retransmit < 4;
     opts->tail_drop_probe = citp_tcp_early_retransmit >= 3;
     opts->oow_ack_ratelimit = citp_tcp_invalid_ratelimit;
+    opts->tcp_fastopen = citp_tcp_fastopen;
 #if CI_CFG_IPV6
     opts->auto_flowlabels = citp_auto_flowlabels;
 #endif
@@ -981,6 +1008,16 @@ void ci_netif_config_opts_getenv(ci_netif_config_opts* opts)
     opts->udp_connect_handover = atoi(s);
   if( (s = getenv("EF_UDP_SEND_UNLOCKED")) )
     opts->udp_send_unlocked = atoi(s);
+  if( (s = getenv("EF_UDP_SEND_DEST_CACHE")) )
+    opts->udp_send_dest_cache = atoi(s);
+  if( (s = getenv("EF_UDP_MCAST_INDEX")) )
+    opts->udp_mcast_index = atoi(s);
+  if( (s = getenv("EF_IP_REASM")) )
+    opts->ip_reasm = atoi(s);
+  if( (s = getenv("EF_IP_REASM_TIMEOUT")) )
+    opts->ip_reasm_timeout = atoi(s);
+  if( (s = getenv("EF_IP_REASM_MAX_FRACTION")) )
+    opts->ip_reasm_max_fraction = atoi(s);
   if( (s = getenv("EF_UDP_SEND_NONBLOCK_NO_PACKETS_MODE")) )
     opts->udp_nonblock_no_pkts_mode = atoi(s);
   if( (s = getenv("EF_UNCONFINE_SYN")) )
@@ -1289,6 +1326,26 @@ void ci_netif_config_opts_getenv(ci_netif_config_opts* opts)
   if( (s = getenv("EF_TCP_EARLY_RETRANSMIT")) )
     opts->tcp_early_retransmit = atoi(s);
 
+  static const char* const tcp_loss_detection_opts[] = { "dupack", "rack", 0 };
+  opts->tcp_loss_detection =
+    parse_enum(opts, "EF_TCP_LOSS_DETECTION", tcp_loss_detection_opts,
+               "dupack");
+
+  static const char* const tcp_cong_opts[] = { "reno", "cubic", "bbr",
+                                               "dctcp", 0 };
+  opts->tcp_cong_alg =
+    parse_enum(opts, "EF_TCP_CONGESTION", tcp_cong_opts, "reno");
+
+  if( (s = getenv("EF_TCP_FASTOPEN")) ) {
+    unsigned v;
+    ci_verify(sscanf(s, "%x", &v) == 1);
+    opts->tcp_fastopen = v;
+  }
+  if( (s = getenv("EF_TCP_AUTOCORK")) )
+    opts->tcp_autocork = atoi(s);
+  if( (s = getenv("EF_TCP_GSO")) )
+    opts->tcp_gso = atoi(s);
+
 #if CI_CFG_IPV6
   if( (s = getenv("EF_AUTO_FLOWLABELS")) )
     opts->auto_flowlabels = atoi(s);
@@ -1699,6 +1756,8 @@ static void netif_tcp_helper_build2(ci_netif* ni)
   ni->deferred_pkts =
     (struct oo_deferred_pkt*) ((char*) ni->state +
                                ni->state->deferred_pkts_ofs);
+  ni->mcast_index = ! NI_OPTS(ni).udp_mcast_index ? NULL :
+    (oo_p*) ((char*) ni->state + ni->state->mcast_index_ofs);
   ni->filter_table =
     (ci_netif_filter_table*) ((char*) ni->state + ni->state->table_ofs);
   ni->filter_table_ext =
@@ -2579,6 +2638,20 @@ static void ci_netif_sanity_checks(void)
   CI_BUILD_ASSERT( (1u << CI_SB_FLAG_WAKE_RX_B) == CI_SB_FLAG_WAKE_RX );
   CI_BUILD_ASSERT( (1u << CI_SB_FLAG_WAKE_TX_B) == CI_SB_FLAG_WAKE_TX );
   CI_BUILD_ASSERT( sizeof(ci_ni_aux_mem) == CI_AUX_MEM_SIZE );
+  /* Every member of the union must fit; these say which one does not. */
+#define AUX_MEMBER_FITS(m)                                      \
+  ( CI_MEMBER_OFFSET(ci_ni_aux_mem, u) +                        \
+    CI_MEMBER_SIZE(ci_ni_aux_mem, u.m) <= CI_AUX_MEM_SIZE )
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(synrecv) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(bucket) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(epoll) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(pmtus) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(udp_dest) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(mcast) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(udp_dest_table) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(rob_index) );
+  CI_BUILD_ASSERT( AUX_MEMBER_FITS(tcp_cc) );
+#undef AUX_MEMBER_FITS
 
   /* AUX_PER_BUF aux buffers + header = ep buffer, where header is
    * oo_ep_header and fits in exactly one cache line. */
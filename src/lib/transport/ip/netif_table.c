@@ -231,6 +231,128 @@ handle_entry(ci_netif* ni, ci_netif_filter_table_entry_fast* entry,
 }
 
 
+/* IPv4 UDP multicast filters are also kept in an index keyed by group and
+ * port.  A multicast datagram may be wanted by any number of sockets, so
+ * the wildcard lookup in ci_netif_filter_for_each_match() cannot stop at
+ * the first match and has to walk the whole probe sequence, which grows
+ * with the number of groups joined and sockets sharing ports.  The index
+ * gives the matching sockets directly.
+ */
+
+ci_inline int /*bool*/
+mcast_index_wanted(ci_netif* ni, unsigned laddr, unsigned raddr,
+                   unsigned protocol)
+{
+  return protocol == IPPROTO_UDP && raddr == 0 &&
+         CI_IP_IS_MULTICAST(laddr) && NI_OPTS(ni).udp_mcast_index;
+}
+
+ci_inline oo_p* mcast_index_head(ci_netif* ni, unsigned laddr, unsigned lport)
+{
+  ci_assert(ni->mcast_index);
+  return &ni->mcast_index[
+    __onload_hash1(CI_CFG_MCAST_INDEX_BUCKETS - 1, laddr, lport, 0, 0,
+                   IPPROTO_UDP)];
+}
+
+
+static int
+mcast_index_for_each_match(ci_netif* ni, unsigned laddr, unsigned lport,
+                           int intf_i, int vlan,
+                           int (*callback)(ci_sock_cmn*, void*),
+                           void* callback_arg)
+{
+  ci_mcast_index_entry* e;
+  ci_sock_cmn* s;
+  oo_p p;
+  int i;
+
+  CITP_STATS_NETIF_INC(ni, udp_rx_mcast_index_lookups);
+
+  for( p = *mcast_index_head(ni, laddr, lport); OO_P_NOT_NULL(p);
+       p = e->next ) {
+    e = ci_ni_aux_p2mcast(ni, p);
+    if( e->group_be32 != laddr || e->port_be16 != lport )
+      continue;
+    for( i = 0; i < e->n_socks; ++i ) {
+      s = ID_TO_SOCK(ni, OO_SP_TO_INT(e->socks[i]));
+      /* As handle_entry(): the socket must still be unconnected. */
+      if( (sock_raddr_be32(s) | sock_rport_be16(s)) == 0 &&
+          CI_LIKELY((s->rx_bind2dev_ifindex == CI_IFID_BAD ||
+                     ci_sock_intf_check(ni, s, intf_i, vlan))) &&
+          callback(s, callback_arg) != 0 )
+        return 1;
+    }
+  }
+  return 0;
+}
+
+
+static void
+mcast_index_insert(ci_netif* ni, oo_sp sock_id,
+                   unsigned laddr, unsigned lport)
+{
+  oo_p* head = mcast_index_head(ni, laddr, lport);
+  ci_mcast_index_entry* e;
+  oo_p p;
+
+  for( p = *head; OO_P_NOT_NULL(p); p = e->next ) {
+    e = ci_ni_aux_p2mcast(ni, p);
+    if( e->group_be32 == laddr && e->port_be16 == lport &&
+        e->n_socks < CI_MCAST_INDEX_SOCKS ) {
+      e->socks[e->n_socks++] = sock_id;
+      return;
+    }
+  }
+
+  p = ci_ni_aux_alloc(ni, CI_TCP_AUX_TYPE_MCAST);
+  if( OO_P_IS_NULL(p) ) {
+    LOG_TC(ci_log(FN_FMT "%d mcast index full %s:%u", FN_PRI_ARGS(ni),
+                  OO_SP_FMT(sock_id), ip_addr_str(laddr),
+                  (unsigned) CI_BSWAP_BE16(lport)));
+    ++ni->state->mcast_index_missing;
+    return;
+  }
+  e = ci_ni_aux_p2mcast(ni, p);
+  e->group_be32 = laddr;
+  e->port_be16 = lport;
+  e->n_socks = 1;
+  e->socks[0] = sock_id;
+  e->next = *head;
+  *head = p;
+}
+
+
+static void
+mcast_index_remove(ci_netif* ni, oo_sp sock_id,
+                   unsigned laddr, unsigned lport)
+{
+  oo_p* pp = mcast_index_head(ni, laddr, lport);
+  ci_mcast_index_entry* e;
+  int i;
+
+  for( ; OO_P_NOT_NULL(*pp); pp = &e->next ) {
+    e = ci_ni_aux_p2mcast(ni, *pp);
+    if( e->group_be32 != laddr || e->port_be16 != lport )
+      continue;
+    for( i = 0; i < e->n_socks; ++i )
+      if( OO_SP_EQ(e->socks[i], sock_id) ) {
+        e->socks[i] = e->socks[--e->n_socks];
+        if( e->n_socks == 0 ) {
+          *pp = e->next;
+          ci_mcast_index_entry_free(ni, e);
+        }
+        return;
+      }
+  }
+
+  /* The filter was one of those that did not make it into the index. */
+  ci_assert_gt(ni->state->mcast_index_missing, 0);
+  if( ni->state->mcast_index_missing > 0 )
+    --ni->state->mcast_index_missing;
+}
+
+
 int
 ci_netif_filter_for_each_match(ci_netif* ni,
                                unsigned laddr, unsigned lport,
@@ -249,6 +371,10 @@ ci_netif_filter_for_each_match(ci_netif* ni,
 
   if( hash_out != NULL )
     *hash_out = __onload_hash3(laddr, lport, raddr, rport, protocol);
+  if( mcast_index_wanted(ni, laddr, raddr, protocol) &&
+      ni->state->mcast_index_missing == 0 )
+    return mcast_index_for_each_match(ni, laddr, lport, intf_i, vlan,
+                                      callback, callback_arg);
   hash1 = __onload_hash1(table_size_mask, laddr, lport, raddr, rport,
                          protocol);
   first = hash1;
@@ -444,7 +570,8 @@ __ci_ip4_netif_filter_remove(ci_netif_filter_table* tbl, ci_netif* ni,
 }
 
 
-static void
+/* Returns true if the filter was found and removed. */
+static int
 ci_ip4_netif_filter_remove(ci_netif_filter_table* tbl,
                            ci_netif* netif, oo_sp sock_p,
                            unsigned laddr, unsigned lport,
@@ -487,7 +614,7 @@ ci_ip4_netif_filter_remove(ci_netif_filter_table* tbl,
       /* We allow multiple removes of the same filter -- helps avoid some
        * complexity in the filter module.
        */
-      return;
+      return 0;
     }
     tbl_i = (tbl_i + hash2) & tbl->table_size_mask;
     ++hops;
@@ -497,11 +624,12 @@ ci_ip4_netif_filter_remove(ci_netif_filter_table* tbl,
                    CI_IP_PROTOCOL_STR(protocol),
                    ip_addr_str(laddr), (unsigned) CI_BSWAP_BE16(lport),
                    ip_addr_str(raddr), (unsigned) CI_BSWAP_BE16(rport)));
-      return;
+      return 0;
     }
   }
 
   __ci_ip4_netif_filter_remove(tbl, netif, hash1, hash2, hops, tbl_i);
+  return 1;
 }
 
 int
@@ -543,6 +671,8 @@ ci_netif_filter_insert(ci_netif* netif, oo_sp tcp_id, int af_space,
      * in the both worlds, and IPv4 fails? */
     if( rc < 0 )
       return rc;
+    if( mcast_index_wanted(netif, laddr.ip4, raddr.ip4, protocol) )
+      mcast_index_insert(netif, tcp_id, laddr.ip4, lport);
   }
 
   return 0;
@@ -577,8 +707,10 @@ ci_netif_filter_remove(ci_netif* netif, oo_sp sock_p, int af_space,
     ci_assert(netif->filter_table);
     ip4_tbl = netif->filter_table;
 
-    ci_ip4_netif_filter_remove(ip4_tbl, netif, sock_p, laddr.ip4, lport,
-                               raddr.ip4, rport, protocol);
+    if( ci_ip4_netif_filter_remove(ip4_tbl, netif, sock_p, laddr.ip4, lport,
+                                   raddr.ip4, rport, protocol) &&
+        mcast_index_wanted(netif, laddr.ip4, raddr.ip4, protocol) )
+      mcast_index_remove(netif, sock_p, laddr.ip4, lport);
   }
 }
 #endif
@@ -608,6 +740,11 @@ void ci_netif_filter_init(ci_netif* ni, int size_lg2)
     ni->filter_table_ext[i].lport = 0;
     ni->filter_table->table[i].laddr = 0;
   }
+
+  if( ni->mcast_index != NULL )
+    for( i = 0; i < CI_CFG_MCAST_INDEX_BUCKETS; ++i )
+      ni->mcast_index[i] = OO_P_NULL;
+  ni->state->mcast_index_missing = 0;
 }
 
 #endif
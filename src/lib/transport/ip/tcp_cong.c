@@ -0,0 +1,928 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_SOURCE>
+**  \brief  TCP congestion control algorithms
+** </L5_PRIVATE>
+*//*
+\**************************************************************************/
+
+/*! \cidoxg_lib_transport_ip */
+
+#include "ip_internal.h"
+
+
+#define LPF "TCP CONG "
+
+
+ci_inline ci_uint32 ci_tcp_cong_ticks2us(ci_netif* ni, ci_iptime_t t)
+{
+  return t << (IPTIMER_STATE(ni)->ci_ip_time_frc2tick -
+               IPTIMER_STATE(ni)->ci_ip_time_frc2us);
+}
+
+
+/**********************************************************************
+ * Reno
+ */
+
+/* Slow start, common to all window-based algorithms. */
+static void ci_tcp_slow_start(ci_netif* ni, ci_tcp_state* ts)
+{
+  unsigned cwnd_inc;
+
+  LOG_TV(log(LPF "%d OPENCWND: SS eff_mss=%u bytes_acked=%u cwnd=%u",
+             S_FMT(ts), tcp_eff_mss(ts), ts->bytes_acked, ts->cwnd));
+#if CI_CFG_CONG_AVOID_SLOW_START_MODE == 2
+  cwnd_inc = CI_MIN(ts->ssthresh - ts->cwnd, ts->bytes_acked);
+  ts->cwnd += cwnd_inc;
+  ts->bytes_acked -= cwnd_inc;
+#else
+  if( CI_CFG_CONG_AVOID_SLOW_START_MODE == 0 && ts->stats.rtos == 0 )
+    /* RFC3465 sec 2.2: May only increase cwnd by more than mss if we've
+    * never had any RTOs on this connection.
+    */
+    cwnd_inc = tcp_eff_mss(ts) * CI_CFG_CONG_AVOID_RFC3465_L_VALUE;
+  else
+    cwnd_inc = tcp_eff_mss(ts);
+  cwnd_inc = CI_MIN(cwnd_inc, ts->bytes_acked);
+  ts->cwnd += cwnd_inc;
+  ts->bytes_acked = 0;
+#endif
+}
+
+
+/* function to open the congestion window following the
+** reception of an ack for new data. Implements RFC3465 (ABC)
+*/
+static void ci_tcp_reno_on_ack(ci_netif* ni, ci_tcp_state* ts,
+                               unsigned acked, int rtt)
+{
+#if CI_CFG_CONG_AVOID_NOTIFIED
+  /* If congestion has been notified (but no loss detected yet)
+     gradually scale the cwnd back */
+  if( ts->congstate == CI_TCP_CONG_NOTIFIED ){
+    if(SEQ_LE(tcp_snd_una(ts), ts->congrecover))
+      ts->congstate = CI_TCP_CONG_OPEN;
+  }
+  else
+#endif
+  if( ts->cwnd >= ts->ssthresh ) {
+    /* Hack - Increase less aggresively on small round trip times */
+#if CI_CFG_CONG_AVOID_SCALE_BACK
+    unsigned tmp = 0, cwnd_scaled;
+    /* tcp_srtt(ts) would relatively easy exceed 32 for a round trip time
+     * on longer links */
+    if( tcp_srtt(ts) < 32 )
+      tmp = NI_OPTS(ni).cong_avoid_scale_back >> tcp_srtt(ts);
+    cwnd_scaled = CI_MAX(1U, tmp) * ts->cwnd;
+#else
+    unsigned cwnd_scaled = ts->cwnd;
+#endif
+    /* Congestion avoidance.  RFC3465 says: increase the congestion window
+    ** by one segment each RTT.  i.e. wait for bytes_acked to be > cwnd
+    ** (which takes one RTT), then reset bytes_acked by subtracting the
+    ** cwnd from it, and add one segment to cwnd.
+    */
+    LOG_TV(log(LPF "%d OPENCWND: CA eff_mss=%u bytes_acked=%u cwnd=%u",
+               S_FMT(ts), tcp_eff_mss(ts), ts->bytes_acked, ts->cwnd));
+    if( ts->bytes_acked >= cwnd_scaled ) {
+      ts->bytes_acked -= cwnd_scaled;
+      ts->cwnd += tcp_eff_mss(ts);
+    }
+  }
+  else {
+    ci_tcp_slow_start(ni, ts);
+  }
+
+  LOG_TV(log(LPF "%d OPENCWND: end cwnd=%u", S_FMT(ts), ts->cwnd));
+}
+
+
+static ci_uint32 ci_tcp_reno_on_loss(ci_netif* ni, ci_tcp_state* ts)
+{
+  return ci_tcp_losswnd(ts);
+}
+
+
+static const ci_tcp_cong_ops ci_tcp_cong_reno = {
+  .name    = "reno",
+  .on_ack  = ci_tcp_reno_on_ack,
+  .on_loss = ci_tcp_reno_on_loss,
+};
+
+
+/**********************************************************************
+ * CUBIC (RFC 8312) with HyStart.  This follows the Linux implementation,
+ * but with time measured in ms and cwnd in segments for the cubic
+ * function.
+ */
+
+#define CUBIC_BETA              717   /* 0.7 * 1024 */
+#define CUBIC_BETA_SCALE        15    /* 8 * (1024 + beta) / 3 / (1024 - beta) */
+/* K = cbrt((W_max - cwnd) / C) with C = 0.4 segs/s^3, so in ms
+ * K = cbrt((W_max - cwnd) * 2.5e9), and the curve offset in segments for
+ * t ms is t^3 / 2.5e9. */
+#define CUBIC_TIME_SCALE        2500000000ull
+/* Bound on |t - K| that keeps t^3 within 64 bits. */
+#define CUBIC_OFFS_MAX          (1u << 21)
+
+#define HYSTART_LOW_WINDOW      16    /* segments */
+#define HYSTART_MIN_SAMPLES     8
+#define HYSTART_ACK_DELTA_US    2000
+#define HYSTART_DELAY_MIN_US    4000
+#define HYSTART_DELAY_MAX_US    16000
+
+
+/* Integer cube root (Hacker's Delight, icbrt64). */
+static ci_uint32 ci_tcp_cubic_cbrt(ci_uint64 x)
+{
+  ci_uint64 y = 0, b;
+  int s;
+
+  for( s = 63; s >= 0; s -= 3 ) {
+    y += y;
+    b = 3 * y * (y + 1) + 1;
+    if( (x >> s) >= b ) {
+      x -= b << s;
+      ++y;
+    }
+  }
+  return (ci_uint32) y;
+}
+
+
+ci_inline ci_uint32 ci_tcp_cubic_now_us(ci_netif* ni)
+{
+  return (ci_uint32) (IPTIMER_STATE(ni)->frc >>
+                      IPTIMER_STATE(ni)->ci_ip_time_frc2us);
+}
+
+
+static void ci_tcp_cubic_hystart_reset(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+
+  ca->round_start = ca->last_ack = ci_tcp_cubic_now_us(ni);
+  ca->end_seq = tcp_snd_nxt(ts);
+  ca->curr_rtt = ~0u;
+  ca->sample_cnt = 0;
+}
+
+
+static void ci_tcp_cubic_init(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+
+  memset(ca, 0, sizeof(*ca));
+  ci_tcp_cubic_hystart_reset(ni, ts);
+}
+
+
+static void ci_tcp_cubic_hystart_exit(ci_netif* ni, ci_tcp_state* ts,
+                                      const char* why)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+
+  ca->found = 1;
+  ts->ssthresh = ts->cwnd;
+  CITP_STATS_NETIF_INC(ni, tcp_cubic_hystart_exits);
+  LOG_TC(log(LNT_FMT "HyStart %s: cwnd=%u delay_min=%u curr_rtt=%u",
+             LNT_PRI_ARGS(ni, ts), why, ts->cwnd, ca->delay_min,
+             ca->curr_rtt));
+}
+
+
+/* Look for the point to leave slow start before loss: either the ACKs for
+ * a round arrive as a train lasting more than half the minimum RTT, or the
+ * RTT has grown noticeably over the round. */
+static void ci_tcp_cubic_hystart_update(ci_netif* ni, ci_tcp_state* ts,
+                                        ci_uint32 delay)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+  ci_uint32 now = ci_tcp_cubic_now_us(ni);
+
+  if( (ci_int32) (now - ca->last_ack) <= HYSTART_ACK_DELTA_US ) {
+    ca->last_ack = now;
+    if( (ci_int32) (now - ca->round_start) > (ca->delay_min >> 1) ) {
+      ci_tcp_cubic_hystart_exit(ni, ts, "ack train");
+      return;
+    }
+  }
+
+  if( delay == 0 )
+    return;
+  if( ca->curr_rtt > delay )
+    ca->curr_rtt = delay;
+  if( ca->sample_cnt < HYSTART_MIN_SAMPLES ) {
+    ++ca->sample_cnt;
+  }
+  else {
+    ci_uint32 thresh = CI_MIN(CI_MAX(ca->delay_min >> 3,
+                                     HYSTART_DELAY_MIN_US),
+                              HYSTART_DELAY_MAX_US);
+    if( ca->curr_rtt > ca->delay_min + thresh )
+      ci_tcp_cubic_hystart_exit(ni, ts, "delay");
+  }
+}
+
+
+/* Compute [cnt], the number of segments to be acked for each increase of
+ * cwnd by one segment, so as to follow the cubic curve. */
+static void ci_tcp_cubic_update(ci_netif* ni, ci_tcp_state* ts,
+                                ci_uint32 segs)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+  ci_iptime_t now = ci_tcp_time_now(ni);
+  ci_uint32 t, offs, delta, target, mss = tcp_eff_mss(ts);
+
+  if( ca->epoch_start != 0 && ca->last_cwnd == segs && ca->last_time == now )
+    return;
+  ca->last_cwnd = segs;
+  ca->last_time = now;
+
+  if( ca->epoch_start == 0 ) {
+    ca->epoch_start = now ? now : 1;
+    ca->ack_bytes = 0;
+    ca->tcp_cwnd = segs;
+    if( ca->last_max_cwnd <= segs ) {
+      ca->K = 0;
+      ca->origin_point = segs;
+    }
+    else {
+      ca->K = ci_tcp_cubic_cbrt((ci_uint64) (ca->last_max_cwnd - segs) *
+                                CUBIC_TIME_SCALE);
+      ca->origin_point = ca->last_max_cwnd;
+    }
+  }
+
+  /* Aim for where the curve will be one RTT from now.  delay_min is in
+   * usec, which is near enough 1024 per ms. */
+  t = ci_ip_time_ticks2ms(ni, now - ca->epoch_start) + (ca->delay_min >> 10);
+  offs = t < ca->K ? ca->K - t : t - ca->K;
+  offs = CI_MIN(offs, CUBIC_OFFS_MAX);
+  delta = (ci_uint32) ((ci_uint64) offs * offs * offs / CUBIC_TIME_SCALE);
+  if( t < ca->K )
+    target = ca->origin_point - CI_MIN(delta, ca->origin_point);
+  else
+    target = ca->origin_point + delta;
+
+  if( target > segs )
+    ca->cnt = segs / (target - segs);
+  else
+    ca->cnt = 100 * segs;
+  /* No loss yet: don't be slower than Reno would be. */
+  if( ca->last_max_cwnd == 0 && ca->cnt > 20 )
+    ca->cnt = 20;
+
+  /* TCP-friendly region: track what Reno would have, and grow at least
+   * that fast. */
+  {
+    ci_uint32 per_seg = CI_MAX((segs * CUBIC_BETA_SCALE) >> 3, 1u) * mss;
+    ci_uint32 n = ca->ack_bytes / per_seg;
+    ca->tcp_cwnd += n;
+    ca->ack_bytes -= n * per_seg;
+    if( ca->tcp_cwnd > segs ) {
+      ci_uint32 max_cnt = segs / (ca->tcp_cwnd - segs);
+      ca->cnt = CI_MIN(ca->cnt, max_cnt);
+    }
+  }
+
+  ca->cnt = CI_MAX(ca->cnt, 2u);
+}
+
+
+static void ci_tcp_cubic_on_ack(ci_netif* ni, ci_tcp_state* ts,
+                                unsigned acked, int rtt)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+  ci_uint32 delay = 0, segs, w;
+
+  if( rtt >= 0 ) {
+    delay = ci_tcp_cong_ticks2us(ni, CI_MAX(rtt, 1));
+    if( ca->delay_min == 0 || ca->delay_min > delay )
+      ca->delay_min = delay;
+  }
+
+  if( ts->cwnd < ts->ssthresh ) {
+    if( SEQ_GT(tcp_snd_una(ts) + acked, ca->end_seq) )
+      ci_tcp_cubic_hystart_reset(ni, ts);
+    if( ! ca->found && ca->delay_min != 0 &&
+        ts->cwnd >= HYSTART_LOW_WINDOW * tcp_eff_mss(ts) )
+      ci_tcp_cubic_hystart_update(ni, ts, delay);
+    if( ts->cwnd < ts->ssthresh ) {
+      ci_tcp_slow_start(ni, ts);
+      return;
+    }
+  }
+
+  segs = ts->cwnd / tcp_eff_mss(ts);
+  ca->ack_bytes += acked;
+  ci_tcp_cubic_update(ni, ts, segs);
+
+  w = ca->cnt * tcp_eff_mss(ts);
+  if( ts->bytes_acked >= w ) {
+    ci_uint32 n = ts->bytes_acked / w;
+    ts->bytes_acked -= n * w;
+    ts->cwnd += n * tcp_eff_mss(ts);
+  }
+  LOG_TV(log(LPF "%d CUBIC: cwnd=%u cnt=%u K=%u origin=%u",
+             S_FMT(ts), ts->cwnd, ca->cnt, ca->K, ca->origin_point));
+}
+
+
+static ci_uint32 ci_tcp_cubic_on_loss(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+  ci_uint32 segs = ts->cwnd / tcp_eff_mss(ts);
+  ci_uint64 x;
+
+  ca->epoch_start = 0;
+  /* Fast convergence: release bandwidth to newer flows. */
+  if( segs < ca->last_max_cwnd )
+    ca->last_max_cwnd = (segs * (1024 + CUBIC_BETA)) / (2 * 1024);
+  else
+    ca->last_max_cwnd = segs;
+
+  x = ((ci_uint64) ci_tcp_inflight(ts) * CUBIC_BETA) >> 10;
+  return CI_MAX((ci_uint32) x, (ci_uint32) tcp_eff_mss(ts) << 1u);
+}
+
+
+static void ci_tcp_cubic_on_rto(ci_netif* ni, ci_tcp_state* ts)
+{
+  ci_tcp_cubic_init(ni, ts);
+}
+
+
+static void ci_tcp_cubic_on_idle(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+  ci_iptime_t now = ci_tcp_time_now(ni);
+
+  /* Don't let the idle period count as time spent growing cwnd. */
+  if( ca->epoch_start != 0 && TIME_GT(now, ca->last_time) ) {
+    ca->epoch_start += now - ca->last_time;
+    if( TIME_GT(ca->epoch_start, now) )
+      ca->epoch_start = now;
+    ca->last_time = now;
+  }
+}
+
+
+static void ci_tcp_cubic_dump(ci_netif* ni, ci_tcp_state* ts, const char* pf,
+                              oo_dump_log_fn_t logger, void* log_arg)
+{
+  struct oo_tcp_cubic* ca = &ci_tcp_cc(ni, ts)->cc.cubic;
+
+  logger(log_arg, "%s  cubic: w_max=%u origin=%u K=%u epoch=%x cnt=%u "
+         "tcp_cwnd=%u", pf, ca->last_max_cwnd, ca->origin_point, ca->K,
+         ca->epoch_start, ca->cnt, ca->tcp_cwnd);
+  logger(log_arg, "%s  hystart: found=%d delay_min=%u curr_rtt=%u",
+         pf, ca->found, ca->delay_min, ca->curr_rtt);
+}
+
+
+static const ci_tcp_cong_ops ci_tcp_cong_cubic = {
+  .name    = "cubic",
+  .init    = ci_tcp_cubic_init,
+  .on_ack  = ci_tcp_cubic_on_ack,
+  .on_loss = ci_tcp_cubic_on_loss,
+  .on_rto  = ci_tcp_cubic_on_rto,
+  .on_idle = ci_tcp_cubic_on_idle,
+  .dump    = ci_tcp_cubic_dump,
+};
+
+
+/**********************************************************************
+ * BBR.  This follows BBR v1 (draft-cardwell-iccrg-bbr-congestion-control),
+ * except that the delivery rate is sampled once per round trip from the
+ * bytes acknowledged over the round, rather than per packet.  Rates are in
+ * CI_TCP_PACE_SHIFT units, and times on the usec clock.
+ */
+
+#define BBR_UNIT                256   /* gains are 8.8 fixed point */
+#define BBR_HIGH_GAIN           739   /* 2/ln(2) */
+#define BBR_DRAIN_GAIN          88    /* ln(2)/2 */
+#define BBR_CWND_GAIN           512
+#define BBR_PACING_MARGIN       253   /* pace 1% below the modelled rate */
+#define BBR_CYCLE_LEN           8
+#define BBR_BW_ROUNDS           5     /* half the bandwidth filter window */
+#define BBR_MIN_RTT_WIN_MS      10000
+#define BBR_PROBE_RTT_MS        200
+#define BBR_MIN_CWND_SEGS       4
+#define BBR_FULL_BW_THRESH      320   /* growth of 25% per round */
+#define BBR_FULL_BW_CNT         3
+
+#define CI_TCP_BBR_STARTUP      0
+#define CI_TCP_BBR_DRAIN        1
+#define CI_TCP_BBR_PROBE_BW     2
+#define CI_TCP_BBR_PROBE_RTT    3
+
+#define CI_TCP_BBR_FLAG_FULL_BW          0x1  /* bottleneck is full */
+#define CI_TCP_BBR_FLAG_RS_APP_LIMITED   0x2  /* rate sample app-limited */
+#define CI_TCP_BBR_FLAG_PROBE_RTT_ROUND  0x4  /* round done in PROBE_RTT */
+
+static const ci_uint16 ci_tcp_bbr_cycle_gain[BBR_CYCLE_LEN] = {
+  320, 192, 256, 256, 256, 256, 256, 256
+};
+
+
+ci_inline ci_uint32 ci_tcp_bbr_bw(const struct oo_tcp_bbr* bbr)
+{
+  return CI_MAX(bbr->bw[0], bbr->bw[1]);
+}
+
+
+ci_inline unsigned ci_tcp_bbr_pacing_gain(const struct oo_tcp_bbr* bbr)
+{
+  switch( bbr->mode ) {
+  case CI_TCP_BBR_STARTUP:
+    return BBR_HIGH_GAIN;
+  case CI_TCP_BBR_DRAIN:
+    return BBR_DRAIN_GAIN;
+  case CI_TCP_BBR_PROBE_BW:
+    return ci_tcp_bbr_cycle_gain[bbr->cycle_idx % BBR_CYCLE_LEN];
+  default:
+    return BBR_UNIT;
+  }
+}
+
+
+ci_inline unsigned ci_tcp_bbr_cwnd_gain(const struct oo_tcp_bbr* bbr)
+{
+  switch( bbr->mode ) {
+  case CI_TCP_BBR_STARTUP:
+  case CI_TCP_BBR_DRAIN:
+    return BBR_HIGH_GAIN;
+  case CI_TCP_BBR_PROBE_BW:
+    return BBR_CWND_GAIN;
+  default:
+    return BBR_UNIT;
+  }
+}
+
+
+/* The bandwidth-delay product scaled by [gain], plus allowance for
+ * delayed and stretched ACKs.  In bytes. */
+static ci_uint32 ci_tcp_bbr_target(ci_netif* ni, ci_tcp_state* ts,
+                                   unsigned gain)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  ci_uint64 bdp;
+
+  if( bbr->min_rtt == ~0u )
+    return ts->cwnd;
+  bdp = ((ci_uint64) ci_tcp_bbr_bw(bbr) * bbr->min_rtt) >> CI_TCP_PACE_SHIFT;
+  bdp = (bdp * gain) / BBR_UNIT + 3 * tcp_eff_mss(ts);
+  return (ci_uint32) CI_MIN(bdp, 0x7fffffffull);
+}
+
+
+static void ci_tcp_bbr_set_pacing_rate(ci_netif* ni, ci_tcp_state* ts,
+                                       unsigned gain)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  ci_uint64 rate = ci_tcp_bbr_bw(bbr);
+
+  if( rate == 0 )
+    return;
+  rate = (rate * gain * BBR_PACING_MARGIN) / (BBR_UNIT * BBR_UNIT);
+  rate = CI_MIN(CI_MAX(rate, 1), 0xffffffffull);
+  /* Until the pipe is known to be full, the initial rate derived from
+   * cwnd may be more accurate than a sample from the first few rounds. */
+  if( rate != bbr->pacing_rate &&
+      ((bbr->flags & CI_TCP_BBR_FLAG_FULL_BW) || rate > bbr->pacing_rate) ) {
+    bbr->pacing_rate = (ci_uint32) rate;
+    ci_tcp_pace_update(ni, ts);
+  }
+}
+
+
+static void ci_tcp_bbr_init(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  ci_uint32 rtt_us;
+
+  memset(bbr, 0, sizeof(*bbr));
+  bbr->min_rtt = ~0u;
+  bbr->min_rtt_stamp = ci_tcp_time_now(ni);
+  ci_ip_time_get_us(IPTIMER_STATE(ni), &bbr->rs_start);
+  bbr->rs_una = tcp_snd_una(ts);
+  bbr->round_end = tcp_snd_nxt(ts);
+  bbr->mode = CI_TCP_BBR_STARTUP;
+
+  /* Until there is a bandwidth sample, pace at the startup gain applied to
+   * cwnd over the smoothed RTT. */
+  rtt_us = ci_tcp_cong_ticks2us(ni, CI_MAX(tcp_srtt(ts), 1));
+  bbr->pacing_rate = (ci_uint32) CI_MIN(
+      ((((ci_uint64) ts->cwnd << CI_TCP_PACE_SHIFT) * BBR_HIGH_GAIN) /
+       BBR_UNIT) / rtt_us, 0xffffffffull);
+}
+
+
+/* RTT of the oldest packet in the retransmit queue, if this ACK covers it
+ * and it has not been retransmitted.  Failing that, the tick-resolution
+ * RTT sample [rtt] if there is one.  Returns 0 if there is no sample.
+ */
+static ci_uint32 ci_tcp_bbr_rtt_us(ci_netif* ni, ci_tcp_state* ts,
+                                   ci_uint32 ack, ci_uint32 now_us, int rtt)
+{
+  if( ci_ip_queue_not_empty(&ts->retrans) ) {
+    ci_ip_pkt_fmt* pkt = PKT_CHK(ni, ts->retrans.head);
+    if( pkt->tstamp_frc != 0 && SEQ_LE(pkt->pf.tcp_tx.end_seq, ack) &&
+        ! (pkt->flags & CI_PKT_FLAG_RTQ_RETRANS) ) {
+      ci_uint32 sent = pkt->tstamp_frc >> IPTIMER_STATE(ni)->ci_ip_time_frc2us;
+      return CI_MAX(now_us - sent, 1u);
+    }
+  }
+  if( rtt >= 0 )
+    return ci_tcp_cong_ticks2us(ni, CI_MAX(rtt, 1));
+  return 0;
+}
+
+
+static void ci_tcp_bbr_enter_probe_bw(ci_netif* ni, ci_tcp_state* ts,
+                                      ci_uint32 now_us)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+
+  bbr->mode = CI_TCP_BBR_PROBE_BW;
+  /* Start at a random phase, but not in the phase that drains the queue
+   * as there should be none. */
+  bbr->cycle_idx = (2 + now_us % (BBR_CYCLE_LEN - 1)) % BBR_CYCLE_LEN;
+  bbr->cycle_start = now_us;
+}
+
+
+static void ci_tcp_bbr_update_cycle(ci_netif* ni, ci_tcp_state* ts,
+                                    ci_uint32 now_us)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  unsigned gain = ci_tcp_bbr_pacing_gain(bbr);
+  int advance = bbr->min_rtt != ~0u &&
+                now_us - bbr->cycle_start > bbr->min_rtt;
+
+  /* Probe for more bandwidth until the extra data is in flight; drain the
+   * resulting queue until it is gone. */
+  if( gain > BBR_UNIT )
+    advance = advance &&
+              ci_tcp_inflight(ts) >= ci_tcp_bbr_target(ni, ts, gain);
+  else if( gain < BBR_UNIT )
+    advance = advance ||
+              ci_tcp_inflight(ts) <= ci_tcp_bbr_target(ni, ts, BBR_UNIT);
+  if( advance ) {
+    bbr->cycle_idx = (bbr->cycle_idx + 1) % BBR_CYCLE_LEN;
+    bbr->cycle_start = now_us;
+  }
+}
+
+
+static void ci_tcp_bbr_update_probe_rtt(ci_netif* ni, ci_tcp_state* ts,
+                                        int round_start, ci_iptime_t now,
+                                        ci_uint32 now_us)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  ci_uint32 min_inflight = BBR_MIN_CWND_SEGS * tcp_eff_mss(ts);
+
+  if( bbr->probe_rtt_done == 0 ) {
+    if( ci_tcp_inflight(ts) <= min_inflight ) {
+      bbr->probe_rtt_done = now + ci_tcp_time_ms2ticks(ni, BBR_PROBE_RTT_MS);
+      if( bbr->probe_rtt_done == 0 )
+        bbr->probe_rtt_done = 1;
+      bbr->flags &= ~CI_TCP_BBR_FLAG_PROBE_RTT_ROUND;
+      bbr->round_end = tcp_snd_nxt(ts);
+    }
+    return;
+  }
+
+  if( round_start )
+    bbr->flags |= CI_TCP_BBR_FLAG_PROBE_RTT_ROUND;
+  if( (bbr->flags & CI_TCP_BBR_FLAG_PROBE_RTT_ROUND) &&
+      TIME_GE(now, bbr->probe_rtt_done) ) {
+    bbr->min_rtt_stamp = now;
+    ts->cwnd = CI_MAX(ts->cwnd, bbr->prior_cwnd);
+    if( bbr->flags & CI_TCP_BBR_FLAG_FULL_BW )
+      ci_tcp_bbr_enter_probe_bw(ni, ts, now_us);
+    else
+      bbr->mode = CI_TCP_BBR_STARTUP;
+  }
+}
+
+
+static void ci_tcp_bbr_on_ack(ci_netif* ni, ci_tcp_state* ts,
+                              unsigned acked, int rtt)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+  ci_uint32 ack = tcp_snd_una(ts) + acked;
+  ci_uint32 mss = tcp_eff_mss(ts);
+  ci_iptime_t now = ci_tcp_time_now(ni);
+  ci_uint32 now_us, rtt_us, target;
+  int round_start = 0, min_rtt_expired;
+
+  ci_ip_time_get_us(IPTIMER_STATE(ni), &now_us);
+  /* cwnd is set from the model, not by counting bytes. */
+  ts->bytes_acked = 0;
+
+  /* Count round trips, and take a delivery rate sample each round. */
+  if( SEQ_GE(ack, bbr->round_end) ) {
+    ci_uint32 elapsed = now_us - bbr->rs_start;
+    int app_limited = bbr->flags & CI_TCP_BBR_FLAG_RS_APP_LIMITED;
+
+    round_start = 1;
+    bbr->round_end = tcp_snd_nxt(ts);
+    if( ++bbr->rounds % BBR_BW_ROUNDS == 0 ) {
+      bbr->bw[1] = bbr->bw[0];
+      bbr->bw[0] = 0;
+    }
+    if( elapsed != 0 ) {
+      ci_uint64 bw = ((ci_uint64) SEQ_SUB(ack, bbr->rs_una) <<
+                      CI_TCP_PACE_SHIFT) / elapsed;
+      bw = CI_MIN(bw, 0xffffffffull);
+      /* An app-limited sample shows only that the path can go at least
+       * this fast. */
+      if( ! app_limited || bw > ci_tcp_bbr_bw(bbr) )
+        bbr->bw[0] = CI_MAX(bbr->bw[0], (ci_uint32) bw);
+    }
+
+    /* The pipe is full once bandwidth stops growing in startup. */
+    if( ! (bbr->flags & CI_TCP_BBR_FLAG_FULL_BW) && ! app_limited ) {
+      ci_uint32 bw = ci_tcp_bbr_bw(bbr);
+      if( bw >= ((ci_uint64) bbr->full_bw * BBR_FULL_BW_THRESH) / BBR_UNIT ) {
+        bbr->full_bw = bw;
+        bbr->full_bw_cnt = 0;
+      }
+      else if( ++bbr->full_bw_cnt >= BBR_FULL_BW_CNT ) {
+        bbr->flags |= CI_TCP_BBR_FLAG_FULL_BW;
+      }
+    }
+
+    bbr->rs_start = now_us;
+    bbr->rs_una = ack;
+    if( ci_ip_queue_is_empty(&ts->send) && ci_tcp_inflight(ts) < ts->cwnd )
+      bbr->flags |= CI_TCP_BBR_FLAG_RS_APP_LIMITED;
+    else
+      bbr->flags &= ~CI_TCP_BBR_FLAG_RS_APP_LIMITED;
+  }
+
+  /* Min RTT over a sliding window. */
+  min_rtt_expired = TIME_GT(now, bbr->min_rtt_stamp +
+                            ci_tcp_time_ms2ticks(ni, BBR_MIN_RTT_WIN_MS));
+  rtt_us = ci_tcp_bbr_rtt_us(ni, ts, ack, now_us, rtt);
+  if( rtt_us != 0 && (rtt_us <= bbr->min_rtt || min_rtt_expired) ) {
+    bbr->min_rtt = rtt_us;
+    bbr->min_rtt_stamp = now;
+  }
+
+  /* State machine. */
+  if( bbr->mode == CI_TCP_BBR_STARTUP &&
+      (bbr->flags & CI_TCP_BBR_FLAG_FULL_BW) ) {
+    bbr->mode = CI_TCP_BBR_DRAIN;
+    ts->ssthresh = CI_MAX(ci_tcp_bbr_target(ni, ts, BBR_UNIT), mss << 1u);
+  }
+  if( bbr->mode == CI_TCP_BBR_DRAIN &&
+      ci_tcp_inflight(ts) <= ci_tcp_bbr_target(ni, ts, BBR_UNIT) )
+    ci_tcp_bbr_enter_probe_bw(ni, ts, now_us);
+  if( bbr->mode == CI_TCP_BBR_PROBE_BW )
+    ci_tcp_bbr_update_cycle(ni, ts, now_us);
+  if( min_rtt_expired && bbr->mode != CI_TCP_BBR_PROBE_RTT ) {
+    bbr->mode = CI_TCP_BBR_PROBE_RTT;
+    bbr->prior_cwnd = ts->cwnd;
+    bbr->probe_rtt_done = 0;
+  }
+  if( bbr->mode == CI_TCP_BBR_PROBE_RTT )
+    ci_tcp_bbr_update_probe_rtt(ni, ts, round_start, now, now_us);
+
+  /* cwnd follows the model once the pipe is full, and grows as in slow
+   * start until then. */
+  target = ci_tcp_bbr_target(ni, ts, ci_tcp_bbr_cwnd_gain(bbr));
+  if( bbr->flags & CI_TCP_BBR_FLAG_FULL_BW )
+    ts->cwnd = CI_MIN(ts->cwnd + acked, target);
+  else if( ts->cwnd < target || bbr->min_rtt == ~0u )
+    ts->cwnd += acked;
+  ts->cwnd = CI_MAX(ts->cwnd, BBR_MIN_CWND_SEGS * mss);
+  if( bbr->mode == CI_TCP_BBR_PROBE_RTT )
+    ts->cwnd = CI_MIN(ts->cwnd, BBR_MIN_CWND_SEGS * mss);
+
+  ci_tcp_bbr_set_pacing_rate(ni, ts, ci_tcp_bbr_pacing_gain(bbr));
+  LOG_TV(log(LPF "%d BBR: mode=%d bw=%u min_rtt=%u cwnd=%u pace=%u",
+             S_FMT(ts), bbr->mode, ci_tcp_bbr_bw(bbr), bbr->min_rtt,
+             ts->cwnd, bbr->pacing_rate));
+}
+
+
+/* The model is not reduced on loss: recovery proceeds from the current
+ * flight size, and on_ack() restores cwnd to the model's target. */
+static ci_uint32 ci_tcp_bbr_on_loss(ci_netif* ni, ci_tcp_state* ts)
+{
+  return CI_MAX(ci_tcp_inflight(ts), (ci_uint32) tcp_eff_mss(ts) << 1u);
+}
+
+
+static void ci_tcp_bbr_on_idle(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+
+  /* Don't restart faster than the estimated bandwidth, and don't take the
+   * idle period as a sign of low bandwidth. */
+  bbr->flags |= CI_TCP_BBR_FLAG_RS_APP_LIMITED;
+  if( bbr->mode == CI_TCP_BBR_PROBE_BW )
+    ci_tcp_bbr_set_pacing_rate(ni, ts, BBR_UNIT);
+}
+
+
+static ci_uint32 ci_tcp_bbr_pacing_rate(ci_netif* ni, ci_tcp_state* ts)
+{
+  return ci_tcp_cc(ni, ts)->cc.bbr.pacing_rate;
+}
+
+
+static void ci_tcp_bbr_dump(ci_netif* ni, ci_tcp_state* ts, const char* pf,
+                            oo_dump_log_fn_t logger, void* log_arg)
+{
+  static const char* const modes[] = {
+    "STARTUP", "DRAIN", "PROBE_BW", "PROBE_RTT"
+  };
+  struct oo_tcp_bbr* bbr = &ci_tcp_cc(ni, ts)->cc.bbr;
+
+  logger(log_arg, "%s  bbr: %s%s bw=%"CI_PRIu64"B/s min_rtt=%uus "
+         "pacing=%"CI_PRIu64"B/s cycle=%u rounds=%u", pf,
+         bbr->mode < 4 ? modes[bbr->mode] : "?",
+         (bbr->flags & CI_TCP_BBR_FLAG_FULL_BW) ? " FULL" : "",
+         ci_tcp_pace_rate_to_bps(ni, ci_tcp_bbr_bw(bbr)), bbr->min_rtt,
+         ci_tcp_pace_rate_to_bps(ni, bbr->pacing_rate), bbr->cycle_idx,
+         bbr->rounds);
+}
+
+
+static const ci_tcp_cong_ops ci_tcp_cong_bbr = {
+  .name        = "bbr",
+  .init        = ci_tcp_bbr_init,
+  .on_ack      = ci_tcp_bbr_on_ack,
+  .on_loss     = ci_tcp_bbr_on_loss,
+  .on_idle     = ci_tcp_bbr_on_idle,
+  .pacing_rate = ci_tcp_bbr_pacing_rate,
+  .dump        = ci_tcp_bbr_dump,
+};
+
+
+/**********************************************************************
+ * DCTCP (RFC 8257).  Window growth and the response to loss are as for
+ * Reno.  The response to ECN is in proportion to [alpha], a moving average
+ * of the fraction of bytes for which the receiver echoed a CE mark.
+ */
+
+#define DCTCP_ALPHA_SHIFT       10    /* alpha is scaled by 1024 */
+#define DCTCP_G_SHIFT           4     /* gain g = 1/16 */
+
+
+static void ci_tcp_dctcp_init(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_dctcp* dc = &ci_tcp_cc(ni, ts)->cc.dctcp;
+
+  /* Start by assuming every byte is marked, so the first reduction is as
+   * conservative as Reno's. */
+  dc->alpha = 1u << DCTCP_ALPHA_SHIFT;
+  dc->acked = 0;
+  dc->acked_ce = 0;
+  dc->window_end = tcp_snd_nxt(ts);
+}
+
+
+static void ci_tcp_dctcp_on_ecn(ci_netif* ni, ci_tcp_state* ts,
+                                unsigned acked, int ece)
+{
+  struct oo_tcp_dctcp* dc = &ci_tcp_cc(ni, ts)->cc.dctcp;
+  ci_uint32 frac, dec;
+
+  dc->acked += acked;
+  if( ece )
+    dc->acked_ce += acked;
+  if( SEQ_LT(tcp_snd_una(ts), dc->window_end) )
+    return;
+
+  /* A window of data has been acked: alpha = (1 - g) * alpha + g * F */
+  frac = dc->acked == 0 ? 0 :
+    (ci_uint32) (((ci_uint64) dc->acked_ce << DCTCP_ALPHA_SHIFT) / dc->acked);
+  dec = dc->alpha >> DCTCP_G_SHIFT;
+  /* As Linux, let alpha decay all the way to zero. */
+  if( dec == 0 )
+    dec = dc->alpha;
+  dc->alpha = CI_MIN(dc->alpha - dec + (frac >> DCTCP_G_SHIFT),
+                     1u << DCTCP_ALPHA_SHIFT);
+  LOG_TV(log(LPF "%d DCTCP: acked=%u ce=%u alpha=%u", S_FMT(ts),
+             dc->acked, dc->acked_ce, dc->alpha));
+  dc->acked = 0;
+  dc->acked_ce = 0;
+  dc->window_end = tcp_snd_nxt(ts);
+}
+
+
+/* cwnd = cwnd * (1 - alpha / 2) */
+static ci_uint32 ci_tcp_dctcp_ecn_ssthresh(ci_netif* ni, ci_tcp_state* ts)
+{
+  ci_uint32 cwnd = ts->cwnd;
+  ci_uint32 cut = ((ci_uint64) cwnd * ci_tcp_cc(ni, ts)->cc.dctcp.alpha) >>
+                  (DCTCP_ALPHA_SHIFT + 1);
+  return CI_MAX(cwnd - cut, (ci_uint32) tcp_eff_mss(ts) << 1u);
+}
+
+
+static void ci_tcp_dctcp_dump(ci_netif* ni, ci_tcp_state* ts, const char* pf,
+                              oo_dump_log_fn_t logger, void* log_arg)
+{
+  struct oo_tcp_dctcp* dc = &ci_tcp_cc(ni, ts)->cc.dctcp;
+
+  logger(log_arg, "%s  dctcp: alpha=%u/%u acked=%u ce=%u", pf, dc->alpha,
+         1u << DCTCP_ALPHA_SHIFT, dc->acked, dc->acked_ce);
+}
+
+
+static const ci_tcp_cong_ops ci_tcp_cong_dctcp = {
+  .name         = "dctcp",
+  .flags        = CI_TCP_CONG_FLAG_NEEDS_ECN,
+  .init         = ci_tcp_dctcp_init,
+  .on_ack       = ci_tcp_reno_on_ack,
+  .on_loss      = ci_tcp_reno_on_loss,
+  .on_ecn       = ci_tcp_dctcp_on_ecn,
+  .ecn_ssthresh = ci_tcp_dctcp_ecn_ssthresh,
+  .dump         = ci_tcp_dctcp_dump,
+};
+
+
+/**********************************************************************/
+
+const ci_tcp_cong_ops* const ci_tcp_cong_ops_tbl[CI_TCP_CONG_NUM] = {
+  [EF_TCP_CONGESTION_RENO]  = &ci_tcp_cong_reno,
+  [EF_TCP_CONGESTION_CUBIC] = &ci_tcp_cong_cubic,
+  [EF_TCP_CONGESTION_BBR]   = &ci_tcp_cong_bbr,
+  [EF_TCP_CONGESTION_DCTCP] = &ci_tcp_cong_dctcp,
+};
+
+
+int ci_tcp_cong_find(const char* name, int len)
+{
+  int i;
+
+  for( i = 0; i < CI_TCP_CONG_NUM; ++i )
+    if( strncmp(ci_tcp_cong_ops_tbl[i]->name, name, len) == 0 &&
+        ci_tcp_cong_ops_tbl[i]->name[len] == '\0' )
+      return i;
+  return -ENOENT;
+}
+
+
+void ci_tcp_cong_set(ci_netif* ni, ci_tcp_state* ts, int alg)
+{
+  ci_assert_ge(alg, 0);
+  ci_assert_lt(alg, CI_TCP_CONG_NUM);
+
+  ts->c.cc_alg = alg;
+  /* Once the connection is up the new algorithm takes over the current
+   * cwnd and ssthresh.  Before then, ci_tcp_set_initialcwnd() will
+   * initialise it. */
+  if( ts->s.b.state & CI_TCP_STATE_SYNCHRONISED )
+    ci_tcp_cong_init(ni, ts);
+}
+
+
+/* The congestion control and RACK state is only needed by some
+ * connections, so lives in an aux buffer that is freed by
+ * ci_tcp_stop_timers().  Without one, the connection falls back to Reno
+ * and to loss detection by dupacks. */
+int ci_tcp_cc_state_alloc(ci_netif* ni, ci_tcp_state* ts)
+{
+  oo_p p;
+
+  ci_assert(OO_P_IS_NULL(ts->cc_state));
+  p = ci_ni_aux_alloc(ni, CI_TCP_AUX_TYPE_TCP_CC);
+  if( OO_P_IS_NULL(p) ) {
+    LOG_TC(log(LNT_FMT "no aux buffer for congestion control state",
+               LNT_PRI_ARGS(ni, ts)));
+    return 0;
+  }
+  ts->cc_state = p;
+  memset(ci_tcp_cc(ni, ts), 0, sizeof(ci_tcp_cc_state));
+  ci_tcp_rack_init(ni, ts);
+  return 1;
+}
+
+
+void ci_tcp_pace_update(ci_netif* ni, ci_tcp_state* ts)
+{
+  const ci_tcp_cong_ops* ops = ci_tcp_cong_ts(ts);
+  ci_uint32 rate = ops->pacing_rate != NULL ? ops->pacing_rate(ni, ts) : 0;
+
+  if( ts->c.max_pacing_rate != CI_TCP_PACING_RATE_UNLIMITED ) {
+    ci_uint32 max_rate = ci_tcp_pace_rate_from_bps(ni, ts->c.max_pacing_rate);
+    if( rate == 0 || rate > max_rate )
+      rate = max_rate;
+  }
+  /* [pace_next] means nothing while unpaced, so start from now */
+  if( ts->pace_rate == 0 && rate != 0 )
+    ci_ip_time_get_us(IPTIMER_STATE(ni), &ts->pace_next);
+  ts->pace_rate = rate;
+}
+
+/*! \cidoxg_end */
@@ -1118,8 +1118,18 @@ static int ci_tcp_connect_ul_start(ci_netif *ni, ci_tcp_state* ts, ci_fd_t fd,
   /* Must be after initialising snd_una. */
   ci_tcp_clear_rtt_timing(ts);
   ci_tcp_set_flags(ts, CI_TCP_FLAG_SYN);
-  ts->tcpflags &=~ CI_TCPT_FLAG_OPT_MASK;
+  ts->tcpflags &=~ (CI_TCPT_FLAG_OPT_MASK | CI_TCPT_FLAG_FASTOPEN |
+                    CI_TCPT_FLAG_FASTOPEN_DEFER | CI_TCPT_FLAG_FASTOPEN_DATA);
   ts->tcpflags |= NI_OPTS(ni).syn_opts;
+  if( ts->c.fastopen_connect &&
+      (NI_OPTS(ni).tcp_fastopen & EF_TCP_FASTOPEN_CLIENT) &&
+      ~ts->s.pkt.flags & CI_IP_CACHE_IS_LOCALROUTE )
+    ts->tcpflags |= CI_TCPT_FLAG_FASTOPEN;
+  if( ci_tcp_cong_needs_ecn(&ts->c) )
+    ts->tcpflags |= CI_TCPT_FLAG_ECN;
+  /* ECN-setup SYN (RFC 3168 section 6.1.1) */
+  if( ts->tcpflags & CI_TCPT_FLAG_ECN )
+    ci_tcp_set_flags(ts, CI_TCP_FLAG_SYN | CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR);
 
   if( (ts->tcpflags & CI_TCPT_FLAG_WSCL) ) {
     if( NI_OPTS(ni).tcp_rcvbuf_mode == 1 )
@@ -1167,6 +1177,19 @@ static int ci_tcp_connect_ul_start(ci_netif *ni, ci_tcp_state* ts, ci_fd_t fd,
   ci_assert(ts->snd_max == tcp_snd_nxt(ts) + 1);
   ts->s.rx_errno = 0;
   ts->s.tx_errno = 0; 
+
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN ) {
+    ci_uint8 cookie[CI_TCP_FASTOPEN_COOKIE_MAX];
+    if( ci_tcp_fastopen_cache_get(ni, tcp_ipx_raddr(ts), cookie) != 0 ) {
+      /* We have a cookie for this peer, so hold the SYN back until the
+       * first send, which it will carry.  connect() succeeds at once. */
+      ts->tcpflags |= CI_TCPT_FLAG_FASTOPEN_DEFER;
+      ci_netif_pkt_release(ni, pkt);
+      LOG_TC(log(LNT_FMT "Fast Open connect deferred", LNT_PRI_ARGS(ni, ts)));
+      return CI_CONNECT_UL_OK;
+    }
+  }
+
   /* If ARP resolution fails, we have to drop the connection, so we store
    * the socket id in the SYN packet. */
   pkt->pf.tcp_tx.sock_id = ts->s.b.bufid;
@@ -1204,6 +1227,10 @@ static int ci_tcp_connect_ul_syn_sent(ci_netif *ni, ci_tcp_state *ts)
 {
   int rc = 0;
 
+  /* The SYN will go with the first send. */
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER )
+    return 0;
+
   if( ts->s.b.state == CI_TCP_SYN_SENT ) {
     ci_uint32 timeout = ts->s.so.sndtimeo_msec;
 
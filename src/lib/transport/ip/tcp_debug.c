@@ -140,13 +140,23 @@ static void ci_tcp_state_retrans_assert_valid(ci_netif* ni, ci_tcp_state* ts,
     }
     if( OO_PP_IS_NULL(pkt->pf.tcp_tx.block_end) )  break;
 
+    /* In a SACKed block [block_end] may point at any later packet of the
+    ** block, so follow it to the packet that points at itself.
+    */
     verify(IS_VALID_PKT_ID(ni, pkt->pf.tcp_tx.block_end));
     end = PKT(ni, pkt->pf.tcp_tx.block_end);
+    while( ! OO_PP_EQ(end->pf.tcp_tx.block_end, OO_PKT_P(end)) ) {
+      verify(is_sacked);
+      verify(IS_VALID_PKT_ID(ni, end->pf.tcp_tx.block_end));
+      end = PKT(ni, end->pf.tcp_tx.block_end);
+    }
 
     while( 1 ) {
       if( prev_pkt )
         verify(pkt->pf.tcp_tx.start_seq == prev_pkt->pf.tcp_tx.end_seq);
       verify(SEQ_LE(pkt->pf.tcp_tx.end_seq, end->pf.tcp_tx.end_seq));
+      verify(SEQ_LE(pkt->pf.tcp_tx.end_seq,
+                    PKT(ni, pkt->pf.tcp_tx.block_end)->pf.tcp_tx.end_seq));
       if( is_sacked )  verify(pkt->flags & CI_PKT_FLAG_RTQ_SACKED);
       else             verify(~pkt->flags & CI_PKT_FLAG_RTQ_SACKED);
       prev_pkt = pkt;
@@ -347,15 +357,29 @@ static void ci_tcp_state_rob_assert_valid(ci_netif* ni, ci_tcp_state* ts,
   ci_ip_pkt_queue* rob = &ts->rob;
   ci_ip_pkt_fmt *block, *pkt, *prev_pkt;
   ci_tcp_hdr* tcp;
-  int block_num, num = 0;
+  int block_num, num = 0, indexed = 0, blocks = 0;
+  ci_tcp_rob_index* ri = NULL;
   oo_pkt_p id;
 
+  if( OO_P_NOT_NULL(ts->rob_index) ) {
+    ri = ci_ni_aux_p2rob_index(ni, ts->rob_index);
+    verify(ri->n <= CI_CFG_TCP_ROB_INDEX_SIZE);
+  }
   for( id = rob->head; OO_PP_NOT_NULL(id);
        id = block->pf.tcp_rx.misc.rob.next_block ) {
     block = PKT_CHK(ni, id);
     block_num = 0;
     prev_pkt = 0;
 
+    /* The index names blocks of the ROB in order. */
+    if( ri != NULL && indexed < ri->n &&
+        OO_PP_EQ(ri->blk[CI_TCP_ROB_INDEX_SLOT(ri, indexed)], id) ) {
+      verify(ri->seq[CI_TCP_ROB_INDEX_SLOT(ri, indexed)] ==
+             CI_BSWAP_BE32(PKT_TCP_HDR(block)->tcp_seq_be32));
+      ++indexed;
+    }
+    ++blocks;
+
     while( 1 ) {
       pkt = PKT_CHK(ni, id);
       tcp = PKT_TCP_HDR(pkt);
@@ -378,6 +402,10 @@ static void ci_tcp_state_rob_assert_valid(ci_netif* ni, ci_tcp_state* ts,
   }
 
   verify(rob->num == num);
+  if( ri != NULL && ! ci_tcp_is_pluginized(ts) ) {
+    verify(rob->num == 0 || indexed == ri->n);
+    verify(rob->num == 0 || blocks == ri->blocks);
+  }
 }
 #endif
 
@@ -635,7 +663,7 @@ void ci_tcp_state_dump_retrans_blocks(ci_netif* ni, ci_tcp_state* ts)
   for( id = rtq->head; OO_PP_NOT_NULL(id); id = end->next ) {
     pkt = PKT(ni, id);
     if( OO_PP_NOT_NULL(pkt->pf.tcp_tx.block_end) )
-      end = PKT(ni, pkt->pf.tcp_tx.block_end);
+      end = ci_tcp_rtq_block_end(ni, pkt);
     else
       end = PKT(ni, rtq->tail);
     log("  %08x-%08x %d-%d len=%d%s%s", pkt->pf.tcp_tx.start_seq,
@@ -674,7 +702,8 @@ static void ci_tcp_socket_cmn_dump(ci_netif* ni, ci_tcp_socket_cmn* tsc,
                                    const char* pf,
                                    oo_dump_log_fn_t logger, void* log_arg)
 {
-  /* fixme: dump tsc fields */
+  /* fixme: dump remaining tsc fields */
+  logger(log_arg, "%s  congestion=%s", pf, ci_tcp_cong(tsc)->name);
 }
 
 
@@ -792,19 +821,33 @@ void ci_tcp_state_dump(ci_netif* ni, ci_tcp_state* ts,
   logger(log_arg, "%s  snd: cwnd=%d+%d used=%d ssthresh=%d bytes_acked=%d %s",
          pf, ts->cwnd, ts->cwnd_extra, tcp_cwnd_used(ts),
          ts->ssthresh, ts->bytes_acked, congstate_str(ts));
+  if( ci_tcp_cong_ts(ts)->dump != NULL )
+    ci_tcp_cong_ts(ts)->dump(ni, ts, pf, logger, log_arg);
   logger(log_arg, "%s  snd: timed_seq %x timed_ts %x",
          pf, ts->timed_seq, ts->timed_ts);
   logger(log_arg, "%s  snd: sndbuf_pkts=%d "OOF_IPCACHE_STATE" "
 	 OOF_IPCACHE_DETAIL,
 	 pf, ts->so_sndbuf_pkts, OOFA_IPCACHE_STATE(ni, &ts->s.pkt),
          OOFA_IPCACHE_DETAIL(&ts->s.pkt));
-  logger(log_arg, "%s  snd: limited rwnd=%d cwnd=%d nagle=%d more=%d app=%d",
-         pf, stats.tx_stop_rwnd, stats.tx_stop_cwnd, stats.tx_stop_nagle,
-         stats.tx_stop_more, stats.tx_stop_app);
+  logger(log_arg, "%s  snd: limited rwnd=%d cwnd=%d nagle=%d more=%d app=%d "
+         "pace=%d", pf, stats.tx_stop_rwnd, stats.tx_stop_cwnd,
+         stats.tx_stop_nagle, stats.tx_stop_more, stats.tx_stop_app,
+         stats.tx_stop_pace);
+  if( ts->pace_rate != 0 )
+    logger(log_arg, "%s  snd: pacing rate=%"CI_PRIu64"B/s next=%u", pf,
+           ci_tcp_pace_rate_to_bps(ni, ts->pace_rate), ts->pace_next);
 #if CI_CFG_TAIL_DROP_PROBE
   if( ts->tcpflags & CI_TCPT_FLAG_TAIL_DROP_MARKED )
     logger(log_arg, "%s  snd: tail loss probe at %x", pf, ts->taildrop_mark);
 #endif
+  if( NI_OPTS(ni).tcp_loss_detection == EF_TCP_LOSS_DETECTION_RACK &&
+      OO_P_NOT_NULL(ts->cc_state) ) {
+    struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+    logger(log_arg, "%s  snd: rack lost=%u tlp=%u rtt=%u min_rtt=%d "
+           "reo_mult=%u%s", pf, stats.rack_lost, stats.tlp_probes,
+           rack->rtt, (int) rack->min_rtt, rack->reo_wnd_mult,
+           (rack->flags & CI_TCP_RACK_FLAG_REORDER_SEEN) ? " REORDER":"");
+  }
 
   logger(log_arg, "%s  rcv: nxt-max=%08x-%08x wnd adv=%d cur=%d %s%s", pf,
          tcp_rcv_nxt(ts), tcp_rcv_wnd_right_edge_sent(ts),
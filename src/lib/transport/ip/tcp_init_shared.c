@@ -44,6 +44,8 @@ static void ci_tcp_state_setup_timers(ci_netif* ni, ci_tcp_state* ts)
   ci_tcp_setup_timer(stats,    CI_IP_TIMER_TCP_STATS,  "stat");
 #endif
   ci_tcp_setup_timer(cork,     CI_IP_TIMER_TCP_CORK,   "cork");
+  ci_tcp_setup_timer(pace,     CI_IP_TIMER_TCP_PACE,   "pace");
+  ci_tcp_setup_timer(rack,     CI_IP_TIMER_TCP_RACK,   "rack");
 
 #undef ci_tcp_setup_timer
 }
@@ -72,6 +74,7 @@ static void ci_tcp_state_connected_opts_init(ci_netif* netif, ci_tcp_state* ts)
   ci_ip_queue_init(&ts->send);
   /* Retransmit queue is limited by peer window. */
   ci_ip_queue_init(&ts->retrans);
+  ts->sack_hint = OO_PP_NULL;
   for(i = 0; i <= CI_TCP_SACK_MAX_BLOCKS; i++ )
       ts->last_sack[i] = OO_PP_NULL;
   ts->dsack_block = OO_PP_INVALID;
@@ -99,6 +102,8 @@ static void ci_tcp_state_tcb_init_fixed(ci_netif* netif, ci_tcp_state* ts,
                        CI_IP_DFLT_TTL, CI_IP_DFLT_TOS);
 
   ts->pmtus = OO_PP_NULL;
+  ts->cc_state = OO_P_NULL;
+  ts->rob_index = OO_P_NULL;
 
   ts->s.laddr = ip4_addr_any;
   TS_IPX_TCP(ts)->tcp_source_be16 = 0;
@@ -190,6 +195,15 @@ static void ci_tcp_state_tcb_reinit(ci_netif* netif, ci_tcp_state* ts,
   if( ts->tcpflags & CI_TCPT_FLAG_TSO )  ts->outgoing_hdrs_len += 12;
   ts->incoming_tcp_hdr_len = (ci_uint8)sizeof(ci_tcp_hdr);
   ts->c.tcp_defer_accept = OO_TCP_DEFER_ACCEPT_OFF;
+  /* TCP_CONGESTION */
+  ts->c.cc_alg = NI_OPTS(netif).tcp_cong_alg;
+  /* SO_MAX_PACING_RATE */
+  ts->c.max_pacing_rate = CI_TCP_PACING_RATE_UNLIMITED;
+  /* TCP_FASTOPEN, TCP_FASTOPEN_CONNECT */
+  ts->c.fastopen_qlen = 0;
+  ts->c.fastopen_connect = 0;
+  /* TCP_NOTSENT_LOWAT */
+  ts->c.notsent_lowat = 0;
 
   ci_tcp_state_connected_opts_init(netif, ts);
 
@@ -225,6 +239,11 @@ static void ci_tcp_state_tcb_reinit(ci_netif* netif, ci_tcp_state* ts,
   ts->burst_window = 0;
 #endif
 
+  /* Software pacing */
+  ts->pace_rate = 0;
+  ts->pace_next = 0;
+  ts->ecn_cwr_seq = 0;
+
   /* congestion window validation RFC2861 */
 #if CI_CFG_CONGESTION_WINDOW_VALIDATION
   ts->t_last_sent = ci_tcp_time_now(netif);
@@ -261,6 +280,8 @@ static void ci_tcp_state_tcb_reinit(ci_netif* netif, ci_tcp_state* ts,
   memset(&ts->stats, 0, sizeof(ts->stats));
 
   ci_assert(OO_PP_IS_NULL(ts->pmtus));
+  ci_assert(OO_P_IS_NULL(ts->cc_state));
+  ci_assert(OO_P_IS_NULL(ts->rob_index));
 
   /* ts is in valid state now */
   ci_wmb();
@@ -188,11 +188,15 @@ void ci_tcp_state_verify_no_timers(ci_netif *ni, ci_tcp_state *ts)
   chk(zwin_tid);
   chk(kalive_tid);
   chk(cork_tid);
+  chk(pace_tid);
+  chk(rack_tid);
 #if CI_CFG_TCP_SOCK_STATS
   chk(stats_tid);
 #endif
 #undef chk
   ci_assert(OO_PP_IS_NULL(ts->pmtus));
+  ci_assert(OO_P_IS_NULL(ts->cc_state));
+  ci_assert(OO_P_IS_NULL(ts->rob_index));
 }
 #endif
 
@@ -531,6 +535,20 @@ int ci_tcp_parse_options(ci_netif* ni, ciip_tcp_rx_pkt* rxp,
       }
       if( topts )  topts->flags |= CI_TCPT_FLAG_SACK;
       break;
+    case CI_TCP_OPT_FASTOPEN:
+      /* Empty for a cookie request, else the cookie (RFC 7413). */
+      if( len != 2 && (len < 2 + CI_TCP_FASTOPEN_COOKIE_MIN ||
+                       len > 2 + CI_TCP_FASTOPEN_COOKIE_MAX || (len & 1)) ) {
+        /* As Linux, ignore it rather than failing the segment. */
+        LOG_U(log(LPF "FASTOPEN(bad length %d)", len));
+        break;
+      }
+      if( topts ) {
+        rxp->flags |= CI_TCPT_FLAG_FASTOPEN;
+        rxp->fastopen_cookie = opt + 2;
+        rxp->fastopen_cookie_len = len - 2;
+      }
+      break;
     default:
 #if CI_CFG_PORT_STRIPING
       if( opt[0] == NI_OPTS(ni).stripe_tcp_opt ) {
@@ -574,12 +592,22 @@ void ci_tcp_stop_timers(ci_netif* netif, ci_tcp_state* ts)
   ci_ip_timer_clear_ool(netif, &ts->zwin_tid);
   ci_ip_timer_clear_ool(netif, &ts->kalive_tid);
   ci_ip_timer_clear_ool(netif, &ts->cork_tid);
+  ci_ip_timer_clear_ool(netif, &ts->pace_tid);
+  ci_ip_timer_clear_ool(netif, &ts->rack_tid);
   if( OO_PP_NOT_NULL(ts->pmtus) ) {
     ci_pmtu_state_t* pmtus = ci_ni_aux_p2pmtus(netif, ts->pmtus);
     ci_ip_timer_clear_ool(netif, &pmtus->tid);
     ci_pmtu_state_free(netif, pmtus);
     ts->pmtus = OO_PP_NULL;
   }
+  if( OO_P_NOT_NULL(ts->cc_state) ) {
+    ci_tcp_cc_state_free(netif, ci_tcp_cc(netif, ts));
+    ts->cc_state = OO_P_NULL;
+  }
+  if( OO_P_NOT_NULL(ts->rob_index) ) {
+    ci_tcp_rob_index_free(netif, ci_ni_aux_p2rob_index(netif, ts->rob_index));
+    ts->rob_index = OO_P_NULL;
+  }
 #if CI_CFG_TCP_SOCK_STATS
   ci_ip_timer_clear_ool(netif, &ts->stats_tid);
 #endif
@@ -626,6 +654,7 @@ static void ci_tcp_tx_drop_queues(ci_netif* ni, ci_tcp_state* ts)
   ts->congstate = CI_TCP_CONG_OPEN;
   ts->cwnd_extra = 0;
   ts->dup_acks = 0;
+  ts->sack_hint = OO_PP_NULL;
   ts->tcpflags &=~ CI_TCPT_FLAG_FIN_PENDING;
 }
 
@@ -910,6 +939,7 @@ void ci_tcp_clear_sacks(ci_netif* ni, ci_tcp_state* ts)
 
   ts->retrans_seq = tcp_snd_una(ts);
   ts->retrans_ptr = rtq->head;
+  ts->sack_hint = OO_PP_NULL;
 }
 
 
@@ -924,12 +954,13 @@ void ci_tcp_retrans_init_ptrs(ci_netif* ni, ci_tcp_state* ts,
   ts->retrans_ptr = rtq->head;
   ts->retrans_seq = pkt->pf.tcp_tx.start_seq;
 
-  while( 1 ) {
-    if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED ) {
-      /* Skip the SACK block. */
+  /* Walk the queue a block at a time.  Nothing beyond the start of the
+  ** trailing unSACKed region has been SACKed.
+  */
+  while( OO_PP_NOT_NULL(pkt->pf.tcp_tx.block_end) ) {
+    if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED )
       *recover_seq_out = pkt->pf.tcp_tx.start_seq;
-      pkt = PKT_CHK(ni, pkt->pf.tcp_tx.block_end);
-    }
+    pkt = ci_tcp_rtq_block_end(ni, pkt);
 
     if( OO_PP_IS_NULL(pkt->next) )  break;
     pkt = PKT_CHK(ni, pkt->next);
@@ -979,7 +1010,7 @@ void ci_tcp_get_fack(ci_netif* ni, ci_tcp_state* ts,
         retrans_data += SEQ_SUB(ts->retrans_seq, fack);
       break;
     }
-    end = PKT_CHK(ni, block->pf.tcp_tx.block_end);
+    end = ci_tcp_rtq_block_end(ni, block);
 
     if( block->flags & CI_PKT_FLAG_RTQ_SACKED )
       fack = end->pf.tcp_tx.end_seq;
@@ -1026,6 +1057,8 @@ void ci_tcp_recovered(ci_netif* ni, ci_tcp_state* ts)
   }
 
   /* If we get here, we've recovered. */
+  if( ci_tcp_rack_enabled(ni, ts) )
+    ci_tcp_rack_on_recovered(ni, ts);
 
   ts->congstate = CI_TCP_CONG_OPEN;
   ts->cwnd_extra = 0;
@@ -0,0 +1,311 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_SOURCE>
+**  \brief  TCP RACK loss detection (RFC 8985)
+** </L5_PRIVATE>
+*//*
+\**************************************************************************/
+
+/*! \cidoxg_lib_transport_ip */
+
+#include "ip_internal.h"
+
+
+#define LPF "TCP RACK "
+
+/* Recoveries for which an enlarged reordering window persists. */
+#define RACK_REO_WND_PERSIST    16
+
+
+/* RACK works from the transmit time of each segment, kept in [tstamp_frc]
+ * on packets in the retransmit queue.  Times are on the usec clock. */
+ci_inline ci_uint32 ci_tcp_rack_now(ci_netif* ni)
+{
+  return (ci_uint32) (IPTIMER_STATE(ni)->frc >>
+                      IPTIMER_STATE(ni)->ci_ip_time_frc2us);
+}
+
+ci_inline ci_uint32 ci_tcp_rack_xmit_ts(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  return (ci_uint32) (pkt->tstamp_frc >> IPTIMER_STATE(ni)->ci_ip_time_frc2us);
+}
+
+/* Was segment 1 sent after segment 2? */
+ci_inline int ci_tcp_rack_sent_after(ci_uint32 t1, ci_uint32 seq1,
+                                     ci_uint32 t2, ci_uint32 seq2)
+{
+  return (ci_int32) (t1 - t2) > 0 || (t1 == t2 && SEQ_GT(seq1, seq2));
+}
+
+
+void ci_tcp_rack_init(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+
+  memset(rack, 0, sizeof(*rack));
+  rack->min_rtt = ~0u;
+  rack->reo_wnd_mult = 1;
+}
+
+
+/* Called for each segment that is newly cumulatively ACKed or SACKed.
+ * Tracks the most recently sent segment to have been delivered. */
+void ci_tcp_rack_on_delivered(ci_netif* ni, ci_tcp_state* ts,
+                              ci_ip_pkt_fmt* pkt)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+  ci_uint32 end_seq = pkt->pf.tcp_tx.end_seq;
+  ci_uint32 xmit_ts, rtt;
+
+  if( pkt->tstamp_frc == 0 )
+    return;
+  xmit_ts = ci_tcp_rack_xmit_ts(ni, pkt);
+  rtt = ci_tcp_rack_now(ni) - xmit_ts;
+
+  /* A segment delivered below one delivered earlier, and never
+   * retransmitted, was reordered by the network. */
+  if( rack->flags & CI_TCP_RACK_FLAG_VALID ) {
+    if( SEQ_LT(end_seq, rack->fack) ) {
+      if( ! (pkt->flags & CI_PKT_FLAG_RTQ_RETRANS) )
+        rack->flags |= CI_TCP_RACK_FLAG_REORDER_SEEN;
+    }
+    else {
+      rack->fack = end_seq;
+    }
+  }
+  else {
+    rack->fack = end_seq;
+  }
+
+  if( (ci_int32) rtt < 0 )
+    return;
+  if( pkt->flags & CI_PKT_FLAG_RTQ_RETRANS ) {
+    /* If this is quicker than any RTT seen, the ACK was probably for the
+     * original transmission, so the sample is ambiguous. */
+    if( rtt < rack->min_rtt )
+      return;
+  }
+  else if( rtt < rack->min_rtt ) {
+    rack->min_rtt = rtt;
+  }
+
+  if( ! (rack->flags & CI_TCP_RACK_FLAG_VALID) ||
+      ci_tcp_rack_sent_after(xmit_ts, end_seq, rack->xmit_ts,
+                             rack->end_seq) ) {
+    rack->xmit_ts = xmit_ts;
+    rack->end_seq = end_seq;
+    rack->rtt = rtt;
+    rack->flags |= CI_TCP_RACK_FLAG_VALID;
+  }
+}
+
+
+/* Called when all sent data has been ACKed. */
+void ci_tcp_rack_on_idle(ci_netif* ni, ci_tcp_state* ts)
+{
+  /* Everything sent from now on is later than the last delivered segment,
+   * so forget it rather than risk comparing times across a wrap of the
+   * usec clock. */
+  ci_tcp_cc(ni, ts)->rack.flags &= ~CI_TCP_RACK_FLAG_VALID;
+  ci_ip_timer_clear(ni, &ts->rack_tid);
+}
+
+
+/* A DSACK shows that a retransmission was spurious, so grow the reordering
+ * window, at most once per round trip. */
+void ci_tcp_rack_on_dsack(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+
+  if( (rack->flags & CI_TCP_RACK_FLAG_DSACK_ROUND) &&
+      SEQ_GE(tcp_snd_una(ts), rack->dsack_round) )
+    rack->flags &= ~CI_TCP_RACK_FLAG_DSACK_ROUND;
+  if( rack->flags & CI_TCP_RACK_FLAG_DSACK_ROUND )
+    return;
+
+  rack->flags |= CI_TCP_RACK_FLAG_DSACK_ROUND;
+  rack->dsack_round = tcp_snd_nxt(ts);
+  if( rack->reo_wnd_mult < 0xff )
+    ++rack->reo_wnd_mult;
+  rack->reo_wnd_persist = RACK_REO_WND_PERSIST;
+  LOG_TL(log(LPF "%d: DSACK reo_wnd_mult=%u", S_FMT(ts),
+             rack->reo_wnd_mult));
+}
+
+
+void ci_tcp_rack_on_recovered(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+
+  if( rack->reo_wnd_persist != 0 && --rack->reo_wnd_persist == 0 )
+    rack->reo_wnd_mult = 1;
+}
+
+
+static ci_uint32 ci_tcp_rack_reo_wnd(ci_netif* ni, ci_tcp_state* ts)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+  ci_uint32 reo_wnd, srtt;
+
+  /* Until reordering has been seen, a segment is lost as soon as a later
+   * one is delivered once in recovery or once there are enough dupacks. */
+  if( ! (rack->flags & CI_TCP_RACK_FLAG_REORDER_SEEN) &&
+      ((ts->congstate != CI_TCP_CONG_OPEN &&
+        ts->congstate != CI_TCP_CONG_NOTIFIED) ||
+       ts->dup_acks >= ci_tcp_base_dupack_thresh(ts)) )
+    return 0;
+  if( rack->min_rtt == ~0u )
+    return 0;
+
+  reo_wnd = (rack->min_rtt >> 2) * rack->reo_wnd_mult;
+  /* Limit to the smoothed RTT.  [sa] is 8 times the smoothed RTT in
+   * ticks. */
+  srtt = (ts->sa << (IPTIMER_STATE(ni)->ci_ip_time_frc2tick -
+                     IPTIMER_STATE(ni)->ci_ip_time_frc2us)) >> 3;
+  if( srtt != 0 )
+    reo_wnd = CI_MIN(reo_wnd, srtt);
+  return reo_wnd;
+}
+
+
+/* Finds the segments that were sent before the most recently sent
+ * delivered segment, and have not themselves been delivered within RTT
+ * plus the reordering window.  If [retrans_only], consider only segments
+ * retransmitted in the current recovery.
+ *
+ * Returns the number of lost segments, and the first of them in
+ * [*lost_out].  Arms the reordering timer for segments that will be lost
+ * if not delivered soon.
+ */
+static int ci_tcp_rack_detect(ci_netif* ni, ci_tcp_state* ts,
+                              int retrans_only, ci_ip_pkt_fmt** lost_out)
+{
+  struct oo_tcp_rack* rack = &ci_tcp_cc(ni, ts)->rack;
+  ci_uint32 now, reo_wnd, timeout = 0;
+  ci_ip_pkt_fmt* pkt;
+  oo_pkt_p id;
+  int lost = 0;
+
+  *lost_out = NULL;
+  if( ! (rack->flags & CI_TCP_RACK_FLAG_VALID) )
+    return 0;
+
+  now = ci_tcp_rack_now(ni);
+  reo_wnd = ci_tcp_rack_reo_wnd(ni, ts);
+
+  for( id = ts->retrans.head; OO_PP_NOT_NULL(id); id = pkt->next ) {
+    ci_uint32 xmit_ts;
+    ci_int32 remaining;
+
+    pkt = PKT_CHK(ni, id);
+    if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED ) {
+      pkt = ci_tcp_rtq_block_end(ni, pkt);
+      continue;
+    }
+    /* The queue is in sequence order, which is also the order of first
+     * transmission.  So nothing beyond the RACK segment can have been sent
+     * before it, unless it has been retransmitted since.  We don't look for
+     * those, and leave them to the next ACK or the RTO. */
+    if( SEQ_GE(pkt->pf.tcp_tx.start_seq, rack->end_seq) )
+      break;
+    if( retrans_only && SEQ_GT(pkt->pf.tcp_tx.end_seq, ts->retrans_seq) )
+      break;
+    if( pkt->tstamp_frc == 0 )
+      continue;
+
+    xmit_ts = ci_tcp_rack_xmit_ts(ni, pkt);
+    if( ! ci_tcp_rack_sent_after(rack->xmit_ts, rack->end_seq,
+                                 xmit_ts, pkt->pf.tcp_tx.end_seq) )
+      continue;
+    remaining = (ci_int32) (xmit_ts + rack->rtt + reo_wnd - now);
+    if( remaining <= 0 ) {
+      if( lost++ == 0 )
+        *lost_out = pkt;
+    }
+    else if( (ci_uint32) remaining > timeout ) {
+      timeout = remaining;
+    }
+  }
+
+  if( timeout != 0 ) {
+    ci_iptime_t ticks = (timeout >> (IPTIMER_STATE(ni)->ci_ip_time_frc2tick -
+                                     IPTIMER_STATE(ni)->ci_ip_time_frc2us));
+    ci_ip_timer_modify(ni, &ts->rack_tid, ci_tcp_time_now(ni) + ticks + 1);
+  }
+  else if( lost == 0 ) {
+    ci_ip_timer_clear(ni, &ts->rack_tid);
+  }
+
+  LOG_TV(if( lost != 0 || timeout != 0 )
+           log(LPF "%d: lost=%d timeout=%uus rtt=%u reo_wnd=%u %s",
+               S_FMT(ts), lost, timeout, rack->rtt, reo_wnd,
+               retrans_only ? "retrans" : ""));
+  return lost;
+}
+
+
+/* Returns the number of segments deemed lost, to decide whether to enter
+ * fast recovery. */
+int ci_tcp_rack_detect_loss(ci_netif* ni, ci_tcp_state* ts)
+{
+  ci_ip_pkt_fmt* pkt;
+  int lost = ci_tcp_rack_detect(ni, ts, 0, &pkt);
+
+  if( lost != 0 ) {
+    ts->stats.rack_lost += lost;
+    CITP_STATS_NETIF_ADD(ni, tcp_rack_lost, lost);
+  }
+  return lost;
+}
+
+
+/* In recovery, ci_tcp_retrans_recover() retransmits the holes in sequence
+ * order.  This catches retransmissions that have themselves been lost,
+ * which would otherwise wait for the RTO.
+ */
+void ci_tcp_rack_recover_lost(ci_netif* ni, ci_tcp_state* ts)
+{
+  ci_ip_pkt_fmt* pkt;
+
+  ci_assert(ts->congstate == CI_TCP_CONG_FAST_RECOV ||
+            ts->congstate == CI_TCP_CONG_COOLING);
+
+  if( ci_tcp_rack_detect(ni, ts, 1, &pkt) == 0 )
+    return;
+
+  LOG_TL(log(LNT_FMT "RACK lost retransmit %08x-%08x "TCP_SND_FMT,
+             LNT_PRI_ARGS(ni, ts), pkt->pf.tcp_tx.start_seq,
+             pkt->pf.tcp_tx.end_seq, TCP_SND_PRI_ARG(ts)));
+  if( ci_tcp_retrans_one(ts, ni, pkt) == 0 ) {
+    ++ts->stats.rack_lost;
+    CITP_STATS_NETIF_INC(ni, tcp_rack_lost_retrans);
+  }
+}
+
+
+void ci_tcp_timeout_rack(ci_netif* ni, ci_tcp_state* ts)
+{
+  CITP_STATS_NETIF_INC(ni, tcp_rack_reo_timeouts);
+
+  if( ci_ip_queue_is_empty(&ts->retrans) ||
+      ! ci_tcp_rack_enabled(ni, ts) )
+    return;
+
+  switch( ts->congstate ) {
+  case CI_TCP_CONG_OPEN:
+  case CI_TCP_CONG_NOTIFIED:
+    ci_tcp_maybe_enter_fast_recovery(ni, ts);
+    break;
+  case CI_TCP_CONG_FAST_RECOV:
+  case CI_TCP_CONG_COOLING:
+    ci_tcp_rack_recover_lost(ni, ts);
+    break;
+  default:
+    /* After an RTO everything is retransmitted anyway. */
+    break;
+  }
+}
+
+/*! \cidoxg_end */
@@ -50,9 +50,6 @@
 static void handle_rx_slow(ci_tcp_state* ts, ci_netif* netif,
 			   ciip_tcp_rx_pkt* rxp);
 
-static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
-                                  ciip_tcp_rx_pkt* rxp);
-
 
 static inline bool tcp_plugin_pkt_was_recycled(ci_tcp_state* ts,
                                                const ci_ip_pkt_fmt* pkt)
@@ -178,6 +175,190 @@ static void remove_from_last_sack(ci_tcp_state* ts, oo_pkt_p id)
 }
 
 
+/*
+ * Re-order buffer index.
+ *
+ * The ci_tcp_rob_index at [ts->rob_index] records the first packet and
+ * start sequence number of up to CI_CFG_TCP_ROB_INDEX_SIZE blocks of the
+ * ROB, in sequence order.  It need not hold every block: finding the place
+ * for an out-of-order segment is a binary search for the nearest indexed
+ * block below it, then a walk over the blocks between that one and the
+ * next entry.  New blocks and blocks passed on the walk are indexed while
+ * there is room.  A walk much longer than the ROB's blocks spread evenly
+ * over the index would give rebuilds the index with evenly spaced entries.
+ * Each entry names the current first packet of a block, so any block's
+ * entry can be found by comparing packet ids.
+ *
+ * The index is an aux buffer, allocated when a segment arrives out of order
+ * with the ROB empty, and kept until ci_tcp_stop_timers().  Without one the
+ * ROB is walked from the head.  Pluginized sockets keep recycled packets at
+ * the head of the ROB, so they do not use the index.
+ */
+
+/* Returns the socket's index, or NULL if the ROB is not indexed. */
+ci_inline ci_tcp_rob_index* ci_tcp_rx_rob_index(ci_netif* netif,
+                                                ci_tcp_state* ts)
+{
+  if( OO_P_IS_NULL(ts->rob_index) )
+    return NULL;
+  return ci_ni_aux_p2rob_index(netif, ts->rob_index);
+}
+
+
+/* Empties the index, allocating it if need be.  The ROB must be empty, so
+ * that the index counts all of its blocks. */
+static ci_tcp_rob_index* ci_tcp_rx_rob_index_reset(ci_netif* netif,
+                                                   ci_tcp_state* ts)
+{
+  ci_tcp_rob_index* ri;
+
+  ci_assert(ci_ip_queue_is_empty(&ts->rob));
+  if( ci_tcp_is_pluginized(ts) )
+    return NULL;
+  if( OO_P_IS_NULL(ts->rob_index) ) {
+    ts->rob_index = ci_ni_aux_alloc(netif, CI_TCP_AUX_TYPE_ROB_INDEX);
+    if( OO_P_IS_NULL(ts->rob_index) )
+      return NULL;
+  }
+  ri = ci_ni_aux_p2rob_index(netif, ts->rob_index);
+  ri->first = ri->n = 0;
+  ri->blocks = 0;
+  return ri;
+}
+
+
+/* Returns the position of the last indexed block which starts before
+ * [seq], or -1 if there is none. */
+static int ci_tcp_rx_rob_index_find(ci_tcp_rob_index* ri, ci_uint32 seq)
+{
+  int lo = 0, hi;
+
+  if( ri == NULL )
+    return -1;
+  hi = ri->n;
+  while( lo < hi ) {
+    int mid = (lo + hi) >> 1;
+    if( SEQ_LT(ri->seq[CI_TCP_ROB_INDEX_SLOT(ri, mid)], seq) )
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo - 1;
+}
+
+
+ci_inline oo_pkt_p ci_tcp_rx_rob_index_blk(ci_tcp_rob_index* ri, int i)
+{
+  ci_assert_lt(i, ri->n);
+  return ri->blk[CI_TCP_ROB_INDEX_SLOT(ri, i)];
+}
+
+
+ci_inline void ci_tcp_rx_rob_index_move(ci_tcp_rob_index* ri, int to,
+                                        int from)
+{
+  int t = CI_TCP_ROB_INDEX_SLOT(ri, to);
+  int f = CI_TCP_ROB_INDEX_SLOT(ri, from);
+  ri->seq[t] = ri->seq[f];
+  ri->blk[t] = ri->blk[f];
+}
+
+
+/* Index the block starting with [pkt] at position [i], which must keep the
+ * index in sequence order.  Returns false if the index is full or
+ * missing. */
+static bool ci_tcp_rx_rob_index_insert(ci_tcp_rob_index* ri, int i,
+                                       ci_ip_pkt_fmt* pkt, ci_uint32 seq)
+{
+  int n, j;
+
+  CI_BUILD_ASSERT(CI_IS_POW2(CI_CFG_TCP_ROB_INDEX_SIZE));
+  if( ri == NULL )
+    return false;
+  n = ri->n;
+  ci_assert_ge(i, 0);
+  ci_assert_le(i, n);
+  if( n == CI_CFG_TCP_ROB_INDEX_SIZE )
+    return false;
+
+  /* Shift whichever side of [i] is shorter. */
+  if( i < n - i ) {
+    ri->first = CI_TCP_ROB_INDEX_SLOT(ri, -1);
+    for( j = 0; j < i; ++j )
+      ci_tcp_rx_rob_index_move(ri, j, j + 1);
+  }
+  else {
+    for( j = n; j > i; --j )
+      ci_tcp_rx_rob_index_move(ri, j, j - 1);
+  }
+  ri->seq[CI_TCP_ROB_INDEX_SLOT(ri, i)] = seq;
+  ri->blk[CI_TCP_ROB_INDEX_SLOT(ri, i)] = OO_PKT_P(pkt);
+  ri->n = n + 1;
+  return true;
+}
+
+
+static void ci_tcp_rx_rob_index_remove(ci_tcp_rob_index* ri, int i)
+{
+  int n = ri->n;
+  int j;
+
+  ci_assert_ge(i, 0);
+  ci_assert_lt(i, n);
+  if( i < n - 1 - i ) {
+    for( j = i; j > 0; --j )
+      ci_tcp_rx_rob_index_move(ri, j, j - 1);
+    ri->first = CI_TCP_ROB_INDEX_SLOT(ri, 1);
+  }
+  else {
+    for( j = i; j < n - 1; ++j )
+      ci_tcp_rx_rob_index_move(ri, j, j + 1);
+  }
+  ri->n = n - 1;
+}
+
+
+/* Index every [stride]th block of the ROB, so that no walk from an
+ * indexed block is longer than [stride]. */
+static void ci_tcp_rx_rob_index_rebuild(ci_netif* netif, ci_tcp_state* ts,
+                                        ci_tcp_rob_index* ri)
+{
+  int stride = ri->blocks / CI_CFG_TCP_ROB_INDEX_SIZE + 1;
+  int af = ipcache_af(&ts->s.pkt);
+  ci_ip_pkt_fmt* pkt;
+  oo_pkt_p id;
+  int i, n = 0;
+
+  ri->first = 0;
+  for( id = ts->rob.head, i = 0; OO_PP_NOT_NULL(id);
+       id = PKT_TCP_RX_ROB(pkt)->next_block, ++i ) {
+    pkt = PKT_CHK(netif, id);
+    if( i % stride == 0 ) {
+      ri->seq[n] = CI_BSWAP_BE32(PKT_IPX_TCP_HDR(af, pkt)->tcp_seq_be32);
+      ri->blk[n] = id;
+      ++n;
+    }
+  }
+  ci_assert_equal(i, ri->blocks);
+  ci_assert_le(n, CI_CFG_TCP_ROB_INDEX_SIZE);
+  ri->n = n;
+  CITP_STATS_NETIF_INC(netif, tcp_rob_index_rebuilds);
+}
+
+
+/* The block starting with [id] has been glued to the preceding one or
+ * delivered.  [i] is where it would be indexed. */
+ci_inline void ci_tcp_rx_rob_index_forget(ci_tcp_rob_index* ri, int i,
+                                          oo_pkt_p id)
+{
+  if( ri == NULL )
+    return;
+  --ri->blocks;
+  if( i < ri->n && OO_PP_EQ(ci_tcp_rx_rob_index_blk(ri, i), id) )
+    ci_tcp_rx_rob_index_remove(ri, i);
+}
+
+
 static void ci_tcp_rx_add_to_recvq(ci_netif *netif, ci_tcp_state *ts,
                                    ci_ip_pkt_fmt *pkt, int bytes)
 {
@@ -703,78 +884,9 @@ ci_inline unsigned ci_tcp_paws_check(ci_netif* netif, ci_uint32 tsval,
 }
 
 
-/* function to open the congestion window following the
-** reception of an ack for new data. Implements RFC3465 (ABC)
-*/
-ci_inline void ci_tcp_opencwnd(ci_netif *ni, ci_tcp_state* ts)
-{
-#if CI_CFG_CONG_AVOID_NOTIFIED
-  /* If congestion has been notified (but no loss detected yet)
-     gradually scale the cwnd back */
-  if( ts->congstate == CI_TCP_CONG_NOTIFIED ){
-    if(SEQ_LE(tcp_snd_una(ts), ts->congrecover))
-      ts->congstate = CI_TCP_CONG_OPEN;
-  }
-  else
-#endif
-  if( ts->cwnd >= ts->ssthresh ) {
-    /* Hack - Increase less aggresively on small round trip times */
-#if CI_CFG_CONG_AVOID_SCALE_BACK
-    unsigned tmp = 0, cwnd_scaled;
-    /* tcp_srtt(ts) would relatively easy exceed 32 for a round trip time
-     * on longer links */
-    if( tcp_srtt(ts) < 32 )
-      tmp = NI_OPTS(ni).cong_avoid_scale_back >> tcp_srtt(ts);
-    cwnd_scaled = CI_MAX(1U, tmp) * ts->cwnd;
-#else
-    unsigned cwnd_scaled = ts->cwnd;
-#endif
-    /* Congestion avoidance.  RFC3465 says: increase the congestion window
-    ** by one segment each RTT.  i.e. wait for bytes_acked to be > cwnd
-    ** (which takes one RTT), then reset bytes_acked by subtracting the
-    ** cwnd from it, and add one segment to cwnd.
-    */
-    LOG_TV(log(LPF "%d OPENCWND: CA eff_mss=%u bytes_acked=%u cwnd=%u",
-               S_FMT(ts), tcp_eff_mss(ts), ts->bytes_acked, ts->cwnd));
-    if( ts->bytes_acked >= cwnd_scaled ) {
-      ts->bytes_acked -= cwnd_scaled;
-      ts->cwnd += tcp_eff_mss(ts);
-    }
-  }
-  else {
-    /* Slow-start. */
-    unsigned cwnd_inc;
-    LOG_TV(log(LPF "%d OPENCWND: SS eff_mss=%u bytes_acked=%u cwnd=%u",
-               S_FMT(ts), tcp_eff_mss(ts), ts->bytes_acked, ts->cwnd));
-#if CI_CFG_CONG_AVOID_SLOW_START_MODE == 2
-    cwnd_inc = CI_MIN(ts->ssthresh - ts->cwnd, ts->bytes_acked);
-    ts->cwnd += cwnd_inc;
-    ts->bytes_acked -= cwnd_inc;
-#else
-    if( CI_CFG_CONG_AVOID_SLOW_START_MODE == 0 && ts->stats.rtos == 0 )
-      /* RFC3465 sec 2.2: May only increase cwnd by more than mss if we've
-      * never had any RTOs on this connection.
-      */
-      cwnd_inc = tcp_eff_mss(ts) * CI_CFG_CONG_AVOID_RFC3465_L_VALUE;
-    else
-      cwnd_inc = tcp_eff_mss(ts);
-    cwnd_inc = CI_MIN(cwnd_inc, ts->bytes_acked);
-    ts->cwnd += cwnd_inc;
-    ts->bytes_acked = 0;
-#endif
-  }
-
-  LOG_TV(log(LPF "%d OPENCWND: end cwnd=%u", S_FMT(ts), ts->cwnd));
-
-  ci_assert_le(tcp_eff_mss(ts), CI_MAX_ETH_FRAME_LEN);
-  ci_assert_ge(ts->cwnd, tcp_eff_mss(ts));
-  ci_assert_ge(ts->ssthresh, (ci_uint32)(tcp_eff_mss(ts) << 1));
-}
-
-
 static void ci_tcp_reset_cwnd_on_loss(ci_netif* ni, ci_tcp_state* ts)
 {
-  ts->ssthresh = ci_tcp_losswnd(ts);
+  ts->ssthresh = ci_tcp_cong_on_loss(ni, ts);
   ts->cwnd = ts->ssthresh + ci_tcp_base_dupack_thresh(ts) * tcp_eff_mss(ts);
   ts->cwnd = CI_MAX(ts->cwnd, NI_OPTS(ni).loss_min_cwnd);
   ts->cwnd = CI_MAX(ts->cwnd, NI_OPTS(ni).min_cwnd);
@@ -787,9 +899,13 @@ static void ci_tcp_reset_cwnd_on_loss(ci_netif* ni, ci_tcp_state* ts)
 int /*bool*/ ci_tcp_maybe_enter_fast_recovery(ci_netif* ni, ci_tcp_state* ts)
 {
   ci_uint32 dup_thresh = ci_tcp_base_dupack_thresh(ts);
-  ci_ip_pkt_fmt *pkt;
 
-  if( ts->dup_acks == 0 ) {
+  if( ci_tcp_rack_enabled(ni, ts) ) {
+    /* RACK decides loss from transmit times rather than dupacks. */
+    if( ci_tcp_rack_detect_loss(ni, ts) == 0 )
+      return 0;
+  }
+  else if( ts->dup_acks == 0 ) {
     return 0;
   }
   else if( ts->dup_acks >= dup_thresh ) {
@@ -811,8 +927,7 @@ int /*bool*/ ci_tcp_maybe_enter_fast_recovery(ci_netif* ni, ci_tcp_state* ts)
     if( ci_ip_queue_not_empty(&ts->send) ) {
       LOG_TL(log(LNT_FMT "Have unsent; use limited transmit if window is open",
                  LNT_PRI_ARGS(ni, ts)));
-      pkt = PKT_CHK(ni, ts->send.head);
-      if( SEQ_LE(pkt->pf.tcp_tx.end_seq, ts->snd_max) )
+      if( SEQ_LE(ci_tcp_sendq_head_end_seq(ni, ts), ts->snd_max) )
         return 0;
       LOG_TL(log(LNT_FMT "Insufficient window for limited transmit; continue "
                  "with ER", LNT_PRI_ARGS(ni, ts)));
@@ -887,6 +1002,102 @@ static void ci_tcp_cwnd_extra_update(ci_netif* netif, ci_tcp_state* ts)
   ts->cwnd_extra = CI_MAX(cwnd_extra, 0);
 }
 
+/* With RACK, an ACK of new data can also show that earlier segments (or
+ * retransmissions) have been lost. */
+static void ci_tcp_rx_rack(ci_netif* ni, ci_tcp_state* ts)
+{
+  if( (ts->congstate == CI_TCP_CONG_OPEN) |
+      (ts->congstate == CI_TCP_CONG_NOTIFIED) )
+    ci_tcp_maybe_enter_fast_recovery(ni, ts);
+  else if( (ts->congstate == CI_TCP_CONG_FAST_RECOV) |
+           (ts->congstate == CI_TCP_CONG_COOLING) )
+    ci_tcp_rack_recover_lost(ni, ts);
+}
+
+
+ci_inline int ci_tcp_rx_pkt_ce(ci_ip_pkt_fmt* pkt)
+{
+  return (ipx_hdr_tos_tclass(oo_pkt_af(pkt), oo_ipx_hdr(pkt)) &
+          CI_IP_ECN_MASK) == CI_IP_ECN_CE;
+}
+
+/* Non-zero if [pkt] changes the ECE state we echo back to the peer, in
+ * which case it has to take the slow path.  A classic ECN receiver keeps
+ * ECE set until it sees CWR, whereas DCTCP echoes the CE state of each
+ * segment.
+ */
+ci_inline int ci_tcp_rx_ecn_changed(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt)
+{
+  int ce = ci_tcp_rx_pkt_ce(pkt);
+  int ece = (ts->tcpflags & CI_TCPT_FLAG_ECN_ECE) != 0;
+  return ce != ece && (ce || ci_tcp_cong_needs_ecn(&ts->c));
+}
+
+/* Receiver side of ECN: update the ECE state from a data segment. */
+static void ci_tcp_rx_ecn(ci_netif* netif, ci_tcp_state* ts,
+                          ciip_tcp_rx_pkt* rxp, ci_ip_pkt_fmt* pkt)
+{
+  int ce = ci_tcp_rx_pkt_ce(pkt);
+
+  if( ce )
+    CITP_STATS_NETIF_INC(netif, tcp_ecn_ce_rx);
+
+  if( ci_tcp_cong_needs_ecn(&ts->c) ) {
+    if( ce != ((ts->tcpflags & CI_TCPT_FLAG_ECN_ECE) != 0) ) {
+      /* Any delayed ACK covers segments received in the old CE state, so
+       * it must go out with the old ECE value before we flip it.
+       */
+      if( ts->acks_pending ) {
+        ci_ip_pkt_fmt* ackpkt = ci_netif_pkt_alloc(netif, 0);
+        if( ackpkt ) ci_tcp_send_ack(netif, ts, ackpkt, CI_FALSE);
+      }
+      ts->tcpflags ^= CI_TCPT_FLAG_ECN_ECE;
+      TCP_FORCE_ACK(ts);
+    }
+  }
+  else {
+    if( rxp->tcp->tcp_flags & CI_TCP_FLAG_CWR )
+      ts->tcpflags &=~ CI_TCPT_FLAG_ECN_ECE;
+    if( ce )
+      ts->tcpflags |= CI_TCPT_FLAG_ECN_ECE;
+  }
+}
+
+/* Sender side of ECN: react to ECE on an ACK of new data.  The window is
+ * reduced at most once per window of data (RFC 3168 section 6.1.2).
+ */
+static void ci_tcp_rx_ece(ci_netif* netif, ci_tcp_state* ts,
+                          ciip_tcp_rx_pkt* rxp, unsigned acked)
+{
+  const ci_tcp_cong_ops* ops = ci_tcp_cong_ts(ts);
+  int ece = (rxp->tcp->tcp_flags & CI_TCP_FLAG_ECE) != 0;
+
+  if( ops->on_ecn != NULL )
+    ops->on_ecn(netif, ts, acked, ece);
+
+  if( (ts->tcpflags & CI_TCPT_FLAG_ECN_REDUCED) &&
+      SEQ_GE(tcp_snd_una(ts), ts->ecn_cwr_seq) )
+    ts->tcpflags &=~ CI_TCPT_FLAG_ECN_REDUCED;
+
+  if( ! ece || (ts->tcpflags & CI_TCPT_FLAG_ECN_REDUCED) ||
+      ts->congstate != CI_TCP_CONG_OPEN ||
+      (rxp->tcp->tcp_flags & CI_TCP_FLAG_SYN) )
+    return;
+
+  if( ops->ecn_ssthresh != NULL )
+    ts->ssthresh = ops->ecn_ssthresh(netif, ts);
+  else
+    ts->ssthresh = ci_tcp_cong_on_loss(netif, ts);
+  ts->cwnd = ts->ssthresh;
+  ts->cwnd = CI_MAX(ts->cwnd, NI_OPTS(netif).loss_min_cwnd);
+  ts->cwnd = CI_MAX(ts->cwnd, NI_OPTS(netif).min_cwnd);
+  ts->bytes_acked = 0;
+  ts->tcpflags |= CI_TCPT_FLAG_ECN_REDUCED | CI_TCPT_FLAG_ECN_CWR;
+  ts->ecn_cwr_seq = tcp_snd_nxt(ts);
+  CITP_STATS_NETIF_INC(netif, tcp_ecn_cwnd_reduced);
+  ci_tcp_pace_update(netif, ts);
+}
+
 /*
 ** Called when a duplicate acknowledgement found
 */
@@ -948,6 +1159,8 @@ static void ci_tcp_rx_dupack(ci_tcp_state* ts, ci_netif* netif,
     }
     /* else sack might have advanced the window */
     ci_tcp_retrans_recover(netif, ts, 0);
+    if( ci_tcp_rack_enabled(netif, ts) )
+      ci_tcp_rack_recover_lost(netif, ts);
   }
   else if( (ts->congstate & CI_TCP_CONG_COOLING) &&
            (rxp->flags & CI_TCP_SACKED) ) {
@@ -1034,9 +1247,48 @@ static void ci_tcp_try_cwndrecover(ci_tcp_state* ts, ci_netif* netif,
 }
 
 
+/* Returns the packet recorded by the last call to
+ * ci_tcp_rx_sack_process_block() if the search for a SACK block starting at
+ * [start] may begin there, or NULL to search from the head of the retransmit
+ * queue.  The hint is not cleared everywhere a packet can leave the queue, so
+ * it is only trusted if it still looks like one of our SACKed packets. */
+ci_inline ci_ip_pkt_fmt*
+ci_tcp_rx_sack_hint(ci_netif* ni, ci_tcp_state* ts, unsigned start)
+{
+  ci_ip_pkt_fmt* pkt;
+
+  if( OO_PP_IS_NULL(ts->sack_hint) ||
+      SEQ_LT(start, ts->sack_hint_seq) ||
+      SEQ_LT(ts->sack_hint_seq, tcp_snd_una(ts)) )
+    return NULL;
+  pkt = PKT(ni, ts->sack_hint);
+  if( (pkt->flags & CI_PKT_FLAG_RTQ_SACKED) &&
+      OO_SP_EQ(pkt->pf.tcp_tx.sock_id, ts->s.b.bufid) &&
+      pkt->pf.tcp_tx.start_seq == ts->sack_hint_seq )
+    return pkt;
+  return NULL;
+}
+
+
+ci_inline void
+ci_tcp_rx_sack_set_hint(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt)
+{
+  ts->sack_hint = OO_PKT_P(pkt);
+  ts->sack_hint_seq = pkt->pf.tcp_tx.start_seq;
+}
+
+
 /* Marks packets in the retransmit queue as having been SACKed.  Returns non-
  * zero if and only if the block allowed us to mark an entire packet, not
- * previously SACKed, as having now been SACKed. */
+ * previously SACKed, as having now been SACKed.
+ *
+ * The search starts at [ts->sack_hint] if the block lies beyond it, so that
+ * a SACK block which extends or follows the previous one costs time in
+ * proportion to the number of blocks and packets newly covered rather than
+ * to the size of the retransmit queue.  Extending an existing SACKed block
+ * only touches the newly covered packets and the old end of the block (see
+ * ci_tcp_rtq_block_end()).
+ */
 static int /*bool*/
 ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
                              unsigned end)
@@ -1050,6 +1302,7 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
   ci_ip_pkt_fmt* end_pkt;
   ci_ip_pkt_fmt* pkt;
   oo_pkt_p next_pp;
+  int rack;
 
   /* ?? TODO:
   **
@@ -1068,9 +1321,12 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
   */
 
   /* Find the block the first packet covered is in.  (The packet at the
-  ** head of rtq certainly won't qualify).
+  ** head of rtq certainly won't qualify).  The hint is a SACKed packet, and
+  ** may be part way into its block, which is fine as we only need the true
+  ** start of an unSACKed block.
   */
-  next_pp = rtq->head;
+  pkt = ci_tcp_rx_sack_hint(ni, ts, start);
+  next_pp = pkt != NULL ? OO_PKT_P(pkt) : rtq->head;
   while( 1 ) {
     start_block = PKT_CHK(ni, next_pp);
     if( OO_PP_IS_NULL(start_block->pf.tcp_tx.block_end) ) {
@@ -1080,7 +1336,7 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
       ci_assert(SEQ_LE(end, start_block_end->pf.tcp_tx.end_seq));
     }
     else
-      start_block_end = PKT_CHK(ni, start_block->pf.tcp_tx.block_end);
+      start_block_end = ci_tcp_rtq_block_end(ni, start_block);
     if( SEQ_LE(start, start_block_end->pf.tcp_tx.start_seq) )  break;
     if( (start_block->flags & CI_PKT_FLAG_RTQ_SACKED) &&
         SEQ_LE(start, start_block_end->pf.tcp_tx.end_seq) ) {
@@ -1121,7 +1377,7 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
     if( SEQ_LT(end, pkt->pf.tcp_tx.end_seq) )  break;
     end_block = pkt;
     if( OO_PP_IS_NULL(end_block->pf.tcp_tx.block_end) )  break;
-    pkt = PKT_CHK(ni, end_block->pf.tcp_tx.block_end);
+    pkt = ci_tcp_rtq_block_end(ni, end_block);
   }
 
   /* Check for duplicate. */
@@ -1131,6 +1387,7 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
                LNT_PRI_ARGS(ni, ts), start, end,
                start_block->pf.tcp_tx.start_seq,
                start_block_end->pf.tcp_tx.end_seq));
+    ci_tcp_rx_sack_set_hint(ts, start_block);
     return 0;
   }
 
@@ -1192,26 +1449,36 @@ ci_tcp_rx_sack_process_block(ci_netif* ni, ci_tcp_state* ts, unsigned start,
   if( OO_PP_NOT_NULL(end_pkt->next) ) {
     pkt = PKT_CHK(ni, end_pkt->next);
     if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED ) {
+      next_pp = OO_PKT_P(ci_tcp_rtq_block_end(ni, pkt));
       LOG_TV(log(LNT_FMT "SACK %08x-%08x inconsistent with %08x-%08x",
                  LNT_PRI_ARGS(ni, ts), start, end,
                  pkt->pf.tcp_tx.start_seq,
-                 PKT_CHK(ni, pkt->pf.tcp_tx.block_end)->pf.tcp_tx.end_seq));
-      next_pp = pkt->pf.tcp_tx.block_end;
+                 PKT_CHK(ni, next_pp)->pf.tcp_tx.end_seq));
     }
   }
 
-  /* Set [block_end] pointers for the SACKed block. */
-  if( start_block->flags & CI_PKT_FLAG_RTQ_SACKED )
-    pkt = start_block;
-  else
+  /* Set [block_end] pointers for the SACKed block.  If we're extending an
+  ** existing block then its packets reach the new end through its old end.
+  */
+  if( start_block->flags & CI_PKT_FLAG_RTQ_SACKED ) {
+    ci_tcp_rx_sack_set_hint(ts, start_block);
+    ci_assert(start_block_end != end_pkt);
+    start_block_end->pf.tcp_tx.block_end = next_pp;
+    pkt = PKT_CHK(ni, start_block_end->next);
+  }
+  else {
+    ci_tcp_rx_sack_set_hint(ts, start_pkt);
     pkt = start_pkt;
-  while( pkt != end_pkt ) {
+  }
+  rack = ci_tcp_rack_enabled(ni, ts);
+  while( 1 ) {
+    if( rack && ! (pkt->flags & CI_PKT_FLAG_RTQ_SACKED) )
+      ci_tcp_rack_on_delivered(ni, ts, pkt);
     pkt->pf.tcp_tx.block_end = next_pp;
     pkt->flags |= CI_PKT_FLAG_RTQ_SACKED;
+    if( pkt == end_pkt )  break;
     pkt = PKT_CHK(ni, pkt->next);
   }
-  pkt->pf.tcp_tx.block_end = next_pp;
-  pkt->flags |= CI_PKT_FLAG_RTQ_SACKED;
 
   /* We took early exits from this function when this SACK block was contained
    * within an earlier one, so we know that we have recorded new SACK
@@ -1253,6 +1520,9 @@ ci_inline int ci_tcp_rx_dsack_check(ci_netif* ni, ci_tcp_state* ts,
     }
   }
 
+  if( rc && ci_tcp_rack_enabled(ni, ts) )
+    ci_tcp_rack_on_dsack(ni, ts);
+
 #if CI_CFG_TAIL_DROP_PROBE
   if( rc && (ts->tcpflags & CI_TCPT_FLAG_TAIL_DROP_MARKED) &&
       SEQ_GE(rxp->ack, ts->taildrop_mark)) {
@@ -1271,13 +1541,16 @@ ci_inline int ci_tcp_rx_dsack_check(ci_netif* ni, ci_tcp_state* ts,
  * CI_TCP_SACKED flag only if something is really SACKed. For DSACK
  * CI_TCP_DSACK flag is used.
  */
-static void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
-				   ciip_tcp_rx_pkt* rxp)
+void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
+                            ciip_tcp_rx_pkt* rxp)
 {
-  int i;
+  int i, j, n;
   unsigned start;
   unsigned end;
   int sacked = 0;
+  ci_uint32 sack[CI_ARRAY_SIZE(rxp->sack)];
+  oo_pkt_p hint = OO_PP_NULL;
+  ci_uint32 hint_seq = 0;
 
   if( !(ts->tcpflags & CI_TCPT_FLAG_SACK) ) {
     LOG_U(log(LNT_FMT "SACK received but not negotiated",
@@ -1305,11 +1578,27 @@ static void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
   /* Check for DSACK.  If it is, then skip the first block. */
   i = ci_tcp_rx_dsack_check(netif, ts, rxp);
 
-  /* Iterate over each sack block, deciding what action to take */
-  for( ; i < rxp->sack_blocks; i++ ) {
-    /* sequence numbers being selectively acknowledged */
+  /* Take the blocks in sequence order, so that each one is found by
+  ** searching onwards from the last (see ci_tcp_rx_sack_hint()).  The hint
+  ** left for the next ACK is the one from the lowest block, as the peer
+  ** reports the same few recent blocks until they are filled.
+  */
+  for( n = 0; i < rxp->sack_blocks; i++, n++ ) {
     start = rxp->sack[2 * i];
     end = rxp->sack[2 * i + 1];
+    for( j = n; j > 0 && SEQ_LT(start, sack[2 * j - 2]); --j ) {
+      sack[2 * j] = sack[2 * j - 2];
+      sack[2 * j + 1] = sack[2 * j - 1];
+    }
+    sack[2 * j] = start;
+    sack[2 * j + 1] = end;
+  }
+
+  /* Iterate over each sack block, deciding what action to take */
+  for( i = 0; i < n; i++ ) {
+    /* sequence numbers being selectively acknowledged */
+    start = sack[2 * i];
+    end = sack[2 * i + 1];
 
     LOG_TO(log(LNT_FMT "SACK %d %08x-%08x "TCP_SND_FMT,
                LNT_PRI_ARGS(netif, ts), i, start, end, TCP_SND_PRI_ARG(ts)));
@@ -1326,6 +1615,10 @@ static void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
            /*3*/SEQ_LE(end, start)) ) {
       if( ci_tcp_rx_sack_process_block(netif, ts, start, end) )
         sacked = 1;
+      if( OO_PP_IS_NULL(hint) ) {
+        hint = ts->sack_hint;
+        hint_seq = ts->sack_hint_seq;
+      }
     }
     else {
       /* Bad SACK block: sender is not behaving.  Prev code would clear the
@@ -1341,6 +1634,11 @@ static void ci_tcp_rx_sack_process(ci_netif* netif, ci_tcp_state* ts,
     }
   }
 
+  if( OO_PP_NOT_NULL(hint) ) {
+    ts->sack_hint = hint;
+    ts->sack_hint_seq = hint_seq;
+  }
+
   if( sacked != 0 )
     rxp->flags |= CI_TCP_SACKED;
 }
@@ -1364,6 +1662,7 @@ static void ci_tcp_rx_free_acked_bufs(ci_netif* netif, ci_tcp_state* ts,
 {
   struct ci_netif_poll_state* ps = rxp->poll_state;
   ci_ip_pkt_queue* rtq = &ts->retrans;
+  int rack = ci_tcp_rack_enabled(netif, ts);
 #if CI_CFG_TIMESTAMPING
   oo_pkt_p ts_q_pending = ts->timestamp_q_pending;
   unsigned ts_q_bufs = 0;
@@ -1403,6 +1702,9 @@ static void ci_tcp_rx_free_acked_bufs(ci_netif* netif, ci_tcp_state* ts,
                CI_TCP_HDR_FLAGS_PRI_ARG(PKT_IPX_TCP_HDR(af, p)),
                rxp->ack, rtq->num));
 
+    if( rack && ! (p->flags & CI_PKT_FLAG_RTQ_SACKED) )
+      ci_tcp_rack_on_delivered(netif, ts, p);
+
 #if CI_CFG_TCP_OFFLOAD_RECYCLER
     if( NI_OPTS(netif).tcp_offload_plugin == CITP_TCP_OFFLOAD_NVME &&
         p->flags & CI_PKT_FLAG_INDIRECT )
@@ -1441,6 +1743,8 @@ static void ci_tcp_rx_free_acked_bufs(ci_netif* netif, ci_tcp_state* ts,
         ci_tcp_rto_clear(netif, ts);
         ci_tcp_kalive_restart(netif, ts, ci_tcp_kalive_idle_get(ts));
       }
+      if( rack )
+        ci_tcp_rack_on_idle(netif, ts);
       break;
     }
   }
@@ -1556,6 +1860,7 @@ static void ci_tcp_rx_handle_ack(ci_tcp_state* ts, ci_netif* netif,
   if( SEQ_LT(tcp_snd_una(ts), rxp->ack) ) {
     /* New data acknowledged: do congestion control and rtt measurement. */
     unsigned acked = SEQ_SUB(rxp->ack, tcp_snd_una(ts));
+    int rtt = -1;
 
     /* If something new was acked, we should restart
      * zero window probes counter. */
@@ -1566,8 +1871,8 @@ static void ci_tcp_rx_handle_ack(ci_tcp_state* ts, ci_netif* netif,
      * Following Linux implementation do not update RTT if segment does not
      * contain TSO. */
     if( ts->tcpflags & rxp->flags & CI_TCPT_FLAG_TSO ) {
-      ci_tcp_update_rtt(netif, ts,
-                        ci_tcp_time_now(netif) - rxp->timestamp_echo);
+      rtt = ci_tcp_time_now(netif) - rxp->timestamp_echo;
+      ci_tcp_update_rtt(netif, ts, rtt);
     }
     else if( SEQ_LE(tcp_snd_una(ts), ts->timed_seq) &&
              SEQ_LT(ts->timed_seq, rxp->ack) &&
@@ -1579,12 +1884,16 @@ static void ci_tcp_rx_handle_ack(ci_tcp_state* ts, ci_netif* netif,
       **   (iii) timed_seq is being acked...
       **   (iv)  not congested
       */
-      ci_tcp_update_rtt(netif, ts, ci_tcp_time_now(netif) - ts->timed_ts);
+      rtt = ci_tcp_time_now(netif) - ts->timed_ts;
+      ci_tcp_update_rtt(netif, ts, rtt);
     }
 
     /* Open the congestion window. */
     ts->bytes_acked += acked;
-    ci_tcp_opencwnd(netif, ts);
+    ci_tcp_cong_ts(ts)->on_ack(netif, ts, acked, rtt);
+    ci_assert_le(tcp_eff_mss(ts), CI_MAX_ETH_FRAME_LEN);
+    ci_assert_ge(ts->cwnd, tcp_eff_mss(ts));
+    ci_assert_ge(ts->ssthresh, (ci_uint32)(tcp_eff_mss(ts) << 1));
 
     /* New acknowledgement clears any dup_acks. */
     ts->dup_acks = 0;
@@ -1592,10 +1901,17 @@ static void ci_tcp_rx_handle_ack(ci_tcp_state* ts, ci_netif* netif,
     /* Free TX buffers that have been acked. */
     ci_tcp_rx_free_acked_bufs(netif, ts, rxp);
 
+    if( ts->tcpflags & CI_TCPT_FLAG_ECN )
+      ci_tcp_rx_ece(netif, ts, rxp, acked);
+
     if( ts->congstate != CI_TCP_CONG_OPEN && ts->congstate != CI_TCP_CONG_NOTIFIED)
       /* Congested: try to recover. */
       ci_tcp_try_cwndrecover(ts, netif, pkt);
 
+    if( ci_tcp_rack_enabled(netif, ts) &&
+        ci_ip_queue_not_empty(&ts->retrans) )
+      ci_tcp_rx_rack(netif, ts);
+
     if( NI_OPTS(netif).tcp_sndbuf_mode == 2 &&
 	ci_tcp_should_expand_sndbuf(netif, ts) )
       ci_tcp_expand_sndbuf(netif, ts);
@@ -1824,18 +2140,19 @@ static int ci_tcp_rx_deliver_rob(ci_netif* netif, ci_tcp_state* ts)
 {
   ci_ip_pkt_fmt* pkt;
   ci_ip_pkt_fmt* end_pkt = NULL;
-  oo_pkt_p end_block_id, id;
+  oo_pkt_p end_block_id, block_id, id;
   ci_tcp_hdr* tcp;
   ci_ip_pkt_queue* rob;
   ci_uint32 last_seq;
   int num;
   ci_uint32 seq;
   int af = ipcache_af(&ts->s.pkt);
+  ci_tcp_rob_index* ri = ci_tcp_rx_rob_index(netif, ts);
 
   ++ts->stats.rx_ooo_fill;
   rob = &ts->rob;
   ci_assert(ci_ip_queue_is_valid(netif, rob));
-  id = rob->head;
+  id = block_id = rob->head;
   pkt = PKT_CHK(netif, id);
   seq = CI_BSWAP_BE32(PKT_IPX_TCP_HDR(af, pkt)->tcp_seq_be32);
 
@@ -1853,12 +2170,16 @@ static int ci_tcp_rx_deliver_rob(ci_netif* netif, ci_tcp_state* ts)
                 pkt->pf.tcp_rx.end_seq));
       remove_from_last_sack(ts, id);
       ci_tcp_rx_queue_dequeue(netif, ts, rob, pkt);
-      if( OO_PP_EQ(id, end_block_id) )
+      if( OO_PP_EQ(id, end_block_id) ) {
         end_block_id = OO_PP_NULL;
+        ci_tcp_rx_rob_index_forget(ri, 0, block_id);
+      }
       ci_netif_pkt_release_rx(netif, pkt);
       if( ci_ip_queue_is_empty(rob) )
         return 0;
       id = rob->head;
+      if( OO_PP_IS_NULL(end_block_id) )
+        block_id = id;
       pkt = PKT_CHK(netif, id);
       seq = CI_BSWAP_BE32(PKT_IPX_TCP_HDR(af, pkt)->tcp_seq_be32);
       if( OO_PP_IS_NULL(end_block_id) ) {
@@ -1915,6 +2236,11 @@ static int ci_tcp_rx_deliver_rob(ci_netif* netif, ci_tcp_state* ts)
 
     if( CI_UNLIKELY(tcp->tcp_flags & CI_TCP_FLAG_FIN) ) {
       LOG_TC(log(LPF "%d out-of-order FIN", S_FMT(ts)));
+      /* Nothing after the FIN is kept: forget all the blocks. */
+      if( ri != NULL ) {
+        ri->n = 0;
+        ri->blocks = 0;
+      }
       break;
     }
     ci_assert(oo_offbuf_not_empty(&pkt->buf));
@@ -1922,8 +2248,10 @@ static int ci_tcp_rx_deliver_rob(ci_netif* netif, ci_tcp_state* ts)
     num++;
     end_pkt = pkt;
     last_seq = pkt->pf.tcp_rx.end_seq;
-    if( OO_PP_EQ(OO_PKT_P(pkt), end_block_id) )
+    if( OO_PP_EQ(OO_PKT_P(pkt), end_block_id) ) {
+      ci_tcp_rx_rob_index_forget(ri, 0, block_id);
       break;
+    }
     id = pkt->next;
     pkt = PKT_CHK(netif, id);
     tcp = PKT_IPX_TCP_HDR(af, pkt);
@@ -2098,10 +2426,12 @@ void ci_tcp_rx_deliver2(ci_tcp_state* ts, ci_netif* netif,
  * should be the first packet of some block. If the first block can be
  * glued with next block(s), it will be done.  It is supposed that all next
  * blocks can't be glued with each other. It is supposed that 'pkt' block
- * is not covered by other blocks.
+ * is not covered by other blocks.  [idx] is the position in the index [ri]
+ * of 'pkt' block or of the last indexed block before it, or -1.
  */
 static void ci_tcp_rx_glue_rob(ci_netif* netif, ci_tcp_state* ts,
-                               ci_ip_pkt_fmt* pkt)
+                               ci_tcp_rob_index* ri, ci_ip_pkt_fmt* pkt,
+                               int idx)
 {
   oo_pkt_p last_id;         /* Id of the last packet in current block */
   unsigned last_seq;        /* End sequence number of current block */
@@ -2121,7 +2451,10 @@ static void ci_tcp_rx_glue_rob(ci_netif* netif, ci_tcp_state* ts,
     LOG_TV(log(LPF "ROB glue %d and %d blocks",
                OO_PKT_FMT(pkt), OO_PP_FMT(next_id)));
 
-    /* next_id block will desappear, clear it from SACK structures. */
+    /* next_id block will desappear, clear it from the index... */
+    ci_tcp_rx_rob_index_forget(ri, idx + 1, next_id);
+
+    /* ...and from SACK structures. */
     if( ts->tcpflags & CI_TCPT_FLAG_SACK) {
       int i;
       for( i = 0; i <= CI_TCP_SACK_MAX_BLOCKS; i++ )
@@ -2255,8 +2588,8 @@ static int ci_tcp_rx_ooo_stripe(ci_netif* netif, ci_tcp_state* ts,
   not to ACK this packet.  This will be 0 if an ACK should be avoided,
   as it has detected that the out-or-order situation is probably due
   to striping over different ports rather than loss*/
-static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
-                                  ciip_tcp_rx_pkt* rxp)
+int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
+                          ciip_tcp_rx_pkt* rxp)
 {
   ci_ip_pkt_fmt* pkt = rxp->pkt;
   ci_ip_pkt_queue* rob = &ts->rob;
@@ -2265,6 +2598,10 @@ static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
   ci_ip_pkt_fmt* prev_pkt = NULL;  /* \todo Initialize in debug build only */
   oo_pkt_p       block_id;
   ci_ip_pkt_fmt* block_pkt = NULL;  /* \todo Initialize in debug build only */
+  ci_tcp_rob_index* ri;
+  int            idx;      /* last entry of [ri] at or before prev */
+  int            pkt_idx;
+  int            walked = 0;
   int af = ipcache_af(&ts->s.pkt);
 
   /* When Onload recycles packets, it bumps rcv_nxt to the end of the recycled
@@ -2287,13 +2624,35 @@ static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
 
   ci_assert(OO_SP_IS_NULL(ts->local_peer));
   ci_assert(ci_ip_queue_is_valid(netif, rob));
-  for( prev_id = OO_PP_NULL, block_id = rob->head;
+
+  /* The ROB may have been dropped wholesale since we were last here. */
+  if( ci_ip_queue_is_empty(rob) )
+    ri = ci_tcp_rx_rob_index_reset(netif, ts);
+  else
+    ri = ci_tcp_rx_rob_index(netif, ts);
+
+  /* Start from the last indexed block before the segment. */
+  idx = ci_tcp_rx_rob_index_find(ri, rxp->seq);
+  if( idx >= 0 ) {
+    prev_id = ci_tcp_rx_rob_index_blk(ri, idx);
+    prev_pkt = PKT_CHK(netif, prev_id);
+    block_id = PKT_TCP_RX_ROB(prev_pkt)->next_block;
+  }
+  else {
+    prev_id = OO_PP_NULL;
+    block_id = rob->head;
+  }
+  for( ;
        OO_PP_NOT_NULL(block_id) &&
        (block_pkt = PKT_CHK(netif, block_id),
         SEQ_LT(CI_BSWAP_BE32(PKT_IPX_TCP_HDR(af, block_pkt)->tcp_seq_be32),
                rxp->seq));
        prev_id = block_id, prev_pkt = block_pkt,
        block_id = PKT_TCP_RX_ROB(block_pkt)->next_block ) {
+    if( ci_tcp_rx_rob_index_insert(ri, idx + 1, block_pkt,
+                   CI_BSWAP_BE32(PKT_IPX_TCP_HDR(af, block_pkt)->tcp_seq_be32)) )
+      ++idx;
+    ++walked;
 
     LOG_TV(log(LNT_FMT "OOO check: from %08x-%08x to %08x-%08x",
                LNT_PRI_ARGS(netif, ts),
@@ -2307,6 +2666,12 @@ static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
                  PKT_TCP_RX_ROB(block_pkt)->end_block_seq : 0));
   }
 
+  if( walked > 8 && ri != NULL &&
+      walked > 2 * ri->blocks / CI_CFG_TCP_ROB_INDEX_SIZE ) {
+    ci_tcp_rx_rob_index_rebuild(netif, ts, ri);
+    idx = ci_tcp_rx_rob_index_find(ri, rxp->seq);
+  }
+
   /* Check if the packet is subset of existing blocks */
   if( (OO_PP_NOT_NULL(prev_id) &&
        SEQ_LE(pkt->pf.tcp_rx.end_seq,
@@ -2348,18 +2713,24 @@ static int ci_tcp_rx_enqueue_ooo(ci_netif* netif, ci_tcp_state* ts,
   if( OO_PP_IS_NULL(block_id) )
     rob->tail = OO_PKT_P(pkt);
 
+  if( ri != NULL )
+    ++ri->blocks;
+  pkt_idx = idx;
+  if( ci_tcp_rx_rob_index_insert(ri, idx + 1, pkt, rxp->seq) )
+    pkt_idx = idx + 1;
+
   /* NB. CHECK_TS(netif, ts) reports that ROB and sack state are
      inconsistent at this point because blocks have not yet been glued
      together.  */
 
   if( OO_PP_IS_NULL(prev_id) ) {
     rob->head = OO_PKT_P(pkt);
-    ci_tcp_rx_glue_rob(netif, ts, pkt);
+    ci_tcp_rx_glue_rob(netif, ts, ri, pkt, pkt_idx);
   } else {
-    ci_tcp_rx_glue_rob(netif, ts, pkt);
+    ci_tcp_rx_glue_rob(netif, ts, ri, pkt, pkt_idx);
     PKT_CHK(netif, PKT_TCP_RX_ROB(prev_pkt)->end_block)->next = OO_PKT_P(pkt);
     PKT_TCP_RX_ROB(prev_pkt)->next_block = OO_PKT_P(pkt);
-    ci_tcp_rx_glue_rob(netif, ts, prev_pkt);
+    ci_tcp_rx_glue_rob(netif, ts, ri, prev_pkt, idx);
   }
 
   CHECK_TS(netif, ts);
@@ -2760,6 +3131,63 @@ static void handle_rx_synrecv_ack(ci_netif* netif, ci_tcp_socket_listen* tls,
 }
 
 
+/* Promote [tsr] straight to the accept queue for a Fast Open SYN, queueing
+ * the data it carries and sending the SYN-ACK from the new socket.  On
+ * failure the caller falls back to an ordinary SYN-ACK and the peer resends
+ * its data.
+ */
+static int handle_rx_listen_fastopen(ci_netif* netif,
+                                     ci_tcp_socket_listen* tls,
+                                     ci_tcp_state_synrecv* tsr,
+                                     ciip_tcp_rx_pkt* rxp,
+                                     ci_ip_cached_hdrs* ipcache)
+{
+  ci_ip_pkt_fmt* pkt = rxp->pkt;
+  ci_ip_pkt_fmt* tx_pkt;
+  ci_tcp_state* ts;
+  ci_uint32 isn = tsr->snd_isn;
+  ci_uint16 wnd;
+  unsigned flags = CI_TCP_FLAG_SYN | CI_TCP_FLAG_ACK;
+
+  tx_pkt = ci_netif_pkt_alloc(netif, 0);
+  if( tx_pkt == NULL )
+    goto fail;
+  wnd = ci_tcp_calc_rcv_wnd_syn(tls->s.so.rcvbuf, tsr->amss, tsr->rcv_wscl);
+  if( tsr->tcpopts.flags & CI_TCPT_FLAG_ECN )
+    flags |= CI_TCP_FLAG_ECE;
+  if( ci_tcp_listenq_try_promote(netif, tls, tsr, ipcache, pkt, &ts) < 0 ) {
+    ci_netif_pkt_release(netif, tx_pkt);
+    goto fail;
+  }
+  CI_TCP_STATS_INC_PASSIVE_OPENS( netif );
+
+  /* Our SYN is not yet acknowledged. */
+  tcp_snd_una(ts) = tcp_snd_nxt(ts) = tcp_enq_nxt(ts) = tcp_snd_up(ts) = isn;
+  ci_tcp_set_snd_max(ts, tcp_rcv_nxt(ts), tcp_snd_una(ts), 0);
+
+  /* Queue the data; [end_seq] already accounts for the SYN. */
+  rxp->seq += 1;
+  ci_tcp_rx_deliver_to_recvq(ts, netif, rxp);
+
+  /* SYN-ACK window is not scaled. */
+  TS_IPX_TCP(ts)->tcp_window_be16 = CI_BSWAP_BE16(wnd);
+  ci_tcp_set_flags(ts, flags);
+  tx_pkt->pf.tcp_tx.sock_id = ts->s.b.bufid;
+  ci_tcp_enqueue_no_data(ts, netif, tx_pkt);
+  ci_tcp_set_flags(ts, CI_TCP_FLAG_ACK);
+
+  ci_netif_put_on_post_poll(netif, &ts->s.b);
+  CITP_STATS_NETIF_INC(netif, tcp_fastopen_passive);
+  LOG_TC(log(LNTS_FMT "Fast Open accepted %d bytes",
+             LNTS_PRI_ARGS(netif, ts), SEQ_SUB(tcp_rcv_nxt(ts), rxp->seq)));
+  return 0;
+
+ fail:
+  CITP_STATS_NETIF_INC(netif, tcp_fastopen_passive_fail);
+  return -1;
+}
+
+
 /*
 ** This function is assumed to be called when a SYN packet is routed
 ** to a listening socket it:
@@ -2781,6 +3209,7 @@ static void handle_rx_listen(ci_netif* netif, ci_tcp_socket_listen* tls,
   ci_ip_cached_hdrs ipcache;
   oo_sp local_peer = OO_SP_NULL;
   int do_syncookie = 0;
+  int fastopen_accept = 0;
 #if CI_CFG_IPV6
   int af = oo_pkt_af(pkt);
 #endif
@@ -3133,10 +3562,41 @@ static void handle_rx_listen(ci_netif* netif, ci_tcp_socket_listen* tls,
   if( tsr->tcpopts.flags & CI_TCPT_FLAG_TSO )
     tsr->tspeer = rxp->timestamp;
 
+  /* ECN-setup SYN (RFC 3168 section 6.1.1) */
+  if( (tcp->tcp_flags & (CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR)) ==
+      (CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR) )
+    tsr->tcpopts.flags |= CI_TCPT_FLAG_ECN;
+
   if( !do_syncookie ) {
     if( ! ci_tcp_can_stripe(netif, ip->ip4.ip_daddr_be32,ip->ip4.ip_saddr_be32) )
       tsr->tcpopts.flags &=~ CI_TCPT_FLAG_STRIPE;
-    tsr->tcpopts.flags &= NI_OPTS(netif).syn_opts | CI_TCPT_FLAG_STRIPE;
+    tsr->tcpopts.flags &= NI_OPTS(netif).syn_opts | CI_TCPT_FLAG_STRIPE |
+                          (ci_tcp_cong_needs_ecn(&tls->c) ?
+                           CI_TCPT_FLAG_ECN : 0);
+  }
+
+  /* TCP Fast Open (RFC 7413): data in a SYN with a valid cookie is accepted
+   * at once, up to [fastopen_qlen] connections waiting to be accepted.  A
+   * cookie request or an invalid cookie gets a fresh cookie in the SYN-ACK.
+   */
+  if( (rxp->flags & CI_TCPT_FLAG_FASTOPEN) && ! do_syncookie &&
+      tls->c.fastopen_qlen != 0 && OO_SP_IS_NULL(tsr->local_peer) &&
+      (NI_OPTS(netif).tcp_fastopen & EF_TCP_FASTOPEN_SERVER) ) {
+    ci_uint8 cookie[CI_TCP_FASTOPEN_COOKIE_LEN];
+
+    ci_tcp_fastopen_cookie(netif, RX_PKT_SADDR(pkt), cookie);
+    if( rxp->fastopen_cookie_len == CI_TCP_FASTOPEN_COOKIE_LEN &&
+        memcmp(rxp->fastopen_cookie, cookie,
+               CI_TCP_FASTOPEN_COOKIE_LEN) == 0 ) {
+      if( pkt->pf.tcp_rx.pay_len != 0 &&
+          ci_tcp_acceptq_n(tls) < CI_MIN((ci_uint32) tls->acceptq_max,
+                                         tls->c.fastopen_qlen) )
+        fastopen_accept = 1;
+    }
+    else {
+      tsr->tcpopts.flags |= CI_TCPT_FLAG_FASTOPEN;
+      CITP_STATS_NETIF_INC(netif, tcp_fastopen_cookie_sent);
+    }
   }
 
   /* setup synrecv state */
@@ -3184,6 +3644,10 @@ static void handle_rx_listen(ci_netif* netif, ci_tcp_socket_listen* tls,
                                   tsr->amss, tsr->rcv_wscl),
              tsr->snd_isn, tsr->snd_isn + pkt->pf.tcp_rx.window));
 
+  if( fastopen_accept && handle_rx_listen_fastopen(netif, tls, tsr, rxp,
+                                                   &ipcache) == 0 )
+    return;
+
   /* send SYN-ACK packet */
   CI_TCP_STATS_INC_PASSIVE_OPENS( netif );
   if( OO_SP_NOT_NULL(tsr->local_peer) )
@@ -3265,6 +3729,24 @@ static int handle_syn_sent_opts(ci_netif* netif, ci_tcp_state* ts,
   }
   tcpopts.flags |= rxp->flags & CI_TCPT_FLAG_TSO;
 
+  /* Remember the peer's Fast Open cookie, or forget it if the peer no
+   * longer accepts our SYN data. */
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN ) {
+    if( (rxp->flags & CI_TCPT_FLAG_FASTOPEN) &&
+        rxp->fastopen_cookie_len >= CI_TCP_FASTOPEN_COOKIE_MIN )
+      ci_tcp_fastopen_cache_put(netif, tcp_ipx_raddr(ts),
+                                rxp->fastopen_cookie,
+                                rxp->fastopen_cookie_len);
+    else if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA )
+      ci_tcp_fastopen_cache_put(netif, tcp_ipx_raddr(ts), NULL, 0);
+    ts->tcpflags &=~ CI_TCPT_FLAG_FASTOPEN;
+  }
+
+  /* ECN-setup SYN-ACK carries ECE but not CWR (RFC 3168 section 6.1.1) */
+  if( (rxp->tcp->tcp_flags & (CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR)) !=
+      CI_TCP_FLAG_ECE )
+    ts->tcpflags &=~ CI_TCPT_FLAG_ECN;
+
   if( ts->tcpflags & tcpopts.flags & CI_TCPT_FLAG_WSCL ) {
     ts->snd_wscl = tcpopts.wscl_shft; /* rcv_wscl set when SYN sent */
     CI_IP_SOCK_STATS_VAL_TXWSCL( ts, ts->snd_wscl );
@@ -3348,6 +3830,10 @@ static void handle_rx_syn_sent(ci_netif* netif, ci_tcp_state* ts,
     goto set_isn;
   }
 
+  /* Fast Open SYN not yet sent: nothing can be for us. */
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER )
+    goto free_out;
+
   /* We should have SYN in RTQ. */
   ci_assert(!ci_ip_queue_is_empty(&ts->retrans));
 
@@ -3415,6 +3901,12 @@ static void handle_rx_syn_sent(ci_netif* netif, ci_tcp_state* ts,
   ** and seed RTT */
   ci_assert(tcp->tcp_flags & CI_TCP_FLAG_ACK);
   ci_tcp_rx_handle_ack(ts, netif, rxp);
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA ) {
+    if( ci_ip_queue_is_empty(&ts->retrans) )
+      ts->tcpflags &=~ CI_TCPT_FLAG_FASTOPEN_DATA;
+    else
+      CITP_STATS_NETIF_INC(netif, tcp_fastopen_active_fail);
+  }
 
   /*
    * It's not necessary to shift the window because it should not be
@@ -3463,6 +3955,9 @@ set_isn:
   ci_tcp_set_initialcwnd(netif, ts);
   ci_assert_gt(ts->rcv_window_max,0);
   ci_tcp_init_rcv_wnd(ts, "SYN SENT");
+  /* Resend at once whatever SYN data the peer did not accept. */
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA )
+    ci_tcp_retrans_one(ts, netif, PKT_CHK(netif, ts->retrans.head));
   if( pkt->intf_i == OO_INTF_I_LOOPBACK ) {
     ci_tcp_state* peer = ID_TO_TCP(netif, ts->local_peer);
     /* peer is the listening socket in case of TCP_DEFER_ACCEPT */
@@ -4032,9 +4527,9 @@ static void handle_rx_slow(ci_tcp_state* ts, ci_netif* netif,
   if(CI_UNLIKELY( tcp->tcp_flags & CI_TCP_FLAG_RST ))
     goto handle_rst;
 
-  /*! \TODO We don't support ECN yet. */
-  LOG_TR(if( tcp->tcp_flags & (CI_TCP_FLAG_ECE|CI_TCP_FLAG_CWR) )
-           log(LNT_FMT "ECN flags=%x not implemented (ignored)",
+  LOG_TR(if( (tcp->tcp_flags & (CI_TCP_FLAG_ECE|CI_TCP_FLAG_CWR)) &&
+             ! (ts->tcpflags & CI_TCPT_FLAG_ECN) )
+           log(LNT_FMT "ECN flags=%x without ECN negotiated (ignored)",
                LNT_PRI_ARGS(netif, ts), (unsigned) tcp->tcp_flags));
 
   ci_assert(CI_IPX_ADDR_EQ(RX_PKT_SADDR(pkt),
@@ -4263,6 +4758,9 @@ static void handle_rx_slow(ci_tcp_state* ts, ci_netif* netif,
         }
       }
 
+      if( ts->tcpflags & CI_TCPT_FLAG_ECN )
+        ci_tcp_rx_ecn(netif, ts, rxp, pkt);
+
       /* Deliver the segment's payload to the endpoint. */
 
       if( SEQ_LE(rxp->seq, tcp_rcv_nxt(ts)) ) {
@@ -4601,6 +5099,63 @@ static void handle_no_match(ci_netif* ni, ciip_tcp_rx_pkt* rxp)
 }
 
 
+/* Locate the TCP header of a segment held by software LRO.  Only IPv4
+ * segments that have passed the checks in handle_rx_pkt() are held.
+ */
+ci_inline ci_tcp_hdr* ci_tcp_rx_lro_hdr(ci_ip_pkt_fmt* pkt, int* ip_paylen)
+{
+  ci_ip4_hdr* ip = oo_ip_hdr(pkt);
+  *ip_paylen = CI_BSWAP_BE16(ip->ip_tot_len_be16) - CI_IP4_IHL(ip);
+  return (ci_tcp_hdr*) ((char*) ip + CI_IP4_IHL(ip));
+}
+
+
+/* Enqueue a whole software LRO train, headed by [rxp->pkt], which the fast
+ * path has accepted.  The head has been prepared by the caller, and the
+ * rest of the train carry the same headers apart from sequence number and
+ * PSH, so only their payload needs setting up.
+ */
+static void ci_tcp_rx_lro_enqueue(ci_netif* ni, ci_tcp_state* ts,
+                                  ciip_tcp_rx_pkt* rxp)
+{
+  struct ci_netif_poll_state* ps = rxp->poll_state;
+  ci_ip_pkt_fmt* pkt = rxp->pkt;
+  ci_ip_pkt_queue q;
+  ci_tcp_hdr* tcp;
+  int ip_paylen;
+
+  ci_assert(ps->lro_rest);
+  ci_assert_gt(ps->lro_n, 1);
+
+  q.head = OO_PKT_P(pkt);
+  q.num = ps->lro_n;
+  pkt->next = OO_PKT_P(ps->lro_rest);
+  ps->lro_rest = NULL;
+
+  do {
+    pkt = PKT_CHK(ni, pkt->next);
+    tcp = ci_tcp_rx_lro_hdr(pkt, &ip_paylen);
+    CI_TCP_STATS_INC_IN_SEGS(ni);
+    CI_IP_SOCK_STATS_ADD_RXBYTE(ts, ip_paylen);
+    ++ts->stats.rx_pkts;
+    pkt->pf.tcp_rx.pay_len = ip_paylen - ts->incoming_tcp_hdr_len;
+    pkt->pf.tcp_rx.end_seq = CI_BSWAP_BE32(tcp->tcp_seq_be32) +
+                             pkt->pf.tcp_rx.pay_len;
+    pkt->pf.tcp_rx.window = rxp->pkt->pf.tcp_rx.window;
+    oo_offbuf_init(&pkt->buf, (char*) tcp + ts->incoming_tcp_hdr_len,
+                   pkt->pf.tcp_rx.pay_len);
+  } while( OO_PP_NOT_NULL(pkt->next) );
+
+  ci_assert_equal(pkt, ps->lro_tail);
+  ci_assert(SEQ_EQ(pkt->pf.tcp_rx.end_seq, ps->lro_next_seq));
+  q.tail = OO_PKT_P(pkt);
+  ci_tcp_rx_enqueue_chain(ni, ts, &q, pkt, ps->lro_n);
+
+  CITP_STATS_NETIF_INC(ni, tcp_lro_trains);
+  CITP_STATS_NETIF_ADD(ni, tcp_lro_segs, ps->lro_n);
+}
+
+
 int ci_tcp_rx_deliver_to_conn(ci_sock_cmn* s, void* opaque_arg)
 {
   ciip_tcp_rx_pkt* rxp = opaque_arg;
@@ -4684,6 +5239,9 @@ int ci_tcp_rx_deliver_to_conn(ci_sock_cmn* s, void* opaque_arg)
               (pkt->pf.tcp_rx.pay_len <= 0) |
               /* we're suffering from memory pressure */
               (ni->state->mem_pressure & OO_MEM_PRESSURE_CRITICAL) |
+              /* ECN echo state must change? */
+              ((ts->tcpflags & CI_TCPT_FLAG_ECN) &&
+               ci_tcp_rx_ecn_changed(ts, pkt)) |
               /* some recycling is needed */
               (ci_tcp_is_pluginized(ts) &&
                ! ci_tcp_plugin_elided_payload(pkt)));
@@ -4699,6 +5257,18 @@ int ci_tcp_rx_deliver_to_conn(ci_sock_cmn* s, void* opaque_arg)
                   OO_PP_EQ(ts->dsack_block, OO_PP_INVALID));
 
   if( not_fast == 0 ) {
+    ci_uint32 end_seq = pkt->pf.tcp_rx.end_seq;
+    int lro = 0;
+
+    /* Is this the head of a software LRO train that we can take whole? */
+    if(CI_UNLIKELY( rxp->poll_state != NULL &&
+                    rxp->poll_state->lro_head == pkt &&
+                    ! ci_tcp_is_pluginized(ts) &&
+                    SEQ_LE(rxp->poll_state->lro_next_seq,
+                           tcp_rcv_wnd_right_edge_sent(ts)) )) {
+      end_seq = rxp->poll_state->lro_next_seq;
+      lro = 1;
+    }
 
     /* Record this time so we can tell if the keepalive timer has expired
      * prematurely.
@@ -4724,8 +5294,7 @@ int ci_tcp_rx_deliver_to_conn(ci_sock_cmn* s, void* opaque_arg)
       if(CI_UNLIKELY( TIME_GT(ts->tsrecent, rxp->timestamp) ))
         goto paws_fail_on_fast_path;
 #endif
-      ci_tcp_tso_update(ni, ts, rxp->seq,
-                        pkt->pf.tcp_rx.end_seq, rxp->timestamp);
+      ci_tcp_tso_update(ni, ts, rxp->seq, end_seq, rxp->timestamp);
       /* When we change fast path to include segments that ack new data,
        * we'll need to enable this:
        */
@@ -4750,7 +5319,10 @@ int ci_tcp_rx_deliver_to_conn(ci_sock_cmn* s, void* opaque_arg)
 
     oo_offbuf_init(&pkt->buf, (char*) tcp + ts->incoming_tcp_hdr_len,
                    pkt->pf.tcp_rx.pay_len);
-    ci_tcp_rx_enqueue_packet(ni, ts, pkt);
+    if( lro )
+      ci_tcp_rx_lro_enqueue(ni, ts, rxp);
+    else
+      ci_tcp_rx_enqueue_packet(ni, ts, pkt);
 
     rxp->pkt = NULL;
 
@@ -5083,6 +5655,123 @@ static int get_actual_ceph_bytes(ci_ip_pkt_fmt* pkt)
 #endif
 
 
+/* Software LRO (EF_HIGH_THROUGHPUT_MODE).  Data segments that continue
+ * the same connection in sequence within one poll batch are held back in
+ * [ps] and handed to ci_tcp_handle_rx() as a single train.  When the head
+ * of the train takes the fast path the whole train is enqueued in one go,
+ * with one window, timestamp and ACK decision for all of it.  Otherwise
+ * the remaining segments are handled individually as usual.
+ *
+ * Like GRO we only merge pure ACK segments whose headers match exactly,
+ * options included, apart from sequence number and PSH; a segment with
+ * PSH ends the train.
+ */
+ci_inline int ci_tcp_rx_lro_can_hold(ci_ip_pkt_fmt* pkt, ci_tcp_hdr* tcp,
+                                     int ip_paylen)
+{
+  ci_ip4_hdr* ip = oo_ip_hdr(pkt);
+  return oo_pkt_af(pkt) == AF_INET &&
+         (ip->ip_frag_off_be16 == CI_IP4_FRAG_DONT ||
+          ip->ip_frag_off_be16 == 0) &&
+         OO_PP_IS_NULL(pkt->frag_next) &&
+#if CI_CFG_TCP_OFFLOAD_RECYCLER
+         pkt->q_id == CI_Q_ID_NORMAL &&
+#endif
+         (tcp->tcp_flags & ~CI_TCP_FLAG_PSH) == CI_TCP_FLAG_ACK &&
+         CI_TCP_HDR_LEN(tcp) >= sizeof(ci_tcp_hdr) &&
+         ip_paylen > CI_TCP_HDR_LEN(tcp);
+}
+
+
+ci_inline int ci_tcp_rx_lro_can_append(struct ci_netif_poll_state* ps,
+                                       ci_ip_pkt_fmt* pkt, ci_tcp_hdr* tcp)
+{
+  ci_ip4_hdr* ip = oo_ip_hdr(pkt);
+  ci_ip4_hdr* head_ip = oo_ip_hdr(ps->lro_head);
+  ci_tcp_hdr* head_tcp = ps->lro_tcp;
+
+  return ps->lro_n < CI_CFG_TCP_LRO_MAX_SEGS &&
+         CI_BSWAP_BE32(tcp->tcp_seq_be32) == ps->lro_next_seq &&
+         pkt->intf_i == ps->lro_head->intf_i &&
+         ip->ip_saddr_be32 == head_ip->ip_saddr_be32 &&
+         ip->ip_daddr_be32 == head_ip->ip_daddr_be32 &&
+         ip->ip_ihl_version == head_ip->ip_ihl_version &&
+         ip->ip_tos == head_ip->ip_tos &&
+         tcp->tcp_source_be16 == head_tcp->tcp_source_be16 &&
+         tcp->tcp_dest_be16 == head_tcp->tcp_dest_be16 &&
+         tcp->tcp_ack_be32 == head_tcp->tcp_ack_be32 &&
+         tcp->tcp_window_be16 == head_tcp->tcp_window_be16 &&
+         tcp->tcp_hdr_len_sl4 == head_tcp->tcp_hdr_len_sl4 &&
+         memcmp(CI_TCP_HDR_OPTS(tcp), CI_TCP_HDR_OPTS(head_tcp),
+                CI_TCP_HDR_LEN(tcp) - sizeof(ci_tcp_hdr)) == 0;
+}
+
+
+void ci_tcp_rx_lro_flush(ci_netif* netif, struct ci_netif_poll_state* ps)
+{
+  ci_ip_pkt_fmt* pkt = ps->lro_head;
+  ci_tcp_hdr* tcp;
+  int ip_paylen;
+
+  if( pkt == NULL )
+    return;
+
+  if( ps->lro_rest == NULL ) {
+    ps->lro_head = NULL;
+    ci_tcp_handle_rx(netif, ps, pkt, ps->lro_tcp, ps->lro_ip_paylen);
+    return;
+  }
+
+  /* ci_tcp_rx_deliver_to_conn() recognises the head of the train by
+   * [lro_head], and clears [lro_rest] if it takes the whole train. */
+  ci_tcp_handle_rx(netif, ps, pkt, ps->lro_tcp, ps->lro_ip_paylen);
+  ps->lro_head = NULL;
+
+  while( (pkt = ps->lro_rest) != NULL ) {
+    ps->lro_rest = OO_PP_IS_NULL(pkt->next) ? NULL : PKT_CHK(netif, pkt->next);
+    pkt->next = OO_PP_NULL;
+    tcp = ci_tcp_rx_lro_hdr(pkt, &ip_paylen);
+    ci_tcp_handle_rx(netif, ps, pkt, tcp, ip_paylen);
+  }
+}
+
+
+void ci_tcp_handle_rx_lro(ci_netif* netif, struct ci_netif_poll_state* ps,
+                          ci_ip_pkt_fmt* pkt, ci_tcp_hdr* tcp, int ip_paylen)
+{
+  ci_assert(ps);
+
+  if( ! ci_tcp_rx_lro_can_hold(pkt, tcp, ip_paylen) ) {
+    ci_tcp_rx_lro_flush(netif, ps);
+    ci_tcp_handle_rx(netif, ps, pkt, tcp, ip_paylen);
+    return;
+  }
+
+  if( ps->lro_head != NULL && ci_tcp_rx_lro_can_append(ps, pkt, tcp) ) {
+    pkt->next = OO_PP_NULL;
+    if( ps->lro_rest == NULL )
+      ps->lro_rest = pkt;
+    else
+      ps->lro_tail->next = OO_PKT_P(pkt);
+    ps->lro_tail = pkt;
+    ++ps->lro_n;
+  }
+  else {
+    ci_tcp_rx_lro_flush(netif, ps);
+    ps->lro_head = ps->lro_tail = pkt;
+    ps->lro_rest = NULL;
+    ps->lro_tcp = tcp;
+    ps->lro_ip_paylen = ip_paylen;
+    ps->lro_n = 1;
+  }
+  ps->lro_next_seq = CI_BSWAP_BE32(tcp->tcp_seq_be32) +
+                     ip_paylen - CI_TCP_HDR_LEN(tcp);
+
+  if( tcp->tcp_flags & CI_TCP_FLAG_PSH )
+    ci_tcp_rx_lro_flush(netif, ps);
+}
+
+
 void ci_tcp_rx_plugin_meta(ci_netif* netif, struct ci_netif_poll_state* ps,
                            ci_ip_pkt_fmt* pkt)
 {
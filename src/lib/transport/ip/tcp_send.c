@@ -115,6 +115,19 @@ static void ci_tcp_tx_advance_nagle(ci_netif* ni, ci_tcp_state* ts)
     goto advance_now;
 
   if( ts->s.s_aflags & CI_SOCK_AFLAG_NODELAY ) {
+    /* Autocork: hold a small segment while the previous one is still
+     * waiting for its TX completion, so that further small sends are
+     * added to it.  The completion releases it via the post-poll list.
+     */
+    if( NI_OPTS(ni).tcp_autocork && ci_ip_queue_not_empty(&ts->retrans) &&
+        (PKT_CHK(ni, ts->retrans.tail)->flags & CI_PKT_FLAG_TX_PENDING) ) {
+      if( ! (ts->tcpflags & CI_TCPT_FLAG_AUTOCORK) ) {
+        ts->tcpflags |= CI_TCPT_FLAG_AUTOCORK;
+        CITP_STATS_NETIF_INC(ni, tcp_autocork_held);
+      }
+      goto poll_and_out;
+    }
+
     /* With nagle off it is possible for a sender to push zillions of tiny
      * packets onto the network, which consumes loads of memory.  To
      * prevent this we choose not to advance if many packets are already
@@ -323,7 +336,8 @@ void ci_tcp_tx_fill_sendq_tail(ci_netif* ni, ci_tcp_state* ts,
   pkt = PKT_CHK(ni, sendq->tail);
   if( ts->s.tx_errno == 0 &&
       (NI_OPTS(ni).tcp_combine_sends_mode == 0 ||
-       pkt->flags & CI_PKT_FLAG_TX_MORE) ) {
+       pkt->flags & CI_PKT_FLAG_TX_MORE ||
+       ts->tcpflags & CI_TCPT_FLAG_AUTOCORK) ) {
     if(CI_UNLIKELY( pkt->flags & CI_PKT_FLAG_INDIRECT )) {
       /* Making this work in kernelspace is not particularly difficult, but
        * so rarely used that it's not worth the effort. The only thing which
@@ -372,6 +386,8 @@ void ci_tcp_tx_fill_sendq_tail(ci_netif* ni, ci_tcp_state* ts,
     }
     else if( oo_offbuf_left(&pkt->buf) > 0 ) {
       n = ci_tcp_fill_stolen_buffer(ni, pkt, piov  CI_KERNEL_ARG(addr_spc));
+      if( (ts->tcpflags & CI_TCPT_FLAG_AUTOCORK) && n > 0 )
+        CITP_STATS_NETIF_INC(ni, tcp_autocork_coalesced);
       LOG_TV(ci_log("%s: "NT_FMT "sq=%d if=%d bytes=%d piov.left=%d "
                     "pkt.left=%d", __FUNCTION__, NT_PRI_ARGS(ni, ts),
                     SEQ_SUB(tcp_enq_nxt(ts), tcp_snd_nxt(ts)),
@@ -420,6 +436,7 @@ ci_inline void ci_tcp_sendmsg_prep_pkt(ci_netif* ni, ci_tcp_state* ts,
   pkt->pf.tcp_tx.end_seq += seq;
 
   pkt->pf.tcp_tx.block_end = OO_PP_NULL;
+  pkt->tstamp_frc = 0;
 
   LOG_TV(log(LPF "%s: %d: %x-%x", __FUNCTION__, OO_PKT_FMT(pkt),
              pkt->pf.tcp_tx.start_seq, pkt->pf.tcp_tx.end_seq));
@@ -1007,9 +1024,11 @@ ci_tcp_tmpl_update(ci_netif* ni, ci_tcp_state* ts,
   ci_assert_ge(pkt->pio_addr, 0);
 
   if( ci_ip_queue_is_empty(&ts->send) && ef_vi_transmit_space(vi) > 0 &&
-      ci_tcp_inflight(ts) + ts->smss < CI_MIN(ts->cwnd, tcp_snd_wnd(ts)) ) {
-    /* Sendq is empty, TXQ is not full, and send window allows us to
-     * send the requested amount of data, so go ahead and send
+      ci_tcp_inflight(ts) + ts->smss < CI_MIN(ts->cwnd, tcp_snd_wnd(ts)) &&
+      ts->pace_rate == 0 ) {
+    /* Sendq is empty, TXQ is not full, send window allows us to send the
+     * requested amount of data, and the socket is not paced, so go ahead
+     * and send
      */
 
     if( CI_BSWAP_BE32(tcp->tcp_seq_be32) != tcp_enq_nxt(ts) ) {
@@ -1054,6 +1073,7 @@ ci_tcp_tmpl_update(ci_netif* ni, ci_tcp_state* ts,
     tcp_snd_nxt(ts) = pkt->pf.tcp_tx.end_seq;
     tcp_enq_nxt(ts) = pkt->pf.tcp_tx.end_seq;
     pkt->pf.tcp_tx.block_end = OO_PP_NULL;
+    ci_frc64(&pkt->tstamp_frc);
     ci_tcp_tmpl_remove(ni, ts, pkt);
     ci_ip_queue_enqueue(ni, &ts->retrans, pkt);
     --ni->state->n_async_pkts;
@@ -1094,6 +1114,55 @@ int ci_tcp_tmpl_abort(ci_netif* ni, ci_tcp_state* ts,
 #endif /* CI_CFG_PIO */
 
 
+/* EF_TCP_GSO: can [pkt] be part of a super-segment?  Only full-sized,
+ * copied segments are grouped so that splitting the super-segment on
+ * transmit is just a matter of building the headers.
+ */
+ci_inline int ci_tcp_sendmsg_gso_can_hold(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt)
+{
+  /* [end_seq] still holds the length of the payload; see
+   * ci_tcp_sendmsg_prep_pkt(). */
+  return pkt->pf.tcp_tx.end_seq == tcp_eff_mss(ts) &&
+         (pkt->flags & (CI_PKT_FLAG_INDIRECT | CI_PKT_FLAG_TX_MORE)) == 0;
+}
+
+
+/* EF_TCP_GSO: chain the full-sized segments that follow [head] on [list]
+ * on to [head] to make a super-segment.  The last segment of the list is
+ * never taken, so the tail of the send queue is always an ordinary packet
+ * that later sends and the FIN can be added to.  Returns the number of
+ * segments taken.
+ */
+static int ci_tcp_sendmsg_gso_chain(ci_netif* ni, ci_tcp_state* ts,
+                                    ci_ip_pkt_fmt* head)
+{
+  ci_ip_pkt_fmt* seg = head;
+  ci_ip_pkt_fmt* next;
+  int bytes = tcp_eff_mss(ts);
+  int n = 0;
+
+  while( OO_PP_NOT_NULL(seg->next) ) {
+    next = PKT_CHK(ni, seg->next);
+    if( OO_PP_IS_NULL(next->next) || ! ci_tcp_sendmsg_gso_can_hold(ts, next) ||
+        bytes + tcp_eff_mss(ts) > CI_CFG_TCP_GSO_MAX_BYTES )
+      break;
+    bytes += tcp_eff_mss(ts);
+    seg->netif.tcp_gso_next = OO_PKT_P(next);
+    next->netif.tcp_gso_next = OO_PP_NULL;
+    seg = next;
+    ++n;
+  }
+
+  if( n ) {
+    head->next = seg->next;
+    head->pf.tcp_tx.end_seq += n * tcp_eff_mss(ts);
+    CITP_STATS_NETIF_INC(ni, tcp_gso_super_segs);
+    CITP_STATS_NETIF_ADD(ni, tcp_gso_segs, n + 1);
+  }
+  return n;
+}
+
+
 static int ci_tcp_sendmsg_enqueue(ci_netif* ni, ci_tcp_state* ts,
                                    ci_ip_pkt_fmt* reverse_list,
                                    int total_bytes,
@@ -1104,29 +1173,70 @@ static int ci_tcp_sendmsg_enqueue(ci_netif* ni, ci_tcp_state* ts,
   oo_pkt_p send_list = OO_PP_NULL;
   ci_ip_pkt_fmt* pkt;
   int n_pkts = 0;
+  int n_entries;
 
   ci_assert(ci_netif_is_locked(ni));
   ci_assert_equal(ts->s.tx_errno, 0);
 
-  do {
-    pkt = reverse_list;
-    reverse_list = (ci_ip_pkt_fmt *)CI_USER_PTR_GET(pkt->pf.tcp_tx.next);
+  if( NI_OPTS(ni).tcp_gso && sendq == &ts->send &&
+      (ts->s.b.state & (CI_TCP_ESTABLISHED | CI_TCP_CLOSE_WAIT)) &&
+      ! (ts->tcpflags & CI_TCPT_FLAG_MSG_WARM) ) {
+    /* Link the list in order, and then prep each packet, leaving the
+     * followers of a super-segment as they were filled.  Their headers are
+     * built by ci_tcp_tx_gso_segment() on transmit.
+     */
+    do {
+      pkt = reverse_list;
+      reverse_list = (ci_ip_pkt_fmt *)CI_USER_PTR_GET(pkt->pf.tcp_tx.next);
+      pkt->next = send_list;
+      send_list = OO_PKT_P(pkt);
+      ++n_pkts;
+    }
+    while( reverse_list );
+
+    seq = tcp_enq_nxt(ts);
+    n_entries = n_pkts;
+    for( pkt = PKT_CHK(ni, send_list); ;
+         pkt = PKT_CHK(ni, pkt->next) ) {
+      int bytes = pkt->pf.tcp_tx.end_seq;
+      int can_hold = ci_tcp_sendmsg_gso_can_hold(ts, pkt);
+      int n;
+      ci_tcp_sendmsg_prep_pkt(ni, ts, pkt, seq);
+      seq += bytes;
+      if( can_hold && (n = ci_tcp_sendmsg_gso_chain(ni, ts, pkt)) ) {
+        seq += n * tcp_eff_mss(ts);
+        n_entries -= n;
+      }
+      if( OO_PP_IS_NULL(pkt->next) )
+        break;
+    }
+    seq -= total_bytes;
+  }
+  else {
+    do {
+      pkt = reverse_list;
+      reverse_list = (ci_ip_pkt_fmt *)CI_USER_PTR_GET(pkt->pf.tcp_tx.next);
 
-    seq -= pkt->pf.tcp_tx.end_seq;
-    ci_tcp_sendmsg_prep_pkt(ni, ts, pkt, seq);
+      seq -= pkt->pf.tcp_tx.end_seq;
+      ci_tcp_sendmsg_prep_pkt(ni, ts, pkt, seq);
 
-    pkt->next = send_list;
-    send_list = OO_PKT_P(pkt);
-    ++n_pkts;
+      pkt->next = send_list;
+      send_list = OO_PKT_P(pkt);
+      ++n_pkts;
+    }
+    while( reverse_list );
+    n_entries = n_pkts;
   }
-  while( reverse_list );
 
   ci_assert_equal(tcp_enq_nxt(ts), seq);
   tcp_enq_nxt(ts) += total_bytes;
 
-  /* Append these packets to the send queue. */
+  /* Append these packets to the send queue.  [n_pkts] counts every buffer,
+   * including those held in super-segments, as that is what [send_in] and
+   * [send_out] count.
+   */
   ni->state->n_async_pkts -= n_pkts;
-  sendq->num += n_pkts;
+  sendq->num += n_entries;
   if( OO_PP_IS_NULL(sendq->head) )
     sendq->head = send_list;
   else
@@ -1142,6 +1252,70 @@ static int ci_tcp_sendmsg_enqueue(ci_netif* ni, ci_tcp_state* ts,
 }
 
 
+/* EF_TCP_GSO: split the super-segment [pkt] on the send queue back into
+ * its segments, building the headers of the followers.  The segments were
+ * filled and accounted for when the super-segment was queued, so this needs
+ * no buffers and cannot fail.  They keep the size they were filled at,
+ * which may be more than the current MSS if it has since shrunk.  Returns
+ * the number of packets added to the send queue.
+ */
+int ci_tcp_tx_gso_segment(ci_netif* ni, ci_tcp_state* ts, ci_ip_pkt_fmt* pkt)
+{
+  ci_ip_pkt_queue* sendq = &ts->send;
+  int af = ipcache_af(&ts->s.pkt);
+  ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
+  ci_uint8 psh = tcp->tcp_flags & CI_TCP_FLAG_PSH;
+  ci_ip_pkt_fmt* seg = pkt;
+  ci_ip_pkt_fmt* next;
+  oo_pkt_p id = pkt->netif.tcp_gso_next;
+  unsigned seq;
+  int n = 0;
+#ifndef NDEBUG
+  unsigned end_seq = pkt->pf.tcp_tx.end_seq;
+#endif
+
+  ci_assert(ci_netif_is_locked(ni));
+  ci_assert(ci_tcp_tx_pkt_is_gso(af, pkt));
+  ci_assert_nflags(tcp->tcp_flags, CI_TCP_FLAG_SYN | CI_TCP_FLAG_FIN);
+  ci_assert(! OO_PP_EQ(sendq->tail, OO_PKT_P(pkt)));
+
+  seq = pkt->pf.tcp_tx.start_seq + ci_tcp_tx_pkt_own_paylen(af, pkt);
+  pkt->pf.tcp_tx.end_seq = seq;
+  tcp->tcp_flags &= ~CI_TCP_FLAG_PSH;
+
+  while( OO_PP_NOT_NULL(id) ) {
+    next = PKT_CHK(ni, id);
+    id = next->netif.tcp_gso_next;
+    ci_tcp_sendmsg_prep_pkt(ni, ts, next, seq);
+    seq = next->pf.tcp_tx.end_seq;
+    next->next = seg->next;
+    seg->next = OO_PKT_P(next);
+    seg = next;
+    ++n;
+  }
+  ci_assert(SEQ_EQ(seq, end_seq));
+  pkt->netif.tcp_gso_next = OO_PP_NULL;
+
+  TX_PKT_IPX_TCP(af, seg)->tcp_flags |= psh;
+  sendq->num += n;
+  return n;
+}
+
+
+void ci_tcp_sendq_gso_segment_all(ci_netif* ni, ci_tcp_state* ts)
+{
+  int af = ipcache_af(&ts->s.pkt);
+  ci_ip_pkt_fmt* pkt;
+  oo_pkt_p id;
+
+  for( id = ts->send.head; OO_PP_NOT_NULL(id); id = pkt->next ) {
+    pkt = PKT_CHK(ni, id);
+    if( ci_tcp_tx_pkt_is_gso(af, pkt) )
+      ci_tcp_tx_gso_segment(ni, ts, pkt);
+  }
+}
+
+
 static int/*bool*/
 ci_tcp_tx_prequeue(ci_netif* ni, ci_tcp_state* ts, ci_ip_pkt_fmt* fill_list)
 {
@@ -1386,6 +1560,43 @@ static int ci_tcp_sendmsg_notsynchronised(ci_netif* ni, ci_tcp_state* ts,
 }
 
 
+/* First send on a socket whose Fast Open connect was deferred: send the
+ * SYN, carrying as much of the data as fits in one segment.  Returns
+ * non-zero if the call is complete, with [sinf->total_sent] or [sinf->rc]
+ * set, and zero to carry on as for any connection in SYN-SENT.
+ */
+static int ci_tcp_sendmsg_fastopen(ci_netif* ni, ci_tcp_state* ts,
+                                   const ci_iovec* iov, unsigned long iovlen,
+                                   struct tcp_send_info* sinf)
+{
+  ci_ip_pkt_fmt* pkt;
+
+  if( !sinf->stack_locked ) {
+    if( (sinf->rc = ci_netif_lock(ni)) )
+      return 1;
+    sinf->stack_locked = 1;
+  }
+  if( ~ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER )
+    return 0;
+
+  pkt = ci_netif_pkt_tx_tcp_alloc(ni, ts);
+  if( pkt == NULL ) {
+    sinf->rc = -ENOBUFS;
+    return 1;
+  }
+  ts->tcpflags &=~ CI_TCPT_FLAG_FASTOPEN_DEFER;
+  pkt->pf.tcp_tx.sock_id = ts->s.b.bufid;
+#ifdef __KERNEL__
+  /* Kernel sends carry user-space iovecs; send the data after the
+   * handshake. */
+  iovlen = 0;
+#endif
+  sinf->total_sent = ci_tcp_enqueue_syn_data(ts, ni, pkt, iov, iovlen);
+  ci_tcp_set_flags(ts, CI_TCP_FLAG_ACK);
+  return sinf->total_sent != 0;
+}
+
+
 static void ci_tcp_sendmsg_handle_rc_or_tx_errno(ci_netif* ni, 
                                                  ci_tcp_state* ts, 
                                                  int flags, 
@@ -2276,6 +2487,13 @@ int ci_tcp_sendmsg(ci_netif* ni, ci_tcp_state* ts,
     RET_WITH_ERRNO(EPIPE);
   }
 
+  if( (ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DEFER) &&
+      ci_tcp_sendmsg_fastopen(ni, ts, iov, iovlen, &sinf) ) {
+    ci_tcp_sendmsg_handle_rc_or_tx_errno(ni, ts, flags, &sinf);
+    if( sinf.set_errno ) CI_SET_ERROR(sinf.rc, sinf.rc);
+    return sinf.rc;
+  }
+
   if( ci_tcp_sendmsg_notsynchronised(ni, ts, flags, &sinf) == -1 ) {
     ci_tcp_sendmsg_handle_rc_or_tx_errno(ni, ts, flags, &sinf);
     if( sinf.set_errno ) CI_SET_ERROR(sinf.rc, sinf.rc);
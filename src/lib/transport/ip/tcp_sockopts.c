@@ -16,6 +16,7 @@
 #include "ip_internal.h"
 #include <ci/internal/ip_stats.h>
 #include <ci/net/sockopts.h>
+#include <onload/sleep.h>
 
 #if !defined(__KERNEL__)
 #  include <onload/extensions_zc.h>
@@ -151,10 +152,10 @@ ci_tcp_info_get(ci_netif* netif, ci_sock_cmn* s, struct ci_tcp_info* uinfo,
     }
     info.tcpi_total_retrans = ts->stats.total_retrans;
 
-    /* Starting from linux-3.15, there are tcpi_pacing_rate and
-     * tcpi_max_pacing_rate fields.  However, as Onload does not support
-     * pacing, we might as well pretend that we simulate older kernel
-     * with smaller tcp_info size. */
+    /* As Linux, report ~0 when the socket is not paced. */
+    info.tcpi_pacing_rate = ts->pace_rate != 0 ?
+      ci_tcp_pace_rate_to_bps(netif, ts->pace_rate) : ~0ull;
+    info.tcpi_max_pacing_rate = ts->c.max_pacing_rate;
   }
 
   if( *optlen > sizeof(info) )
@@ -231,6 +232,31 @@ int ci_get_sol_tcp(ci_netif* netif, ci_sock_cmn* s, int optname, void *optval,
       }
       goto u_out;
     }
+  case TCP_CONGESTION:
+    {
+      /* As Linux, return the name padded with zeros to the maximum length */
+      char name[CI_TCP_CONG_NAME_MAX] = "";
+      strncpy(name, ci_tcp_cong(c)->name, sizeof(name) - 1);
+      if( *optlen > sizeof(name) )
+        *optlen = sizeof(name);
+      memcpy(optval, name, *optlen);
+      return 0;
+    }
+#ifdef TCP_FASTOPEN
+  case TCP_FASTOPEN:
+    u = c->fastopen_qlen;
+    goto u_out;
+#endif
+#ifdef TCP_FASTOPEN_CONNECT
+  case TCP_FASTOPEN_CONNECT:
+    u = c->fastopen_connect;
+    goto u_out;
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+  case TCP_NOTSENT_LOWAT:
+    u = c->notsent_lowat;
+    goto u_out;
+#endif
   case TCP_QUICKACK:
     {
       u = 0;
@@ -304,6 +330,18 @@ int ci_tcp_getsockopt(citp_socket* ep, ci_fd_t fd, int level,
       ci_tcp_set_sndbuf_from_sndbuf_pkts(netif, ts);
     }
 
+    if( optname == SO_MAX_PACING_RATE ) {
+      ci_uint64 rate = SOCK_TO_WAITABLE_OBJ(s)->tcp.c.max_pacing_rate;
+      if( *optlen >= sizeof(ci_uint64) )
+        return ci_getsockopt_final(optval, optlen, level,
+                                   &rate, sizeof(rate));
+      else {
+        ci_uint32 rate32 = CI_MIN(rate, (ci_uint64) ~0u);
+        return ci_getsockopt_final(optval, optlen, level,
+                                   &rate32, sizeof(rate32));
+      }
+    }
+
     /* Common SOL_SOCKET handler */
     return ci_get_sol_socket(netif, s, optname, optval, optlen);
 
@@ -379,6 +417,24 @@ static int ci_tcp_setsockopt_lk(citp_socket* ep, ci_fd_t fd, int level,
       }
       break;
 
+    case SO_MAX_PACING_RATE:
+      /* Linux accepts either a 32- or 64-bit rate in bytes per second.  With
+       * 32 bits, ~0U means unlimited. */
+      if( optlen >= sizeof(ci_uint64) && optval != NULL ) {
+        c->max_pacing_rate = *(ci_uint64*) optval;
+      }
+      else {
+        ci_uint32 rate;
+        if( (rc = opt_not_ok(optval, optlen, ci_uint32)) )
+          goto fail_inval;
+        rate = *(ci_uint32*) optval;
+        c->max_pacing_rate = rate == ~0u ? CI_TCP_PACING_RATE_UNLIMITED : rate;
+      }
+      if( s->b.state != CI_TCP_LISTEN &&
+          (s->b.state & CI_TCP_STATE_SYNCHRONISED) )
+        ci_tcp_pace_update(netif, SOCK_TO_TCP(s));
+      break;
+
     default:
       {
         /* Common socket level options */
@@ -394,6 +450,27 @@ static int ci_tcp_setsockopt_lk(citp_socket* ep, ci_fd_t fd, int level,
     /* IPv6 level options valid for TCP */
     return ci_set_sol_ip6(netif, s, optname, optval, optlen);
   }
+  else if( level == IPPROTO_TCP && optname == TCP_CONGESTION ) {
+    /* The only TCP option that is a string rather than an int */
+    char name[CI_TCP_CONG_NAME_MAX];
+    int alg, len;
+
+    if( optlen < 1 ) {
+      rc = -EINVAL;
+      goto fail_inval;
+    }
+    len = CI_MIN(optlen, sizeof(name) - 1);
+    memcpy(name, optval, len);
+    name[len] = '\0';
+    if( (alg = ci_tcp_cong_find(name, strlen(name))) < 0 ) {
+      rc = alg;
+      goto fail_inval;
+    }
+    if( s->b.state == CI_TCP_LISTEN )
+      c->cc_alg = alg;
+    else
+      ci_tcp_cong_set(netif, SOCK_TO_TCP(s), alg);
+  }
   else if( level == IPPROTO_TCP ) {
     /* These are ints values */
     if( (rc = opt_not_ok(optval, optlen, int)) )
@@ -509,6 +586,40 @@ static int ci_tcp_setsockopt_lk(citp_socket* ep, ci_fd_t fd, int level,
         }
       }
       break;
+#ifdef TCP_FASTOPEN
+    case TCP_FASTOPEN:
+      /* Maximum number of connections accepted with data in the SYN that
+       * may be waiting in the accept queue. */
+      if( *(int*) optval < 0 ||
+          (s->b.state != CI_TCP_CLOSED && s->b.state != CI_TCP_LISTEN) ) {
+        rc = -EINVAL;
+        goto fail_inval;
+      }
+      c->fastopen_qlen = *(int*) optval;
+      break;
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+    case TCP_NOTSENT_LOWAT:
+      c->notsent_lowat = *(unsigned*) optval;
+      /* Raising the limit may make the socket writable. */
+      if( (s->b.state & CI_TCP_STATE_SYNCHRONISED) &&
+          ci_tcp_tx_advertise_space(netif, SOCK_TO_TCP(s)) )
+        ci_tcp_wake(netif, SOCK_TO_TCP(s), CI_SB_FLAG_WAKE_TX);
+      break;
+#endif
+#ifdef TCP_FASTOPEN_CONNECT
+    case TCP_FASTOPEN_CONNECT:
+      if( *(unsigned*) optval > 1 || s->b.state != CI_TCP_CLOSED ) {
+        rc = -EINVAL;
+        goto fail_inval;
+      }
+      if( ~NI_OPTS(netif).tcp_fastopen & EF_TCP_FASTOPEN_CLIENT ) {
+        rc = -EOPNOTSUPP;
+        goto fail_inval;
+      }
+      c->fastopen_connect = *(int*) optval;
+      break;
+#endif
 #if CI_CFG_TCP_OFFLOAD_RECYCLER
     case ONLOAD_TCP_OFFLOAD:
       {
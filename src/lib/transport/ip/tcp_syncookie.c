@@ -258,3 +258,61 @@ ci_tcp_syncookie_ack(ci_netif* netif, ci_tcp_socket_listen* tls,
   CITP_STATS_TCP_LISTEN(++tls->stats.n_syncookie_ack_answ);
 }
 
+
+
+/* TCP Fast Open (RFC 7413) cookies.  The cookie we give a client is a MAC
+ * of its address, so checking one needs no state on the server.  Cookies
+ * servers give us are remembered per remote address in the stack. */
+
+void
+ci_tcp_fastopen_cookie(ci_netif* netif, ci_addr_t raddr, ci_uint8* cookie)
+{
+  ci_uint64 mac;
+
+  CI_BUILD_ASSERT(sizeof(mac) == CI_TCP_FASTOPEN_COOKIE_LEN);
+  mac = sip_hash((void*)netif->state->hash_salt, &raddr, sizeof(raddr));
+  memcpy(cookie, &mac, sizeof(mac));
+}
+
+ci_inline ci_tcp_fastopen_cache_entry*
+ci_tcp_fastopen_cache_entry_get(ci_netif* netif, ci_addr_t raddr)
+{
+  unsigned h = onload_addr_xor(raddr);
+  h ^= h >> 16;
+  h ^= h >> 8;
+  return &netif->state->tcp_fastopen_cache[h &
+                                   (CI_CFG_TCP_FASTOPEN_CACHE_SIZE - 1)];
+}
+
+int
+ci_tcp_fastopen_cache_get(ci_netif* netif, ci_addr_t raddr, ci_uint8* cookie)
+{
+  ci_tcp_fastopen_cache_entry* e =
+    ci_tcp_fastopen_cache_entry_get(netif, raddr);
+
+  ci_assert(ci_netif_is_locked(netif));
+  if( e->cookie_len == 0 || ! CI_IPX_ADDR_EQ(e->raddr, raddr) )
+    return 0;
+  memcpy(cookie, e->cookie, e->cookie_len);
+  return e->cookie_len;
+}
+
+void
+ci_tcp_fastopen_cache_put(ci_netif* netif, ci_addr_t raddr,
+                          const ci_uint8* cookie, int len)
+{
+  ci_tcp_fastopen_cache_entry* e =
+    ci_tcp_fastopen_cache_entry_get(netif, raddr);
+
+  ci_assert(ci_netif_is_locked(netif));
+  ci_assert_le(len, CI_TCP_FASTOPEN_COOKIE_MAX);
+  if( len == 0 ) {
+    /* Forget the cookie for [raddr], leaving any other host's alone. */
+    if( CI_IPX_ADDR_EQ(e->raddr, raddr) )
+      e->cookie_len = 0;
+    return;
+  }
+  e->raddr = raddr;
+  e->cookie_len = len;
+  memcpy(e->cookie, cookie, len);
+}
@@ -648,6 +648,12 @@ static void ci_tcp_inherit_options(ci_netif* ni, ci_sock_cmn* s,
   ts->c.t_ka_intvl         = c->t_ka_intvl;
   ts->c.t_ka_intvl_in_secs = c->t_ka_intvl_in_secs;
   ts->c.ka_probe_th        = c->ka_probe_th;
+  /* TCP_CONGESTION */
+  ts->c.cc_alg             = c->cc_alg;
+  /* SO_MAX_PACING_RATE */
+  ts->c.max_pacing_rate    = c->max_pacing_rate;
+  /* TCP_NOTSENT_LOWAT */
+  ts->c.notsent_lowat      = c->notsent_lowat;
   {
     int af = ipcache_af(&ts->s.pkt);
     ci_ipx_hdr_init_fixed(&ts->s.pkt.ipx, af, IPPROTO_TCP,
@@ -911,7 +917,7 @@ int ci_tcp_listenq_try_promote(ci_netif* netif, ci_tcp_socket_listen* tls,
 
     /* options and flags */
     ts->tcpflags = 0;
-    ts->tcpflags |= tsr->tcpopts.flags;
+    ts->tcpflags |= tsr->tcpopts.flags & ~CI_TCPT_FLAG_FASTOPEN;
     ts->tcpflags |= CI_TCPT_FLAG_PASSIVE_OPENED;
     ts->outgoing_hdrs_len = CI_IPX_HDR_SIZE(ipcache_af(&ts->s.pkt)) +
                             sizeof(ci_tcp_hdr);
@@ -952,6 +958,8 @@ int ci_tcp_listenq_try_promote(ci_netif* netif, ci_tcp_socket_listen* tls,
 
     ts->smss = tsr->tcpopts.smss;
     ts->c.user_mss = tls->c.user_mss;
+    ts->c.cc_alg = tls->c.cc_alg;
+    ts->c.max_pacing_rate = tls->c.max_pacing_rate;
     if (ts->c.user_mss && ts->c.user_mss < ts->smss)
       ts->smss = ts->c.user_mss;
 #if CI_CFG_LIMIT_SMSS
@@ -445,6 +445,14 @@ void ci_tcp_timeout_cork(ci_netif* netif, ci_tcp_state* ts)
 }
 
 
+/* Called when the pacing timer fires: send what the budget now allows. */
+void ci_tcp_timeout_pace(ci_netif* netif, ci_tcp_state* ts)
+{
+  if( ci_ip_queue_not_empty(&ts->send) )
+    ci_tcp_tx_advance(ts, netif);
+}
+
+
 /* Called as action on a retransmission timer timeout (RTO) */
 void ci_tcp_timeout_rto(ci_netif* netif, ci_tcp_state* ts)
 {
@@ -564,7 +572,7 @@ void ci_tcp_timeout_rto(ci_netif* netif, ci_tcp_state* ts)
       ts->ssthresh = CI_MAX(x, y);
     }
     else
-      ts->ssthresh = ci_tcp_losswnd(ts);
+      ts->ssthresh = ci_tcp_cong_on_loss(netif, ts);
 
     ts->congstate = CI_TCP_CONG_RTO;
     ts->cwnd_extra = 0;
@@ -577,6 +585,7 @@ void ci_tcp_timeout_rto(ci_netif* netif, ci_tcp_state* ts)
   ts->cwnd = CI_MAX((ci_uint32)tcp_eff_mss(ts), NI_OPTS(netif).loss_min_cwnd);
   ts->cwnd = CI_MAX(ts->cwnd, NI_OPTS(netif).min_cwnd);
   ts->bytes_acked = 0;
+  ci_tcp_cong_on_rto(netif, ts);
 
   /* Backoff RTO timer and restart. */
   ts->rto <<= 1u;
@@ -613,7 +622,8 @@ void ci_tcp_timeout_rto(ci_netif* netif, ci_tcp_state* ts)
 static void ci_tcp_timeout_taildrop(ci_netif* netif, ci_tcp_state* ts)
 {
 #if CI_CFG_TAIL_DROP_PROBE
-  ci_assert(NI_OPTS(netif).tail_drop_probe);
+  ci_assert(NI_OPTS(netif).tail_drop_probe ||
+            NI_OPTS(netif).tcp_loss_detection == EF_TCP_LOSS_DETECTION_RACK);
   ci_assert(ts->tcpflags & CI_TCPT_FLAG_TAIL_DROP_TIMING);
 
   LOG_TL(log(FNTS_FMT "now=%x srtt=%u+%u "TCP_SND_FMT,
@@ -641,11 +651,12 @@ static void ci_tcp_timeout_taildrop(ci_netif* netif, ci_tcp_state* ts)
 
   /* If we have new data to send, and window, send that. */
   if( ts->send.num > 0 ) {
-    const ci_ip_pkt_fmt* pkt = PKT_CHK(netif, ts->send.head);
-    if( SEQ_LE(pkt->pf.tcp_tx.end_seq, ts->snd_max) ) {
+    unsigned end_seq = ci_tcp_sendq_head_end_seq(netif, ts);
+    if( SEQ_LE(end_seq, ts->snd_max) ) {
       ci_uint32 cntr;
-      ci_tcp_tx_advance_to(netif, ts, pkt->pf.tcp_tx.end_seq, &cntr);
+      ci_tcp_tx_advance_to(netif, ts, end_seq, &cntr);
       CITP_STATS_NETIF(++netif->state->stats.tail_drop_probe_sendq);
+      ++ts->stats.tlp_probes;
       return;
     }
   }
@@ -664,6 +675,7 @@ static void ci_tcp_timeout_taildrop(ci_netif* netif, ci_tcp_state* ts)
   ts->taildrop_mark = ts->snd_nxt;
   ts->tcpflags |= CI_TCPT_FLAG_TAIL_DROP_MARKED;
   CITP_STATS_NETIF(++netif->state->stats.tail_drop_probe_retrans);
+  ++ts->stats.tlp_probes;
 #endif
 }
 
@@ -324,6 +324,20 @@ ci_inline int ci_tcp_tx_opt_sack_perm(ci_uint8** opt)
   return 2;
 }
 
+/*
+** Fill out the Fast Open option (RFC 7413) on a given packet; an empty
+** option requests a cookie
+*/
+ci_inline int ci_tcp_tx_opt_fastopen(ci_uint8** opt, const ci_uint8* cookie,
+                                     int cookie_len)
+{
+  (*opt)[0] = CI_TCP_OPT_FASTOPEN;
+  (*opt)[1] = 2 + cookie_len;
+  memcpy(*opt + 2, cookie, cookie_len);
+  *opt += 2 + cookie_len;
+  return 2 + cookie_len;
+}
+
 
 ci_inline bool rob_is_empty(ci_netif* netif, ci_tcp_state* ts)
 {
@@ -581,6 +595,11 @@ void ci_tcp_tx_change_mss(ci_netif* ni, ci_tcp_state* ts)
   int prev_eff_mss = tcp_eff_mss(ts);
   ci_assert(ci_netif_is_locked(ni));
 
+  /* Super-segments were filled at the old MSS; split them now so that the
+   * over-length segments are dealt with like any other. */
+  if( NI_OPTS(ni).tcp_gso )
+    ci_tcp_sendq_gso_segment_all(ni, ts);
+
   ci_tcp_set_eff_mss(ni, ts);
 
   LOG_TL(ci_log(LNTS_FMT "%s: before=%d after=%d", LNTS_PRI_ARGS(ni, ts),
@@ -603,9 +622,12 @@ void ci_tcp_tx_change_mss(ci_netif* ni, ci_tcp_state* ts)
 }
 
 
+/* [tfo_cookie] is sent in a Fast Open option if [optflags] has
+ * CI_TCPT_FLAG_FASTOPEN. */
 static int ci_tcp_tx_insert_syn_options(ci_netif* ni, ci_uint16 amss,
                                         unsigned optflags, unsigned rcv_wscl,
-                                        ci_uint8** opt)
+                                        const ci_uint8* tfo_cookie,
+                                        int tfo_cookie_len, ci_uint8** opt)
 {
   int optlen = 0;
 
@@ -629,6 +651,11 @@ static int ci_tcp_tx_insert_syn_options(ci_netif* ni, ci_uint16 amss,
   }
 #endif
 
+  /* Fast Open (RFC7413), if it fits alongside a timestamp option. */
+  if( (optflags & CI_TCPT_FLAG_FASTOPEN) &&
+      optlen + 2 + tfo_cookie_len <= CI_TCP_MAX_OPTS_LEN - 12 )
+    optlen += ci_tcp_tx_opt_fastopen(opt, tfo_cookie, tfo_cookie_len);
+
   /* Pad to dword boundary. */
   while( optlen & 3 ) {
     *(*opt)++ = CI_TCP_OPT_END;
@@ -639,16 +666,17 @@ static int ci_tcp_tx_insert_syn_options(ci_netif* ni, ci_uint16 amss,
 }
 
 
-/*
-** called to enqueue a packet with no data (i.e. SYN/FIN) the segment
-** is placed on the TX queue and so is reliably transmitted
-*/
-void ci_tcp_enqueue_no_data(ci_tcp_state* ts, ci_netif* netif,
-                            ci_ip_pkt_fmt* pkt)
+/* Enqueue a SYN or FIN.  A SYN may carry up to one segment of data
+ * from [iov] (Fast Open); returns the number of bytes of data enqueued.
+ */
+static int ci_tcp_enqueue_ctl(ci_tcp_state* ts, ci_netif* netif,
+                              ci_ip_pkt_fmt* pkt, const ci_iovec* iov,
+                              int iovlen)
 {
   ci_tcp_hdr* thdr;
   int af = ipcache_af(&ts->s.pkt);
   int optlen = tcp_ipx_outgoing_opts_len(af, ts);
+  int n = 0;
 
   ci_assert(ts);
   ci_assert(netif);
@@ -665,9 +693,17 @@ void ci_tcp_enqueue_no_data(ci_tcp_state* ts, ci_netif* netif,
   thdr = PKT_IPX_TCP_HDR(af, pkt);
   if( TS_IPX_TCP(ts)->tcp_flags & CI_TCP_FLAG_SYN ) {
     ci_uint8* opt = CI_TCP_HDR_OPTS(thdr);
+    ci_uint8 cookie[CI_TCP_FASTOPEN_COOKIE_MAX];
+    int cookie_len = 0;
+
+    if( (ts->tcpflags & CI_TCPT_FLAG_FASTOPEN) &&
+        ~TS_IPX_TCP(ts)->tcp_flags & CI_TCP_FLAG_ACK )
+      cookie_len = ci_tcp_fastopen_cache_get(netif, tcp_ipx_raddr(ts),
+                                             cookie);
     opt += optlen;
     optlen += ci_tcp_tx_insert_syn_options(netif, ts->amss,
-                                           ts->tcpflags, ts->rcv_wscl, &opt);
+                                           ts->tcpflags, ts->rcv_wscl,
+                                           cookie, cookie_len, &opt);
 
     /* If we don't get timestamps, we'll need to calculate RTT without
      * them.  Let's prepare: */
@@ -678,25 +714,69 @@ void ci_tcp_enqueue_no_data(ci_tcp_state* ts, ci_netif* netif,
 
   pkt->buf_len = ( oo_tx_ether_hdr_size(pkt) + CI_IPX_HDR_SIZE(af)
                    + sizeof(ci_tcp_hdr) + optlen );
+#ifndef __KERNEL__
+  if( iovlen > 0 ) {
+    /* Keep the SYN within a single default-MSS segment. */
+    int space = tcp_eff_mss(ts) - optlen + tcp_ipx_outgoing_opts_len(af, ts);
+    ci_uint8* p = (ci_uint8*) PKT_START(pkt) + pkt->buf_len;
+    int i;
+    for( i = 0; i < iovlen && n < space; ++i ) {
+      int len = CI_MIN((int) CI_IOVEC_LEN(&iov[i]), space - n);
+      memcpy(p + n, CI_IOVEC_BASE(&iov[i]), len);
+      n += len;
+    }
+    pkt->buf_len += n;
+  }
+#endif
   pkt->pay_len = pkt->buf_len;
   oo_offbuf_init(&pkt->buf, PKT_START(pkt) + pkt->buf_len, 0);
   pkt->flags &= CI_PKT_FLAG_NONB_POOL;
   ASSERT_VALID_PKT(netif, pkt);
 
   pkt->pf.tcp_tx.start_seq = tcp_enq_nxt(ts);
-  tcp_enq_nxt(ts) += 1;
+  tcp_enq_nxt(ts) += 1 + n;
   pkt->pf.tcp_tx.end_seq = tcp_enq_nxt(ts);
   pkt->pf.tcp_tx.block_end = OO_PP_NULL;
 
   ci_ip_queue_enqueue(netif, &ts->send, pkt);
   ++ts->send_in;
 
-  LOG_TC(log(LNTS_FMT "enqueue ["CI_TCP_FLAGS_FMT"] seq=%x",
+  LOG_TC(log(LNTS_FMT "enqueue ["CI_TCP_FLAGS_FMT"] seq=%x len=%d",
              LNTS_PRI_ARGS(netif, ts),
              CI_TCP_HDR_FLAGS_PRI_ARG(TX_PKT_IPX_TCP(af, pkt)),
-             tcp_enq_nxt(ts) - 1));
+             pkt->pf.tcp_tx.start_seq, n));
+
+  if( n > 0 ) {
+    /* Data in the SYN may go beyond the peer's (as yet unknown) window. */
+    ts->snd_max = tcp_enq_nxt(ts);
+    ts->tcpflags |= CI_TCPT_FLAG_FASTOPEN_DATA;
+    CITP_STATS_NETIF_INC(netif, tcp_fastopen_active);
+  }
 
   ci_tcp_tx_advance(ts, netif);
+  return n;
+}
+
+
+/*
+** called to enqueue a packet with no data (i.e. SYN/FIN) the segment
+** is placed on the TX queue and so is reliably transmitted
+*/
+void ci_tcp_enqueue_no_data(ci_tcp_state* ts, ci_netif* netif,
+                            ci_ip_pkt_fmt* pkt)
+{
+  ci_tcp_enqueue_ctl(ts, netif, pkt, NULL, 0);
+}
+
+
+/* Enqueue the SYN of a Fast Open connection carrying data from [iov]. */
+int ci_tcp_enqueue_syn_data(ci_tcp_state* ts, ci_netif* netif,
+                            ci_ip_pkt_fmt* pkt, const ci_iovec* iov,
+                            int iovlen)
+{
+  ci_assert(ts->tcpflags & CI_TCPT_FLAG_FASTOPEN);
+  ci_assert(TS_IPX_TCP(ts)->tcp_flags & CI_TCP_FLAG_SYN);
+  return ci_tcp_enqueue_ctl(ts, netif, pkt, iov, iovlen);
 }
 
 /* Rewrite the first SYN packet as a SYNACK for simultaneous open */
@@ -733,13 +813,20 @@ int ci_tcp_send_sim_synack(ci_netif* netif, ci_tcp_state *ts)
     return 0;
   }
 
+  /* Rewriting would lose the data carried by a Fast Open SYN; let the
+   * peer's SYN-ACK complete the handshake instead.
+   */
+  if( ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA )
+    return 0;
+
   /* fill out options */
   opt = CI_TCP_HDR_OPTS(tcp);
   if( ts->tcpflags & CI_TCPT_FLAG_TSO )
     optlen += ci_tcp_tx_opt_tso(&opt, ci_tcp_time_now(netif), 0);
 
   optlen += ci_tcp_tx_insert_syn_options(netif, ts->amss,
-                                         ts->tcpflags, ts->rcv_wscl, &opt);
+                                         ts->tcpflags & ~CI_TCPT_FLAG_FASTOPEN,
+                                         ts->rcv_wscl, NULL, 0, &opt);
 
   CI_TCP_HDR_SET_LEN(tcp, sizeof(*tcp) + optlen);
   tcp->tcp_flags |= CI_TCP_FLAG_ACK;
@@ -797,6 +884,11 @@ int ci_tcp_synrecv_send(ci_netif* netif, ci_tcp_socket_listen* tls,
     ci_assert_equal(ipcache->dport_be16, tsr->r_port);
   }
 
+  /* ECN-setup SYN-ACK (RFC 3168 section 6.1.1) */
+  if( (tcp_flags & CI_TCP_FLAG_SYN) &&
+      (tsr->tcpopts.flags & CI_TCPT_FLAG_ECN) )
+    tcp_flags |= CI_TCP_FLAG_ECE;
+
   LOG_TC(log(LNT_FMT "SYNRECV ["CI_TCP_FLAGS_FMT"] isn=%08x "
              "rcv=%08x-%08x", LNT_PRI_ARGS(netif, tls),
              CI_TCP_FLAGS_PRI_ARG(tcp_flags),
@@ -875,10 +967,14 @@ int ci_tcp_synrecv_send(ci_netif* netif, ci_tcp_socket_listen* tls,
       (ipcache->status == retrrc_success ||
        ipcache->status == retrrc_nomac ||
        OO_SP_NOT_NULL(tsr->local_peer)) ) {
+    ci_uint8 cookie[CI_TCP_FASTOPEN_COOKIE_LEN];
+    if( tsr->tcpopts.flags & CI_TCPT_FLAG_FASTOPEN )
+      ci_tcp_fastopen_cookie(netif, tsr->r_addr, cookie);
     tsr->amss = ci_tcp_amss(netif, &tls->c, ipcache, __func__);
     optlen += ci_tcp_tx_insert_syn_options(netif, tsr->amss,
                                            tsr->tcpopts.flags,
-                                           tsr->rcv_wscl, &opt);
+                                           tsr->rcv_wscl, cookie,
+                                           CI_TCP_FASTOPEN_COOKIE_LEN, &opt);
     pkt->pf.tcp_tx.sock_id = OO_SP_NULL;
   }
   /* NB. If [ipcache->status] has some other value, then packet won't be
@@ -913,6 +1009,39 @@ int ci_tcp_synrecv_send(ci_netif* netif, ci_tcp_socket_listen* tls,
 }
 
 
+/* Turn a Fast Open SYN whose data the peer did not accept into a plain
+ * data segment, so that it can be retransmitted once established. */
+static void ci_tcp_tx_fastopen_strip_syn(ci_netif* netif, ci_tcp_state* ts,
+                                         ci_ip_pkt_fmt* pkt)
+{
+  int af = ipcache_af(&ts->s.pkt);
+  ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
+  ci_uint8* data;
+  int paylen, shrink;
+
+  ts->tcpflags &= ~CI_TCPT_FLAG_FASTOPEN_DATA;
+  if( ~tcp->tcp_flags & CI_TCP_FLAG_SYN )
+    return;
+
+  paylen = SEQ_SUB(pkt->pf.tcp_tx.end_seq, pkt->pf.tcp_tx.start_seq) - 1;
+  data = CI_TCP_HDR_OPTS(tcp) + tcp_ipx_outgoing_opts_len(af, ts);
+  shrink = (ci_uint8*) CI_TCP_PAYLOAD(tcp) - data;
+  ci_assert_ge(shrink, 0);
+  memmove(data, CI_TCP_PAYLOAD(tcp), paylen);
+  CI_TCP_HDR_SET_LEN(tcp, sizeof(*tcp) + tcp_ipx_outgoing_opts_len(af, ts));
+  /* ECE and CWR in a SYN negotiate ECN, and a data segment needs ACK */
+  tcp->tcp_flags = (tcp->tcp_flags & ~(CI_TCP_FLAG_SYN | CI_TCP_FLAG_ECE |
+                                       CI_TCP_FLAG_CWR)) | CI_TCP_FLAG_ACK;
+  pkt->buf_len -= shrink;
+  pkt->pay_len -= shrink;
+  oo_offbuf_init(&pkt->buf, data + paylen, 0);
+  pkt->pf.tcp_tx.start_seq += 1;
+
+  LOG_TC(log(LNTS_FMT "Fast Open data not accepted, resend %d bytes",
+             LNTS_PRI_ARGS(netif, ts), paylen));
+}
+
+
 /* Retransmit the indicated packet, returns 0 on success, 1 if packet
    tx in progress */
 int ci_tcp_retrans_one(ci_tcp_state* ts, ci_netif* netif, ci_ip_pkt_fmt* pkt)
@@ -926,6 +1055,10 @@ int ci_tcp_retrans_one(ci_tcp_state* ts, ci_netif* netif, ci_ip_pkt_fmt* pkt)
   /* Return code 1 means packet in progress */
   if( pkt->flags & CI_PKT_FLAG_TX_PENDING )  return 1;
 
+  if( (ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA) &&
+      (ts->s.b.state & CI_TCP_STATE_SYNCHRONISED) )
+    ci_tcp_tx_fastopen_strip_syn(netif, ts, pkt);
+
   /* If we're going to reset any connection that has to retransmit,
    * just pretend here that we've sent it, and then it will either (i)
    * sort itself out due to a delay or reordering in the network; or
@@ -957,6 +1090,8 @@ int ci_tcp_retrans_one(ci_tcp_state* ts, ci_netif* netif, ci_ip_pkt_fmt* pkt)
 
   /* place TCP options, ECN, and take RTT on outgoing packet */
   ci_tcp_tx_finish(netif, ts, pkt);
+  if( ci_tcp_tx_ecn_enabled(ts) )
+    ci_tcp_tx_ecn(ts, pkt, 1);
 
   /* set the urgent pointer */
   ci_tcp_tx_set_urg_ptr(ts, netif, tcp);
@@ -994,6 +1129,7 @@ int ci_tcp_retrans_one(ci_tcp_state* ts, ci_netif* netif, ci_ip_pkt_fmt* pkt)
     pkt->pf.tcp_tx.first_tx_hw_stamp = pkt->hw_stamp;
 #endif
   pkt->flags |= CI_PKT_FLAG_RTQ_RETRANS;
+  ci_frc64(&pkt->tstamp_frc);
   ci_tcp_tx_maybe_do_striping(pkt, ts);
   __ci_ip_send_tcp(netif, pkt, ts);
   CI_TCP_STATS_INC_OUT_SEGS(netif);
@@ -1029,7 +1165,7 @@ int ci_tcp_unsacked_segments_in_flight(ci_netif* ni, ci_tcp_state* ts)
   while( OO_PP_NOT_NULL(pp) ) {
     pkt = PKT_CHK(ni, pp);
     if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED )
-      pkt = PKT_CHK(ni, pkt->pf.tcp_tx.block_end);
+      pkt = ci_tcp_rtq_block_end(ni, pkt);
     else
       ++unsacked;
     pp = pkt->next;
@@ -1073,7 +1209,7 @@ int ci_tcp_retrans(ci_netif* ni, ci_tcp_state* ts, int seq_limit,
   while( 1 ) {
     /* Skip SACKed packets. */
     if( pkt->flags & CI_PKT_FLAG_RTQ_SACKED ) {
-      pkt = PKT_CHK(ni, pkt->pf.tcp_tx.block_end);
+      pkt = ci_tcp_rtq_block_end(ni, pkt);
       ts->retrans_ptr = pkt->next;
       if( OO_PP_IS_NULL(ts->retrans_ptr) )  break;
       pkt = PKT_CHK(ni, ts->retrans_ptr);
@@ -1291,10 +1427,73 @@ static void ci_tcp_tx_advance_too_long(ci_netif* ni, ci_tcp_state* ts,
 }
 
 
+/* Software pacing: returns the number of bytes that may be sent now, given
+ * the credit accumulated since [pace_next].  Credit is capped at one timer
+ * tick, so that an idle connection does not burst.
+ *
+ * Sending only moves [pace_next] past the clock by the time one segment
+ * takes at the pacing rate.  If it is further ahead than that, it was
+ * left behind by a connection idle for so long that the 32-bit usec clock
+ * has wrapped past it, and it earns a tick of credit like any other stale
+ * deadline.  A connection with nothing in flight restarts from now.
+ */
+static ci_uint32 ci_tcp_tx_pace_budget(ci_netif* ni, ci_tcp_state* ts,
+                                       ci_uint32 now_us, int idle)
+{
+  ci_uint32 tick_us = 1u << (IPTIMER_STATE(ni)->ci_ip_time_frc2tick -
+                             IPTIMER_STATE(ni)->ci_ip_time_frc2us);
+  ci_uint32 ahead_us = ts->pace_next - now_us;
+  ci_uint64 wait_max_us, budget;
+  ci_uint32 credit_us;
+
+  if( (ci_int32) ahead_us > 0 ) {
+    wait_max_us = (((ci_uint64) tcp_eff_mss(ts) + 1) << CI_TCP_PACE_SHIFT) /
+                  ts->pace_rate + tick_us;
+    if( ahead_us <= wait_max_us )
+      return 0;
+    ts->pace_next = now_us - tick_us;
+  }
+  else if( idle ) {
+    ts->pace_next = now_us;
+  }
+  else if( now_us - ts->pace_next > tick_us ) {
+    ts->pace_next = now_us - tick_us;
+  }
+  credit_us = now_us - ts->pace_next;
+  budget = ((ci_uint64) credit_us * ts->pace_rate) >> CI_TCP_PACE_SHIFT;
+  /* Always allow at least one segment once the deadline has passed. */
+  return (ci_uint32) CI_MIN(CI_MAX(budget, (ci_uint64) tcp_eff_mss(ts) + 1),
+                            0x7fffffffull);
+}
+
+
+/* Charge the bytes just sent against the pacing budget, and arm the pacing
+ * timer if there is more to send. */
+static void ci_tcp_tx_pace_charge(ci_netif* ni, ci_tcp_state* ts,
+                                  ci_uint32 sent, ci_uint32 now_us,
+                                  int pace_limited)
+{
+  ci_uint32 frc2us_shift = IPTIMER_STATE(ni)->ci_ip_time_frc2tick -
+                           IPTIMER_STATE(ni)->ci_ip_time_frc2us;
+  ci_int32 wait_us;
+
+  ts->pace_next += (ci_uint32) (((ci_uint64) sent << CI_TCP_PACE_SHIFT) /
+                                ts->pace_rate);
+  if( ! pace_limited || ci_ip_queue_is_empty(&ts->send) ||
+      ci_ip_timer_pending(ni, &ts->pace_tid) )
+    return;
+  wait_us = (ci_int32) (ts->pace_next - now_us);
+  ci_ip_timer_set(ni, &ts->pace_tid, ci_tcp_time_now(ni) +
+                  (CI_MAX(wait_us, 0) >> frc2us_shift) + 1);
+}
+
+
 void ci_tcp_tx_advance(ci_tcp_state* ts, ci_netif* ni)
 {
   unsigned cwnd_right_edge, right_edge;
   ci_uint32* p_stop_cntr;
+  ci_uint32 now_us = 0, snd_nxt = 0;
+  int pace = 0, pace_limited = 0, idle;
 
   ci_assert(ci_netif_is_locked(ni));
   ci_assert(ci_ip_queue_not_empty(&ts->send));
@@ -1306,6 +1505,11 @@ void ci_tcp_tx_advance(ci_tcp_state* ts, ci_netif* ni)
   if( CI_UNLIKELY(ts->tcpflags & CI_TCPT_FLAG_NO_TX_ADVANCE) )
     return;
 
+  ts->tcpflags &= ~CI_TCPT_FLAG_AUTOCORK;
+
+  idle = ts->snd_una == ts->snd_nxt;
+  if( idle )
+    ci_tcp_cong_on_idle(ni, ts);
   ci_tcp_tx_cwv_idle(ni, ts);
 
   if( OO_SP_NOT_NULL(ts->local_peer) ) {
@@ -1348,7 +1552,25 @@ void ci_tcp_tx_advance(ci_tcp_state* ts, ci_netif* ni)
   }
 #endif
 
+  if( ts->pace_rate != 0 && OO_SP_IS_NULL(ts->local_peer) &&
+      ! (ts->tcpflags & CI_TCPT_FLAG_MSG_WARM) ) {
+    unsigned pace_right_edge;
+    ci_ip_time_get_us(IPTIMER_STATE(ni), &now_us);
+    snd_nxt = tcp_snd_nxt(ts);
+    pace_right_edge = snd_nxt + ci_tcp_tx_pace_budget(ni, ts, now_us, idle);
+    pace = 1;
+    if( SEQ_LT(pace_right_edge, right_edge) ) {
+      p_stop_cntr = &ts->stats.tx_stop_pace;
+      right_edge = pace_right_edge;
+      pace_limited = 1;
+    }
+  }
+
   ci_tcp_tx_advance_to(ni, ts, right_edge, p_stop_cntr);
+
+  if( pace )
+    ci_tcp_tx_pace_charge(ni, ts, SEQ_SUB(tcp_snd_nxt(ts), snd_nxt), now_us,
+                          pace_limited);
 }
 
 
@@ -1360,11 +1582,16 @@ void ci_tcp_tx_advance_to(ci_netif* ni, ci_tcp_state* ts,
   oo_pkt_p id = sendq->head;
   int sent_num = 0;
   int af = ipcache_af(&ts->s.pkt);
+  ci_uint64 now_frc = 0;
 
   while( 1 ) {
     ci_ip_pkt_fmt* pkt = PKT_CHK(ni, id);
     ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
 
+    if(CI_UNLIKELY( NI_OPTS(ni).tcp_gso && ci_tcp_tx_pkt_is_gso(af, pkt) ))
+      /* Super-segment: build the headers of the segments it holds. */
+      ci_tcp_tx_gso_segment(ni, ts, pkt);
+
     if(CI_UNLIKELY( PKT_TCP_TX_SEQ_SPACE(pkt) > tcp_eff_mss(ts) ))
       /* Likely MSS has changed (or FIN added to MSS segment).  If we're
        * unable to split then we go ahead and push out the over-length
@@ -1415,6 +1642,8 @@ void ci_tcp_tx_advance_to(ci_netif* ni, ci_tcp_state* ts,
 
     /* place TCP options into outgoing packet */
     ci_tcp_tx_finish(ni, ts, pkt);
+    if( ci_tcp_tx_ecn_enabled(ts) )
+      ci_tcp_tx_ecn(ts, pkt, 0);
 
     /* Finish-off the IP header.  We increment the ID field for payload
      * segments because some old versions of Linux GRO require incrementing
@@ -1447,6 +1676,12 @@ void ci_tcp_tx_advance_to(ci_netif* ni, ci_tcp_state* ts,
     CI_TCP_STATS_INC_OUT_SEGS(ni);
     last_pkt = pkt;
 
+    /* Transmit timestamp, used for RTT measurement.  The field is otherwise
+     * unused on the TCP transmit path. */
+    if( now_frc == 0 )
+      ci_frc64(&now_frc);
+    pkt->tstamp_frc = now_frc;
+
     /* Prep the packet for the retransmit queue. */
     ci_assert( ! (pkt->flags & CI_PKT_FLAG_TX_PENDING));
     ci_assert_equal(pkt->flags & ~CI_PKT_FLAG_TX_MASK_ALLOWED, 0);
@@ -1521,8 +1756,10 @@ void ci_tcp_tx_advance_to(ci_netif* ni, ci_tcp_state* ts,
     ci_ip_queue_move(ni, sendq, &ts->retrans, last_pkt, sent_num);
     ts->send_out += sent_num;
 
-    /* Wake up TX if necessary */
-    if( NI_OPTS(ni).tcp_sndbuf_mode == 0 &&
+    /* Wake up TX if necessary.  Sending may have brought the unsent
+     * backlog below TCP_NOTSENT_LOWAT whatever the sndbuf mode.
+     */
+    if( (NI_OPTS(ni).tcp_sndbuf_mode == 0 || ts->c.notsent_lowat != 0) &&
         ci_tcp_tx_advertise_space(ni, ts) )
       ci_tcp_wake_possibly_not_in_poll(ni, ts, CI_SB_FLAG_WAKE_TX);
 
@@ -2009,6 +2246,8 @@ void ci_tcp_send_ack_rx(ci_netif* netif, ci_tcp_state* ts, ci_ip_pkt_fmt* pkt,
   }
 
   tcp->tcp_flags = CI_TCP_FLAG_ACK;
+  if( ts->tcpflags & CI_TCPT_FLAG_ECN_ECE )
+    tcp->tcp_flags |= CI_TCP_FLAG_ECE;
   /* SACK option may change pre-computed header length. */
   CI_TCP_HDR_SET_LEN(tcp, sizeof(ci_tcp_hdr) + optlen);
 
@@ -65,6 +65,42 @@ ci_inline void ci_tcp_tx_finish(ci_netif* netif, ci_tcp_state* ts,
 }
 
 
+/* Set the ECN marks (RFC 3168) on a segment of a connection that has
+** negotiated ECN.  Retransmissions are not ECN-capable and don't carry
+** CWR (section 6.1.5).
+*/
+ci_inline void ci_tcp_tx_ecn(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt,
+                             int retrans)
+{
+  int af = ipcache_af(&ts->s.pkt);
+  ci_tcp_hdr* tcp = TX_PKT_IPX_TCP(af, pkt);
+  ci_uint8 flags = tcp->tcp_flags & ~(CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR);
+
+  ci_assert(ts->tcpflags & CI_TCPT_FLAG_ECN);
+
+  /* The SYN-ACK of an accepted Fast Open connection is sent from a
+   * synchronised socket: leave its ECE alone and keep it not-ECT.
+   */
+  if( tcp->tcp_flags & CI_TCP_FLAG_SYN )
+    return;
+  if( ts->tcpflags & CI_TCPT_FLAG_ECN_ECE )
+    flags |= CI_TCP_FLAG_ECE;
+  if( ! retrans && (ts->tcpflags & CI_TCPT_FLAG_ECN_CWR) ) {
+    flags |= CI_TCP_FLAG_CWR;
+    ts->tcpflags &=~ CI_TCPT_FLAG_ECN_CWR;
+  }
+  tcp->tcp_flags = flags;
+  ipx_hdr_set_ecn(af, oo_tx_ipx_hdr(af, pkt),
+                  retrans ? CI_IP_ECN_NOT_ECT : CI_IP_ECN_ECT0);
+}
+
+ci_inline int ci_tcp_tx_ecn_enabled(const ci_tcp_state* ts)
+{
+  return (ts->tcpflags & CI_TCPT_FLAG_ECN) &&
+         (ts->s.b.state & CI_TCP_STATE_SYNCHRONISED);
+}
+
+
 ci_inline void ci_tcp_ip_hdr_init(ci_ip4_hdr* ip, unsigned len)
 {
   ci_assert_equal(CI_IP4_IHL(ip), sizeof(ci_ip4_hdr));
@@ -269,6 +269,7 @@ static ci_ip_pkt_fmt* ci_tcp_tx_allocate_pkt(ci_netif* ni, ci_tcp_state* ts,
   ** for [next] if necessary.
   */
   next->flags = pkt->flags;
+  next->tstamp_frc = pkt->tstamp_frc;
 
   return next;
 }
@@ -42,6 +42,8 @@ static void ci_udp_hdrs_init(ci_ip_cached_hdrs* ipcache)
 ** There are no IP options, no destination addresses, no ports */
 static void ci_udp_state_init(ci_netif* netif, ci_udp_state* us)
 {
+  oo_p sp;
+
   ci_sock_cmn_init(netif, &us->s, 1);
 
   /* IP_MULTICAST_LOOP is 1 by default, so we should not send multicast
@@ -93,6 +95,21 @@ static void ci_udp_state_init(ci_netif* netif, ci_udp_state* us)
   us->tx_count = 0;
   us->udpflags = CI_UDPF_MCAST_LOOP;
   us->future_intf_i = 0;
+  us->tx_gso_size = 0;
+  us->txtime_clockid = 0;
+  us->txtime_flags = 0;
+  us->txtime_head = OO_PP_NULL;
+  us->txtime_tail = OO_PP_NULL;
+  us->txtime_tid.fn = CI_IP_TIMER_UDP_TXTIME;
+  sp = oo_sockp_to_statep(netif, S_SP(us));
+  OO_P_ADD(sp, CI_MEMBER_OFFSET(ci_udp_state, txtime_tid));
+  ci_ip_timer_init(netif, &us->txtime_tid, sp, "txtm");
+  us->dest_cache = OO_P_NULL;
+  us->arb_seq_offset = 0;
+  us->arb_seq_len = 0;
+  us->arb_flags = 0;
+  us->arb_last = 0;
+  us->arb_window = 0;
   us->ip_pktinfo_cache.intf_i = -1;
   us->stamp = 0;
   memset(&us->stats, 0, sizeof(us->stats));
@@ -269,6 +286,13 @@ void ci_udp_state_dump(ci_netif* ni, ci_udp_state* us, const char* pf,
          percent(uss.n_rx_overflow, rx_total),
          uss.n_rx_mem_drop, uss.n_rx_eagain, uss.n_rx_pktinfo, 
          uss.max_recvq_pkts);
+  if( us->arb_seq_len != 0 )
+    logger(log_arg, "%s  rcv: ARB seq_off=%u seq_len=%u%s last=%"CI_PRIu64" dup=%u "
+           "late=%u gap=%u old=%u reset=%u", pf, us->arb_seq_offset,
+           us->arb_seq_len,
+           (us->arb_flags & CI_UDP_ARB_LITTLE_ENDIAN) ? " le" : "",
+           us->arb_last, uss.n_rx_arb_dup, uss.n_rx_arb_late,
+           uss.n_rx_arb_gap, uss.n_rx_arb_old, uss.n_rx_arb_reset);
   logger(log_arg, "%s  rcv: os=%u(%u%%) os_slow=%u os_error=%u", pf,
          rx_os, percent(rx_os, rx_total), uss.n_rx_os_slow, uss.n_rx_os_error);
 
@@ -301,6 +325,12 @@ void ci_udp_state_dump(ci_netif* ni, ci_udp_state* us, const char* pf,
          percent(uss.n_tx_cp_uc_lookup + uss.n_tx_cp_a_lookup,
                  uss.n_tx_onload_uc),
          OOFA_IPCACHE_STATE(ni, ipcache));
+  if( NI_OPTS(ni).udp_send_dest_cache )
+    logger(log_arg, "%s  snd: TO dest_cache n=%u hit=%u(%u%%)", pf,
+           OO_P_IS_NULL(us->dest_cache) ? 0 :
+           ci_ni_aux_p2udp_dest_table(ni, us->dest_cache)->n,
+           uss.n_tx_cp_dest_hit,
+           percent(uss.n_tx_cp_dest_hit, uss.n_tx_onload_uc));
   logger(log_arg, "%s  snd: TO "OOF_IPCACHE_DETAIL, pf,
          OOFA_IPCACHE_DETAIL(ipcache));
   logger(log_arg, "%s  snd: TO "OOF_IPXPORT" => "OOF_IPXPORT, pf,
@@ -323,6 +353,11 @@ void ci_udp_state_dump(ci_netif* ni, ci_udp_state* us, const char* pf,
          "%s  snd: os_slow=%d os_late=%d unconnect_late=%d nomac=%u(%u%%)", pf,
          uss.n_tx_os_slow, uss.n_tx_os_late, uss.n_tx_unconnect_late,
          uss.n_tx_cp_no_mac, percent(uss.n_tx_cp_no_mac, tx_total));
+  if( us->udpflags & CI_UDPF_TXTIME )
+    logger(log_arg, "%s  snd: TXTIME clock=%d flags=%x early=%u late=%u "
+           "drop=%u", pf, us->txtime_clockid, us->txtime_flags,
+           uss.n_tx_txtime_early, uss.n_tx_txtime_late,
+           uss.n_tx_txtime_drop);
 }
 
 #endif
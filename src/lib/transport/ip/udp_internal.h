@@ -43,8 +43,9 @@ ci_inline int ci_udp_rx_deliver_to_future(ci_sock_cmn* s, void* opaque_arg)
   struct ci_udp_rx_future* future = opaque_arg;
   ci_udp_state* us = SOCK_TO_UDP(s);
 
+  /* Feed arbitration needs the payload, which may not have arrived. */
   if( ci_udp_recv_q_pkts(&us->recv_q) >= us->stats.max_recvq_pkts ||
-      future->socket != NULL ) {
+      future->socket != NULL || us->arb_seq_len != 0 ) {
     future->socket = NULL;
     return 1;
   }
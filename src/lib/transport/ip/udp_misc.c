@@ -25,6 +25,10 @@ void ci_udp_state_free(ci_netif* ni, ci_udp_state* us)
   ci_assert(ci_netif_is_locked(ni));
   ci_assert(us->s.b.state == CI_TCP_STATE_UDP);
   OO_P_DLLINK_ASSERT_EMPTY_SB(ni, &us->s.b, &us->s.b.post_poll_link);
+  ci_assert(OO_PP_IS_NULL(us->txtime_head));
+  ci_assert(! ci_ip_timer_pending(ni, &us->txtime_tid));
+
+  ci_udp_dest_cache_flush(ni, us);
 
 #if CI_CFG_TIMESTAMPING
   ci_udp_recv_q_drop(ni, &us->timestamp_q);
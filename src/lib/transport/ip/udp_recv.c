@@ -77,6 +77,9 @@ typedef struct {
 #if HAVE_MSG_FLAGS
   int msg_flags;
 #endif
+#ifndef __KERNEL__
+  int batch;       /* recvmmsg(): prefetch the next datagram */
+#endif
 } ci_udp_recv_info;
 
 
@@ -234,6 +237,131 @@ static void ci_udp_filter_kernel_pkt(ci_netif* ni, ci_udp_state* us,
 #endif /* __KERNEL__ */
 
 
+#ifndef __KERNEL__
+/* Returns true if [pkt] and [next] belong to the same UDP flow, so that
+ * UDP_GRO may return them from a single receive call.
+ */
+static int ci_udp_gro_same_flow(ci_netif* ni, const ci_ip_pkt_fmt* pkt,
+                                const ci_ip_pkt_fmt* next)
+{
+  const ci_udp_hdr* udp_pkt;
+  const ci_udp_hdr* udp_next;
+  ci_addr_t saddr_pkt, saddr_next, daddr_pkt, daddr_next;
+  int af = oo_pkt_af(pkt);
+
+  if( (pkt->flags | next->flags) & CI_PKT_FLAG_INDIRECT )
+    return 0;
+  if( oo_pkt_af(next) != af )
+    return 0;
+  udp_pkt = oo_ipx_data(af, (ci_ip_pkt_fmt*)pkt);
+  udp_next = oo_ipx_data(af, (ci_ip_pkt_fmt*)next);
+  if( udp_pkt->udp_source_be16 != udp_next->udp_source_be16 ||
+      udp_pkt->udp_dest_be16 != udp_next->udp_dest_be16 )
+    return 0;
+  saddr_pkt = RX_PKT_SADDR((ci_ip_pkt_fmt*)pkt);
+  saddr_next = RX_PKT_SADDR((ci_ip_pkt_fmt*)next);
+  daddr_pkt = RX_PKT_DADDR((ci_ip_pkt_fmt*)pkt);
+  daddr_next = RX_PKT_DADDR((ci_ip_pkt_fmt*)next);
+  return CI_IPX_ADDR_EQ(saddr_pkt, saddr_next) &&
+         CI_IPX_ADDR_EQ(daddr_pkt, daddr_next);
+}
+
+
+/* Returns the number of datagrams starting at [pkt] that a UDP_GRO receive
+ * can return together: a run of datagrams from the same flow, each no
+ * larger than the first, that fits in [piov].  Only the final datagram of
+ * the run may be shorter than the first.
+ */
+static int ci_udp_gro_run_len(ci_netif* ni, ci_udp_state* us,
+                              ci_ip_pkt_fmt* pkt, const ci_iovec_ptr* piov)
+{
+  ci_ip_pkt_fmt* first = pkt;
+  int seg_len = pkt->pf.udp.pay_len;
+  int space = CI_MIN(ci_iovec_ptr_bytes_count(piov), 0xffff);
+  int avail = ci_udp_recv_q_pkts(&us->recv_q) - pkt->n_buffers;
+  int total = seg_len;
+  int n = 1;
+
+  if( seg_len == 0 || seg_len > space || (pkt->flags & CI_PKT_FLAG_INDIRECT) )
+    return 1;
+
+  while( n < CI_CFG_UDP_GRO_MAX_SEGS && avail > 0 &&
+         (pkt = ci_udp_recv_q_next(ni, pkt)) != NULL ) {
+    if( pkt->pf.udp.pay_len == 0 || pkt->pf.udp.pay_len > seg_len ||
+        total + pkt->pf.udp.pay_len > space ||
+        ! ci_udp_gro_same_flow(ni, first, pkt) )
+      break;
+    avail -= pkt->n_buffers;
+    total += pkt->pf.udp.pay_len;
+    ++n;
+    if( pkt->pf.udp.pay_len < seg_len )
+      break;
+  }
+  return n;
+}
+
+
+/* Copy the whole payload of [pkt] to [piov], advancing [piov].  The caller
+ * has checked that [piov] has room for it.
+ */
+static int oo_copy_pkt_to_iovec_adv(ci_netif* ni, const ci_ip_pkt_fmt* pkt,
+                                    ci_iovec_ptr* piov)
+{
+  int left = pkt->pf.udp.pay_len;
+  int n;
+
+  while( 1 ) {
+    n = CI_MIN(oo_offbuf_left(&pkt->buf), left);
+    if( n > 0 && ci_copy_to_iovec(piov, oo_offbuf_ptr(&pkt->buf), n) != n )
+      return -EFAULT;
+    left -= n;
+    if( left == 0 || OO_PP_IS_NULL(pkt->frag_next) )
+      break;
+    pkt = PKT_CHK_NNL(ni, pkt->frag_next);
+  }
+  return pkt->pf.udp.pay_len - left;
+}
+
+
+/* UDP_GRO receive: return [n_segs] consecutive datagrams, starting with
+ * [pkt], as one buffer with a UDP_GRO control message giving the size of
+ * the datagrams.  The datagrams stay separate in the receive queue, so
+ * this only changes how they are handed to the application.
+ */
+static int ci_udp_recvmsg_get_gro(ci_udp_recv_info* rinf, ci_iovec_ptr* piov,
+                                  ci_ip_pkt_fmt* pkt, int n_segs)
+{
+  ci_netif* ni = rinf->a->ni;
+  ci_udp_state* us = rinf->a->us;
+  int rc, total = 0, i;
+
+  ci_ip_cmsg_recv(ni, us, pkt, rinf->msg, 0, &rinf->msg_flags,
+                  pkt->pf.udp.pay_len);
+  us->stamp = pkt->tstamp_frc;
+  us->future_intf_i = pkt->intf_i;
+  ci_udp_recvmsg_fill_msghdr(ni, rinf->msg, pkt, &us->s);
+
+  for( i = 0; i < n_segs; ++i ) {
+    if( i > 0 )
+      pkt = ci_udp_recv_q_get(ni, &us->recv_q);
+    ci_assert(pkt);
+    rc = oo_copy_pkt_to_iovec_adv(ni, pkt, piov);
+    if( rc < 0 )
+      return total ? total : rc;
+    total += rc;
+    /* Once [pkt] is delivered the next ci_udp_recv_q_get() can make it
+     * reapable, so it must not be touched after this point. */
+    ci_udp_recv_q_deliver(ni, &us->recv_q, pkt);
+  }
+
+  CITP_STATS_NETIF_INC(ni, udp_rx_gro_recvs);
+  CITP_STATS_NETIF_ADD(ni, udp_rx_gro_segs, n_segs);
+  us->udpflags |= CI_UDPF_LAST_RECV_ON;
+  return total;
+}
+#endif
+
+
 static int ci_udp_recvmsg_get(ci_udp_recv_info* rinf, ci_iovec_ptr* piov)
 {
   ci_netif* ni = rinf->a->ni;
@@ -248,9 +376,26 @@ static int ci_udp_recvmsg_get(ci_udp_recv_info* rinf, ci_iovec_ptr* piov)
     goto recv_q_is_empty;
 
 #ifndef __KERNEL__
+  if( rinf->batch && OO_PP_NOT_NULL(pkt->udp_rx_next) ) {
+    /* Start pulling in the next datagram while this one is copied out. */
+    ci_ip_pkt_fmt* next = PKT_CHK_NNL(ni, pkt->udp_rx_next);
+    ci_prefetch(next);
+    ci_prefetch(next->dma_start);
+  }
+
+  if( CI_UNLIKELY(us->s.cmsg_flags & CI_UDP_CMSG_GRO) && msg != NULL &&
+# if CI_CFG_ZC_RECV_FILTER
+      ! us->recv_q_filter &&
+# endif
+      ! (rinf->flags & MSG_PEEK) ) {
+    int n_segs = ci_udp_gro_run_len(ni, us, pkt, piov);
+    if( n_segs > 1 )
+      return ci_udp_recvmsg_get_gro(rinf, piov, pkt, n_segs);
+  }
+
   if( msg != NULL ) {
     if( CI_UNLIKELY(us->s.cmsg_flags != 0 ) )
-      ci_ip_cmsg_recv(ni, us, pkt, msg, 0, &rinf->msg_flags);
+      ci_ip_cmsg_recv(ni, us, pkt, msg, 0, &rinf->msg_flags, 0);
     else
       msg->msg_controllen = 0;
   }
@@ -656,6 +801,22 @@ ci_udp_recvmsg_socklocked_spin(ci_netif* ni, ci_udp_state* us,
 }
 
 
+ci_inline int ci_udp_recvmsg_needs_slowpath(ci_udp_recv_info* rinf)
+{
+  ci_netif* ni = rinf->a->ni;
+  ci_udp_state* us = rinf->a->us;
+
+  return ((rinf->flags & (MSG_OOB_CHK | MSG_ERRQUEUE_CHK)) |
+          (rinf->msg->msg_iovlen == 0              ) |
+          (rinf->msg->msg_iov == NULL              ) |
+          (ni->state->rxq_low                      ) |
+#if CI_CFG_POSIX_RECV
+          (udp_lport_be16(us) == 0                 ) |
+#endif
+          (us->s.so_error                          ));
+}
+
+
 static int 
 ci_udp_recvmsg_common(ci_udp_recv_info *rinf)
 {
@@ -686,14 +847,7 @@ ci_udp_recvmsg_common(ci_udp_recv_info *rinf)
   rinf->msg_flags = 0;
 #endif
 
-  slow = ((rinf->flags & (MSG_OOB_CHK | MSG_ERRQUEUE_CHK)) |
-	  (rinf->msg->msg_iovlen == 0              ) |
-	  (rinf->msg->msg_iov == NULL              ) |
-	  (ni->state->rxq_low                      ) |
-#if CI_CFG_POSIX_RECV  
-	  (udp_lport_be16(us) == 0                 ) |
-#endif
-	  (us->s.so_error                          ));
+  slow = ci_udp_recvmsg_needs_slowpath(rinf);
   if( slow )
     goto slow_path;
 
@@ -840,6 +994,9 @@ int ci_udp_recvmsg(ci_udp_iomsg_args *a, ci_msghdr* msg, int flags)
   rinf.msg = msg;
   rinf.sock_locked = 0;
   rinf.flags = flags;
+#ifndef __KERNEL__
+  rinf.batch = 0;
+#endif
 
   rc = ci_udp_recvmsg_common(&rinf);
   if( rinf.sock_locked )
@@ -854,13 +1011,54 @@ int ci_udp_recvmsg(ci_udp_iomsg_args *a, ci_msghdr* msg, int flags)
 
 
 #ifndef __KERNEL__
+/* Fill further mmsghdrs straight from the user-level receive queue.  The
+ * socket lock is held throughout, and none of the checks that
+ * ci_udp_recvmsg_common() makes before and after each datagram are
+ * repeated.  Stops at the first message that needs more than that: an
+ * empty queue, a slow-path condition or an error.  The caller handles
+ * those through ci_udp_recvmsg_common().
+ *
+ * Returns the number of messages filled.
+ */
+static int ci_udp_recvmmsg_batch(ci_udp_recv_info* rinf,
+                                 struct mmsghdr* mmsg, unsigned int vlen)
+{
+  ci_netif* ni = rinf->a->ni;
+  ci_udp_state* us = rinf->a->us;
+  ci_iovec_ptr piov;
+  unsigned int i;
+  int rc;
+
+  ci_assert(rinf->sock_locked);
+
+  for( i = 0; i < vlen; ++i ) {
+    rinf->msg = &mmsg[i].msg_hdr;
+    if( ci_udp_recv_q_is_empty(&us->recv_q) ||
+        ci_udp_recvmsg_needs_slowpath(rinf) ||
+        (us->udpflags & CI_UDPF_PEEK_FROM_OS) )
+      break;
+
+    rinf->msg_flags = 0;
+    ci_iovec_ptr_init_nz(&piov, rinf->msg->msg_iov, rinf->msg->msg_iovlen);
+    rc = ci_udp_recvmsg_get(rinf, &piov);
+    if( rc < 0 )
+      break;
+    mmsg[i].msg_len = rc;
+    mmsg[i].msg_hdr.msg_flags = rinf->msg_flags;
+  }
+
+  CITP_STATS_NETIF_ADD(ni, udp_rx_mmsg_batched, i);
+  return i;
+}
+
+
 int ci_udp_recvmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg, 
                     unsigned int vlen, int flags, 
                     const struct timespec* timeout)
 {
   ci_netif* ni = a->ni;
   ci_udp_state* us = a->us;
-  int rc, i;
+  int rc, i, n_batched = 0;
   struct timeval tv_before;
   int timeout_msec = -1;
   ci_udp_recv_info rinf;
@@ -868,6 +1066,7 @@ int ci_udp_recvmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
   rinf.a = a;
   rinf.sock_locked = 0;
   rinf.flags = flags;
+  rinf.batch = 1;
 
   if( timeout ) {
     timeout_msec = timeout->tv_sec * 1000 + timeout->tv_nsec / 1000000;
@@ -903,6 +1102,14 @@ int ci_udp_recvmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
 
     ++i;
 
+    /* Whatever else is already in the receive queue can be had without
+     * going round the full receive path again. */
+    if( i < vlen && rinf.sock_locked && ! (rinf.flags & MSG_PEEK) ) {
+      rc = ci_udp_recvmmsg_batch(&rinf, mmsg + i, vlen - i);
+      n_batched += rc;
+      i += rc;
+    }
+
     if( timeout_msec >= 0 ) {
       struct timeval tv_after, tv_sub;
       gettimeofday(&tv_after, NULL);
@@ -917,6 +1124,14 @@ int ci_udp_recvmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
     }
   }
 
+  /* Free the buffers of the batch in one go rather than leaving each of
+   * them to be reaped separately later. */
+  if( n_batched && ci_udp_recv_q_reapable(&us->recv_q) &&
+      ci_netif_trylock(ni) ) {
+    ci_udp_recv_q_reap(ni, &us->recv_q);
+    ci_netif_unlock(ni);
+  }
+
   if( rinf.sock_locked )
     ci_sock_unlock(ni, &us->s.b);
   
@@ -1144,7 +1359,7 @@ int ci_udp_zc_recv(ci_udp_iomsg_args* a, struct onload_zc_recv_args* args)
         args->msg.msghdr.msg_controllen = supplied_controllen;
         args->msg.msghdr.msg_control = supplied_control;
         ci_ip_cmsg_recv(ni, us, pkt, &args->msg.msghdr, 0,
-                        &args->msg.msghdr.msg_flags);
+                        &args->msg.msghdr.msg_flags, 0);
       }
       else
         args->msg.msghdr.msg_controllen = 0;
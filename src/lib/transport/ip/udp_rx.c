@@ -119,6 +119,80 @@ int ci_udp_csum_correct(ci_ip_pkt_fmt* pkt, ci_udp_hdr* udp)
 }
 
 
+/* Redundant feed arbitration (onload_set_recv_arbitration()).  Returns
+ * true if [pkt] is to be dropped because its sequence number has already
+ * been delivered to [us], or is too old to tell.
+ */
+int ci_udp_arb_drop(ci_udp_state* us, ci_ip_pkt_fmt* pkt)
+{
+  unsigned off = us->arb_seq_offset, len = us->arb_seq_len;
+  unsigned shift = 64 - 8 * len;
+  const ci_uint8* p;
+  ci_uint64 seq = 0;
+  ci_int64 delta;
+  unsigned i;
+
+  if( off + len > pkt->pf.udp.pay_len ||
+      off + len > oo_offbuf_left(&pkt->buf) )
+    return 0;
+
+  p = (const ci_uint8*) oo_offbuf_ptr(&pkt->buf) + off;
+  if( us->arb_flags & CI_UDP_ARB_LITTLE_ENDIAN )
+    for( i = len; i-- > 0; )
+      seq = (seq << 8) | p[i];
+  else
+    for( i = 0; i < len; ++i )
+      seq = (seq << 8) | p[i];
+
+  if( us->arb_window == 0 )
+    goto restart;
+
+  /* Distance from the highest sequence number delivered, allowing for the
+   * sequence number wrapping at [len] bytes. */
+  delta = (ci_int64) ((seq - us->arb_last) << shift) >> shift;
+
+  if( delta > 0 ) {
+    /* Sequence numbers that leave the window without having arrived on
+     * any feed are lost. */
+    for( i = 0; i < delta && i < CI_UDP_ARB_WINDOW; ++i )
+      if( ! (us->arb_window & (1ull << (CI_UDP_ARB_WINDOW - 1 - i))) )
+        ++us->stats.n_rx_arb_gap;
+    if( delta >= CI_UDP_ARB_WINDOW ) {
+      us->stats.n_rx_arb_gap += delta - CI_UDP_ARB_WINDOW;
+      us->arb_window = 1;
+    }
+    else {
+      us->arb_window = (us->arb_window << delta) | 1;
+    }
+    us->arb_last = seq;
+    return 0;
+  }
+
+  if( -delta < CI_UDP_ARB_WINDOW ) {
+    if( us->arb_window & (1ull << -delta) ) {
+      ++us->stats.n_rx_arb_dup;
+      return 1;
+    }
+    us->arb_window |= 1ull << -delta;
+    ++us->stats.n_rx_arb_late;
+    return 0;
+  }
+
+  if( -delta < CI_CFG_UDP_ARB_RESET ) {
+    ++us->stats.n_rx_arb_old;
+    return 1;
+  }
+  ++us->stats.n_rx_arb_reset;
+
+ restart:
+  /* Anything before the first sequence number seen is taken to have been
+   * delivered already. */
+  us->arb_last = seq;
+  us->arb_window = ~0ull;
+  return 0;
+}
+
+
 int ci_udp_rx_deliver(ci_sock_cmn* s, void* opaque_arg)
 {
   /* Deliver a received packet to a socket. */
@@ -138,6 +212,11 @@ int ci_udp_rx_deliver(ci_sock_cmn* s, void* opaque_arg)
 
   state->delivered = 1;
 
+  if(CI_UNLIKELY( us->arb_seq_len != 0 ) && ci_udp_arb_drop(us, pkt) )
+    /* A copy has already been delivered from another feed. */
+    return ! (CI_IP_IS_MULTICAST(oo_ip_hdr(pkt)->ip_daddr_be32) ||
+              oo_ip_hdr(pkt)->ip_daddr_be32 == CI_IP_ALL_BROADCAST);
+
   if( (recvq_depth <= us->stats.max_recvq_pkts) &&
       ! (ni->state->mem_pressure & OO_MEM_PRESSURE_CRITICAL) ) {
     int multi_destination_pkt;
@@ -321,7 +400,11 @@ void ci_udp_handle_rx(ci_netif* ni, ci_ip_pkt_fmt* pkt, ci_udp_hdr* udp,
       ci_netif_pkt_release_rx_1ref(ni, pkt);
       return;
     }
-    if ( ci_netif_pkt_pass_to_kernel(ni, pkt) ) {
+    /* A datagram reassembled by the stack goes to the kernel in the
+     * fragments it arrived in. */
+    if( IS_AF_INET6(af) || ! CI_IP4_IS_FIRST_FRAG(&ipx->ip4) ?
+        ci_netif_pkt_pass_to_kernel(ni, pkt) :
+        ci_ip_reasm_pass_to_kernel(ni, pkt) ) {
       CITP_STATS_NETIF_INC(ni, no_match_pass_to_kernel_udp);
       return;
     }
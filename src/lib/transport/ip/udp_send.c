@@ -13,6 +13,8 @@
   
 /*! \cidoxg_lib_transport_ip */
   
+#define _GNU_SOURCE  /* for sendmmsg */
+
 #include "ip_internal.h"
 #include "udp_internal.h"
 #include "ip_tx.h"
@@ -20,6 +22,11 @@
 #include <onload/osfile.h>
 #include <onload/pkt_filler.h>
 #include <onload/sleep.h>
+#ifdef __KERNEL__
+#include <linux/udp.h>
+#else
+#include <netinet/udp.h>
+#endif
 
 #ifndef __KERNEL__
 #include <ci/internal/efabcfg.h>
@@ -69,6 +76,14 @@
 #define oo_tx_ipx_udp_hdr(af, pkt) ((ci_udp_hdr*) oo_tx_ipx_data(af, pkt))
 
 
+/* State of a sendmmsg() call: datagrams that are on the DMA queue but
+ * have not yet been pushed to the NIC.
+ */
+struct udp_send_batch {
+  int                   n_queued;
+  ci_uint32             intf_mask;
+};
+
 struct udp_send_info {
   int                   rc;
   ci_ip_cached_hdrs     ipcache;
@@ -76,8 +91,12 @@ struct udp_send_info {
   int                   stack_locked;
   ci_uint32             timeout;
   int                   old_ipcache_updated;
+  ci_uint16             gso_size;
+  struct udp_send_batch* batch;
+  ci_uint64             txtime_frc;
 };
 
+
 static bool ci_ipx_is_first_frag(int af, ci_ipx_hdr_t* ipx)
 {
 #if CI_CFG_IPV6
@@ -327,6 +346,17 @@ static void ci_udp_sendmsg_mcast(ci_netif* ni, ci_udp_state* us,
 }
 
 
+/* UDP_SEGMENT: a send that was split into several datagrams is chained in
+ * the same way as the IP fragments of one datagram, but its first packet is
+ * not a fragment.
+ */
+ci_inline int ci_udp_pkt_is_gso(int af, ci_ip_pkt_fmt* pkt)
+{
+  return OO_PP_NOT_NULL(pkt->next) &&
+         ! ci_ipx_is_frag(af, TX_PKT_IPX_HDR(af, pkt));
+}
+
+
 /* Pass prepared packet to ip_send(), release our ref & and update stats */
 ci_inline void prep_send_pkt(ci_netif* ni, ci_udp_state* us,
                              ci_ip_pkt_fmt* pkt, ci_ip_cached_hdrs* ipcache)
@@ -547,14 +577,21 @@ static int ci_udp_sendmsg_send_pkt_via_os(ci_netif* ni, ci_udp_state* us,
   int seg_i, buf_len, iov_i;
   ci_ip_pkt_fmt* frag_head;
   ci_ip_pkt_fmt* buf_pkt;
-  struct iovec iov[30];
+  struct iovec iov[CI_CFG_UDP_GSO_MAX_SEGS];
   ci_udp_hdr* udp;
   void* buf_start;
   ci_msghdr m;
+  int af = ipcache_af(&us->s.pkt);
+  int is_gso = ci_udp_pkt_is_gso(af, pkt);
 #ifndef __KERNEL__
   struct sockaddr_storage ss;
+#ifdef UDP_SEGMENT
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(ci_uint16))];
+  } cbuf;
+#endif
 #endif
-  int af = ipcache_af(&us->s.pkt);
 
   m.msg_iov = iov;
   m.msg_iovlen = 0;
@@ -577,6 +614,23 @@ static int ci_udp_sendmsg_send_pkt_via_os(ci_netif* ni, ci_udp_state* us,
     }
     m.msg_controllen = 0;
   }
+#ifdef UDP_SEGMENT
+  if( is_gso ) {
+    /* Have the kernel split the payload as we would have done.  (In the
+     * kernel case, the socket option is set on the OS socket.) */
+    ci_uint16 gso_size = CI_BSWAP_BE16(TX_PKT_IPX_UDP(af, pkt,
+                                                      false)->udp_len_be16) -
+                         sizeof(ci_udp_hdr);
+    struct cmsghdr* cmsg;
+    m.msg_control = &cbuf;
+    m.msg_controllen = sizeof(cbuf.buf);
+    cmsg = CMSG_FIRSTHDR(&m);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(gso_size));
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+  }
+#endif
 #endif /* __KERNEL__ */
 
   frag_head = pkt;
@@ -588,6 +642,9 @@ static int ci_udp_sendmsg_send_pkt_via_os(ci_netif* ni, ci_udp_state* us,
     if( buf_pkt == pkt )
       /* First IP fragment, move past IP+UDP header */
       buf_start = udp + 1;
+    else if( seg_i == 0 && is_gso )
+      /* Subsequent UDP_SEGMENT datagram, move past IP+UDP header */
+      buf_start = (ci_udp_hdr*) oo_tx_ipx_data(af, buf_pkt) + 1;
     else if( seg_i == 0 )
       /* Subsequent IP fragment, move past IP header */
       buf_start = oo_tx_ipx_data(af, buf_pkt);
@@ -628,7 +685,7 @@ static int ci_udp_sendmsg_send_pkt_via_os(ci_netif* ni, ci_udp_state* us,
 }
 
 
-static void fixup_pkt_not_transmitted(ci_netif *ni, ci_ip_pkt_fmt* pkt)
+void ci_udp_fixup_pkt_not_transmitted(ci_netif *ni, ci_ip_pkt_fmt* pkt)
 {
   ci_assert(ci_netif_is_locked(ni));
   while( 1 ) {
@@ -648,6 +705,290 @@ static void fixup_pkt_not_transmitted(ci_netif *ni, ci_ip_pkt_fmt* pkt)
 }
 
 
+/* UDP_SEGMENT: only the first datagram has had its destination port set. */
+static void ci_udp_sendmsg_gso_set_dport(ci_netif* ni, int af,
+                                         ci_ip_pkt_fmt* pkt)
+{
+  ci_uint16 dport_be16 = TX_PKT_IPX_UDP(af, pkt, false)->udp_dest_be16;
+  while( OO_PP_NOT_NULL(pkt->next) ) {
+    pkt = PKT_CHK(ni, pkt->next);
+    TX_PKT_IPX_UDP(af, pkt, false)->udp_dest_be16 = dport_be16;
+  }
+}
+
+
+/* Push the datagrams that a sendmmsg() batch has put on the DMA queues.
+ * Stack must be locked.  The lock is dropped between datagrams, so a poll
+ * or another sender may have pushed some of the queues already.
+ */
+static void ci_udp_sendmmsg_push(ci_netif* ni, struct udp_send_batch* batch)
+{
+  int intf_i;
+
+  ci_assert(ci_netif_is_locked(ni));
+
+  for( intf_i = 0; batch->intf_mask != 0; ++intf_i )
+    if( batch->intf_mask & (1u << intf_i) ) {
+      if( ci_netif_dmaq_not_empty(ni, intf_i) )
+        ci_netif_dmaq_shove2(ni, intf_i, 0 /*is_fresh*/);
+      batch->intf_mask &= ~(1u << intf_i);
+    }
+  batch->n_queued = 0;
+}
+
+
+/* Push what a sendmmsg() batch has queued before a send that may go out
+ * ahead of it: through the OS socket, or after blocking.  Takes the stack
+ * lock if the caller does not hold it.
+ */
+static void ci_udp_sendmmsg_flush(ci_netif* ni, struct udp_send_info* sinf)
+{
+#ifndef __KERNEL__
+  struct udp_send_batch* batch = sinf->batch;
+
+  if( batch == NULL || batch->intf_mask == 0 )
+    return;
+  if( sinf->stack_locked ) {
+    ci_udp_sendmmsg_push(ni, batch);
+  }
+  else {
+    ci_netif_lock(ni);
+    ci_udp_sendmmsg_push(ni, batch);
+    ci_netif_unlock(ni);
+  }
+#endif
+}
+
+
+/* Put all the datagrams of a send on the DMA queue.  They are pushed to
+ * the NIC together: now for a UDP_SEGMENT send, or by
+ * ci_udp_sendmmsg_push() when [batch] is given.
+ */
+static void ci_udp_sendmsg_list_to_dmaq(ci_netif* ni, ci_udp_state* us,
+                                        ci_ip_pkt_fmt* pkt,
+                                        ci_ip_cached_hdrs* ipcache,
+                                        struct udp_send_batch* batch)
+{
+  oo_pkt_p head_id = OO_PKT_P(pkt);
+  oo_pktq* dmaq;
+  ef_vi* vi;
+  int n = 0, is_fresh;
+
+  while( 1 ) {
+    prep_send_pkt(ni, us, pkt, ipcache);
+    /* We've called ci_netif_pkt_hold() in ci_udp_sendmsg_fill(). */
+    __ci_netif_dmaq_insert_prep_pkt(ni, pkt);
+    pkt->netif.tx.dmaq_next = pkt->next;
+    ++n;
+    if( OO_PP_IS_NULL(pkt->next) )
+      break;
+    pkt = PKT_CHK(ni, pkt->next);
+  }
+
+  ci_netif_dmaq_and_vi_for_pkt(ni, pkt, &dmaq, &vi);
+  is_fresh = oo_pktq_is_empty(dmaq);
+  __oo_pktq_put_list(ni, dmaq, head_id, pkt, n, netif.tx.dmaq_next);
+  if( batch == NULL ) {
+    ci_netif_dmaq_shove2(ni, pkt->intf_i, is_fresh);
+    return;
+  }
+
+  CITP_STATS_NETIF_ADD(ni, udp_tx_mmsg_batched, n);
+  batch->intf_mask |= 1u << pkt->intf_i;
+  batch->n_queued += n;
+  if( batch->n_queued >= CI_CFG_UDP_SENDMMSG_PUSH )
+    ci_udp_sendmmsg_push(ni, batch);
+}
+
+
+/* Per-socket cache of the headers that the control plane resolved for
+ * recent unconnected destinations (EF_UDP_SEND_DEST_CACHE).  A send that
+ * switches [us->ephemeral_pkt] to a destination that is in the cache, and
+ * whose entry is still valid, takes the resolved headers from the entry
+ * instead of doing a control plane lookup.
+ */
+
+ci_inline unsigned ci_udp_dest_cache_hash(const ci_ip_cached_hdrs* ipcache)
+{
+  return __onload_hash1(CI_CFG_UDP_DEST_CACHE_BUCKETS - 1, 0, 0,
+                        onload_addr_xor(ipcache_raddr(ipcache)),
+                        ipcache->dport_be16, IPPROTO_UDP);
+}
+
+
+/* Store the destination and the resolved headers of [ipcache] in [e]. */
+static void ci_udp_dest_cache_entry_set(ci_udp_dest_cache_entry* e,
+                                        ci_ip_cached_hdrs* ipcache)
+{
+  ci_assert_equal(ipcache->status, retrrc_success);
+
+  e->raddr = ipcache_raddr(ipcache);
+  e->laddr = ipcache_laddr(ipcache);
+  e->nexthop = ipcache->nexthop;
+  e->fwd_ver = ipcache->fwd_ver;
+  e->fwd_ver_init_net = ipcache->fwd_ver_init_net;
+  e->encap = ipcache->encap;
+  e->dport_be16 = ipcache->dport_be16;
+  e->ether_type = ipcache->ether_type;
+  e->mtu = ipcache->mtu;
+  e->ifindex = ipcache->ifindex;
+  e->iif_ifindex = ipcache->iif_ifindex;
+  e->intf_i = ipcache->intf_i;
+  e->hwport = ipcache->hwport;
+  e->ether_offset = ipcache->ether_offset;
+  e->flags = ipcache->flags;
+  e->ttl = ipcache_ttl(ipcache);
+  memcpy(e->ether_header, ipcache->ether_header, sizeof(e->ether_header));
+}
+
+
+/* As cicp_ip_cache_update_from(), from a cache entry. */
+static void ci_udp_dest_cache_entry_get(ci_ip_cached_hdrs* ipcache,
+                                        const ci_udp_dest_cache_entry* e)
+{
+  ci_ipcache_set_saddr(ipcache, e->laddr);
+  ipcache_ttl(ipcache) = e->ttl;
+  ipcache->fwd_ver = e->fwd_ver;
+  ipcache->fwd_ver_init_net = e->fwd_ver_init_net;
+  ipcache->status = retrrc_success;
+  ipcache->flags = e->flags;
+  ipcache->nexthop = e->nexthop;
+  ipcache->mtu = e->mtu;
+  ipcache->ifindex = e->ifindex;
+  ipcache->iif_ifindex = e->iif_ifindex;
+  ipcache->encap = e->encap;
+  ipcache->intf_i = e->intf_i;
+  ipcache->hwport = e->hwport;
+  ipcache->ether_offset = e->ether_offset;
+  memcpy(ipcache->ether_header, e->ether_header,
+         sizeof(ipcache->ether_header));
+}
+
+
+void ci_udp_dest_cache_flush(ci_netif* ni, ci_udp_state* us)
+{
+  ci_udp_dest_cache* dc;
+  ci_udp_dest_cache_entry* e;
+  int i;
+
+  ci_assert(ci_netif_is_locked(ni));
+
+  if( OO_P_IS_NULL(us->dest_cache) )
+    return;
+  dc = ci_ni_aux_p2udp_dest_table(ni, us->dest_cache);
+  for( i = 0; i < CI_CFG_UDP_DEST_CACHE_BUCKETS; ++i )
+    while( OO_P_NOT_NULL(dc->bucket[i]) ) {
+      e = ci_ni_aux_p2udp_dest(ni, dc->bucket[i]);
+      dc->bucket[i] = e->next;
+      ci_udp_dest_cache_entry_free(ni, e);
+      --dc->n;
+    }
+  ci_assert_equal(dc->n, 0);
+  ci_udp_dest_cache_free(ni, dc);
+  us->dest_cache = OO_P_NULL;
+}
+
+
+/* Resolve [us->ephemeral_pkt], whose destination has just been set. */
+static void ci_udp_ephemeral_retrieve(ci_netif* ni, ci_udp_state* us)
+{
+  ci_ip_cached_hdrs* ipcache = &us->ephemeral_pkt;
+  ci_udp_dest_cache* dc = NULL;
+  ci_udp_dest_cache_entry* e = NULL;
+  oo_p* head = NULL;
+  oo_p* pp;
+  oo_p* tail_pp = NULL;
+  oo_p p;
+  int i;
+
+  ci_assert(ci_netif_is_locked(ni));
+
+  if( NI_OPTS(ni).udp_send_dest_cache == 0 ) {
+    ++us->stats.n_tx_cp_uc_lookup;
+    cicp_user_retrieve(ni, ipcache, &us->s.cp);
+    return;
+  }
+
+  if( OO_P_NOT_NULL(us->dest_cache) ) {
+    dc = ci_ni_aux_p2udp_dest_table(ni, us->dest_cache);
+    /* Entries are only good for the socket options they were resolved
+     * with. */
+    if( memcmp(&dc->cp, &us->s.cp, sizeof(us->s.cp)) != 0 ) {
+      ci_udp_dest_cache_flush(ni, us);
+      dc = NULL;
+    }
+  }
+
+  if( dc != NULL ) {
+    head = &dc->bucket[ci_udp_dest_cache_hash(ipcache)];
+    for( pp = head; OO_P_NOT_NULL(*pp); pp = &e->next ) {
+      e = ci_ni_aux_p2udp_dest(ni, *pp);
+      if( e->dport_be16 == ipcache->dport_be16 &&
+          e->ether_type == ipcache->ether_type &&
+          CI_IPX_ADDR_EQ(e->raddr, ipcache_raddr(ipcache)) )
+        break;
+      tail_pp = pp;
+    }
+
+    if( OO_P_NOT_NULL(*pp) ) {
+      if( pp != head ) {
+        /* Keep the chain in most recently used order. */
+        p = *pp;
+        *pp = e->next;
+        e->next = *head;
+        *head = p;
+      }
+      if( oo_cp_fwd_ver_is_valid(ni, &e->fwd_ver, &e->fwd_ver_init_net) ) {
+        ++us->stats.n_tx_cp_dest_hit;
+        ci_udp_dest_cache_entry_get(ipcache, e);
+        return;
+      }
+    }
+    else {
+      e = NULL;
+    }
+  }
+
+  ++us->stats.n_tx_cp_uc_lookup;
+  cicp_user_retrieve(ni, ipcache, &us->s.cp);
+  if( ipcache->status != retrrc_success )
+    return;
+
+  if( dc == NULL ) {
+    /* The hash table is allocated by the first send that can use it. */
+    p = ci_ni_aux_alloc(ni, CI_TCP_AUX_TYPE_UDP_DEST_TABLE);
+    if( OO_P_IS_NULL(p) )
+      return;
+    us->dest_cache = p;
+    dc = ci_ni_aux_p2udp_dest_table(ni, p);
+    for( i = 0; i < CI_CFG_UDP_DEST_CACHE_BUCKETS; ++i )
+      dc->bucket[i] = OO_P_NULL;
+    dc->n = 0;
+    memcpy(&dc->cp, &us->s.cp, sizeof(us->s.cp));
+    head = &dc->bucket[ci_udp_dest_cache_hash(ipcache)];
+  }
+
+  if( e == NULL ) {
+    if( dc->n < NI_OPTS(ni).udp_send_dest_cache &&
+        OO_P_NOT_NULL(p = ci_ni_aux_alloc(ni, CI_TCP_AUX_TYPE_UDP_DEST)) ) {
+      ++dc->n;
+    }
+    else if( tail_pp != NULL ) {
+      /* Full: reuse the least recently used entry of this chain. */
+      p = *tail_pp;
+      *tail_pp = OO_P_NULL;
+    }
+    else {
+      return;
+    }
+    e = ci_ni_aux_p2udp_dest(ni, p);
+    e->next = *head;
+    *head = p;
+  }
+  ci_udp_dest_cache_entry_set(e, ipcache);
+}
+
+
 static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
                                 ci_ip_pkt_fmt* pkt, int flags,
                                 struct udp_send_info* sinf)
@@ -662,9 +1003,15 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
   ci_addr_t pkt_daddr = TX_PKT_DADDR(af, pkt);
   unsigned tot_len;
   int old_ipcache_updated = (sinf == NULL) ? 0 : sinf->old_ipcache_updated;
+  struct udp_send_batch* batch = (sinf == NULL) ? NULL : sinf->batch;
+  int is_gso = ci_udp_pkt_is_gso(af, pkt);
 
   ci_assert(ci_netif_is_locked(ni));
 
+  if(CI_UNLIKELY( (us->udpflags & CI_UDPF_TXTIME) && pkt->tstamp_frc != 0 ))
+    if( ci_udp_txtime_hold(ni, us, pkt, flags) )
+      return;
+
   is_connected_send = CI_IPX_ADDR_IS_ANY(pkt_daddr) ? 1 : 0;
 
   if( ! is_connected_send ) {
@@ -696,12 +1043,11 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
       }
     }
 
-    ++us->stats.n_tx_cp_uc_lookup;
     /* Although we know that [ipcache] has the wrong destination, it might
      * still be valid for the old destination.  Invalidate it to avoid wrong-
      * footing cicp_user_retrieve(). */
     ci_ip_cache_invalidate(ipcache);
-    cicp_user_retrieve(ni, ipcache, &us->s.cp);
+    ci_udp_ephemeral_retrieve(ni, us);
   }
   else {
     /**********************************************************************
@@ -768,27 +1114,34 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
     ci_log("%s: pkt mtu=%d exceeds path mtu=%d", __FUNCTION__,
            tot_len, ipcache->mtu);
 
+  if( is_gso )
+    ci_udp_sendmsg_gso_set_dport(ni, af, pkt);
+
   ci_assert_equal(ni->state->send_may_poll, 0);
   ni->state->send_may_poll = ci_netif_may_poll(ni);
 
   /* Linux allows sending IPv6 packets with zero Hop Limit field */
   if( ipcache_ttl(ipcache) || ipcache_is_ipv6(ipcache) ) {
     if(CI_LIKELY( ipcache_onloadable )) {
-      /* TODO: Hit the doorbell just once. */
-      while( 1 ) {
-        oo_pkt_p next = pkt->next;
-        prep_send_pkt(ni, us, pkt, ipcache);
-        /* We've called ci_netif_pkt_hold() in ci_udp_sendmsg_fill(). */
-        ci_netif_send(ni, pkt);
-        if( OO_PP_IS_NULL(next) )
-          break;
-        pkt = PKT_CHK(ni, next);
+      if( is_gso || batch != NULL ) {
+        ci_udp_sendmsg_list_to_dmaq(ni, us, pkt, ipcache, batch);
+      }
+      else {
+        while( 1 ) {
+          oo_pkt_p next = pkt->next;
+          prep_send_pkt(ni, us, pkt, ipcache);
+          /* We've called ci_netif_pkt_hold() in ci_udp_sendmsg_fill(). */
+          ci_netif_send(ni, pkt);
+          if( OO_PP_IS_NULL(next) )
+            break;
+          pkt = PKT_CHK(ni, next);
 #ifdef __KERNEL__
-        if(CI_UNLIKELY( i++ > ni->pkt_sets_n << CI_CFG_PKTS_PER_SET_S )) {
-          ci_netif_error_detected(ni, CI_NETIF_ERROR_UDP_SEND_PKTS_LIST,
-                                  __FUNCTION__);
-        }
+          if(CI_UNLIKELY( i++ > ni->pkt_sets_n << CI_CFG_PKTS_PER_SET_S )) {
+            ci_netif_error_detected(ni, CI_NETIF_ERROR_UDP_SEND_PKTS_LIST,
+                                    __FUNCTION__);
+          }
 #endif
+        }
       }
       if( flags & MSG_CONFIRM )
         oo_cp_arp_confirm(ni->cplane, &ipcache->fwd_ver,
@@ -829,11 +1182,11 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
     }
   }
   else if( CI_IPX_IS_MULTICAST(ipcache_raddr(ipcache)) ) {
-    fixup_pkt_not_transmitted(ni, first_pkt);
+    ci_udp_fixup_pkt_not_transmitted(ni, first_pkt);
     ci_udp_sendmsg_mcast(ni, us, ipcache, first_pkt);
   }
   else {
-    fixup_pkt_not_transmitted(ni, first_pkt);
+    ci_udp_fixup_pkt_not_transmitted(ni, first_pkt);
     LOG_U(ci_log("%s: do not send UDP packet because IP TTL = 0",
                  __FUNCTION__));
   }
@@ -843,7 +1196,9 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
 
  send_pkt_via_os:
   ++us->stats.n_tx_os_late;
-  fixup_pkt_not_transmitted(ni, pkt);
+  ci_udp_fixup_pkt_not_transmitted(ni, pkt);
+  if( batch != NULL )
+    ci_udp_sendmmsg_push(ni, batch);
 
   {
     int rc = ci_udp_sendmsg_send_pkt_via_os(ni, us, pkt, flags, sinf);
@@ -871,21 +1226,15 @@ static void ci_udp_sendmsg_send(ci_netif* ni, ci_udp_state* us,
      * odd thing to do).
      */
     ++us->stats.n_tx_unconnect_late;
-  fixup_pkt_not_transmitted(ni, pkt);
+  ci_udp_fixup_pkt_not_transmitted(ni, pkt);
   return;
 }
 
 
-static int ci_udp_tx_datagram_level(ci_netif* ni, ci_ip_pkt_fmt* pkt,
-                                    ci_boolean_t ni_locked)
+void ci_udp_sendmsg_send_held(ci_netif* ni, ci_udp_state* us,
+                              ci_ip_pkt_fmt* pkt, int flags)
 {
-  /* Sum the contributions from each IP fragment. */
-  int level = 0;
-  for( ; ; pkt = PKT_CHK_NML(ni, pkt->next, ni_locked) ) {
-    level += pkt->pf.udp.tx_length;
-    if( OO_PP_IS_NULL(pkt->next) )
-      return level;
-  }
+  ci_udp_sendmsg_send(ni, us, pkt, flags, NULL);
 }
 
 
@@ -1025,6 +1374,9 @@ static int ci_udp_sendmsg_wait(ci_netif* ni, ci_udp_state* us,
   udp_send_spin = 0;
 #endif
 
+  /* The batch must not wait behind this datagram. */
+  ci_udp_sendmmsg_flush(ni, sinf);
+
   /* Processing events may free space. */
   if( ci_netif_may_poll(ni) && ci_netif_has_event(ni) )
     if( si_trylock_and_inc(ni, sinf, us->stats.n_tx_lock_poll) )
@@ -1173,6 +1525,11 @@ ci_inline ci_ip6_hdr* eth_ip6_init(ci_netif* ni, ci_udp_state* us,
 
 
 /* Allocate packet buffers and fill them with the payload.
+ *
+ * If [gso_size] is non-zero, the payload is split into datagrams of
+ * [gso_size] bytes (the last may be shorter), each with its own headers.
+ * These are chained through [next] and [frag_next] in the same way as the
+ * IP fragments of a single datagram.
  *
  * Returns [bytes_to_send] on success, -errno on failure.
  */
@@ -1182,7 +1539,7 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
                         int flags,
                         struct oo_pkt_filler* pf,
                         struct udp_send_info* sinf,
-                        bool need_frag)
+                        bool need_frag, int gso_size)
 {
   ci_ip_pkt_fmt* first_pkt;
   ci_ip_pkt_fmt* new_pkt;
@@ -1197,8 +1554,9 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
   ci_udp_hdr* udp;
 
   ci_assert(pmtu > 0);
-  ci_assert_equiv( need_frag,
+  ci_assert_equiv( need_frag, ! gso_size &&
       bytes_to_send > pmtu - CI_IPX_HDR_SIZE(af) - sizeof(ci_udp_hdr) );
+  ci_assert(! gso_size || bytes_to_send > gso_size);
 
   frag_off = 0;
   bytes_left = bytes_to_send;
@@ -1221,7 +1579,8 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
   if( !IS_AF_INET6(af) || need_frag )
     ipx_id = ci_next_ipx_id_be(af, ni);
 
-  udp = udp_init(us, first_pkt, bytes_to_send, need_frag);
+  udp = udp_init(us, first_pkt, gso_size ? gso_size : bytes_to_send,
+                 need_frag);
 
   oo_pkt_filler_init(pf, first_pkt, (uint8_t*) udp + sizeof(ci_udp_hdr));
   first_pkt->pay_len = ((char*) udp + sizeof(ci_udp_hdr) - PKT_START(first_pkt));
@@ -1229,7 +1588,11 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
   oo_pkt_af_set(first_pkt, af);
 
   payload_bytes = pmtu - CI_IPX_HDR_SIZE(af) - sizeof(ci_udp_hdr);
-  if( payload_bytes >= bytes_left ) {
+  if( gso_size ) {
+    payload_bytes = gso_size;
+    bytes_left -= payload_bytes;
+  }
+  else if( payload_bytes >= bytes_left ) {
     payload_bytes = bytes_left;
     bytes_left = 0;
   }
@@ -1265,16 +1628,17 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
       ip->ip_tot_len_be16 = CI_BSWAP_BE16(ip->ip_tot_len_be16);
       ip->ip_frag_off_be16 = frag_off >> 3u;
       ip->ip_frag_off_be16 = CI_BSWAP_BE16(ip->ip_frag_off_be16);
-      if( bytes_left > 0 )
+      if( bytes_left > 0 && ! gso_size )
         ip->ip_frag_off_be16 |= CI_IP4_FRAG_MORE;
       else if( us->s.s_flags & CI_SOCK_FLAG_ALWAYS_DF ||
                ( us->s.s_flags & CI_SOCK_FLAG_PMTU_DO &&
-                 pf->pkt == first_pkt ) ) {
+                 (pf->pkt == first_pkt || gso_size) ) ) {
         ip->ip_frag_off_be16 = CI_IP4_FRAG_DONT;
       }
       ip->ip_id_be16 = ipx_id.ip4;
     }
-    frag_off += frag_bytes;
+    if( ! gso_size )
+      frag_off += frag_bytes;
 
     /* This refcount is used later by ci_netif_send() */
     ci_netif_pkt_hold(ni, pf->pkt);
@@ -1288,7 +1652,8 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
       break;
 
     /* This counts the number of fragments not including the first. */
-    ++us->stats.n_tx_fragments;
+    if( ! gso_size )
+      ++us->stats.n_tx_fragments;
 
     rc = ci_netif_pkt_alloc_block(ni, &us->s, &sinf->stack_locked, 
                                   can_block, &new_pkt);
@@ -1299,6 +1664,21 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
     pf->pkt->next = OO_PKT_P(new_pkt);
     pf->last_pkt->frag_next = OO_PKT_P(new_pkt);
 
+    if( gso_size ) {
+      /* Next datagram of a UDP_SEGMENT send. */
+      payload_bytes = CI_MIN(gso_size, bytes_left);
+      bytes_left -= payload_bytes;
+      frag_bytes = payload_bytes + sizeof(ci_udp_hdr);
+      udp = udp_init(us, new_pkt, payload_bytes, false);
+      oo_pkt_filler_init(pf, new_pkt, (uint8_t*) udp + sizeof(ci_udp_hdr));
+      new_pkt->pay_len = (char*) udp + sizeof(ci_udp_hdr) -
+                         PKT_START(new_pkt);
+      oo_pkt_af_set(new_pkt, af);
+      if( ! IS_AF_INET6(af) )
+        ipx_id = ci_next_ipx_id_be(af, ni);
+      continue;
+    }
+
     udp = TX_PKT_IPX_UDP(af, new_pkt, need_frag);
     oo_pkt_filler_init(pf, new_pkt, udp);
     new_pkt->pay_len = (char*) udp - PKT_START(new_pkt);
@@ -1322,8 +1702,9 @@ int ci_udp_sendmsg_fill(ci_netif* ni, ci_udp_state* us,
     sinf->stack_locked = 1;
 
   /* Release the refs we've taken for ci_netif_send().
-   * Unlike fixup_pkt_not_transmitted(), we can't rely that ->next links to
-   * the next IP fragment, because oo_pkt_fill() can leave it in other way.
+   * Unlike ci_udp_fixup_pkt_not_transmitted(), we can't rely that ->next
+   * links to the next IP fragment, because oo_pkt_fill() can leave it in
+   * other way.
    * So, we should go through all fragments and decrement refcounts for IP
    * fragments only. */
   {
@@ -1373,6 +1754,7 @@ void ci_udp_sendmsg_onload(ci_netif* ni, ci_udp_state* us,
   int was_locked;
   int af = ipcache_af(&us->s.pkt);
   bool need_frag = false;
+  int gso_size = 0;
 
   /* Caller should guarantee the following: */
   ci_assert(ni);
@@ -1395,8 +1777,24 @@ void ci_udp_sendmsg_onload(ci_netif* ni, ci_udp_state* us,
     ci_iovec_ptr_init(&piov, NULL, 0);
   }
 
-  if( bytes_to_send > sinf->ipcache.mtu - CI_IPX_HDR_SIZE(af) -
-      sizeof(ci_udp_hdr) )
+  if( sinf->gso_size != 0 && bytes_to_send > sinf->gso_size ) {
+    /* UDP_SEGMENT: as Linux, each datagram must fit in the path MTU. */
+    gso_size = sinf->gso_size;
+    if( gso_size > sinf->ipcache.mtu - CI_IPX_HDR_SIZE(af) -
+                   sizeof(ci_udp_hdr) ||
+        bytes_to_send > (unsigned long) gso_size * CI_CFG_UDP_GSO_MAX_SEGS ) {
+      sinf->rc = -EINVAL;
+      return;
+    }
+    /* Multicast loopback delivers a send as one datagram. */
+    if( (us->udpflags & CI_UDPF_MCAST_LOOP) &&
+        CI_IPX_IS_MULTICAST(CI_IPX_ADDR_IS_ANY(ipcache_raddr(&sinf->ipcache)) ?
+                            udp_ipx_raddr(us) :
+                            ipcache_raddr(&sinf->ipcache)) )
+      goto send_via_os;
+  }
+  else if( bytes_to_send > sinf->ipcache.mtu - CI_IPX_HDR_SIZE(af) -
+           sizeof(ci_udp_hdr) )
     need_frag = true;
 
   /* For now we don't allocate packets in advance, so init to NULL */
@@ -1443,7 +1841,7 @@ void ci_udp_sendmsg_onload(ci_netif* ni, ci_udp_state* us,
     /* IP_PMTUDISC_PROBE does not do anything in non-connected case */
   }
   rc = ci_udp_sendmsg_fill(ni, us, &piov, bytes_to_send, flags, &pf, sinf,
-                           need_frag);
+                           need_frag, gso_size);
 #if CI_CFG_TIMESTAMPING
   if( us->s.timestamping_flags & ONLOAD_SOF_TIMESTAMPING_OPT_ID ) {
     pf.pkt->ts_key = us->s.ts_key;
@@ -1454,9 +1852,16 @@ void ci_udp_sendmsg_onload(ci_netif* ni, ci_udp_state* us,
     ++us->stats.n_tx_lock_pkt;
   if(CI_LIKELY( rc >= 0 )) {
     sinf->rc = bytes_to_send;
+    if( gso_size ) {
+      CITP_STATS_NETIF_INC(ni, udp_tx_gso_sends);
+      CITP_STATS_NETIF_ADD(ni, udp_tx_gso_segs,
+                           (bytes_to_send + gso_size - 1) / gso_size);
+    }
     TX_PKT_SET_DADDR(af, pf.pkt, ipcache_raddr(&sinf->ipcache));
     TX_PKT_IPX_UDP(af, pf.pkt, need_frag)->udp_dest_be16 =
         sinf->ipcache.dport_be16;
+    /* SO_TXTIME launch time, or 0 to send now. */
+    pf.pkt->tstamp_frc = sinf->txtime_frc;
 
     if( si_trylock_and_inc(ni, sinf, us->stats.n_tx_lock_snd) ) {
       ci_udp_sendmsg_send(ni, us, pf.pkt, flags, sinf);
@@ -1480,6 +1885,7 @@ void ci_udp_sendmsg_onload(ci_netif* ni, ci_udp_state* us,
   return;
 
  send_via_os:
+  ci_udp_sendmmsg_flush(ni, sinf);
   if( sinf->stack_locked ) {
     ci_netif_unlock(ni);
     sinf->stack_locked = 0;
@@ -1524,8 +1930,37 @@ static int ci_udp_sendmsg_control_os(ci_fd_t fd, ci_udp_state *us,
 }
 #endif
 
-int ci_udp_sendmsg(ci_udp_iomsg_args *a,
-                   const ci_msghdr* msg, int flags)
+#if !defined(__KERNEL__) && !defined(__i386__)
+/* Convert an SCM_TXTIME launch time (ns against the socket's SO_TXTIME
+ * clock) to the FRC timebase.  Returns 0 if the launch time is too far in
+ * the future for us to hold the datagram.
+ */
+static ci_uint64 ci_udp_txtime_to_frc(ci_netif* ni, ci_udp_state* us,
+                                      ci_uint64 txtime_ns)
+{
+  const ci_int64 horizon_ns = (ci_int64) CI_CFG_UDP_TXTIME_HORIZON_US * 1000;
+  struct timespec ts;
+  ci_uint64 now_frc, frc;
+  ci_int64 delta_ns;
+
+  clock_gettime(us->txtime_clockid, &ts);
+  ci_frc64(&now_frc);
+  delta_ns = (ci_int64) (txtime_ns -
+                         ((ci_uint64) ts.tv_sec * 1000000000 + ts.tv_nsec));
+  if( delta_ns > horizon_ns )
+    return 0;
+  if( delta_ns >= 0 )
+    frc = now_frc + oo_usec_to_cycles64(ni, delta_ns / 1000);
+  else
+    frc = now_frc - oo_usec_to_cycles64(ni, CI_MIN(-delta_ns, horizon_ns) /
+                                            1000);
+  return frc != 0 ? frc : 1;
+}
+#endif
+
+static int __ci_udp_sendmsg(ci_udp_iomsg_args *a,
+                            const ci_msghdr* msg, int flags,
+                            struct udp_send_batch* batch)
 {
   ci_netif *ni = a->ni;
   ci_udp_state *us = a->us;
@@ -1541,18 +1976,31 @@ int ci_udp_sendmsg(ci_udp_iomsg_args *a,
   sinf.used_ipcache = 0;
   sinf.old_ipcache_updated = 0;
   sinf.timeout = us->s.so.sndtimeo_msec;
+  sinf.gso_size = us->tx_gso_size;
+  sinf.batch = batch;
+  sinf.txtime_frc = 0;
 
 #ifndef __KERNEL__
 #ifdef __i386__
   /* We do not want to re-pack msg_control field or to find out sys_sendmsg32()
    * syscall when sending from a 32-bit application. So, let the kernel to take
    * care of it. */
-  if(CI_UNLIKELY( msg->msg_controllen != 0 ))
+  if(CI_UNLIKELY( msg->msg_controllen != 0 )) {
+    ci_udp_sendmmsg_flush(ni, &sinf);
     return ci_udp_sendmsg_control_os(a->fd, us, msg, flags);
+  }
 #else
   if(CI_UNLIKELY( CMSG_FIRSTHDR(msg) != NULL )) {
     void* info = NULL;
-    if( ci_ip_cmsg_send(msg, &info) != 0 || info != NULL )
+    ci_uint64 txtime = 0;
+    if( ci_ip_cmsg_send(msg, &info, &sinf.gso_size, &txtime) != 0 ||
+        info != NULL )
+      goto send_via_os;
+    /* Without SO_TXTIME the OS reports the error.  Beyond our horizon we
+     * let the OS qdisc deal with it. */
+    if( txtime != 0 &&
+        ( ! (us->udpflags & CI_UDPF_TXTIME) ||
+          (sinf.txtime_frc = ci_udp_txtime_to_frc(ni, us, txtime)) == 0 ) )
       goto send_via_os;
   }
 #endif
@@ -1674,6 +2122,7 @@ int ci_udp_sendmsg(ci_udp_iomsg_args *a,
 #ifndef __KERNEL__
     if(CI_UNLIKELY( udp_lport_be16(us) == 0 )) {
       /* We haven't yet allocated a local port.  Do it now. */
+      ci_udp_sendmmsg_flush(ni, &sinf);
       if( sinf.stack_locked )
         ci_netif_unlock(ni);
       rc = ci_udp_sendmsg_os_get_binding(a->ep, a->fd, msg, flags);
@@ -1713,8 +2162,7 @@ int ci_udp_sendmsg(ci_udp_iomsg_args *a,
         ci_ip_cache_invalidate(&us->ephemeral_pkt);
       }
       if(CI_UNLIKELY( ! oo_cp_ipcache_is_valid(ni, &us->ephemeral_pkt) )) {
-        ++us->stats.n_tx_cp_uc_lookup;
-        cicp_user_retrieve(ni, &us->ephemeral_pkt, &us->s.cp);
+        ci_udp_ephemeral_retrieve(ni, us);
         if( reuse_ipcache )
           sinf.old_ipcache_updated = 1;
       }
@@ -1759,6 +2207,7 @@ int ci_udp_sendmsg(ci_udp_iomsg_args *a,
   return rc;
 
  send_via_os:
+  ci_udp_sendmmsg_flush(ni, &sinf);
   if( sinf.stack_locked )
     ci_netif_unlock(ni);
   rc = ci_udp_sendmsg_os(ni, us, msg, flags, 1, 0);
@@ -1768,5 +2217,70 @@ int ci_udp_sendmsg(ci_udp_iomsg_args *a,
     RET_WITH_ERRNO(-rc);
 }
 
+
+int ci_udp_sendmsg(ci_udp_iomsg_args *a,
+                   const ci_msghdr* msg, int flags)
+{
+  return __ci_udp_sendmsg(a, msg, flags, NULL);
+}
+
+
+#ifndef __KERNEL__
+/* Datagrams that go out through the DMA queue are not pushed to the NIC
+ * one at a time.  They are pushed once per CI_CFG_UDP_SENDMMSG_PUSH
+ * datagrams, before a datagram that goes through the OS or has to wait
+ * for space, and at the end of the call.
+ */
+int ci_udp_sendmmsg(ci_udp_iomsg_args *a, struct mmsghdr* mmsg,
+                    unsigned int vlen, int flags)
+{
+  ci_netif* ni = a->ni;
+  struct udp_send_batch batch;
+  unsigned int i;
+  int rc = 0;
+
+  /* Nothing to batch with */
+  if( vlen == 1 ) {
+    if(CI_UNLIKELY( mmsg->msg_hdr.msg_iov == NULL &&
+                    mmsg->msg_hdr.msg_iovlen != 0 )) {
+      CI_SET_ERROR(rc, EFAULT);
+      return rc;
+    }
+    rc = ci_udp_sendmsg(a, &mmsg->msg_hdr, flags);
+    if( rc < 0 )
+      return rc;
+    mmsg->msg_len = rc;
+    return 1;
+  }
+
+  batch.n_queued = 0;
+  batch.intf_mask = 0;
+
+  for( i = 0; i < vlen; ++i ) {
+    if(CI_UNLIKELY( mmsg[i].msg_hdr.msg_iov == NULL &&
+                    mmsg[i].msg_hdr.msg_iovlen != 0 )) {
+      CI_SET_ERROR(rc, EFAULT);
+      break;
+    }
+    rc = __ci_udp_sendmsg(a, &mmsg[i].msg_hdr, flags, &batch);
+    if( rc < 0 )
+      break;
+    mmsg[i].msg_len = rc;
+  }
+
+  if( batch.intf_mask != 0 ) {
+    ci_netif_lock(ni);
+    ci_udp_sendmmsg_push(ni, &batch);
+    ci_netif_unlock(ni);
+  }
+
+  /* As Linux: the error is reported only if nothing was sent, and is
+   * otherwise dropped. */
+  if( rc < 0 && i == 0 )
+    return rc;
+  return i;
+}
+#endif
+
 #endif
 /*! \cidoxg_end */
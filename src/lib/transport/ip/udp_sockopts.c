@@ -248,6 +248,15 @@ int ci_udp_getsockopt(citp_socket* ep, ci_fd_t fd, int level,
       }
       goto u_out;
     }
+#ifdef SO_TXTIME
+    else if( optname == SO_TXTIME ) {
+      struct oo_sock_txtime txt;
+      txt.clockid = us->txtime_clockid;
+      txt.flags = us->txtime_flags;
+      return ci_getsockopt_final(optval, optlen, SOL_SOCKET,
+                                 &txt, sizeof(txt));
+    }
+#endif
     else {
       /* Common SOL_SOCKET option handler */
       return ci_get_sol_socket(netif, &us->s, optname, optval, optlen);
@@ -295,8 +304,21 @@ int ci_udp_getsockopt(citp_socket* ep, ci_fd_t fd, int level,
 #endif
 
   } else if (level == IPPROTO_UDP) {
-    /* We definitely don't support this */
-    RET_WITH_ERRNO(ENOPROTOOPT);
+    switch (optname) {
+#ifdef UDP_SEGMENT
+    case UDP_SEGMENT:
+      u = us->tx_gso_size;
+      return ci_getsockopt_final(optval, optlen, SOL_UDP, &u, sizeof(u));
+#endif
+#ifdef UDP_GRO
+    case UDP_GRO:
+      u = !!(us->s.cmsg_flags & CI_UDP_CMSG_GRO);
+      return ci_getsockopt_final(optval, optlen, SOL_UDP, &u, sizeof(u));
+#endif
+    default:
+      /* We definitely don't support this */
+      RET_WITH_ERRNO(ENOPROTOOPT);
+    }
   } else {
     SOCKOPT_RET_INVALID_LEVEL(&us->s);
   }
@@ -445,6 +467,42 @@ static int ci_udp_setsockopt_lk(citp_socket* ep, ci_fd_t fd, ci_fd_t os_sock,
       return ci_set_sol_socket(netif, &us->s, optname, optval, optlen);
       break;
 
+#ifdef SO_TXTIME
+    case SO_TXTIME:
+    {
+      const struct oo_sock_txtime* txt = optval;
+      if( optlen != sizeof(*txt) ) {
+        rc = -EINVAL;
+        goto fail_inval;
+      }
+      if( txt->flags & ~(CI_UDP_TXTIME_DEADLINE_MODE |
+                         CI_UDP_TXTIME_REPORT_ERRORS) ) {
+        rc = -EINVAL;
+        goto fail_inval;
+      }
+      us->txtime_clockid = txt->clockid;
+      us->txtime_flags = txt->flags;
+      /* We hold datagrams against the clocks we can convert to the FRC.
+       * Launch times against other clocks are left to the OS.  We do not
+       * generate SOF_TXTIME_REPORT_ERRORS reports: a datagram that
+       * misses its launch time is counted and dropped.
+       */
+      switch( txt->clockid ) {
+      case CLOCK_MONOTONIC:
+      case CLOCK_REALTIME:
+#ifdef CLOCK_TAI
+      case CLOCK_TAI:
+#endif
+        us->udpflags |= CI_UDPF_TXTIME;
+        break;
+      default:
+        us->udpflags &= ~CI_UDPF_TXTIME;
+        break;
+      }
+      break;
+    }
+#endif
+
     default:
       /* Common socket level options */
       return ci_set_sol_socket(netif, &us->s, optname, optval, optlen);
@@ -632,7 +690,32 @@ static int ci_udp_setsockopt_lk(citp_socket* ep, ci_fd_t fd, ci_fd_t os_sock,
 #endif
 
   } else if (level == IPPROTO_UDP) {
-    RET_WITH_ERRNO(ENOPROTOOPT);
+    switch(optname) {
+#ifdef UDP_SEGMENT
+    case UDP_SEGMENT:
+      if( (rc = opt_not_ok(optval, optlen, int)) )
+        goto fail_inval;
+      v = *(int*) optval;
+      if( v < 0 || v > 0xffff ) {
+        rc = -EINVAL;
+        goto fail_inval;
+      }
+      us->tx_gso_size = v;
+      break;
+#endif
+#ifdef UDP_GRO
+    case UDP_GRO:
+      if( (rc = opt_not_ok(optval, optlen, int)) )
+        goto fail_inval;
+      if( *(int*) optval )
+        us->s.cmsg_flags |= CI_UDP_CMSG_GRO;
+      else
+        us->s.cmsg_flags &= ~CI_UDP_CMSG_GRO;
+      break;
+#endif
+    default:
+      RET_WITH_ERRNO(ENOPROTOOPT);
+    }
   }
   else {
     LOG_U(log(FNS_FMT "unknown level=%d optname=%d accepted by O/S",
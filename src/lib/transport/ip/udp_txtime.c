@@ -0,0 +1,222 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/**************************************************************************\
+*//*! \file
+** <L5_PRIVATE L5_SOURCE>
+**  \brief  UDP SO_TXTIME: holding datagrams until their launch time
+** </L5_PRIVATE>
+*//*
+\**************************************************************************/
+
+/*! \cidoxg_lib_transport_ip */
+
+#include "ip_internal.h"
+#include <onload/sleep.h>
+
+
+#if OO_DO_STACK_POLL
+
+/* SO_TXTIME: a datagram is sent when its launch time is within half a
+ * timer tick.  Held datagrams are sent from the timer wheel, so they
+ * go out within half a tick either side of their launch time.
+ *
+ * Held datagrams are charged to [tx_count] just as those queued on the
+ * NIC are, so SO_SNDBUF bounds how much a socket can hold.  The charge is
+ * released when a held datagram is sent (and charged again as it goes to
+ * the NIC) or dropped.
+ */
+#define UDP_TXTIME_SLACK(ni)                                    \
+  (1ull << (IPTIMER_STATE(ni)->ci_ip_time_frc2tick - 1))
+
+enum {
+  UDP_TXTIME_SEND,
+  UDP_TXTIME_HOLD,
+  UDP_TXTIME_DROP,
+};
+
+
+/* SO_TXTIME: decide what to do with a datagram that is [late] cycles past
+ * its launch time (negative if the launch time is still to come).
+ */
+static int ci_udp_txtime_check(ci_netif* ni, ci_udp_state* us, ci_int64 late)
+{
+  if( us->txtime_flags & CI_UDP_TXTIME_DEADLINE_MODE )
+    /* The launch time is the latest time at which to send. */
+    return late > 0 ? UDP_TXTIME_DROP : UDP_TXTIME_SEND;
+
+  if( late > (ci_int64) oo_usec_to_cycles64(ni, CI_CFG_UDP_TXTIME_LATE_US) )
+    return UDP_TXTIME_DROP;
+  if( late < -(ci_int64) UDP_TXTIME_SLACK(ni) )
+    return UDP_TXTIME_HOLD;
+  if( late < 0 )
+    ++us->stats.n_tx_txtime_early;
+  else if( late > 0 )
+    ++us->stats.n_tx_txtime_late;
+  return UDP_TXTIME_SEND;
+}
+
+
+/* Arm [txtime_tid] to fire when the head of the held datagrams is due. */
+static void ci_udp_txtime_arm(ci_netif* ni, ci_udp_state* us)
+{
+  ci_ip_pkt_fmt* pkt = PKT_CHK(ni, us->txtime_head);
+  ci_iptime_t t = (pkt->tstamp_frc + UDP_TXTIME_SLACK(ni)) >>
+                  IPTIMER_STATE(ni)->ci_ip_time_frc2tick;
+
+  if( TIME_LE(t, ci_ip_time_now(ni)) )
+    t = ci_ip_time_now(ni) + 1;
+  if( ! ci_ip_timer_pending(ni, &us->txtime_tid) )
+    ci_ip_timer_set(ni, &us->txtime_tid, t);
+  else if( us->txtime_tid.time != t )
+    ci_ip_timer_modify(ni, &us->txtime_tid, t);
+}
+
+
+/* Send the held datagrams that are due, in launch time order, stopping at
+ * the first whose launch time is after [limit].  With [drop_all] every
+ * held datagram is dropped instead.
+ */
+static void ci_udp_txtime_send_due(ci_netif* ni, ci_udp_state* us,
+                                   ci_uint64 limit, int drop_all)
+{
+  ci_ip_pkt_fmt* pkt;
+  ci_uint64 now;
+  int verdict, level, n_dropped = 0;
+
+  ci_assert(ci_netif_is_locked(ni));
+
+  ci_frc64(&now);
+  while( OO_PP_NOT_NULL(us->txtime_head) ) {
+    pkt = PKT_CHK(ni, us->txtime_head);
+    if( drop_all ) {
+      verdict = UDP_TXTIME_DROP;
+    }
+    else {
+      if( (ci_int64) (pkt->tstamp_frc - limit) > 0 )
+        break;
+      verdict = ci_udp_txtime_check(ni, us, now - pkt->tstamp_frc);
+      if( verdict == UDP_TXTIME_HOLD )
+        break;
+    }
+
+    us->txtime_head = pkt->netif.tx.dmaq_next;
+    pkt->tstamp_frc = 0;
+    level = ci_udp_tx_datagram_level(ni, pkt, CI_TRUE);
+    ci_assert_ge((int) us->tx_count, level);
+    us->tx_count -= level;
+    if( verdict == UDP_TXTIME_SEND ) {
+      ci_udp_sendmsg_send_held(ni, us, pkt,
+                               (pkt->flags & CI_PKT_FLAG_MSG_CONFIRM) ?
+                               MSG_CONFIRM : 0);
+    }
+    else {
+      ++us->stats.n_tx_txtime_drop;
+      ++n_dropped;
+      ci_udp_fixup_pkt_not_transmitted(ni, pkt);
+    }
+    /* Drop the reference taken in ci_udp_txtime_hold(). */
+    ci_netif_pkt_release(ni, pkt);
+  }
+
+  /* A sender may be waiting for the space that dropped datagrams held. */
+  if( n_dropped && ci_udp_tx_advertise_space(us) &&
+      ! (us->s.b.sb_aflags & CI_SB_AFLAG_ORPHAN) )
+    ci_udp_wake_possibly_not_in_poll(ni, us, CI_SB_FLAG_WAKE_TX);
+
+  if( OO_PP_NOT_NULL(us->txtime_head) ) {
+    ci_udp_txtime_arm(ni, us);
+  }
+  else {
+    us->txtime_tail = OO_PP_NULL;
+    if( ci_ip_timer_pending(ni, &us->txtime_tid) )
+      ci_ip_timer_clear(ni, &us->txtime_tid);
+  }
+}
+
+
+/* Called from ci_udp_sendmsg_send() for a datagram with an SO_TXTIME
+ * launch time in [pkt->tstamp_frc].  Returns true if the datagram has
+ * been held until its launch time or dropped, or false if it should be
+ * sent now.
+ */
+int ci_udp_txtime_hold(ci_netif* ni, ci_udp_state* us,
+                       ci_ip_pkt_fmt* pkt, int flags)
+{
+  ci_uint64 now, launch = pkt->tstamp_frc;
+  ci_ip_pkt_fmt* prev;
+  oo_pkt_p pp;
+
+  ci_frc64(&now);
+
+  /* Anything held that launches no later than this datagram and is due
+   * goes first. */
+  if( OO_PP_NOT_NULL(us->txtime_head) )
+    ci_udp_txtime_send_due(ni, us, launch, 0);
+
+  switch( ci_udp_txtime_check(ni, us, now - launch) ) {
+  case UDP_TXTIME_SEND:
+    pkt->tstamp_frc = 0;
+    return 0;
+  case UDP_TXTIME_DROP:
+    ++us->stats.n_tx_txtime_drop;
+    ci_udp_fixup_pkt_not_transmitted(ni, pkt);
+    return 1;
+  }
+
+  if( flags & MSG_CONFIRM )
+    pkt->flags |= CI_PKT_FLAG_MSG_CONFIRM;
+  /* The caller releases its reference once we return. */
+  ci_netif_pkt_hold(ni, pkt);
+  us->tx_count += ci_udp_tx_datagram_level(ni, pkt, CI_TRUE);
+
+  if( OO_PP_IS_NULL(us->txtime_head) ) {
+    pkt->netif.tx.dmaq_next = OO_PP_NULL;
+    us->txtime_head = us->txtime_tail = OO_PKT_P(pkt);
+  }
+  else if( (ci_int64) (launch -
+                       PKT_CHK(ni, us->txtime_tail)->tstamp_frc) >= 0 ) {
+    /* Launch times are usually given in order. */
+    pkt->netif.tx.dmaq_next = OO_PP_NULL;
+    PKT_CHK(ni, us->txtime_tail)->netif.tx.dmaq_next = OO_PKT_P(pkt);
+    us->txtime_tail = OO_PKT_P(pkt);
+  }
+  else if( (ci_int64) (launch -
+                       PKT_CHK(ni, us->txtime_head)->tstamp_frc) < 0 ) {
+    pkt->netif.tx.dmaq_next = us->txtime_head;
+    us->txtime_head = OO_PKT_P(pkt);
+  }
+  else {
+    prev = PKT_CHK(ni, us->txtime_head);
+    for( pp = prev->netif.tx.dmaq_next; ; pp = prev->netif.tx.dmaq_next ) {
+      ci_assert(OO_PP_NOT_NULL(pp));
+      if( (ci_int64) (launch - PKT_CHK(ni, pp)->tstamp_frc) < 0 )
+        break;
+      prev = PKT_CHK(ni, pp);
+    }
+    pkt->netif.tx.dmaq_next = pp;
+    prev->netif.tx.dmaq_next = OO_PKT_P(pkt);
+  }
+
+  ci_udp_txtime_arm(ni, us);
+  return 1;
+}
+
+
+void ci_udp_timeout_txtime(ci_netif* ni, ci_udp_state* us)
+{
+  ci_uint64 now;
+  ci_frc64(&now);
+  ci_udp_txtime_send_due(ni, us, now + UDP_TXTIME_SLACK(ni), 0);
+}
+
+
+/* Drop all held datagrams.  Used when the socket is closed: those that
+ * are not yet due would otherwise go early, and an orphaned socket cannot
+ * keep them until their launch times.  Each counts in [n_tx_txtime_drop].
+ */
+void ci_udp_txtime_flush(ci_netif* ni, ci_udp_state* us)
+{
+  ci_udp_txtime_send_due(ni, us, 0, 1);
+}
+
+#endif
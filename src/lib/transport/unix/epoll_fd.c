@@ -67,6 +67,15 @@ epoll+exec() in LKML: http://www.mail-archive.com/search?q=epoll (exec OR
 shared)&l=linux-kernel@vger.kernel.org
 
 
+epoll_pwait() and epoll_pwait2()
+================================
+Both go through citp_epoll_wait() with the sigmask.  The mask is only
+installed while we spin (citp_ul_pwait_spin_pre()), so signals arriving
+meanwhile are deferred and reported as EINTR; when blocking, the kernel
+installs it.  The timespec timeout of epoll_pwait2() is converted to
+timeout_hr without rounding, and when we pass through to the kernel epoll
+fd we use epoll_pwait2() too, if libc and the kernel have it.
+
 
 Missing features:
 
@@ -75,10 +84,6 @@ exec()
 Restore onload epoll fd after exec.  Currently, we get kernel epoll fd
 in the exec'ed app.
 
-epoll_pwait()
-=============
-epoll_pwait(), ppoll() and pselect() are not accelerated.
-
 multi-level poll
 ================
 If an application uses poll/epoll/select on onload epoll fd, we can
@@ -651,6 +656,9 @@ int citp_epoll_create(int size, int flags)
   ep->avoid_spin_once = 0;
   ep->closing = 0;
   ep->phase = 0;
+  ep->os_poll_frc = 0;
+  ep->wake_one = CITP_OPTS.ul_epoll_wake_one;
+  ep->spinner = 0;
   citp_fdtable_insert(fdi, fd, 0);
   Log_POLL(ci_log("%s: fd=%d driver_fd=%d epfd=%d", __FUNCTION__,
                   fd, ep->epfd_os, (int) ep->shared->epfd));
@@ -1122,6 +1130,23 @@ static int citp_epoll_ctl_onload2(struct citp_epoll_fd* ep, int op,
   int sync_kernel, rc = 0;
   int sync_op = op;
   int type = citp_epoll_find(ep, fd_fdi, &eitem, epoll_fd);
+  struct epoll_event ex_event;
+  int exclusive = 0;
+
+  /* EPOLLEXCLUSIVE is checked as the kernel does, and makes waiters on
+   * this set wake one at a time.  It is not passed on to the kernel epoll
+   * set, which would refuse to sync later changes to the member. */
+  if( event != NULL && (event->events & EPOLLEXCLUSIVE) ) {
+    if( op != EPOLL_CTL_ADD ||
+        (event->events & ~OO_EPOLL_EXCLUSIVE_OK_EVENTS) ) {
+      errno = EINVAL;
+      return -1;
+    }
+    ex_event = *event;
+    ex_event.events &= ~EPOLLEXCLUSIVE;
+    event = &ex_event;
+    exclusive = 1;
+  }
 
   /* Should we sync this op to the kernel?
    *
@@ -1143,8 +1168,22 @@ static int citp_epoll_ctl_onload2(struct citp_epoll_fd* ep, int op,
   case EPOLL_CTL_ADD:
     rc = citp_epoll_ctl_onload_add(&eitem, ep, fd_fdi, &sync_kernel, &sync_op,
                                    event, epoll_fd, epoll_fd_seq);
+    if( rc == 0 ) {
+      if( exclusive ) {
+        eitem->flags |= CITP_EITEM_FLAG_EXCLUSIVE;
+        ep->wake_one = 1;
+      }
+      else {
+        eitem->flags &= ~CITP_EITEM_FLAG_EXCLUSIVE;
+      }
+    }
     break;
   case EPOLL_CTL_MOD:
+    if( eitem != NULL && (eitem->flags & CITP_EITEM_FLAG_EXCLUSIVE) ) {
+      errno = EINVAL;
+      rc = -1;
+      break;
+    }
     rc = citp_epoll_ctl_onload_mod(eitem, ep, &sync_kernel, &sync_op, event,
                                    fd_fdi);
     break;
@@ -1353,6 +1392,8 @@ static int citp_epoll_ctl_os(citp_fdinfo* fdi, int op, int fd,
   rc = ci_sys_ioctl(ep->epfd_os, OO_EPOLL1_IOC_CTL, &oop);
   Log_POLL(ci_log("%s("EPOLL_CTL_FMT"): rc=%d errno=%d", __FUNCTION__,
                   EPOLL_CTL_ARGS(fdi->fd, op, fd, event), rc, errno));
+  if( rc == 0 && op == EPOLL_CTL_ADD && (event->events & EPOLLEXCLUSIVE) )
+    ep->wake_one = 1;
   return rc;
 }
 
@@ -1698,6 +1739,26 @@ static void citp_epoll_poll_ul(struct oo_ul_epoll_state*__restrict__ eps)
 }
 
 
+/* Should we fetch events from the kernel fds now?  The epoll device sets
+ * OO_EPOLL1_FLAG_EVENT when one of them changes state, and
+ * OO_EPOLL1_FLAG_LT when level-triggered ones were still ready after we
+ * last fetched events.  The latter can wait for EF_EPOLL_OS_LT_USEC if we
+ * have accelerated events to return anyway.
+ */
+ci_inline int citp_epoll_os_pending(struct citp_epoll_fd* ep,
+                                    ci_uint64 now_frc, int have_events)
+{
+  ci_uint32 flag = OO_ACCESS_ONCE(ep->shared->flag);
+
+  if( flag & OO_EPOLL1_FLAG_EVENT )
+    return 1;
+  if( flag & OO_EPOLL1_FLAG_LT )
+    return ! have_events ||
+           now_frc - ep->os_poll_frc >= citp.epoll_os_lt_cycles;
+  return 0;
+}
+
+
 ci_inline int citp_epoll_os_fds(citp_epoll_fdi *efdi,
                                 struct epoll_event* events,
                                 struct citp_ordering_info* ordering_info,
@@ -1709,11 +1770,13 @@ ci_inline int citp_epoll_os_fds(citp_epoll_fdi *efdi,
 
   ci_assert(__oo_per_thread_get()->sig.c.inside_lib);
 
-  if( (ep->shared->flag & OO_EPOLL1_FLAG_EVENT) == 0 )
+  if( (ep->shared->flag & (OO_EPOLL1_FLAG_EVENT | OO_EPOLL1_FLAG_LT)) == 0 )
     return 0;
 
   Log_VVPOLL(ci_log("%s(%d): poll os fds", __FUNCTION__, efdi->fdinfo.fd));
 
+  ci_frc64(&ep->os_poll_frc);
+
   op.epfd = efdi->fdinfo.fd;
   op.maxevents = maxevents;
   CI_USER_PTR_SET(op.events, events);
@@ -1752,6 +1815,16 @@ static int timeout_hr_to_ms(ci_int64 hr)
 }
 
 
+#if CI_LIBC_HAS_epoll_pwait2
+static void timeout_hr_to_ts(ci_int64 hr, struct timespec* ts)
+{
+  ci_uint64 khz = citp.cpu_khz;
+  ts->tv_sec = hr / (khz * 1000);
+  ts->tv_nsec = (hr % (khz * 1000)) * 1000000 / khz;
+}
+#endif
+
+
 static ci_uint64 timeout_hr_to_us(ci_int64 hr)
 {
   ci_assert_ge(hr, 0);
@@ -1764,6 +1837,32 @@ static ci_uint64 timeout_hr_to_us(ci_int64 hr)
 }
 
 
+/* Waits on the kernel epoll fd.  Timeouts with a sub-millisecond part
+ * would be rounded up by epoll_wait(), so use epoll_pwait2() for those. */
+static int citp_epoll_sys_wait(int epfd, struct epoll_event* events,
+                               int maxevents, ci_int64 timeout_hr,
+                               const sigset_t* sigmask)
+{
+  int timeout_ms = timeout_hr_to_ms(timeout_hr);
+
+#if CI_LIBC_HAS_epoll_pwait2
+  if( timeout_hr > 0 && timeout_hr < OO_EPOLL_MAX_TIMEOUT_HR &&
+      timeout_hr % citp.cpu_khz != 0 ) {
+    struct timespec ts;
+    int rc;
+
+    timeout_hr_to_ts(timeout_hr, &ts);
+    rc = ci_sys_epoll_pwait2(epfd, events, maxevents, &ts, sigmask);
+    if( rc >= 0 || errno != ENOSYS )
+      return rc;
+  }
+#endif
+  if( sigmask != NULL )
+    return ci_sys_epoll_pwait(epfd, events, maxevents, timeout_ms, sigmask);
+  return ci_sys_epoll_wait(epfd, events, maxevents, timeout_ms);
+}
+
+
 /* Synchronise state to kernel if:
    - EF_EPOLL_CTL_FAST=0;
    - or we are going to block (timeout != 0 && rc == 0) */
@@ -1789,6 +1888,7 @@ int citp_epoll_wait(citp_fdinfo* fdi, struct epoll_event*__restrict__ events,
   sigset_t sigsaved;
   int pwait_was_spinning = 0;
   int have_spin = 0;
+  int have_spin_token = 0;
 
   ci_assert_ge(timeout_hr, 0);
   ci_assert_le(timeout_hr, OO_EPOLL_MAX_TIMEOUT_HR);
@@ -1823,18 +1923,14 @@ int citp_epoll_wait(citp_fdinfo* fdi, struct epoll_event*__restrict__ events,
        ci_dllist_is_empty(&ep->oo_sockets)) ||
       maxevents <= 0 || events == NULL ) {
     /* No accelerated fds or invalid parameters). */
-    int timeout_ms = timeout_hr_to_ms(timeout_hr);
     if( ep->epfd_syncs_needed )
       citp_ul_epoll_ctl_sync(ep, fdi->fd);
     CITP_EPOLL_EP_UNLOCK(ep, 0);
     citp_exit_lib(lib_context, FALSE);
-    if( timeout_ms )
+    if( timeout_hr )
       ep->blocking = 1;
     Log_VPOLL(ci_log("%s(%d, ..): passthrough", __FUNCTION__, fdi->fd));
-    if( sigmask != NULL )
-      rc = ci_sys_epoll_pwait(fdi->fd, events, maxevents, timeout_ms, sigmask);
-    else
-      rc = ci_sys_epoll_wait(fdi->fd, events, maxevents, timeout_ms);
+    rc = citp_epoll_sys_wait(fdi->fd, events, maxevents, timeout_hr, sigmask);
 
     /* We don't have valid timestamps for events grabbed via the kernel, so
      * we need to ensure that the ordering info shows that.
@@ -1900,7 +1996,8 @@ int citp_epoll_wait(citp_fdinfo* fdi, struct epoll_event*__restrict__ events,
     }
     if( eps.phase & EPOLL_PHASE_DONE_OTHER ) {
       /* Time for os socket priority round */
-      if(CI_UNLIKELY( ep->shared->flag & OO_EPOLL1_FLAG_EVENT )) {
+      if(CI_UNLIKELY( citp_epoll_os_pending(ep, eps.this_poll_frc,
+                                            rc > 0) )) {
         rc_os = citp_epoll_os_fds(fdi_to_epoll_fdi(fdi),
                                   events + rc,
                                   ordering ? ordering->ordering_info+rc : NULL,
@@ -1967,7 +2064,7 @@ int citp_epoll_wait(citp_fdinfo* fdi, struct epoll_event*__restrict__ events,
     rc = eps.events - events;
     ci_assert_le(rc, maxevents);
     ci_assert_impl(rc < maxevents, eps.phase & EPOLL_PHASE_DONE_OTHER);
-    if(CI_UNLIKELY( ep->shared->flag & OO_EPOLL1_FLAG_EVENT )) {
+    if(CI_UNLIKELY( citp_epoll_os_pending(ep, eps.this_poll_frc, 1) )) {
       if(CI_LIKELY( rc < maxevents )) {
         rc_os = citp_epoll_os_fds(fdi_to_epoll_fdi(fdi),
                                   events + rc,
@@ -2008,7 +2105,14 @@ no_events:
     goto unlock_release_exit_ret;
   }
 
-  /* Blocking.  Shall we spin? */
+  /* Blocking.  Shall we spin?  With wake-one, only one thread spins on the
+   * set, and the others block until an event wakes one of them. */
+  if( ep->wake_one && eps.ul_epoll_spin && ! have_spin_token ) {
+    if( ci_cas32u_fail(&ep->spinner, 0, 1) )
+      eps.ul_epoll_spin = 0;
+    else
+      have_spin_token = 1;
+  }
   if( KEEP_POLLING(eps.ul_epoll_spin, eps.this_poll_frc, base_poll_start_frc) ) {
     if( !pwait_was_spinning && sigmask != NULL) {
       if( ep->avoid_spin_once ) {
@@ -2018,6 +2122,8 @@ no_events:
       }
       rc = citp_ul_pwait_spin_pre(lib_context, sigmask, &sigsaved);
       if( rc != 0 ) {
+        if( have_spin_token )
+          ep->spinner = 0;
         CITP_EPOLL_EP_UNLOCK(ep, 0);
         citp_exit_lib(lib_context, CI_FALSE);
         return rc;
@@ -2088,6 +2194,9 @@ no_events:
   }
 
  unlock_release_exit_ret:
+  if( have_spin_token )
+    ep->spinner = 0;
+
   /* Synchronise state to kernel (if necessary) and block. */
   citp_epoll_ctl_try_sync(ep, fdi, timeout_hr, rc);
 
@@ -2131,10 +2240,10 @@ no_events:
   {
     struct oo_epoll1_block_on_arg op;
 
-    op.flags = 0;
+    op.flags = ep->wake_one ? OO_EPOLL1_WAKE_ONE : 0;
     op.epoll_fd = fdi->fd;
     if( sigmask != NULL ) {
-      op.flags = OO_EPOLL1_HAS_SIGMASK;
+      op.flags |= OO_EPOLL1_HAS_SIGMASK;
       op.sigmask = *(ci_uint64*)sigmask;
     }
    block_again:
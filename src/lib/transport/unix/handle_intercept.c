@@ -0,0 +1,315 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Implementation of the onload_h_* handle-based socket API.
+ *
+ * These do what citp_tcp_send(), citp_udp_recv() and friends do once the
+ * intercept has found the fdinfo, but with the fdinfo already in hand.
+ */
+
+#include "internal.h"
+#include "ul_poll.h"
+#include <onload/tcp_poll.h>
+#include <onload/extensions.h>
+#include <onload/extensions_handle.h>
+
+
+struct onload_h_sock {
+  /* Holds a reference */
+  citp_fdinfo* fdi;
+  citp_socket* ep;
+  int fd;
+  int is_tcp;
+};
+
+
+ci_inline int h_is_stale(onload_h h)
+{
+  /* Closed or handed over since the handle was opened */
+  return h->fdi->on_ref_count_zero != FDI_ON_RCZ_NONE;
+}
+
+
+ci_inline void h_udp_args(onload_h h, ci_udp_iomsg_args* a)
+{
+  a->fd = h->fd;
+  a->ep = h->ep;
+  a->ni = h->ep->netif;
+  a->us = SOCK_TO_UDP(h->ep->s);
+}
+
+
+static int h_tcp_sendmsg(onload_h h, const struct msghdr* msg, int flags)
+{
+  ci_sock_cmn* s = h->ep->s;
+  ci_uint32 state;
+  int rc;
+
+  if( s->b.sb_aflags & (CI_SB_AFLAG_O_NONBLOCK | CI_SB_AFLAG_O_NDELAY) )
+    flags |= MSG_DONTWAIT;
+
+  if( msg->msg_iovlen == 0 ) {
+    if( s->tx_errno )
+      return -s->tx_errno;
+    return 0;
+  }
+
+  state = OO_ACCESS_ONCE(s->b.state);
+  if( CI_UNLIKELY(state == CI_TCP_CLOSED || state == CI_TCP_LISTEN ||
+                  state == CI_TCP_INVALID) ) {
+    if( (rc = ci_get_so_error(s)) == 0 )
+      rc = EPIPE;
+    rc = -rc;
+  }
+  else {
+    rc = ci_tcp_sendmsg(h->ep->netif, SOCK_TO_TCP(s),
+                        msg->msg_iov, msg->msg_iovlen, flags);
+    if( rc < 0 )
+      rc = -errno;
+  }
+
+  if( rc == -EPIPE && ! (flags & MSG_NOSIGNAL) )
+    oo_resource_op(ci_netif_get_driver_handle(h->ep->netif),
+                   OO_IOC_KILL_SELF_SIGPIPE, NULL);
+  return rc;
+}
+
+
+static int h_tcp_recvmsg(onload_h h, struct msghdr* msg, int flags)
+{
+  ci_sock_cmn* s = h->ep->s;
+  ci_tcp_recvmsg_args a;
+  int rc;
+
+  if( s->b.sb_aflags & (CI_SB_AFLAG_O_NONBLOCK | CI_SB_AFLAG_O_NDELAY) )
+    flags |= MSG_DONTWAIT;
+
+  if( s->b.state == CI_TCP_LISTEN )
+    return -SOCK_RX_ERRNO(s);
+  if( (flags & (MSG_WAITALL | ONLOAD_MSG_ONEPKT)) ==
+      (MSG_WAITALL | ONLOAD_MSG_ONEPKT) )
+    return -EINVAL;
+  if( (msg->msg_iovlen == 0 || msg->msg_iov == NULL) &&
+      ! (flags & MSG_ERRQUEUE) ) {
+    msg->msg_flags = 0;
+    msg->msg_controllen = 0;
+    return 0;
+  }
+
+  ci_tcp_recvmsg_args_init(&a, h->ep->netif, SOCK_TO_TCP(s), msg, flags);
+  rc = ci_tcp_recvmsg(&a);
+  return rc < 0 ? -errno : rc;
+}
+
+
+static ssize_t h_sendmsg(onload_h h, const struct msghdr* msg, int flags)
+{
+  citp_lib_context_t lib_context;
+  ci_udp_iomsg_args a;
+  int rc;
+
+  if( CI_UNLIKELY(h_is_stale(h)) )
+    return -EBADF;
+
+  citp_enter_lib(&lib_context);
+  if( h->is_tcp ) {
+    rc = h_tcp_sendmsg(h, msg, flags);
+  }
+  else {
+    h_udp_args(h, &a);
+    rc = ci_udp_sendmsg(&a, msg, flags);
+    if( rc < 0 )
+      rc = -errno;
+  }
+  citp_exit_lib(&lib_context, TRUE);
+  return rc;
+}
+
+
+static ssize_t h_recvmsg(onload_h h, struct msghdr* msg, int flags)
+{
+  citp_lib_context_t lib_context;
+  ci_udp_iomsg_args a;
+  int rc;
+
+  if( CI_UNLIKELY(h_is_stale(h)) )
+    return -EBADF;
+
+  citp_enter_lib(&lib_context);
+  if( h->is_tcp ) {
+    rc = h_tcp_recvmsg(h, msg, flags);
+  }
+  else {
+    h_udp_args(h, &a);
+    rc = ci_udp_recvmsg(&a, msg, flags);
+    if( rc < 0 )
+      rc = -errno;
+  }
+  citp_exit_lib(&lib_context, TRUE);
+  return rc;
+}
+
+
+int onload_h_open(int fd, onload_h* h_out)
+{
+  citp_lib_context_t lib_context;
+  citp_fdinfo* fdi;
+  onload_h h;
+  int rc = 0;
+
+  Log_CALL(ci_log("%s(%d, %p)", __FUNCTION__, fd, h_out));
+
+  citp_enter_lib(&lib_context);
+  fdi = citp_fdtable_lookup(fd);
+  if( fdi == NULL ) {
+    rc = -ESOCKTNOSUPPORT;
+    goto out;
+  }
+  if( citp_fdinfo_get_type(fdi) != CITP_TCP_SOCKET &&
+      citp_fdinfo_get_type(fdi) != CITP_UDP_SOCKET ) {
+    rc = -ESOCKTNOSUPPORT;
+    goto out_release;
+  }
+  if( (h = malloc(sizeof(*h))) == NULL ) {
+    rc = -ENOMEM;
+    goto out_release;
+  }
+
+  h->fdi = fdi;
+  h->ep = &fdi_to_sock_fdi(fdi)->sock;
+  h->fd = fd;
+  h->is_tcp = citp_fdinfo_get_type(fdi) == CITP_TCP_SOCKET;
+  *h_out = h;
+  goto out;
+
+ out_release:
+  citp_fdinfo_release_ref(fdi, 0);
+ out:
+  citp_exit_lib(&lib_context, TRUE);
+  Log_CALL_RESULT(rc);
+  return rc;
+}
+
+
+int onload_h_close(onload_h h)
+{
+  citp_lib_context_t lib_context;
+
+  Log_CALL(ci_log("%s(%p)", __FUNCTION__, h));
+
+  citp_enter_lib(&lib_context);
+  citp_fdinfo_release_ref(h->fdi, 0);
+  citp_exit_lib(&lib_context, TRUE);
+  free(h);
+  return 0;
+}
+
+
+ssize_t onload_h_send(onload_h h, const void* buf, size_t len, int flags)
+{
+  struct iovec iov = { .iov_base = (void*) buf, .iov_len = len };
+  struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+
+  return h_sendmsg(h, &msg, flags);
+}
+
+
+ssize_t onload_h_sendmsg(onload_h h, const struct msghdr* msg, int flags)
+{
+  if( msg->msg_iov == NULL && msg->msg_iovlen != 0 )
+    return -EFAULT;
+  return h_sendmsg(h, msg, flags);
+}
+
+
+ssize_t onload_h_recv(onload_h h, void* buf, size_t len, int flags)
+{
+  struct iovec iov = { .iov_base = buf, .iov_len = len };
+  struct msghdr msg = { .msg_iov = &iov, .msg_iovlen = 1 };
+
+  return h_recvmsg(h, &msg, flags);
+}
+
+
+ssize_t onload_h_recvmsg(onload_h h, struct msghdr* msg, int flags)
+{
+  if( msg->msg_iov == NULL && msg->msg_iovlen != 0 )
+    return -EFAULT;
+  return h_recvmsg(h, msg, flags);
+}
+
+
+/* Blocks in poll() on the handle's fd for up to [timeout_ms].  Returns as
+ * poll() does.
+ */
+static int h_block(onload_h h, short events, citp_lib_context_t* lib_context,
+                   int timeout_ms)
+{
+  struct pollfd pfd = { .fd = h->fd, .events = events, .revents = 0 };
+  int rc, saved_errno;
+
+  citp_exit_lib(lib_context, TRUE);
+  rc = ci_sys_poll(&pfd, 1, timeout_ms);
+  saved_errno = errno;
+  citp_reenter_lib(lib_context);
+  errno = saved_errno;
+  return rc;
+}
+
+
+int onload_h_poll(onload_h h, short events, int timeout_ms)
+{
+  citp_lib_context_t lib_context;
+  ci_netif* ni = h->ep->netif;
+  ci_uint64 start_frc, now_frc, max_cycles = 0;
+  unsigned revents;
+  int rc, spin, block_ms;
+
+  if( CI_UNLIKELY(h_is_stale(h)) )
+    return -EBADF;
+
+  citp_enter_lib(&lib_context);
+  events |= POLLERR | POLLHUP;
+  ci_frc64(&start_frc);
+  if( timeout_ms > 0 )
+    max_cycles = (ci_uint64) timeout_ms * IPTIMER_STATE(ni)->khz;
+  spin = oo_per_thread_get()->spinstate & (1 << ONLOAD_SPIN_POLL);
+
+  while( 1 ) {
+    if( ci_netif_may_poll(ni) && ci_netif_need_poll(ni) &&
+        ci_netif_trylock(ni) ) {
+      ci_netif_poll(ni);
+      ci_netif_unlock(ni);
+    }
+    if( h->is_tcp )
+      revents = ci_tcp_poll_events(ni, h->ep->s);
+    else
+      revents = ci_udp_poll_events(ni, SOCK_TO_UDP(h->ep->s));
+    rc = revents & events;
+    if( rc != 0 || timeout_ms == 0 )
+      break;
+    ci_frc64(&now_frc);
+    if( timeout_ms > 0 && now_frc - start_frc >= max_cycles )
+      break;
+    if(CI_UNLIKELY( lib_context.thread->sig.c.aflags &
+                    OO_SIGNAL_FLAG_HAVE_PENDING )) {
+      rc = -EINTR;
+      break;
+    }
+    if( KEEP_POLLING(spin, now_frc, start_frc) )
+      continue;
+
+    /* Events are read back from the stack on the next pass, which also
+     * covers a timeout that expires while blocked. */
+    block_ms = -1;
+    if( timeout_ms > 0 )
+      block_ms = timeout_ms - (now_frc - start_frc) / IPTIMER_STATE(ni)->khz;
+    if( h_block(h, events, &lib_context, block_ms) < 0 ) {
+      rc = -errno;
+      break;
+    }
+  }
+
+  citp_exit_lib(&lib_context, TRUE);
+  return rc;
+}
@@ -62,6 +62,7 @@ typedef struct {
   ci_uint64             poll_fast_cycles;
   ci_uint64             select_nonblock_fast_cycles;
   ci_uint64             select_fast_cycles;
+  ci_uint64             epoll_os_lt_cycles;
   ci_uint32             cpu_khz;
 
   enum {
@@ -988,21 +989,21 @@ extern int citp_sock_fcntl(citp_sock_fdi*, int fd, int cmd, long arg) CI_HF;
 /* Generic poll/ppoll implementation.
  * This function is called after citp_enter_lib(), and it MUST NOT call
  * citp_exit_lib().
- * At exit time, if *timeout_ms!=0 and rc==0, caller should block in system
- * call for the specified timeout.
+ * Timeouts are in cycles.  At exit time, if *used_frc<timeout_frc and
+ * rc==0, caller should block in system call for the rest of the timeout.
  */
 int citp_ul_do_poll(struct pollfd*__restrict__ fds, nfds_t nfds,
-                    ci_uint64 timeout_ms, ci_uint64 *used_ms,
+                    ci_uint64 timeout_frc, ci_uint64 *used_frc,
                     citp_lib_context_t *lib_context,
                     const sigset_t *sigmask);
 /* Generic select/pselect implementation.
  * This function is called after citp_enter_lib(), and it MUST NOT call
  * citp_exit_lib().
- * At exit time, if *timeout_ms!=0 and rc==0, caller should block in system
- * call for the specified timeout.
+ * Timeouts are in cycles.  At exit time, if rc==CI_SOCKET_HANDOVER, caller
+ * should block in system call for the rest of the timeout.
  */
 int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
-                      ci_uint64 timeout_ms, ci_uint64 *used_ms,
+                      ci_uint64 timeout_frc, ci_uint64 *used_frc,
                       citp_lib_context_t *lib_context,
                       const sigset_t *sigmask);
 
@@ -1128,15 +1129,26 @@ extern int citp_sock_is_spinning(citp_fdinfo* fdi);
 /**********************************************************************
  * Utils
  */
+/* Sets [left] to what remains of [timeout] after [spent_frc] cycles. */
 ci_inline void
-ms2timespec(ci_uint64 timeout, ci_uint64 spent, struct timespec* tv)
+timespec_left(const struct timespec* timeout, ci_uint64 spent_frc,
+              struct timespec* left)
 {
-  if( timeout > spent ) {
-    tv->tv_sec = (timeout - spent) / 1000;
-    tv->tv_nsec = ((timeout - spent) % 1000) * 1000000;
+  ci_uint64 khz = citp.cpu_khz;
+  ci_uint64 sec = spent_frc / (khz * 1000);
+  long nsec = (spent_frc % (khz * 1000)) * 1000000 / khz;
+
+  if( (ci_uint64) timeout->tv_sec < sec ||
+      ((ci_uint64) timeout->tv_sec == sec && timeout->tv_nsec <= nsec) ) {
+    left->tv_sec = left->tv_nsec = 0;
+  }
+  else if( timeout->tv_nsec >= nsec ) {
+    left->tv_sec = timeout->tv_sec - sec;
+    left->tv_nsec = timeout->tv_nsec - nsec;
   }
   else {
-    tv->tv_sec = tv->tv_nsec = 0;
+    left->tv_sec = timeout->tv_sec - sec - 1;
+    left->tv_nsec = timeout->tv_nsec + 1000000000 - nsec;
   }
 }
 
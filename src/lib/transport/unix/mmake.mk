@@ -25,6 +25,8 @@ LIB_SRCS	:=			\
 		onload_ext_intercept.c	\
 		zc_intercept.c          \
 		zc_hlrx.c          \
+		ring_intercept.c	\
+		handle_intercept.c	\
 		tmpl_intercept.c	\
 		stackname.c		\
 		stackopt.c		\
@@ -533,6 +533,59 @@ fail:
 
 
 
+int onload_set_recv_arbitration(int fd, const struct onload_recv_arb* arb)
+{
+  citp_lib_context_t lib_context;
+  citp_fdinfo* fdi;
+  citp_sock_fdi* sock_epi;
+  ci_udp_state* us;
+  int rc = -1;
+
+  Log_CALL(ci_log("%s(%d, %p)", __FUNCTION__, fd, arb));
+
+  citp_enter_lib(&lib_context);
+  fdi = citp_fdtable_lookup(fd);
+  if( fdi == NULL ) {
+    errno = EBADF;
+    goto out;
+  }
+  if( citp_fdinfo_get_type(fdi) != CITP_UDP_SOCKET )
+    goto fail;
+  if( arb != NULL &&
+      ((arb->seq_len != 2 && arb->seq_len != 4 && arb->seq_len != 8) ||
+       (arb->flags & ~ONLOAD_RECV_ARB_LITTLE_ENDIAN)) )
+    goto fail;
+  sock_epi = fdi_to_sock_fdi(fdi);
+  us = SOCK_TO_UDP(sock_epi->sock.s);
+
+  ci_netif_lock(sock_epi->sock.netif);
+  if( arb != NULL ) {
+    us->arb_seq_offset = arb->seq_offset;
+    us->arb_seq_len = arb->seq_len;
+    us->arb_flags = (arb->flags & ONLOAD_RECV_ARB_LITTLE_ENDIAN) ?
+                    CI_UDP_ARB_LITTLE_ENDIAN : 0;
+  }
+  else {
+    us->arb_seq_len = 0;
+  }
+  us->arb_last = 0;
+  us->arb_window = 0;
+  ci_netif_unlock(sock_epi->sock.netif);
+
+  rc = 0;
+  goto out;
+
+fail:
+  errno = EINVAL;
+ out:
+  if( fdi != NULL )
+    citp_fdinfo_release_ref(fdi, 0);
+  citp_exit_lib(&lib_context, FALSE);
+  Log_CALL_RESULT(rc);
+  return rc;
+}
+
+
 int onload_socket_nonaccel(int domain, int type, int protocol)
 {
   return ci_sys_socket(domain, type, protocol);
@@ -119,10 +119,11 @@ static int ci_format_select(char* s, int len_s, int nfds,
 
 static inline void log_select(const char* msg, int nfds,
                               fd_set* rds, fd_set* wrs, fd_set* exs,
-                              int timeout)
+                              ci_uint64 timeout_frc)
 {
   char s[1024];
-  ci_format_select(s, sizeof(s), nfds, rds, wrs, exs, timeout);
+  ci_format_select(s, sizeof(s), nfds, rds, wrs, exs,
+                   (int) (timeout_frc / citp.cpu_khz));
   ci_log("select[%s]%s", msg, s);
 }
 
@@ -227,7 +228,7 @@ ci_inline int citp_ul_select(struct oo_ul_select_state*__restrict__ s)
 
 /* Generic select/pselect implementation. */
 int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
-                      ci_uint64 timeout_ms, ci_uint64 *used_ms,
+                      ci_uint64 timeout_frc, ci_uint64 *used_frc,
                       citp_lib_context_t *lib_context,
                       const sigset_t *sigmask)
 {
@@ -249,7 +250,7 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
   sigset_t sigsaved;
 
   Log_FL(CI_UL_LOG_CALL | CI_UL_LOG_SEL,
-         log_select("enter", nfds, rds, wrs, exs, timeout_ms));
+         log_select("enter", nfds, rds, wrs, exs, timeout_frc));
 
   /* Cope with some apps just passing a really big number in [nfds]
   ** Split between ul/kern and kern only handling at nfds_split
@@ -347,17 +348,17 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
     }
 
     /* We spin for a while if we've got any U/L sockets. */
-    if( timeout_ms != 0 ) {
+    if( timeout_frc != 0 ) {
       if( s.is_ul_fd && 
           KEEP_POLLING(s.ul_select_spin, s.now_frc, poll_start_frc) ) {
 
-        if( s.now_frc - poll_start_frc >= timeout_ms * citp.cpu_khz ) {
+        if( s.now_frc - poll_start_frc >= timeout_frc ) {
           /* Timeout while spinning */
           select_zero(rds, wrs, exs, n_words);
           n = 0;
-          *used_ms = timeout_ms;
+          *used_frc = timeout_frc;
           Log_SEL(log_select("spin_timeout", nfds, rds, wrs, exs,
-                             timeout_ms));
+                             timeout_frc));
           goto out;
         }
    
@@ -425,7 +426,7 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
         s.now_frc - lib_context->thread->select_nonblock_fast_frc <
             citp.select_nonblock_fast_cycles ) {
       select_zero(rds, wrs, exs, n_words);
-      Log_SEL(log_select("ul_only_nonb_0", nfds, rds, wrs, exs, timeout_ms));
+      Log_SEL(log_select("ul_only_nonb_0", nfds, rds, wrs, exs, timeout_frc));
       n = 0;
       goto out;
     }
@@ -491,7 +492,7 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
           if (split)
             memcpy((char *)exs+n_bytes_bs, (char *)s.exk+n_bytes_bs, n_bytes_as);
         }
-        Log_SEL(log_select("merge_out", nfds, rds, wrs, exs, timeout_ms));
+        Log_SEL(log_select("merge_out", nfds, rds, wrs, exs, timeout_frc));
         goto out;
       }
       else
@@ -512,12 +513,12 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
       memcpy(exs, s.exu, n_bytes_bs);
       if (split) memset((char *)exs+n_bytes_bs, 0, n_bytes_as);
     }
-    Log_SEL(log_select("ul_out", nfds, rds, wrs, exs, timeout_ms));
+    Log_SEL(log_select("ul_out", nfds, rds, wrs, exs, timeout_frc));
   } /* End of block that declares [bits]. */
 
  out:
   /* Calculate new timeout */
-  *used_ms = (s.now_frc - poll_start_frc) / citp.cpu_khz;
+  *used_frc = s.now_frc - poll_start_frc;
 
   /* Exit library, and protect signals if necessary */
   if( sigmask_set ) {
@@ -529,7 +530,7 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
     citp_exit_lib(lib_context, n >= 0);
 
   if( n == CI_SOCKET_HANDOVER )
-    Log_SEL(log_select("pass_through", nfds, rds, wrs, exs, timeout_ms));
+    Log_SEL(log_select("pass_through", nfds, rds, wrs, exs, timeout_frc));
 
   return n;
 
@@ -538,7 +539,7 @@ int citp_ul_do_select(int nfds, fd_set* rds, fd_set* wrs, fd_set* exs,
   if( rds )  memcpy(rds, s.rdk, n_words * sizeof(ci_fd_mask));
   if( wrs )  memcpy(wrs, s.wrk, n_words * sizeof(ci_fd_mask));
   if( exs )  memcpy(exs, s.exk, n_words * sizeof(ci_fd_mask));
-  Log_SEL(log_select("k_out", nfds, rds, wrs, exs, timeout_ms));
+  Log_SEL(log_select("k_out", nfds, rds, wrs, exs, timeout_frc));
   goto out;
 }
 
@@ -633,7 +634,7 @@ static void citp_ul_poll_merge_kfds(struct oo_ul_poll_state*__restrict__ ps)
 
 /* Generic poll/ppoll implementation. */
 int citp_ul_do_poll(struct pollfd*__restrict__ fds, nfds_t nfds,
-                    ci_uint64 timeout_ms, ci_uint64 *used_ms,
+                    ci_uint64 timeout_frc, ci_uint64 *used_frc,
                     citp_lib_context_t *lib_context,
                     const sigset_t *sigmask)
 {
@@ -675,22 +676,21 @@ int citp_ul_do_poll(struct pollfd*__restrict__ fds, nfds_t nfds,
   /* Prioritise ul fds over kernel fds and keep semantics of only
    * kernel fds in poll set same as not using onload
    */
-  if( ps.n_ul_fds != 0 && timeout_ms == 0 &&
+  if( ps.n_ul_fds != 0 && timeout_frc == 0 &&
       ps.this_poll_frc - lib_context->thread->poll_nonblock_fast_frc < 
       citp.poll_nonblock_fast_cycles)
     goto out;
 
   if( ps.n_ul_fds != 0 ) {
     /* We have some userlevel fds. */
-    if( timeout_ms ) {
+    if( timeout_frc ) {
       /* Blocking.  Shall we spin? */
       if( KEEP_POLLING(ps.ul_poll_spin, ps.this_poll_frc, poll_start_frc) ) {
         /* Timeout while spinning? */
-        if( timeout_ms > 0 && (ps.this_poll_frc - poll_start_frc >=
-                               timeout_ms * citp.cpu_khz) ) {
+        if( ps.this_poll_frc - poll_start_frc >= timeout_frc ) {
           for( i = 0; i < ps.nkfds; ++i )
             fds[ps.kfd_map[i]].revents = 0;
-          *used_ms = timeout_ms;
+          *used_frc = timeout_frc;
           goto out;
         }
 
@@ -763,10 +763,10 @@ int citp_ul_do_poll(struct pollfd*__restrict__ fds, nfds_t nfds,
   /* We only have kernel fds, or we want to block; so pass through. */
 
  out_block:
-  *used_ms = (ps.this_poll_frc - poll_start_frc) / citp.cpu_khz;
+  *used_frc = CI_MIN(ps.this_poll_frc - poll_start_frc, timeout_frc);
 
   /* If the caller will block, no need to poll kfds - exit. */
-  if( (timeout_ms != *used_ms) || (*used_ms == 0 && sigmask != NULL) )
+  if( *used_frc < timeout_frc || (timeout_frc == 0 && sigmask != NULL) )
     goto out;
 
  poll_kfds_and_return:
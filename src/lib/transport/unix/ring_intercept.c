@@ -0,0 +1,537 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Implementation of the onload_ring_* submission/completion ring API.
+ *
+ * Sockets are looked up once, when they are registered, and a ring keeps a
+ * reference to each.  onload_ring_enter() then runs every outstanding
+ * operation through the socket's protocol ops without blocking, polling
+ * the stack once per pass for all of them.  Operations that need data or
+ * a connection stay in the ring's list until a later pass, and are only
+ * retried once poll state says the socket is ready.  The protocol ops take
+ * the stack lock themselves, as they do for intercepted calls.  Waiting for them
+ * spins for EF_SPIN_USEC, as poll() does, and then blocks in poll() on the
+ * sockets they are waiting for.
+ */
+
+#include "internal.h"
+#include "ul_poll.h"
+#include <onload/tcp_poll.h>
+#include <onload/extensions.h>
+#include <onload/extensions_ring.h>
+#include <fcntl.h>
+
+
+#define RING_MAX_ENTRIES  32768
+
+/* Directions an operation may need to stay ordered in */
+#define RING_DIR_TX  0x1
+#define RING_DIR_RX  0x2
+
+struct oo_ring_op {
+  struct onload_ring_sqe sqe;
+  int res;
+  int state;
+#define RING_OP_NEW         0  /* not yet attempted */
+#define RING_OP_CONNECTING  1  /* connect() returned EINPROGRESS */
+#define RING_OP_DONE        2  /* waiting for completion queue space */
+};
+
+struct onload_ring_priv {
+  ci_netif* ni;
+
+  /* Registered sockets, each holding a reference */
+  citp_fdinfo** fdis;
+  int n_fdis;
+
+  /* Directions of each socket with an operation still outstanding, during
+   * a pass over ops */
+  ci_uint8* fd_busy;
+
+  /* Room to poll() every registered socket when blocking */
+  struct pollfd* pfds;
+
+  /* Outstanding operations, in submission order */
+  struct oo_ring_op* ops;
+  unsigned n_ops;
+  unsigned max_ops;
+};
+
+
+static int ring_op_dir(const struct onload_ring_sqe* sqe)
+{
+  switch( sqe->opcode ) {
+  case ONLOAD_RING_OP_SEND:
+  case ONLOAD_RING_OP_SENDMSG:
+  case ONLOAD_RING_OP_CONNECT:
+    return RING_DIR_TX;
+  case ONLOAD_RING_OP_RECV:
+  case ONLOAD_RING_OP_RECVMSG:
+  case ONLOAD_RING_OP_ACCEPT:
+    return RING_DIR_RX;
+  default:
+    return 0;
+  }
+}
+
+
+static unsigned ring_sock_events(citp_fdinfo* fdi)
+{
+  citp_sock_fdi* epi = fdi_to_sock_fdi(fdi);
+
+  if( citp_fdinfo_get_type(fdi) == CITP_TCP_SOCKET )
+    return ci_tcp_poll_events(epi->sock.netif, epi->sock.s);
+  return ci_udp_poll_events(epi->sock.netif, SOCK_TO_UDP(epi->sock.s));
+}
+
+
+static void ring_op_done(struct oo_ring_op* op, int res)
+{
+  op->res = res;
+  op->state = RING_OP_DONE;
+}
+
+
+/* accept() and connect() have no flag to stop them blocking, so a socket
+ * that is in blocking mode is put in non-blocking mode for the call only.
+ * Returns the file status flags to pass to ring_sock_restore_flags().
+ */
+static int ring_sock_set_nonblock(citp_fdinfo* fdi)
+{
+  citp_fdops* ops = citp_fdinfo_get_ops(fdi);
+  int fl = ops->fcntl(fdi, F_GETFL, 0);
+
+  if( fl >= 0 && ! (fl & O_NONBLOCK) )
+    ops->fcntl(fdi, F_SETFL, fl | O_NONBLOCK);
+  return fl;
+}
+
+
+static void ring_sock_restore_flags(citp_fdinfo* fdi, int fl)
+{
+  int saved_errno = errno;
+
+  if( fl >= 0 && ! (fl & O_NONBLOCK) )
+    citp_fdinfo_get_ops(fdi)->fcntl(fdi, F_SETFL, fl);
+  errno = saved_errno;
+}
+
+
+/* Makes one non-blocking attempt at [op].  It is left outstanding if it
+ * cannot finish yet. */
+static void ring_op_try(struct onload_ring_priv* priv, struct oo_ring_op* op,
+                        citp_lib_context_t* lib_context)
+{
+  struct onload_ring_sqe* sqe = &op->sqe;
+  citp_fdinfo* fdi;
+  citp_fdops* ops;
+  struct msghdr msg;
+  struct iovec iov;
+  int rc, err, fl;
+  socklen_t len;
+
+  if( sqe->opcode == ONLOAD_RING_OP_NOP ) {
+    ring_op_done(op, 0);
+    return;
+  }
+
+  fdi = priv->fdis[sqe->fd_index];
+  ops = citp_fdinfo_get_ops(fdi);
+  if( fdi->on_ref_count_zero != FDI_ON_RCZ_NONE ) {
+    /* Closed or handed over since it was registered */
+    ring_op_done(op, -EBADF);
+    return;
+  }
+
+  switch( sqe->opcode ) {
+  case ONLOAD_RING_OP_SEND:
+  case ONLOAD_RING_OP_RECV:
+    iov.iov_base = sqe->buf;
+    iov.iov_len = sqe->len;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if( sqe->opcode == ONLOAD_RING_OP_SEND ) {
+      rc = ops->send(fdi, &msg,
+                     sqe->msg_flags | MSG_DONTWAIT | MSG_NOSIGNAL);
+      break;
+    }
+    if( ! (ring_sock_events(fdi) & (POLLIN | POLLERR | POLLHUP)) )
+      return;
+    rc = ops->recv(fdi, &msg, sqe->msg_flags | MSG_DONTWAIT);
+    break;
+
+  case ONLOAD_RING_OP_SENDMSG:
+    rc = ops->send(fdi, sqe->msg,
+                   sqe->msg_flags | MSG_DONTWAIT | MSG_NOSIGNAL);
+    break;
+
+  case ONLOAD_RING_OP_RECVMSG:
+    if( ! (ring_sock_events(fdi) & (POLLIN | POLLERR | POLLHUP)) )
+      return;
+    rc = ops->recv(fdi, sqe->msg, sqe->msg_flags | MSG_DONTWAIT);
+    break;
+
+  case ONLOAD_RING_OP_ACCEPT:
+    if( ! (ring_sock_events(fdi) & (POLLIN | POLLERR | POLLHUP)) )
+      return;
+    fl = ring_sock_set_nonblock(fdi);
+    rc = ops->accept(fdi, sqe->addr, (socklen_t*) sqe->accept_addrlen,
+                     sqe->msg_flags, lib_context);
+    ring_sock_restore_flags(fdi, fl);
+    break;
+
+  case ONLOAD_RING_OP_CONNECT:
+    if( op->state == RING_OP_CONNECTING ) {
+      if( ! (ring_sock_events(fdi) & (POLLOUT | POLLERR | POLLHUP)) )
+        return;
+      len = sizeof(err);
+      rc = ops->getsockopt(fdi, SOL_SOCKET, SO_ERROR, &err, &len);
+      ring_op_done(op, rc < 0 ? -errno : -err);
+      return;
+    }
+    fl = ring_sock_set_nonblock(fdi);
+    rc = ops->connect(fdi, sqe->addr, sqe->addrlen, lib_context);
+    ring_sock_restore_flags(fdi, fl);
+    if( rc < 0 && (errno == EINPROGRESS || errno == EALREADY) ) {
+      op->state = RING_OP_CONNECTING;
+      return;
+    }
+    break;
+
+  default:
+    rc = -1;
+    errno = EINVAL;
+    break;
+  }
+
+  if( rc >= 0 )
+    ring_op_done(op, rc);
+  else if( errno != EAGAIN )
+    ring_op_done(op, -errno);
+}
+
+
+/* Moves new submissions onto the list of outstanding operations. */
+static void ring_take_sqes(struct onload_ring* ring)
+{
+  struct onload_ring_priv* priv = ring->priv;
+  struct onload_ring_sqe* sqe;
+  struct oo_ring_op* op;
+
+  while( ring->sq.head != ring->sq.tail && priv->n_ops < priv->max_ops ) {
+    sqe = &ring->sq.sqes[ring->sq.head++ & ring->sq.mask];
+    op = &priv->ops[priv->n_ops++];
+    op->sqe = *sqe;
+    op->state = RING_OP_NEW;
+    if( sqe->flags != 0 || sqe->opcode > ONLOAD_RING_OP_CONNECT ||
+        (sqe->opcode != ONLOAD_RING_OP_NOP &&
+         sqe->fd_index >= (unsigned) priv->n_fdis) ) {
+      op->sqe.opcode = ONLOAD_RING_OP_NOP;
+      ring_op_done(op, -EINVAL);
+    }
+  }
+}
+
+
+/* Attempts every outstanding operation, and posts completions in order of
+ * submission for as long as there is space for them. */
+static void ring_run(struct onload_ring* ring, citp_lib_context_t* lib_context)
+{
+  struct onload_ring_priv* priv = ring->priv;
+  struct onload_ring_cqe* cqe;
+  struct oo_ring_op* op;
+  unsigned i, j;
+  int dir;
+
+  if( priv->n_fdis )
+    memset(priv->fd_busy, 0, priv->n_fdis);
+  for( i = j = 0; i < priv->n_ops; ++i ) {
+    op = &priv->ops[i];
+    dir = ring_op_dir(&op->sqe);
+    if( dir && (priv->fd_busy[op->sqe.fd_index] & dir) )
+      goto keep;
+    if( op->state != RING_OP_DONE ) {
+      ring_op_try(priv, op, lib_context);
+      if( op->state != RING_OP_DONE )
+        goto keep;
+    }
+    if( ring->cq.tail - ring->cq.head > ring->cq.mask )
+      goto keep;
+    cqe = &ring->cq.cqes[ring->cq.tail++ & ring->cq.mask];
+    cqe->user_data = op->sqe.user_data;
+    cqe->res = op->res;
+    cqe->flags = 0;
+    continue;
+
+  keep:
+    if( dir )
+      priv->fd_busy[op->sqe.fd_index] |= dir;
+    if( i != j )
+      priv->ops[j] = *op;
+    ++j;
+  }
+  priv->n_ops = j;
+}
+
+
+static void ring_poll_stack(ci_netif* ni)
+{
+  if( ci_netif_may_poll(ni) && ci_netif_need_poll(ni) &&
+      ci_netif_trylock(ni) ) {
+    ci_netif_poll(ni);
+    ci_netif_unlock(ni);
+  }
+}
+
+
+/* Blocks in poll() until a socket that an outstanding operation is waiting
+ * for becomes ready, or for [timeout_ms].  Returns as poll() does.
+ */
+static int ring_block(struct onload_ring* ring,
+                      citp_lib_context_t* lib_context, int timeout_ms)
+{
+  struct onload_ring_priv* priv = ring->priv;
+  struct oo_ring_op* op;
+  unsigned i;
+  int rc, saved_errno;
+
+  for( i = 0; i < (unsigned) priv->n_fdis; ++i ) {
+    priv->pfds[i].fd = -1;
+    priv->pfds[i].events = 0;
+    priv->pfds[i].revents = 0;
+  }
+  for( i = 0; i < priv->n_ops; ++i ) {
+    op = &priv->ops[i];
+    if( ! ring_op_dir(&op->sqe) )
+      continue;
+    priv->pfds[op->sqe.fd_index].fd = priv->fdis[op->sqe.fd_index]->fd;
+    priv->pfds[op->sqe.fd_index].events |=
+      ring_op_dir(&op->sqe) == RING_DIR_RX ? POLLIN : POLLOUT;
+  }
+
+  citp_exit_lib(lib_context, TRUE);
+  rc = ci_sys_poll(priv->pfds, priv->n_fdis, timeout_ms);
+  saved_errno = errno;
+  citp_reenter_lib(lib_context);
+  errno = saved_errno;
+  return rc;
+}
+
+
+int onload_ring_init(int fd, unsigned entries, unsigned flags,
+                     struct onload_ring* ring)
+{
+  citp_lib_context_t lib_context;
+  struct onload_ring_priv* priv = NULL;
+  citp_fdinfo* fdi;
+  int rc = 0;
+
+  Log_CALL(ci_log("%s(%d, %u, %x, %p)", __FUNCTION__, fd, entries, flags,
+                  ring));
+
+  if( flags != 0 || entries == 0 || (entries & (entries - 1)) ||
+      entries > RING_MAX_ENTRIES )
+    return -EINVAL;
+
+  citp_enter_lib(&lib_context);
+  fdi = citp_fdtable_lookup(fd);
+  if( fdi == NULL ) {
+    rc = -ESOCKTNOSUPPORT;
+    goto out;
+  }
+  if( citp_fdinfo_get_type(fdi) != CITP_TCP_SOCKET &&
+      citp_fdinfo_get_type(fdi) != CITP_UDP_SOCKET ) {
+    rc = -ESOCKTNOSUPPORT;
+    goto out_release;
+  }
+
+  memset(ring, 0, sizeof(*ring));
+  priv = calloc(1, sizeof(*priv));
+  ring->sq.sqes = calloc(entries, sizeof(ring->sq.sqes[0]));
+  ring->cq.cqes = calloc(entries * 2, sizeof(ring->cq.cqes[0]));
+  if( priv != NULL )
+    priv->ops = calloc(entries, sizeof(priv->ops[0]));
+  if( priv == NULL || priv->ops == NULL ||
+      ring->sq.sqes == NULL || ring->cq.cqes == NULL ) {
+    if( priv != NULL )
+      free(priv->ops);
+    free(priv);
+    free(ring->sq.sqes);
+    free(ring->cq.cqes);
+    rc = -ENOMEM;
+    goto out_release;
+  }
+
+  ring->sq.mask = entries - 1;
+  ring->cq.mask = entries * 2 - 1;
+  ring->priv = priv;
+  priv->ni = fdi_to_sock_fdi(fdi)->sock.netif;
+  priv->max_ops = entries;
+  citp_netif_add_ref(priv->ni);
+
+ out_release:
+  citp_fdinfo_release_ref(fdi, 0);
+ out:
+  citp_exit_lib(&lib_context, TRUE);
+  Log_CALL_RESULT(rc);
+  return rc;
+}
+
+
+int onload_ring_free(struct onload_ring* ring)
+{
+  citp_lib_context_t lib_context;
+  struct onload_ring_priv* priv = ring->priv;
+  int i;
+
+  Log_CALL(ci_log("%s(%p)", __FUNCTION__, ring));
+
+  if( priv == NULL )
+    return -EINVAL;
+
+  citp_enter_lib(&lib_context);
+  for( i = 0; i < priv->n_fdis; ++i )
+    citp_fdinfo_release_ref(priv->fdis[i], 0);
+  citp_netif_release_ref(priv->ni, 0);
+  citp_exit_lib(&lib_context, TRUE);
+
+  free(priv->fdis);
+  free(priv->fd_busy);
+  free(priv->pfds);
+  free(priv->ops);
+  free(priv);
+  free(ring->sq.sqes);
+  free(ring->cq.cqes);
+  memset(ring, 0, sizeof(*ring));
+  return 0;
+}
+
+
+int onload_ring_register_fds(struct onload_ring* ring,
+                             const int* fds, int n_fds)
+{
+  citp_lib_context_t lib_context;
+  struct onload_ring_priv* priv = ring->priv;
+  citp_fdinfo** fdis;
+  ci_uint8* fd_busy;
+  struct pollfd* pfds;
+  citp_fdinfo* fdi;
+  int i, rc;
+
+  Log_CALL(ci_log("%s(%p, %p, %d)", __FUNCTION__, ring, fds, n_fds));
+
+  if( priv == NULL || n_fds <= 0 )
+    return -EINVAL;
+
+  fdis = realloc(priv->fdis, (priv->n_fdis + n_fds) * sizeof(fdis[0]));
+  if( fdis == NULL )
+    return -ENOMEM;
+  priv->fdis = fdis;
+  fd_busy = realloc(priv->fd_busy, priv->n_fdis + n_fds);
+  if( fd_busy == NULL )
+    return -ENOMEM;
+  priv->fd_busy = fd_busy;
+  pfds = realloc(priv->pfds, (priv->n_fdis + n_fds) * sizeof(pfds[0]));
+  if( pfds == NULL )
+    return -ENOMEM;
+  priv->pfds = pfds;
+
+  citp_enter_lib(&lib_context);
+  for( i = 0; i < n_fds; ++i ) {
+    fdi = citp_fdtable_lookup(fds[i]);
+    if( fdi == NULL ) {
+      rc = -ESOCKTNOSUPPORT;
+      goto fail;
+    }
+    if( (citp_fdinfo_get_type(fdi) != CITP_TCP_SOCKET &&
+         citp_fdinfo_get_type(fdi) != CITP_UDP_SOCKET) ||
+        fdi_to_sock_fdi(fdi)->sock.netif != priv->ni ) {
+      citp_fdinfo_release_ref(fdi, 0);
+      rc = -EINVAL;
+      goto fail;
+    }
+    fdis[priv->n_fdis + i] = fdi;
+  }
+
+  rc = priv->n_fdis;
+  priv->n_fdis += n_fds;
+  citp_exit_lib(&lib_context, TRUE);
+  Log_CALL_RESULT(rc);
+  return rc;
+
+ fail:
+  while( --i >= 0 )
+    citp_fdinfo_release_ref(fdis[priv->n_fdis + i], 0);
+  citp_exit_lib(&lib_context, TRUE);
+  Log_CALL_RESULT(rc);
+  return rc;
+}
+
+
+int onload_ring_enter(struct onload_ring* ring, unsigned min_complete,
+                      int timeout_ms)
+{
+  citp_lib_context_t lib_context;
+  struct onload_ring_priv* priv = ring->priv;
+  ci_uint64 start_frc, now_frc, max_cycles = 0;
+  unsigned n;
+  int rc, spin, block_ms;
+
+  Log_CALL(ci_log("%s(%p, %u, %d)", __FUNCTION__, ring, min_complete,
+                  timeout_ms));
+
+  if( priv == NULL )
+    return -EINVAL;
+
+  citp_enter_lib(&lib_context);
+  ring_take_sqes(ring);
+  ci_frc64(&start_frc);
+  if( timeout_ms > 0 )
+    max_cycles = (ci_uint64) timeout_ms * IPTIMER_STATE(priv->ni)->khz;
+  spin = oo_per_thread_get()->spinstate & (1 << ONLOAD_SPIN_POLL);
+
+  while( 1 ) {
+    ring_poll_stack(priv->ni);
+    ring_run(ring, &lib_context);
+    /* Operations held back by a full submission list can go now */
+    if( ring->sq.head != ring->sq.tail && priv->n_ops < priv->max_ops ) {
+      ring_take_sqes(ring);
+      ring_run(ring, &lib_context);
+    }
+
+    n = ring->cq.tail - ring->cq.head;
+    rc = n;
+    /* Nothing more can complete until the completion queue is read */
+    if( n >= min_complete || priv->n_ops == 0 || timeout_ms == 0 ||
+        n > ring->cq.mask )
+      break;
+    ci_frc64(&now_frc);
+    if( timeout_ms > 0 && now_frc - start_frc >= max_cycles )
+      break;
+    if(CI_UNLIKELY( lib_context.thread->sig.c.aflags &
+                    OO_SIGNAL_FLAG_HAVE_PENDING )) {
+      if( n == 0 )
+        rc = -EINTR;
+      break;
+    }
+    if( KEEP_POLLING(spin, now_frc, start_frc) )
+      continue;
+
+    block_ms = -1;
+    if( timeout_ms > 0 )
+      block_ms = timeout_ms -
+                 (now_frc - start_frc) / IPTIMER_STATE(priv->ni)->khz;
+    if( ring_block(ring, &lib_context, block_ms) < 0 ) {
+      if( errno != EINTR )
+        rc = -errno;
+      else if( n == 0 )
+        rc = -EINTR;
+      break;
+    }
+  }
+
+  citp_exit_lib(&lib_context, TRUE);
+  Log_CALL_RESULT(rc);
+  return rc;
+}
@@ -17,6 +17,7 @@
 
 #include "internal.h"
 #include "ul_pipe.h"
+#include "ul_epoll.h"
 #include <onload/syscalls.h>
 
 #include <stdarg.h>
@@ -1105,59 +1106,32 @@ OO_INTERCEPT(int, sendmmsg,
 strong_alias(onload_sendmmsg, __sendmmsg);
 
 
-/* Internal poll/select timeout is calculated in milliseconds,
- * and in citp_ul_do_select/citp_ul_do_poll this value is multiplied by
- * citp.cpu_khz, assuming it not to overflow.
- * So we are dividing by 10GHz here.
- * This does limit us to maximum timeout of about 58 years.
+/* Internal poll/select timeouts are in cycles, converted as for
+ * epoll_pwait2() by oo_epoll_ts_to_frc().  A non-zero timeout stays
+ * non-zero, so that a user who has enabled spinning gets to spin a bit
+ * even with an extra-small timeout.
  */
-#define MAX_POLL_SELECT_MILLISEC ((ci_uint64) -1 / 10000000)
-static inline ci_uint64
-timespec2ms(const struct timespec* tv)
-{
-  ci_uint64 ms;
-
-  if( tv == NULL )
-    return MAX_POLL_SELECT_MILLISEC;
-  ms = (ci_uint64)tv->tv_sec * 1000 +
-       (tv->tv_nsec + 500000) / 1000000;
-
-  /* If spinning is enabled, user expects us to spin a bit
-   * even with extra-small timeout. */
-  if( ms == 0 && tv->tv_nsec != 0 )
-    ms = 1;
-  if( ms >= MAX_POLL_SELECT_MILLISEC )
-    return MAX_POLL_SELECT_MILLISEC;
-  return ms;
-}
 static inline ci_uint64
-timeval2ms(const struct timeval* tv)
+timeval2frc(const struct timeval* tv)
 {
-  ci_uint64 ms;
+  struct timespec ts;
 
   if( tv == NULL )
-    return MAX_POLL_SELECT_MILLISEC;
-  ms = (ci_uint64)tv->tv_sec * 1000 +
-    (tv->tv_usec + 500) / 1000;
-
-  /* If spinning is enabled, user expects us to spin a bit
-   * even with extra-small timeout. */
-  if( ms == 0 && tv->tv_usec != 0 )
-    ms = 1;
-  if( ms >= MAX_POLL_SELECT_MILLISEC )
-    return MAX_POLL_SELECT_MILLISEC;
-  return ms;
+    return oo_epoll_ts_to_frc(NULL);
+  ts.tv_sec = tv->tv_sec;
+  ts.tv_nsec = tv->tv_usec * 1000;
+  return oo_epoll_ts_to_frc(&ts);
 }
 static inline void
-ms2timeval(ci_uint64 timeout, ci_uint64 spent, struct timeval* tv)
+timeval_left(struct timeval* tv, ci_uint64 spent_frc)
 {
-  if( timeout > spent ) {
-    tv->tv_sec = (timeout - spent) / 1000;
-    tv->tv_usec = ((timeout - spent) % 1000) * 1000;
-  }
-  else {
-    tv->tv_sec = tv->tv_usec = 0;
-  }
+  struct timespec ts;
+
+  ts.tv_sec = tv->tv_sec;
+  ts.tv_nsec = tv->tv_usec * 1000;
+  timespec_left(&ts, spent_frc, &ts);
+  tv->tv_sec = ts.tv_sec;
+  tv->tv_usec = ts.tv_nsec / 1000;
 }
 
 
@@ -1166,7 +1140,7 @@ OO_INTERCEPT(int, select,
               struct timeval* timeout))
 {
   citp_lib_context_t lib_context;
-  ci_uint64 timeout_ms, used_ms = 0;
+  ci_uint64 timeout_frc, used_frc = 0;
   int rc;
 
   if( CI_UNLIKELY(citp.init_level < CITP_INIT_ALL) ) {
@@ -1186,19 +1160,15 @@ OO_INTERCEPT(int, select,
     goto out;
   }
 
-  timeout_ms = timeval2ms(timeout);
+  timeout_frc = timeval2frc(timeout);
 
   citp_enter_lib(&lib_context);
-  rc = citp_ul_do_select(nfds, rds, wrs, exs, timeout_ms, &used_ms,
+  rc = citp_ul_do_select(nfds, rds, wrs, exs, timeout_frc, &used_frc,
                          &lib_context, NULL);
 
   /* Linux-specific behaviour: change timeout parameter. */
-  if( timeout != NULL && used_ms != 0 ) {
-    if( timeout_ms > used_ms )
-      ms2timeval(timeout_ms, used_ms, timeout);
-    else
-      timeout->tv_sec = timeout->tv_usec = 0;
-  }
+  if( timeout != NULL && used_frc != 0 )
+    timeval_left(timeout, used_frc);
   if( rc == CI_SOCKET_HANDOVER )
     rc = ci_sys_select(nfds, rds, wrs, exs, timeout);
 
@@ -1212,7 +1182,7 @@ OO_INTERCEPT(int, pselect,
               const struct timespec *timeout_ts, const sigset_t *sigmask))
 {
   citp_lib_context_t lib_context;
-  ci_uint64 timeout_ms, used_ms = 0;
+  ci_uint64 timeout_frc, used_frc = 0;
   int rc = 0;
 
   if( CI_UNLIKELY(citp.init_level < CITP_INIT_ALL) ) {
@@ -1233,18 +1203,18 @@ OO_INTERCEPT(int, pselect,
     goto out;
   }
 
-  timeout_ms = timespec2ms(timeout_ts);
+  timeout_frc = oo_epoll_ts_to_frc(timeout_ts);
 
   /* Set up signal mask and spin */
   citp_enter_lib(&lib_context);
-  rc = citp_ul_do_select(nfds, rds, wrs, exs, timeout_ms, &used_ms,
+  rc = citp_ul_do_select(nfds, rds, wrs, exs, timeout_frc, &used_frc,
                          &lib_context, sigmask);
 
   /* we should not return 0 without signal check; do it now: */
   if( rc == CI_SOCKET_HANDOVER || (rc == 0 && sigmask != NULL) ) {
-    if( timeout_ts != NULL && used_ms != 0 ) {
+    if( timeout_ts != NULL && used_frc != 0 ) {
       struct timespec ts;
-      ms2timespec(timeout_ms, used_ms, &ts);
+      timespec_left(timeout_ts, used_frc, &ts);
       rc = ci_sys_pselect(nfds, rds, wrs, exs, &ts, sigmask);
     }
     else
@@ -1261,7 +1231,7 @@ OO_INTERCEPT(int, poll,
 {
   citp_lib_context_t lib_context;
   int rc;
-  ci_uint64 used_ms = 0;
+  ci_uint64 timeout_frc, used_frc = 0;
 
   if( CI_UNLIKELY(citp.init_level < CITP_INIT_ALL) ) {
     citp_do_init(CITP_INIT_SYSCALLS);
@@ -1273,11 +1243,13 @@ OO_INTERCEPT(int, poll,
 
   Log_CALL(ci_log("%s(%p, %ld, %d)", __FUNCTION__, fds, nfds, timeout));
 
+  timeout_frc = oo_epoll_ms_to_frc(timeout);
   citp_enter_lib(&lib_context);
-  rc = citp_ul_do_poll(fds, nfds, timeout, &used_ms, &lib_context, NULL);
+  rc = citp_ul_do_poll(fds, nfds, timeout_frc, &used_frc, &lib_context, NULL);
 
-  if( timeout != used_ms && rc == 0 )
-    rc = ci_sys_poll(fds, nfds, timeout - used_ms);
+  if( used_frc < timeout_frc && rc == 0 )
+    rc = ci_sys_poll(fds, nfds,
+                     timeout < 0 ? -1 : timeout - used_frc / citp.cpu_khz);
 
   Log_CALL_RESULT(rc);
   return rc;
@@ -1296,7 +1268,7 @@ OO_INTERCEPT(int, ppoll,
               const struct timespec *timeout_ts, const sigset_t *sigmask))
 {
   citp_lib_context_t lib_context;
-  ci_uint64 timeout_ms, used_ms = 0;
+  ci_uint64 timeout_frc, used_frc = 0;
   int rc = 0;
 
   if( CI_UNLIKELY(citp.init_level < CITP_INIT_ALL) ) {
@@ -1316,20 +1288,20 @@ OO_INTERCEPT(int, ppoll,
     goto out;
   }
 
-  timeout_ms = timespec2ms(timeout_ts);
+  timeout_frc = oo_epoll_ts_to_frc(timeout_ts);
 
   citp_enter_lib(&lib_context);
-  rc = citp_ul_do_poll(fds, nfds, timeout_ms, &used_ms, &lib_context,
+  rc = citp_ul_do_poll(fds, nfds, timeout_frc, &used_frc, &lib_context,
                        sigmask);
 
-  /* Block in the OS, check signals */
-  if( rc == 0 && ( timeout_ms != used_ms ||
-                   (used_ms == 0 && sigmask != NULL) ) ) {
-    if( used_ms == 0 || timeout_ts == NULL )
+  /* Block in the OS for the rest of the timeout, check signals */
+  if( rc == 0 && ( used_frc < timeout_frc ||
+                   (timeout_frc == 0 && sigmask != NULL) ) ) {
+    if( used_frc == 0 || timeout_ts == NULL )
       rc = ci_sys_ppoll(fds, nfds, timeout_ts, sigmask);
     else {
       struct timespec ts;
-      ms2timespec(timeout_ms, used_ms, &ts);
+      timespec_left(timeout_ts, used_frc, &ts);
       rc = ci_sys_ppoll(fds, nfds, &ts, sigmask);
     }
   }
@@ -1349,9 +1321,6 @@ OO_INTERCEPT(int, __ppoll_chk,
 }
 
 
-#include "ul_epoll.h"
-
-
 OO_INTERCEPT(int, epoll_create1,
              (int flags))
 {
@@ -1571,6 +1540,70 @@ error:
   return ci_sys_epoll_pwait(epfd, events, maxevents, timeout, sigmask);
 }
 
+#if CI_LIBC_HAS_epoll_pwait2
+OO_INTERCEPT(int, epoll_pwait2,
+             (int epfd, struct epoll_event*events, int maxevents,
+              const struct timespec *timeout_ts, const sigset_t *sigmask))
+{
+  citp_lib_context_t lib_context;
+  citp_fdinfo* fdi;
+
+  if(CI_UNLIKELY( citp.init_level < CITP_INIT_ALL )) {
+    citp_do_init(CITP_INIT_SYSCALLS);
+    goto pass_through;
+  }
+  /* Let the kernel report invalid timeouts */
+  if( ! CITP_OPTS.ul_epoll ||
+      (timeout_ts != NULL &&
+       (timeout_ts->tv_sec < 0 || timeout_ts->tv_nsec < 0 ||
+        timeout_ts->tv_nsec >= 1000000000)) )
+    goto pass_through;
+
+  citp_enter_lib(&lib_context);
+  Log_CALL(ci_log("%s(%d, %p, %d, {%d,%d}, %p)", __FUNCTION__, epfd, events,
+                  maxevents, timeout_ts ? (int)timeout_ts->tv_sec : -1,
+                  timeout_ts ? (int)timeout_ts->tv_nsec : -1, sigmask));
+
+  if( (fdi=citp_fdtable_lookup(epfd)) ) {
+    int rc = CI_SOCKET_HANDOVER;
+    if( fdi->protocol->type == CITP_EPOLL_FD ) {
+      /* NB. citp_epoll_wait() calls citp_exit_lib(). */
+      rc = citp_epoll_wait(fdi, events, NULL, maxevents,
+                           oo_epoll_ts_to_frc(timeout_ts), sigmask,
+                           &lib_context);
+      citp_reenter_lib(&lib_context);
+    }
+#if CI_CFG_EPOLL2
+    else if (fdi->protocol->type == CITP_EPOLLB_FD ) {
+      /* The epoll2 ioctl takes milliseconds: round up */
+      int timeout = -1;
+      if( timeout_ts != NULL )
+        timeout = CI_MIN((ci_uint64)timeout_ts->tv_sec * 1000 +
+                         (timeout_ts->tv_nsec + 999999) / 1000000,
+                         (ci_uint64)0x7fffffff);
+      rc = citp_epollb_wait(fdi, events, maxevents, timeout, sigmask,
+                            &lib_context);
+    }
+#endif
+    citp_fdinfo_release_ref(fdi, 0);
+    citp_exit_lib(&lib_context, rc >= 0);
+    if( rc == CI_SOCKET_HANDOVER )
+      goto error;
+    Log_CALL_RESULT(rc);
+    return rc;
+  }
+  else {
+    citp_exit_lib(&lib_context, TRUE);
+  }
+
+error:
+  Log_PT(log("PT: sys_epoll_pwait2(%d, %p, %d, %p, %p)", epfd, events,
+             maxevents, timeout_ts, sigmask));
+ pass_through:
+  return ci_sys_epoll_pwait2(epfd, events, maxevents, timeout_ts, sigmask);
+}
+#endif
+
 
 
 OO_INTERCEPT(ssize_t, read,
@@ -2799,6 +2832,9 @@ OO_INTERCEPT(long, syscall,
     NR(epoll_ctl)
     NR(epoll_wait)
     NR(epoll_pwait)
+#if CI_LIBC_HAS_epoll_pwait2 && defined(__NR_epoll_pwait2)
+    NR(epoll_pwait2)
+#endif
     /* When adding new syscalls here, make sure to check that the libc API
     matches the kernel API. It does for almost everything (on x86-64) but
     there are a few exceptions.  */
@@ -171,6 +171,8 @@ static void citp_dump_opts(citp_opts_t *o)
   DUMP_OPT_INT("EF_EPOLL_CTL_FAST",     ul_epoll_ctl_fast);
   DUMP_OPT_INT("EF_EPOLL_CTL_HANDOFF",  ul_epoll_ctl_handoff);
   DUMP_OPT_INT("EF_EPOLL_MT_SAFE",      ul_epoll_mt_safe);
+  DUMP_OPT_INT("EF_EPOLL_WAKE_ONE",     ul_epoll_wake_one);
+  DUMP_OPT_INT("EF_EPOLL_OS_LT_USEC",   ul_epoll_os_lt_usec);
   DUMP_OPT_INT("EF_FDTABLE_SIZE",	fdtable_size);
   DUMP_OPT_INT("EF_SPIN_USEC",		ul_spin_usec);
   DUMP_OPT_INT("EF_SLEEP_SPIN_USEC",	sleep_spin_usec);
@@ -433,6 +435,8 @@ static void citp_opts_getenv(citp_opts_t* opts)
   GET_ENV_OPT_INT("EF_EPOLL_CTL_FAST",  ul_epoll_ctl_fast);
   GET_ENV_OPT_INT("EF_EPOLL_CTL_HANDOFF",ul_epoll_ctl_handoff);
   GET_ENV_OPT_INT("EF_EPOLL_MT_SAFE",   ul_epoll_mt_safe);
+  GET_ENV_OPT_INT("EF_EPOLL_WAKE_ONE",  ul_epoll_wake_one);
+  GET_ENV_OPT_INT("EF_EPOLL_OS_LT_USEC",ul_epoll_os_lt_usec);
   GET_ENV_OPT_INT("EF_WODA_SINGLE_INTERFACE", woda_single_if);
   GET_ENV_OPT_INT("EF_FDTABLE_SIZE",	fdtable_size);
   GET_ENV_OPT_INT("EF_SPIN_USEC",	ul_spin_usec);
@@ -599,6 +603,8 @@ citp_transport_init(void)
     citp_usec_to_cycles64(CITP_OPTS.ul_select_nonblock_fast_usec);
   citp.select_fast_cycles = 
     citp_usec_to_cycles64(CITP_OPTS.ul_select_fast_usec);
+  citp.epoll_os_lt_cycles =
+    citp_usec_to_cycles64(CITP_OPTS.ul_epoll_os_lt_usec);
   ci_tp_init(__oo_per_thread_init_thread, oo_signal_terminate);
 
   citp_update_and_crosscheck(&ci_cfg_opts.netif_opts, &CITP_OPTS);
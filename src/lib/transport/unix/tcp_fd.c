@@ -1751,6 +1751,37 @@ static int citp_tcp_sendmmsg(citp_fdinfo* fdinfo, struct mmsghdr* msg,
   return -1;
 }
 
+#ifdef MSG_FASTOPEN
+/* sendto(MSG_FASTOPEN) on an unconnected socket: connect as with
+ * TCP_FASTOPEN_CONNECT, so that the data goes in the SYN if we hold a
+ * cookie for the peer.  Returns 0 if the caller should go on to send.
+ */
+static int citp_tcp_send_fastopen(citp_fdinfo* fdinfo,
+                                  const struct msghdr* msg)
+{
+  citp_sock_fdi* epi = fdi_to_sock_fdi(fdinfo);
+  ci_tcp_state* ts = SOCK_TO_TCP(epi->sock.s);
+  ci_uint8 fastopen_connect;
+  int rc, moved = 0;
+
+  if( ~NI_OPTS(epi->sock.netif).tcp_fastopen & EF_TCP_FASTOPEN_CLIENT )
+    RET_WITH_ERRNO(EOPNOTSUPP);
+
+  fastopen_connect = ts->c.fastopen_connect;
+  ts->c.fastopen_connect = 1;
+  rc = ci_tcp_connect(&epi->sock, msg->msg_name, msg->msg_namelen,
+                      fdinfo->fd, &moved);
+  ts->c.fastopen_connect = fastopen_connect;
+
+  /* The socket has been handed over or moved to another stack; leave the
+   * caller to retry with connect() and send(). */
+  if( moved || tcp_rc_means_handover(rc) )
+    RET_WITH_ERRNO(EOPNOTSUPP);
+  return rc;
+}
+#endif
+
+
 static int citp_tcp_send(citp_fdinfo* fdinfo, const struct msghdr* msg,
                          int flags)
 {
@@ -1759,6 +1790,16 @@ static int citp_tcp_send(citp_fdinfo* fdinfo, const struct msghdr* msg,
 
   ci_assert(msg != NULL);
 
+#ifdef MSG_FASTOPEN
+  if( (flags & MSG_FASTOPEN) ) {
+    flags &= ~MSG_FASTOPEN;
+    if( msg->msg_name != NULL &&
+        OO_ACCESS_ONCE(epi->sock.s->b.state) == CI_TCP_CLOSED &&
+        citp_tcp_send_fastopen(fdinfo, msg) != 0 )
+      return -1;
+  }
+#endif
+
   if( epi->sock.s->b.sb_aflags & (CI_SB_AFLAG_O_NONBLOCK |
                                   CI_SB_AFLAG_O_NDELAY) ) {
     flags |= MSG_DONTWAIT;
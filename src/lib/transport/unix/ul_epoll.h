@@ -122,6 +122,8 @@ struct citp_epoll_member {
 /*!< this eitem is (or was) a non-home member of the epoll set,
  * and it was added to the kernel epoll set. */
 #define CITP_EITEM_FLAG_OS_SYNC     2
+/*!< this eitem was added with EPOLLEXCLUSIVE */
+#define CITP_EITEM_FLAG_EXCLUSIVE   4
 };
 
 
@@ -194,6 +196,15 @@ struct citp_epoll_fd {
    * value of highest bit matters */
   int phase;
 
+  /* When the kernel fds were last checked.  See citp_epoll_os_pending(). */
+  ci_uint64 os_poll_frc;
+
+  /* Waiters are woken one at a time (EF_EPOLL_WAKE_ONE or EPOLLEXCLUSIVE),
+   * and only the one holding [spinner] spins.  A woken waiter still takes
+   * its events from the set's one ready list. */
+  int wake_one;
+  volatile ci_uint32 spinner;
+
 #if CI_CFG_TIMESTAMPING
   /* When using WODA with large numbers of sockets performance can be harmed
    * by repeated large alloc/free calls, so we cache memory allocated for this
@@ -276,6 +287,21 @@ static inline ci_int64 oo_epoll_ms_to_frc(int ms_timeout)
     return (ci_int64)ms_timeout * citp.cpu_khz;
 }
 
+/* As oo_epoll_ms_to_frc(), for the timespec timeout of epoll_pwait2().
+ * NULL waits indefinitely.  The caller must check that ts is valid.
+ * A partial cycle is rounded up, so that a non-zero timeout stays
+ * non-zero. */
+static inline ci_int64 oo_epoll_ts_to_frc(const struct timespec* ts)
+{
+  ci_int64 khz = citp.cpu_khz;
+
+  if( ts == NULL || ts->tv_sec >= OO_EPOLL_MAX_TIMEOUT_HR / (khz * 1000) )
+    return OO_EPOLL_MAX_TIMEOUT_HR;
+  return CI_MIN(ts->tv_sec * khz * 1000 +
+                ((ci_int64)ts->tv_nsec * khz + 999999) / 1000000,
+                (ci_int64)OO_EPOLL_MAX_TIMEOUT_HR);
+}
+
 
 extern int citp_epoll_create(int size, int flags) CI_HF;
 extern int citp_epoll_ctl(citp_fdinfo* fdi, int op, int fd,
@@ -319,6 +345,14 @@ extern void citp_epoll_remove_if_not_ready(struct oo_ul_epoll_state* eps,
                                 OO_EPOLL_WRITE_EVENTS | \
                                 OO_EPOLL_HUP_EVENTS)
 
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE (1u << 28)
+#endif
+/* Events the kernel allows together with EPOLLEXCLUSIVE */
+#define OO_EPOLL_EXCLUSIVE_OK_EVENTS (EPOLLIN | EPOLLOUT | EPOLLERR | \
+                                      EPOLLHUP | EPOLLWAKEUP | EPOLLET | \
+                                      EPOLLEXCLUSIVE)
+
 
 int
 citp_ul_epoll_find_events(struct oo_ul_epoll_state* eps,
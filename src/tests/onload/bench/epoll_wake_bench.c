@@ -0,0 +1,296 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/* Benchmark for many threads waiting on one epoll set.
+ *
+ * "rx" binds a number of UDP sockets to consecutive ports, adds them to one
+ * epoll set and runs rounds with 1, 2, 4 ... threads all calling
+ * epoll_wait() on it.  For each round it reports the datagrams received
+ * per second, the wakeups per datagram, and the fraction of wakeups that
+ * found nothing to receive because another thread got there first.  It
+ * also reports the fraction of wakeups that were handed a socket which
+ * another thread was still draining.  That is the contention that wake-one
+ * does not remove, as every thread takes events from the same ready list.
+ *
+ * "tx" sends datagrams round-robin to the ports as fast as it can.
+ *
+ * With -x the sockets are added with EPOLLEXCLUSIVE.  Setting
+ * EF_EPOLL_WAKE_ONE=1 has the same effect on Onload epoll sets without
+ * changing the application.
+ *
+ * Example:
+ * (host1)$ onload epoll_wake_bench -x rx
+ * (host1)$ EF_EPOLL_WAKE_ONE=1 onload epoll_wake_bench rx
+ * (host2)$ onload epoll_wake_bench tx host1
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+#ifndef EPOLLEXCLUSIVE
+#define EPOLLEXCLUSIVE  (1u << 28)
+#endif
+
+
+#define MAX_SIZE     1472
+#define MAX_THREADS  32
+#define MAX_SOCKS    1024
+
+
+#define TRY(x)                                                          \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY(%s) failed\n", #x);                 \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d errno=%d (%s)\n",                 \
+                __rc, errno, strerror(errno));                          \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+
+static int cfg_port = 8080;
+static int cfg_socks = 16;
+static int cfg_size = 32;
+static int cfg_threads = MAX_THREADS;
+static int cfg_seconds = 2;
+static int cfg_exclusive = 0;
+static int cfg_edge = 0;
+
+
+struct waiter {
+  pthread_t thread;
+  unsigned long wakeups;
+  unsigned long empty_wakeups;
+  unsigned long shared_wakeups;
+  unsigned long datagrams;
+  /* Keep each thread's counters on their own cache line */
+  char pad[64];
+};
+
+static struct waiter waiters[MAX_THREADS];
+static int socks[MAX_SOCKS];
+/* Number of threads draining each socket */
+static volatile int sock_busy[MAX_SOCKS];
+static int epfd;
+static volatile int stop;
+
+
+static void usage(void)
+{
+  fprintf(stderr, "usage:\n");
+  fprintf(stderr, "  epoll_wake_bench [options] rx\n");
+  fprintf(stderr, "  epoll_wake_bench [options] tx <host>\n");
+  fprintf(stderr, "\noptions:\n");
+  fprintf(stderr, "  -p <port>     first UDP port (default %d)\n", cfg_port);
+  fprintf(stderr, "  -S <socks>    number of sockets (default %d)\n",
+          cfg_socks);
+  fprintf(stderr, "  -s <bytes>    datagram size (default %d)\n", cfg_size);
+  fprintf(stderr, "  -t <threads>  largest number of waiters (default %d)\n",
+          cfg_threads);
+  fprintf(stderr, "  -T <seconds>  duration of each round (default %d)\n",
+          cfg_seconds);
+  fprintf(stderr, "  -x            add sockets with EPOLLEXCLUSIVE\n");
+  fprintf(stderr, "  -e            add sockets with EPOLLET\n");
+  exit(1);
+}
+
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static int udp_socket(int port)
+{
+  struct sockaddr_in sa;
+  int fd;
+
+  TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(port);
+  TRY(bind(fd, (struct sockaddr*) &sa, sizeof(sa)));
+  return fd;
+}
+
+
+static void* waiter_fn(void* arg)
+{
+  struct waiter* w = arg;
+  static __thread char buf[MAX_SIZE];
+  struct epoll_event ev;
+  int n, got;
+
+  while( ! stop ) {
+    TRY(n = epoll_wait(epfd, &ev, 1, 100));
+    if( n == 0 )
+      continue;
+    ++w->wakeups;
+    if( __sync_fetch_and_add(&sock_busy[ev.data.u32], 1) != 0 )
+      ++w->shared_wakeups;
+    got = 0;
+    while( recv(socks[ev.data.u32], buf, MAX_SIZE, MSG_DONTWAIT) >= 0 )
+      ++got;
+    __sync_fetch_and_sub(&sock_busy[ev.data.u32], 1);
+    if( got == 0 )
+      ++w->empty_wakeups;
+    w->datagrams += got;
+  }
+  return NULL;
+}
+
+
+static void run_round(int n_threads)
+{
+  unsigned long wakeups = 0, empty = 0, shared = 0, datagrams = 0;
+  struct epoll_event ev;
+  double t;
+  int i;
+
+  TRY(epfd = epoll_create1(0));
+  for( i = 0; i < cfg_socks; ++i ) {
+    ev.events = EPOLLIN;
+    if( cfg_exclusive )
+      ev.events |= EPOLLEXCLUSIVE;
+    if( cfg_edge )
+      ev.events |= EPOLLET;
+    ev.data.u32 = i;
+    TRY(epoll_ctl(epfd, EPOLL_CTL_ADD, socks[i], &ev));
+  }
+
+  memset(waiters, 0, sizeof(waiters));
+  stop = 0;
+  t = now_sec();
+  for( i = 0; i < n_threads; ++i )
+    TRY(-pthread_create(&waiters[i].thread, NULL, waiter_fn, &waiters[i]));
+  sleep(cfg_seconds);
+  stop = 1;
+  for( i = 0; i < n_threads; ++i ) {
+    pthread_join(waiters[i].thread, NULL);
+    wakeups += waiters[i].wakeups;
+    empty += waiters[i].empty_wakeups;
+    shared += waiters[i].shared_wakeups;
+    datagrams += waiters[i].datagrams;
+  }
+  t = now_sec() - t;
+  close(epfd);
+
+  printf("%8d %14.0f %14.3f %10.3f %10.3f\n", n_threads, datagrams / t,
+         datagrams ? (double) wakeups / datagrams : 0.0,
+         wakeups ? (double) empty / wakeups : 0.0,
+         wakeups ? (double) shared / wakeups : 0.0);
+  fflush(stdout);
+}
+
+
+static int do_rx(void)
+{
+  int i, n;
+
+  for( i = 0; i < cfg_socks; ++i ) {
+    socks[i] = udp_socket(cfg_port + i);
+    TRY(fcntl(socks[i], F_SETFL, O_NONBLOCK));
+  }
+
+  printf("# socks=%d exclusive=%d edge=%d seconds=%d\n",
+         cfg_socks, cfg_exclusive, cfg_edge, cfg_seconds);
+  printf("#%7s %14s %14s %10s %10s\n", "waiters", "datagrams/s",
+         "wakeups/dgram", "empty", "shared");
+  for( n = 1; n <= cfg_threads; n *= 2 )
+    run_round(n);
+  return 0;
+}
+
+
+static int do_tx(const char* host)
+{
+  static char buf[MAX_SIZE];
+  struct addrinfo hints, *ai;
+  struct sockaddr_in sa;
+  int fd, i;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if( getaddrinfo(host, NULL, &hints, &ai) != 0 ) {
+    fprintf(stderr, "ERROR: could not resolve '%s'\n", host);
+    exit(1);
+  }
+  memcpy(&sa, ai->ai_addr, sizeof(sa));
+  freeaddrinfo(ai);
+  fd = udp_socket(0);
+
+  for( i = 0; ; i = (i + 1) % cfg_socks ) {
+    sa.sin_port = htons(cfg_port + i);
+    if( sendto(fd, buf, cfg_size, 0, (struct sockaddr*) &sa,
+               sizeof(sa)) < 0 && errno != EAGAIN && errno != ENOBUFS )
+      TRY(-1);
+  }
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int c;
+
+  while( (c = getopt(argc, argv, "p:S:s:t:T:xe")) != -1 )
+    switch( c ) {
+    case 'p':
+      cfg_port = atoi(optarg);
+      break;
+    case 'S':
+      cfg_socks = atoi(optarg);
+      break;
+    case 's':
+      cfg_size = atoi(optarg);
+      break;
+    case 't':
+      cfg_threads = atoi(optarg);
+      break;
+    case 'T':
+      cfg_seconds = atoi(optarg);
+      break;
+    case 'x':
+      cfg_exclusive = 1;
+      break;
+    case 'e':
+      cfg_edge = 1;
+      break;
+    default:
+      usage();
+    }
+  argc -= optind;
+  argv += optind;
+
+  if( cfg_socks < 1 || cfg_socks > MAX_SOCKS ||
+      cfg_size < 0 || cfg_size > MAX_SIZE ||
+      cfg_threads < 1 || cfg_threads > MAX_THREADS || cfg_seconds < 1 )
+    usage();
+
+  if( argc == 1 && ! strcmp(argv[0], "rx") )
+    return do_rx();
+  else if( argc == 2 && ! strcmp(argv[0], "tx") )
+    return do_tx(argv[1]);
+  usage();
+  return 1;
+}
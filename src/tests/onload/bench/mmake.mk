@@ -0,0 +1,17 @@
+# SPDX-License-Identifier: BSD-2-Clause
+# X-SPDX-Copyright-Text: (c) Copyright 2023 Advanced Micro Devices, Inc.
+TARGETS	:= udp_recvmmsg_bench udp_mcast_groups_bench onload_h_bench \
+	   epoll_wake_bench onload_ring_bench
+
+onload_h_bench: MMAKE_LIBS += $(LINK_ONLOAD_EXT_LIB)
+onload_h_bench: MMAKE_LIB_DEPS += $(ONLOAD_EXT_LIB_DEPEND)
+onload_ring_bench: MMAKE_LIBS += $(LINK_ONLOAD_EXT_LIB)
+onload_ring_bench: MMAKE_LIB_DEPS += $(ONLOAD_EXT_LIB_DEPEND)
+
+all: $(TARGETS)
+
+targets:
+	@echo $(TARGETS)
+
+clean:
+	@$(MakeClean)
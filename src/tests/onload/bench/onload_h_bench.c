@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/* Benchmark for the onload_h_* handle-based socket API.
+ *
+ * "call" measures the cost of a non-blocking receive on an empty UDP
+ * socket, which is almost all per-call overhead, through recv() and
+ * through onload_h_recv().
+ *
+ * "ping" and "pong" measure UDP round-trip latency with either API, chosen
+ * with -a on each side.
+ *
+ * Example:
+ * (host1)$ onload onload_h_bench call
+ * (host1)$ onload onload_h_bench -a handle pong
+ * (host2)$ onload onload_h_bench -a handle ping host1
+ * (host2)$ onload onload_h_bench -a socket ping host1
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+#include <onload/extensions_handle.h>
+
+
+#define MAX_SIZE   1472
+
+
+#define TRY(x)                                                          \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY(%s) failed\n", #x);                 \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d errno=%d (%s)\n",                 \
+                __rc, errno, strerror(errno));                          \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+
+static int cfg_port = 8080;
+static int cfg_size = 32;
+static int cfg_iters = 1000000;
+static int cfg_handle = 0;
+
+
+static void usage(void)
+{
+  fprintf(stderr, "usage:\n");
+  fprintf(stderr, "  onload_h_bench [options] call\n");
+  fprintf(stderr, "  onload_h_bench [options] pong\n");
+  fprintf(stderr, "  onload_h_bench [options] ping <host>\n");
+  fprintf(stderr, "\noptions:\n");
+  fprintf(stderr, "  -a socket|handle  API for ping and pong "
+          "(default socket)\n");
+  fprintf(stderr, "  -p <port>         UDP port (default %d)\n", cfg_port);
+  fprintf(stderr, "  -s <bytes>        datagram size (default %d)\n",
+          cfg_size);
+  fprintf(stderr, "  -n <iterations>   calls or round trips (default %d)\n",
+          cfg_iters);
+  exit(1);
+}
+
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static int udp_socket(int port)
+{
+  struct sockaddr_in sa;
+  int fd;
+
+  TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(port);
+  TRY(bind(fd, (struct sockaddr*) &sa, sizeof(sa)));
+  return fd;
+}
+
+
+static onload_h open_handle(int fd)
+{
+  onload_h h;
+  int rc = onload_h_open(fd, &h);
+
+  if( rc < 0 ) {
+    fprintf(stderr, "ERROR: onload_h_open failed: %s\n", strerror(-rc));
+    fprintf(stderr, "ERROR: is this running with Onload?\n");
+    exit(1);
+  }
+  return h;
+}
+
+
+static void send_one(int fd, onload_h h, const char* buf)
+{
+  if( cfg_handle )
+    TRY(onload_h_send(h, buf, cfg_size, 0) < 0 ? -1 : 0);
+  else
+    TRY(send(fd, buf, cfg_size, 0));
+}
+
+
+/* Spins until a datagram arrives. */
+static void recv_one(int fd, onload_h h, char* buf)
+{
+  ssize_t rc;
+
+  if( cfg_handle ) {
+    while( (rc = onload_h_recv(h, buf, MAX_SIZE, MSG_DONTWAIT)) == -EAGAIN )
+      ;
+    TRY(rc < 0 ? -1 : 0);
+  }
+  else {
+    while( (rc = recv(fd, buf, MAX_SIZE, MSG_DONTWAIT)) < 0 &&
+           errno == EAGAIN )
+      ;
+    TRY(rc);
+  }
+}
+
+
+static int do_call(void)
+{
+  static char buf[MAX_SIZE];
+  int fd = udp_socket(0);
+  onload_h h = open_handle(fd);
+  double t, t_sock, t_handle;
+  int i;
+
+  /* Warm up both paths */
+  for( i = 0; i < 1000; ++i ) {
+    recv(fd, buf, MAX_SIZE, MSG_DONTWAIT);
+    onload_h_recv(h, buf, MAX_SIZE, MSG_DONTWAIT);
+  }
+
+  t = now_sec();
+  for( i = 0; i < cfg_iters; ++i )
+    if( recv(fd, buf, MAX_SIZE, MSG_DONTWAIT) >= 0 )
+      break;
+  t_sock = now_sec() - t;
+
+  t = now_sec();
+  for( i = 0; i < cfg_iters; ++i )
+    if( onload_h_recv(h, buf, MAX_SIZE, MSG_DONTWAIT) >= 0 )
+      break;
+  t_handle = now_sec() - t;
+
+  printf("#%9s %12s\n", "api", "ns/call");
+  printf("%10s %12.1f\n", "socket", t_sock * 1e9 / cfg_iters);
+  printf("%10s %12.1f\n", "handle", t_handle * 1e9 / cfg_iters);
+
+  onload_h_close(h);
+  close(fd);
+  return 0;
+}
+
+
+static int do_pong(void)
+{
+  static char buf[MAX_SIZE];
+  struct sockaddr_storage from;
+  socklen_t from_len = sizeof(from);
+  int fd = udp_socket(cfg_port);
+  onload_h h;
+
+  /* Connect to the first pinger, so that send() knows where to reply */
+  TRY(recvfrom(fd, buf, MAX_SIZE, MSG_PEEK,
+               (struct sockaddr*) &from, &from_len));
+  TRY(connect(fd, (struct sockaddr*) &from, from_len));
+  h = cfg_handle ? open_handle(fd) : NULL;
+  while( 1 ) {
+    recv_one(fd, h, buf);
+    send_one(fd, h, buf);
+  }
+  return 0;
+}
+
+
+static int do_ping(const char* host)
+{
+  static char buf[MAX_SIZE];
+  struct addrinfo hints, *ai;
+  char port[16];
+  onload_h h;
+  double t;
+  int fd, i;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  snprintf(port, sizeof(port), "%d", cfg_port);
+  if( getaddrinfo(host, port, &hints, &ai) != 0 ) {
+    fprintf(stderr, "ERROR: could not resolve '%s'\n", host);
+    exit(1);
+  }
+  fd = udp_socket(0);
+  TRY(connect(fd, ai->ai_addr, ai->ai_addrlen));
+  freeaddrinfo(ai);
+  h = cfg_handle ? open_handle(fd) : NULL;
+
+  for( i = 0; i < cfg_iters / 10 + 1; ++i ) {
+    send_one(fd, h, buf);
+    recv_one(fd, h, buf);
+  }
+
+  t = now_sec();
+  for( i = 0; i < cfg_iters; ++i ) {
+    send_one(fd, h, buf);
+    recv_one(fd, h, buf);
+  }
+  t = now_sec() - t;
+
+  printf("# api=%s size=%d round_trips=%d\n",
+         cfg_handle ? "handle" : "socket", cfg_size, cfg_iters);
+  printf("mean half-RTT: %.3f usec\n", t * 1e6 / cfg_iters / 2);
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int c;
+
+  while( (c = getopt(argc, argv, "a:p:s:n:")) != -1 )
+    switch( c ) {
+    case 'a':
+      if( ! strcmp(optarg, "handle") )
+        cfg_handle = 1;
+      else if( ! strcmp(optarg, "socket") )
+        cfg_handle = 0;
+      else
+        usage();
+      break;
+    case 'p':
+      cfg_port = atoi(optarg);
+      break;
+    case 's':
+      cfg_size = atoi(optarg);
+      break;
+    case 'n':
+      cfg_iters = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  argc -= optind;
+  argv += optind;
+
+  if( cfg_size < 0 || cfg_size > MAX_SIZE || cfg_iters < 1 )
+    usage();
+
+  if( argc == 1 && ! strcmp(argv[0], "call") )
+    return do_call();
+  else if( argc == 1 && ! strcmp(argv[0], "pong") )
+    return do_pong();
+  else if( argc == 2 && ! strcmp(argv[0], "ping") )
+    return do_ping(argv[1]);
+  usage();
+  return 1;
+}
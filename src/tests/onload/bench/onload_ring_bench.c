@@ -0,0 +1,369 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/* Driver and benchmark for the onload_ring_* submission/completion API.
+ *
+ * "check" runs the ring over a TCP connection to itself and checks:
+ * - accept and connect submitted together both complete;
+ * - receives and sends on one socket complete in submission order;
+ * - a wait with nothing to complete sleeps rather than spinning, and
+ *   times out;
+ * - registered sockets keep their blocking mode;
+ * - operations on a registered socket that has been closed complete with
+ *   -EBADF.
+ *
+ * "ping" measures TCP round-trip latency over the same connection, with
+ * every send and receive going through the ring.
+ *
+ * Both need the connection to be accelerated, so run with a local
+ * interface address, or with loopback acceleration enabled.
+ *
+ * Example:
+ * $ EF_TCP_CLIENT_LOOPBACK=4 EF_TCP_SERVER_LOOPBACK=2 \
+ *     onload onload_ring_bench check
+ * $ onload onload_ring_bench ping 192.168.0.1
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <onload/extensions_ring.h>
+
+
+#define MSG_SIZE      4
+#define WAIT_MS       5000
+#define IDLE_WAIT_MS  200
+
+
+#define TRY(x)                                                          \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY(%s) failed\n", #x);                 \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d errno=%d (%s)\n",                 \
+                __rc, errno, strerror(errno));                          \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+#define TRY_RING(x)                                                     \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY_RING(%s) failed\n", #x);            \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d (%s)\n", __rc, strerror(-__rc));  \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+#define CHECK(cond)                                                     \
+  do {                                                                  \
+    if( ! (cond) ) {                                                    \
+      fprintf(stderr, "FAIL: %s\n", #cond);                             \
+      fprintf(stderr, "FAIL: at %s:%d\n", __FILE__, __LINE__);          \
+      exit(1);                                                          \
+    }                                                                   \
+  } while( 0 )
+
+
+static int cfg_port = 8080;
+static int cfg_iters = 100000;
+
+
+static void usage(void)
+{
+  fprintf(stderr, "usage:\n");
+  fprintf(stderr, "  onload_ring_bench [options] check [<local-addr>]\n");
+  fprintf(stderr, "  onload_ring_bench [options] ping [<local-addr>]\n");
+  fprintf(stderr, "\noptions:\n");
+  fprintf(stderr, "  -p <port>         TCP port (default %d)\n", cfg_port);
+  fprintf(stderr, "  -n <iterations>   round trips (default %d)\n",
+          cfg_iters);
+  exit(1);
+}
+
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static double cpu_sec(void)
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+
+/* A ring with a connection to itself.  Socket indices in the ring: */
+#define IDX_LISTEN  0
+#define IDX_CLIENT  1
+#define IDX_SERVER  2
+
+struct conn {
+  struct onload_ring ring;
+  int listen_fd;
+  int client_fd;
+  int server_fd;
+};
+
+
+static struct onload_ring_sqe* get_sqe(struct onload_ring* ring,
+                                       int opcode, int fd_index,
+                                       uint64_t user_data)
+{
+  struct onload_ring_sqe* sqe = onload_ring_get_sqe(ring);
+
+  CHECK(sqe != NULL);
+  sqe->opcode = opcode;
+  sqe->fd_index = fd_index;
+  sqe->user_data = user_data;
+  return sqe;
+}
+
+
+static void submit_buf(struct onload_ring* ring, int opcode, int fd_index,
+                       void* buf, int len, uint64_t user_data)
+{
+  struct onload_ring_sqe* sqe = get_sqe(ring, opcode, fd_index, user_data);
+
+  sqe->buf = buf;
+  sqe->len = len;
+}
+
+
+/* Waits for [n] completions and copies them out in the order the ring
+ * posted them. */
+static void reap(struct onload_ring* ring, struct onload_ring_cqe* cqes,
+                 int n)
+{
+  struct onload_ring_cqe* cqe;
+  int i;
+
+  TRY_RING(onload_ring_enter(ring, n, WAIT_MS));
+  for( i = 0; i < n; ++i ) {
+    CHECK((cqe = onload_ring_peek_cqe(ring)) != NULL);
+    cqes[i] = *cqe;
+    onload_ring_cqe_seen(ring);
+  }
+  CHECK(onload_ring_peek_cqe(ring) == NULL);
+}
+
+
+static void conn_open(struct conn* c, const char* addr)
+{
+  struct onload_ring_cqe cqes[2];
+  struct onload_ring_sqe* sqe;
+  struct sockaddr_in sa;
+  int one = 1, fd, rc, i;
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(cfg_port);
+  if( inet_pton(AF_INET, addr, &sa.sin_addr) != 1 )
+    usage();
+
+  TRY(c->listen_fd = socket(AF_INET, SOCK_STREAM, 0));
+  TRY(setsockopt(c->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)));
+  TRY(bind(c->listen_fd, (struct sockaddr*) &sa, sizeof(sa)));
+  TRY(listen(c->listen_fd, 1));
+  TRY(c->client_fd = socket(AF_INET, SOCK_STREAM, 0));
+  TRY(setsockopt(c->client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)));
+
+  rc = onload_ring_init(c->listen_fd, 64, 0, &c->ring);
+  if( rc < 0 ) {
+    fprintf(stderr, "ERROR: onload_ring_init failed: %s\n", strerror(-rc));
+    fprintf(stderr, "ERROR: is this running with Onload?\n");
+    exit(1);
+  }
+  fd = c->listen_fd;
+  CHECK(onload_ring_register_fds(&c->ring, &fd, 1) == IDX_LISTEN);
+  fd = c->client_fd;
+  CHECK(onload_ring_register_fds(&c->ring, &fd, 1) == IDX_CLIENT);
+
+  /* Neither can finish without the other */
+  get_sqe(&c->ring, ONLOAD_RING_OP_ACCEPT, IDX_LISTEN, 1);
+  sqe = get_sqe(&c->ring, ONLOAD_RING_OP_CONNECT, IDX_CLIENT, 2);
+  sqe->addr = (struct sockaddr*) &sa;
+  sqe->addrlen = sizeof(sa);
+  reap(&c->ring, cqes, 2);
+
+  c->server_fd = -1;
+  for( i = 0; i < 2; ++i ) {
+    if( cqes[i].user_data == 1 ) {
+      CHECK(cqes[i].res >= 0);
+      c->server_fd = cqes[i].res;
+    }
+    else {
+      CHECK(cqes[i].user_data == 2);
+      CHECK(cqes[i].res == 0);
+    }
+  }
+  CHECK(c->server_fd >= 0);
+  TRY(setsockopt(c->server_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)));
+  fd = c->server_fd;
+  CHECK(onload_ring_register_fds(&c->ring, &fd, 1) == IDX_SERVER);
+}
+
+
+static void conn_close(struct conn* c)
+{
+  TRY_RING(onload_ring_free(&c->ring));
+  if( c->server_fd >= 0 )
+    close(c->server_fd);
+  close(c->client_fd);
+  close(c->listen_fd);
+}
+
+
+static int do_check(const char* addr)
+{
+  struct onload_ring_cqe cqes[4];
+  char rx[2][MSG_SIZE];
+  char buf[MSG_SIZE];
+  struct conn c;
+  double t, cpu;
+
+  conn_open(&c, addr);
+  printf("accept and connect: ok\n");
+
+  /* The receives wait for the sends behind them, and each socket keeps
+   * its order */
+  submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER, rx[0], MSG_SIZE, 10);
+  submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER, rx[1], MSG_SIZE, 11);
+  submit_buf(&c.ring, ONLOAD_RING_OP_SEND, IDX_CLIENT, "ping", MSG_SIZE, 12);
+  submit_buf(&c.ring, ONLOAD_RING_OP_SEND, IDX_CLIENT, "pong", MSG_SIZE, 13);
+  reap(&c.ring, cqes, 4);
+  CHECK(cqes[0].user_data == 12 && cqes[0].res == MSG_SIZE);
+  CHECK(cqes[1].user_data == 13 && cqes[1].res == MSG_SIZE);
+  CHECK(cqes[2].user_data == 10 && cqes[2].res == MSG_SIZE);
+  CHECK(cqes[3].user_data == 11 && cqes[3].res == MSG_SIZE);
+  CHECK(! memcmp(rx[0], "ping", MSG_SIZE));
+  CHECK(! memcmp(rx[1], "pong", MSG_SIZE));
+  printf("send and recv order: ok\n");
+
+  /* Waiting on an idle receive sleeps until the timeout */
+  submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER, rx[0], MSG_SIZE, 20);
+  t = now_sec();
+  cpu = cpu_sec();
+  CHECK(onload_ring_enter(&c.ring, 1, IDLE_WAIT_MS) == 0);
+  t = now_sec() - t;
+  cpu = cpu_sec() - cpu;
+  CHECK(t * 1000 >= IDLE_WAIT_MS - 1);
+  printf("idle wait: %.0f ms, %.0f ms cpu\n", t * 1000, cpu * 1000);
+
+  /* The sockets are still in blocking mode, and an ordinary send wakes
+   * the ring */
+  CHECK(! (fcntl(c.client_fd, F_GETFL) & O_NONBLOCK));
+  CHECK(! (fcntl(c.server_fd, F_GETFL) & O_NONBLOCK));
+  TRY(send(c.client_fd, "data", MSG_SIZE, 0));
+  reap(&c.ring, cqes, 1);
+  CHECK(cqes[0].user_data == 20 && cqes[0].res == MSG_SIZE);
+  CHECK(! memcmp(rx[0], "data", MSG_SIZE));
+  printf("blocking mode kept: ok\n");
+
+  /* Operations on a closed socket fail */
+  TRY(close(c.server_fd));
+  c.server_fd = -1;
+  submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER, buf, MSG_SIZE, 30);
+  submit_buf(&c.ring, ONLOAD_RING_OP_SEND, IDX_SERVER, buf, MSG_SIZE, 31);
+  reap(&c.ring, cqes, 2);
+  CHECK(cqes[0].user_data == 30 && cqes[0].res == -EBADF);
+  CHECK(cqes[1].user_data == 31 && cqes[1].res == -EBADF);
+  printf("closed socket: ok\n");
+
+  /* So does a bad socket index */
+  get_sqe(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER + 1, 40);
+  reap(&c.ring, cqes, 1);
+  CHECK(cqes[0].user_data == 40 && cqes[0].res == -EINVAL);
+
+  conn_close(&c);
+  printf("all checks passed\n");
+  return 0;
+}
+
+
+static int do_ping(const char* addr)
+{
+  struct onload_ring_cqe cqes[4];
+  char tx[MSG_SIZE] = "ping";
+  char rx[MSG_SIZE], echo[MSG_SIZE];
+  struct conn c;
+  double t = 0;
+  int i, warm = cfg_iters / 10 + 1;
+
+  conn_open(&c, addr);
+
+  /* The client sends and the server receives, then the server echoes and
+   * the client receives the echo */
+  for( i = 0; i < warm + cfg_iters; ++i ) {
+    if( i == warm )
+      t = now_sec();
+    submit_buf(&c.ring, ONLOAD_RING_OP_SEND, IDX_CLIENT, tx, MSG_SIZE, 1);
+    submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_SERVER, echo, MSG_SIZE, 2);
+    reap(&c.ring, cqes, 2);
+    submit_buf(&c.ring, ONLOAD_RING_OP_SEND, IDX_SERVER, echo, MSG_SIZE, 3);
+    submit_buf(&c.ring, ONLOAD_RING_OP_RECV, IDX_CLIENT, rx, MSG_SIZE, 4);
+    reap(&c.ring, cqes, 2);
+    CHECK(cqes[1].user_data == 4 && cqes[1].res == MSG_SIZE);
+  }
+  t = now_sec() - t;
+
+  printf("# size=%d round_trips=%d\n", MSG_SIZE, cfg_iters);
+  printf("mean half-RTT: %.3f usec\n", t * 1e6 / cfg_iters / 2);
+  conn_close(&c);
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  const char* addr = "127.0.0.1";
+  int c;
+
+  while( (c = getopt(argc, argv, "p:n:")) != -1 )
+    switch( c ) {
+    case 'p':
+      cfg_port = atoi(optarg);
+      break;
+    case 'n':
+      cfg_iters = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  argc -= optind;
+  argv += optind;
+
+  if( cfg_iters < 1 || argc < 1 || argc > 2 )
+    usage();
+  if( argc == 2 )
+    addr = argv[1];
+
+  if( ! strcmp(argv[0], "check") )
+    return do_check(addr);
+  else if( ! strcmp(argv[0], "ping") )
+    return do_ping(addr);
+  usage();
+  return 1;
+}
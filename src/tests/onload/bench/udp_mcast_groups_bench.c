@@ -0,0 +1,261 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/* Benchmark for UDP multicast receive with many groups joined.
+ *
+ * The receiver joins a large number of consecutive multicast groups on a
+ * single port, spread over sockets that all share that port, and measures
+ * how many datagrams per second, and per second of CPU time, it can
+ * consume.  The sender sends to each of the groups in turn.
+ *
+ * Example:
+ * (host1)$ EF_UDP_MCAST_INDEX=0 onload udp_mcast_groups_bench -g 10000 rx
+ * (host1)$ EF_UDP_MCAST_INDEX=1 onload udp_mcast_groups_bench -g 10000 rx
+ * (host2)$ onload udp_mcast_groups_bench -g 10000 tx
+ *
+ * Add -i <local-address> on both sides to choose the interface.  The
+ * number of groups joined by each socket (-m) is limited by the kernel
+ * (net.ipv4.igmp_max_memberships).
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+
+#define MAX_SIZE   1472
+#define MAX_EVENTS 64
+
+
+#define TRY(x)                                                          \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY(%s) failed\n", #x);                 \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d errno=%d (%s)\n",                 \
+                __rc, errno, strerror(errno));                          \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+
+static int cfg_port = 8080;
+static int cfg_size = 32;
+static int cfg_groups = 10000;
+static int cfg_per_sock = 20;
+static int cfg_seconds = 10;
+static const char* cfg_group = "239.100.0.0";
+static const char* cfg_iface = NULL;
+
+
+static void usage(void)
+{
+  fprintf(stderr, "usage:\n");
+  fprintf(stderr, "  udp_mcast_groups_bench [options] rx\n");
+  fprintf(stderr, "  udp_mcast_groups_bench [options] tx\n");
+  fprintf(stderr, "\noptions:\n");
+  fprintf(stderr, "  -p <port>     UDP port (default %d)\n", cfg_port);
+  fprintf(stderr, "  -s <bytes>    tx: datagram size (default %d)\n", cfg_size);
+  fprintf(stderr, "  -g <n>        number of groups (default %d)\n",
+          cfg_groups);
+  fprintf(stderr, "  -a <group>    first group (default %s)\n", cfg_group);
+  fprintf(stderr, "  -i <addr>     address of the interface to use\n");
+  fprintf(stderr, "  -m <n>        rx: groups joined per socket "
+          "(default %d)\n", cfg_per_sock);
+  fprintf(stderr, "  -t <seconds>  rx: run time (default %d)\n",
+          cfg_seconds);
+  exit(1);
+}
+
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static double cpu_sec(void)
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+
+static struct in_addr parse_addr(const char* s)
+{
+  struct in_addr a;
+  if( inet_aton(s, &a) == 0 ) {
+    fprintf(stderr, "ERROR: bad address '%s'\n", s);
+    exit(1);
+  }
+  return a;
+}
+
+
+static struct in_addr nth_group(int n)
+{
+  struct in_addr a = parse_addr(cfg_group);
+  a.s_addr = htonl(ntohl(a.s_addr) + n);
+  return a;
+}
+
+
+static int do_rx(void)
+{
+  static char buf[MAX_SIZE];
+  struct epoll_event ev, events[MAX_EVENTS];
+  struct sockaddr_in sa;
+  struct ip_mreq mreq;
+  unsigned long long msgs = 0, last_msgs = 0;
+  double start, last, end, cpu_start, t;
+  int n_socks = (cfg_groups + cfg_per_sock - 1) / cfg_per_sock;
+  int one = 1, zero = 0;
+  int epfd, fd, i, g, n, rc;
+
+  TRY(epfd = epoll_create(1));
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(cfg_port);
+  memset(&mreq, 0, sizeof(mreq));
+  mreq.imr_interface.s_addr = cfg_iface ? parse_addr(cfg_iface).s_addr :
+                                          htonl(INADDR_ANY);
+
+  for( i = 0, g = 0; i < n_socks; ++i ) {
+    TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+    TRY(setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)));
+#ifdef IP_MULTICAST_ALL
+    TRY(setsockopt(fd, IPPROTO_IP, IP_MULTICAST_ALL, &zero, sizeof(zero)));
+#endif
+    TRY(bind(fd, (struct sockaddr*) &sa, sizeof(sa)));
+    for( n = 0; n < cfg_per_sock && g < cfg_groups; ++n, ++g ) {
+      mreq.imr_multiaddr = nth_group(g);
+      TRY(setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                     &mreq, sizeof(mreq)));
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    TRY(epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev));
+  }
+  printf("# groups=%d sockets=%d\n", cfg_groups, n_socks);
+
+  /* Wait for the first datagram so that the sender's start-up time does
+   * not count. */
+  TRY(epoll_wait(epfd, events, MAX_EVENTS, -1));
+  printf("#%9s %14s\n", "time", "msgs/sec");
+
+  start = last = now_sec();
+  end = start + cfg_seconds;
+  cpu_start = cpu_sec();
+  while( 1 ) {
+    TRY(n = epoll_wait(epfd, events, MAX_EVENTS, 0));
+    for( i = 0; i < n; ++i )
+      while( (rc = recv(events[i].data.fd, buf, MAX_SIZE,
+                        MSG_DONTWAIT)) >= 0 )
+        ++msgs;
+
+    t = now_sec();
+    if( t - last >= 1.0 ) {
+      printf("%10.1f %14.0f\n", t - start, (msgs - last_msgs) / (t - last));
+      fflush(stdout);
+      last = t;
+      last_msgs = msgs;
+    }
+    if( t >= end )
+      break;
+  }
+
+  t = now_sec() - start;
+  printf("# total: %llu msgs in %.1f sec: %.0f msgs/sec, "
+         "%.0f msgs/cpu-sec\n", msgs, t, msgs / t,
+         msgs / (cpu_sec() - cpu_start));
+  return 0;
+}
+
+
+static int do_tx(void)
+{
+  static char buf[MAX_SIZE];
+  struct sockaddr_in sa;
+  struct in_addr iface;
+  int fd, g;
+
+  TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+  if( cfg_iface != NULL ) {
+    iface = parse_addr(cfg_iface);
+    TRY(setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)));
+  }
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_port = htons(cfg_port);
+
+  for( g = 0; ; g = (g + 1) % cfg_groups ) {
+    sa.sin_addr = nth_group(g);
+    if( sendto(fd, buf, cfg_size, 0, (struct sockaddr*) &sa,
+               sizeof(sa)) < 0 && errno != EAGAIN && errno != ENOBUFS )
+      TRY(-1);
+  }
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int c;
+
+  while( (c = getopt(argc, argv, "p:s:g:a:i:m:t:")) != -1 )
+    switch( c ) {
+    case 'p':
+      cfg_port = atoi(optarg);
+      break;
+    case 's':
+      cfg_size = atoi(optarg);
+      break;
+    case 'g':
+      cfg_groups = atoi(optarg);
+      break;
+    case 'a':
+      cfg_group = optarg;
+      break;
+    case 'i':
+      cfg_iface = optarg;
+      break;
+    case 'm':
+      cfg_per_sock = atoi(optarg);
+      break;
+    case 't':
+      cfg_seconds = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  argc -= optind;
+  argv += optind;
+
+  if( cfg_size < 0 || cfg_size > MAX_SIZE ||
+      cfg_groups < 1 || cfg_per_sock < 1 )
+    usage();
+
+  if( argc == 1 && ! strcmp(argv[0], "rx") )
+    return do_rx();
+  else if( argc == 1 && ! strcmp(argv[0], "tx") )
+    return do_tx();
+  usage();
+  return 1;
+}
@@ -0,0 +1,225 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+/* Benchmark for UDP receive batching.
+ *
+ * Measures how many small datagrams per second, and per second of CPU
+ * time, a receiver can consume with recv() compared with recvmmsg() of
+ * a given batch size.
+ *
+ * Example:
+ * (host1)$ onload udp_recvmmsg_bench -b 1 rx
+ * (host1)$ onload udp_recvmmsg_bench -b 32 rx
+ * (host2)$ onload udp_recvmmsg_bench tx host1
+ *
+ * The receiver reports once a second and exits after the time given
+ * with -t.  The sender sends as fast as it can until it is killed.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netdb.h>
+
+
+#define MAX_BATCH  1024
+#define MAX_SIZE   1472
+
+
+#define TRY(x)                                                          \
+  do {                                                                  \
+    int __rc = (x);                                                     \
+      if( __rc < 0 ) {                                                  \
+        fprintf(stderr, "ERROR: TRY(%s) failed\n", #x);                 \
+        fprintf(stderr, "ERROR: at %s:%d\n", __FILE__, __LINE__);       \
+        fprintf(stderr, "ERROR: rc=%d errno=%d (%s)\n",                 \
+                __rc, errno, strerror(errno));                          \
+        exit(1);                                                        \
+      }                                                                 \
+  } while( 0 )
+
+
+static int cfg_port = 8080;
+static int cfg_size = 32;
+static int cfg_batch = 32;
+static int cfg_seconds = 10;
+
+
+static void usage(void)
+{
+  fprintf(stderr, "usage:\n");
+  fprintf(stderr, "  udp_recvmmsg_bench [options] rx\n");
+  fprintf(stderr, "  udp_recvmmsg_bench [options] tx <host>\n");
+  fprintf(stderr, "\noptions:\n");
+  fprintf(stderr, "  -p <port>     UDP port (default %d)\n", cfg_port);
+  fprintf(stderr, "  -s <bytes>    datagram size (default %d)\n", cfg_size);
+  fprintf(stderr, "  -b <n>        rx: recvmmsg() batch size, 1 to use "
+          "recv() (default %d)\n", cfg_batch);
+  fprintf(stderr, "  -t <seconds>  rx: run time (default %d)\n",
+          cfg_seconds);
+  exit(1);
+}
+
+
+static double now_sec(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static double cpu_sec(void)
+{
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 +
+         ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+}
+
+
+static int do_rx(void)
+{
+  static char bufs[MAX_BATCH][MAX_SIZE];
+  static struct iovec iov[MAX_BATCH];
+  static struct mmsghdr mmsg[MAX_BATCH];
+  struct sockaddr_in sa;
+  unsigned long long msgs = 0, calls = 0, last_msgs = 0;
+  double start, last, end, cpu_start, t;
+  int fd, i, rc;
+
+  TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(cfg_port);
+  TRY(bind(fd, (struct sockaddr*) &sa, sizeof(sa)));
+
+  for( i = 0; i < cfg_batch; ++i ) {
+    iov[i].iov_base = bufs[i];
+    iov[i].iov_len = MAX_SIZE;
+    memset(&mmsg[i], 0, sizeof(mmsg[i]));
+    mmsg[i].msg_hdr.msg_iov = &iov[i];
+    mmsg[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  /* Wait for the first datagram so that the sender's start-up time does
+   * not count. */
+  TRY(recv(fd, bufs[0], MAX_SIZE, 0));
+  printf("# batch=%d size=%d\n", cfg_batch, cfg_size);
+  printf("#%9s %14s\n", "time", "msgs/sec");
+
+  start = last = now_sec();
+  end = start + cfg_seconds;
+  cpu_start = cpu_sec();
+  while( 1 ) {
+    if( cfg_batch == 1 ) {
+      rc = recv(fd, bufs[0], MAX_SIZE, MSG_DONTWAIT);
+      if( rc >= 0 )
+        rc = 1;
+    }
+    else {
+      rc = recvmmsg(fd, mmsg, cfg_batch, MSG_DONTWAIT, NULL);
+    }
+    if( rc > 0 ) {
+      msgs += rc;
+      ++calls;
+    }
+    else if( rc < 0 && errno != EAGAIN ) {
+      TRY(rc);
+    }
+
+    if( (calls & 0xff) == 0 || rc <= 0 ) {
+      t = now_sec();
+      if( t - last >= 1.0 ) {
+        printf("%10.1f %14.0f\n", t - start,
+               (msgs - last_msgs) / (t - last));
+        fflush(stdout);
+        last = t;
+        last_msgs = msgs;
+      }
+      if( t >= end )
+        break;
+    }
+  }
+
+  t = now_sec() - start;
+  printf("# total: %llu msgs in %.1f sec: %.0f msgs/sec, "
+         "%.0f msgs/cpu-sec, %.2f msgs/call\n", msgs, t, msgs / t,
+         msgs / (cpu_sec() - cpu_start), calls ? (double) msgs / calls : 0.0);
+  close(fd);
+  return 0;
+}
+
+
+static int do_tx(const char* host)
+{
+  static char buf[MAX_SIZE];
+  struct addrinfo hints, *ai;
+  int fd, rc;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if( (rc = getaddrinfo(host, NULL, &hints, &ai)) != 0 ) {
+    fprintf(stderr, "ERROR: %s: %s\n", host, gai_strerror(rc));
+    exit(1);
+  }
+  ((struct sockaddr_in*) ai->ai_addr)->sin_port = htons(cfg_port);
+
+  TRY(fd = socket(AF_INET, SOCK_DGRAM, 0));
+  TRY(connect(fd, ai->ai_addr, ai->ai_addrlen));
+  freeaddrinfo(ai);
+
+  while( 1 )
+    if( send(fd, buf, cfg_size, 0) < 0 && errno != EAGAIN &&
+        errno != ENOBUFS && errno != ECONNREFUSED )
+      TRY(-1);
+  return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+  int c;
+
+  while( (c = getopt(argc, argv, "p:s:b:t:")) != -1 )
+    switch( c ) {
+    case 'p':
+      cfg_port = atoi(optarg);
+      break;
+    case 's':
+      cfg_size = atoi(optarg);
+      break;
+    case 'b':
+      cfg_batch = atoi(optarg);
+      break;
+    case 't':
+      cfg_seconds = atoi(optarg);
+      break;
+    default:
+      usage();
+    }
+  argc -= optind;
+  argv += optind;
+
+  if( cfg_size < 0 || cfg_size > MAX_SIZE ||
+      cfg_batch < 1 || cfg_batch > MAX_BATCH )
+    usage();
+
+  if( argc == 1 && ! strcmp(argv[0], "rx") )
+    return do_rx();
+  else if( argc == 2 && ! strcmp(argv[0], "tx") )
+    return do_tx(argv[1]);
+  usage();
+  return 1;
+}
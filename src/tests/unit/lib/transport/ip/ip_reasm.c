@@ -0,0 +1,373 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Functions under test */
+#include <ci/internal/ip.h>
+
+/* Test infrastructure */
+#include "unit_test.h"
+
+
+/* Dependencies */
+static int n_passed, n_freed;
+
+int ci_netif_pkt_pass_to_kernel(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  CHECK_TRUE(OO_PP_IS_NULL(pkt->frag_next));
+  CHECK(pkt->n_buffers, ==, 1);
+  ++n_passed;
+  return 1;
+}
+
+void ci_netif_pkt_free(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  ++n_freed;
+  if( OO_PP_NOT_NULL(pkt->frag_next) ) {
+    ci_netif_pkt_release(ni, PKT_CHK(ni, pkt->frag_next));
+    pkt->frag_next = OO_PP_NULL;
+  }
+}
+
+unsigned ci_ip_csum_partial(unsigned sum, const volatile void* in_buf,
+                            int bytes)
+{
+  const ci_uint8* p = (const ci_uint8*) in_buf;
+  ci_uint16 word;
+
+  for( ; bytes > 1; bytes -= 2, p += 2 ) {
+    memcpy(&word, p, 2);
+    sum += word;
+  }
+  if( bytes ) {
+    word = 0;
+    memcpy(&word, p, 1);
+    sum += word;
+  }
+  return sum;
+}
+
+/* Timers are "pending" while linked on a list of their own. */
+void __ci_ip_timer_set(ci_netif* ni, ci_ip_timer* ts, ci_iptime_t t)
+{
+  ts->time = t;
+  oo_p_dllink_add(ni, oo_p_dllink_ptr(ni, &ni->state->timeout_q[0]),
+                  oo_p_dllink_statep(ni, ts->statep));
+}
+
+
+/* A stack with packet buffers to build fragments in. */
+#define REASM_TEST_PKTS  256
+#define REASM_TEST_SADDR CI_BSWAPC_BE32(0x0a000001)
+#define REASM_TEST_DADDR CI_BSWAPC_BE32(0xe0000001)
+
+static char* reasm_test_bufs;
+static int reasm_test_next_pkt;
+
+static ci_netif* reasm_test_init(void)
+{
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_netif_state* ns = calloc(1, sizeof(*ns));
+  int i, n_sets = (REASM_TEST_PKTS + PKTS_PER_SET - 1) / PKTS_PER_SET;
+
+  ni->state = ns;
+  reasm_test_bufs = calloc(n_sets << CI_CFG_PKTS_PER_SET_S,
+                           CI_CFG_PKT_BUF_SIZE);
+  ni->pkt_bufs = calloc(n_sets, sizeof(ni->pkt_bufs[0]));
+  ni->packets = calloc(1, sizeof(*ni->packets));
+  for( i = 0; i < n_sets; ++i )
+    ni->pkt_bufs[i] = reasm_test_bufs +
+                      ((size_t) i << CI_CFG_PKTS_PER_SET_S) *
+                      CI_CFG_PKT_BUF_SIZE;
+  *(ci_uint32*) &ni->packets->sets_n = n_sets;
+  *(ci_int32*) &ni->packets->n_pkts_allocated =
+                                        n_sets << CI_CFG_PKTS_PER_SET_S;
+  reasm_test_next_pkt = 0;
+  n_passed = n_freed = 0;
+
+  ns->lock.lock = CI_EPLOCK_LOCKED;
+  ns->opts.ip_reasm = 1;
+  ns->opts.ip_reasm_timeout = 100;
+  ns->opts.max_rx_packets = 1024;
+  ns->opts.ip_reasm_max_fraction = 1;
+  /* One tick per millisecond */
+  ns->iptimer_state.ci_ip_time_ms2tick_fxp = 1ull << 32;
+  ns->iptimer_state.sched_ticks = 1;
+
+  oo_p_dllink_init(ni, oo_p_dllink_ptr(ni, &ns->timeout_q[0]));
+  ci_ip_timer_init(ni, &ns->reasm_tid, oo_ptr_to_statep(ni, &ns->reasm_tid),
+                   "reas");
+  ns->reasm_tid.fn = CI_IP_TIMER_NETIF_REASM;
+  for( i = 0; i < CI_CFG_IP_REASM_SLOTS; ++i )
+    ns->reasm[i].frags = OO_PP_NULL;
+  return ni;
+}
+
+static void reasm_test_fini(ci_netif* ni)
+{
+  free(ni->packets);
+  free(ni->pkt_bufs);
+  free(reasm_test_bufs);
+  free(ni->state);
+  free(ni);
+}
+
+/* A UDP datagram of [len] bytes including its header, with a valid
+ * checksum. */
+static ci_uint8* reasm_test_dgram(int len)
+{
+  ci_uint8* dgram = calloc(1, len);
+  ci_udp_hdr* udp = (ci_udp_hdr*) dgram;
+  ci_uint32 addrs[2] = { REASM_TEST_SADDR, REASM_TEST_DADDR };
+  unsigned sum;
+  int i;
+
+  for( i = sizeof(*udp); i < len; ++i )
+    dgram[i] = i * 7;
+  udp->udp_source_be16 = CI_BSWAPC_BE16(1234);
+  udp->udp_dest_be16 = CI_BSWAPC_BE16(5678);
+  udp->udp_len_be16 = CI_BSWAP_BE16(len);
+  sum = ci_ip_csum_partial(0, addrs, 8);
+  sum += CI_BSWAPC_BE16(IPPROTO_UDP) + udp->udp_len_be16;
+  sum = ci_ip_csum_partial(sum, dgram, len);
+  udp->udp_check_be16 = ci_udp_csum_finish(sum);
+  return dgram;
+}
+
+/* A received fragment carrying [len] bytes at [off] of [dgram]. */
+static ci_ip_pkt_fmt* reasm_test_frag(ci_netif* ni, const ci_uint8* dgram,
+                                      int id, int off, int len, int more)
+{
+  ci_ip_pkt_fmt* pkt = PKT(ni, reasm_test_next_pkt);
+  ci_ip4_hdr* ip;
+
+  OO_PKT_PP_INIT(pkt, reasm_test_next_pkt);
+  ++reasm_test_next_pkt;
+  pkt->refcount = 1;
+  pkt->n_buffers = 1;
+  pkt->frag_next = OO_PP_NULL;
+  pkt->rx_flags = 0;
+  pkt->pkt_start_off = 0;
+  pkt->pkt_eth_payload_off = 14;
+  pkt->pay_len = 14 + sizeof(*ip) + len;
+  oo_offbuf_init(&pkt->buf, PKT_START(pkt), pkt->pay_len);
+
+  ip = oo_ip_hdr(pkt);
+  memset(ip, 0, sizeof(*ip));
+  ip->ip_ihl_version = CI_IP4_IHL_VERSION(sizeof(*ip));
+  ip->ip_tot_len_be16 = CI_BSWAP_BE16(sizeof(*ip) + len);
+  ip->ip_id_be16 = CI_BSWAP_BE16(id);
+  ip->ip_frag_off_be16 = CI_IP4_MAKE_OFFSET(off) |
+                         (more ? CI_IP4_FRAG_MORE : 0);
+  ip->ip_protocol = IPPROTO_UDP;
+  ip->ip_saddr_be32 = REASM_TEST_SADDR;
+  ip->ip_daddr_be32 = REASM_TEST_DADDR;
+  memcpy(ip + 1, dgram + off, len);
+  return pkt;
+}
+
+/* CHECK() evaluates its arguments more than once. */
+#define CHECK_REASM_RX(NI, PKT, EXPECT)                 \
+  do {                                                  \
+    ci_ip_pkt_fmt* out_ = ci_ip_reasm_rx((NI), (PKT));  \
+    CHECK(out_, ==, (EXPECT));                          \
+  } while( 0 )
+
+/* Returns true if the chain from [pkt] holds exactly [dgram]. */
+static int reasm_test_chain_matches(ci_netif* ni, ci_ip_pkt_fmt* pkt,
+                                    const ci_uint8* dgram, int len)
+{
+  int off = 0, n = pkt->n_buffers;
+
+  while( 1 ) {
+    if( pkt->n_buffers != n-- ||
+        off + oo_offbuf_left(&pkt->buf) > len ||
+        memcmp(oo_offbuf_ptr(&pkt->buf), dgram + off,
+               oo_offbuf_left(&pkt->buf)) )
+      return 0;
+    off += oo_offbuf_left(&pkt->buf);
+    if( OO_PP_IS_NULL(pkt->frag_next) )
+      break;
+    pkt = PKT_CHK(ni, pkt->frag_next);
+  }
+  return off == len && n == 0;
+}
+
+
+static void test_ci_ip_reasm_in_order(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_uint8* dgram = reasm_test_dgram(3000);
+  ci_ip_pkt_fmt* head = reasm_test_frag(ni, dgram, 1, 0, 1480, 1);
+  ci_ip_pkt_fmt* pkt;
+
+  CHECK_REASM_RX(ni, head, NULL);
+  CHECK_TRUE(ci_ip_timer_pending(ni, &ni->state->reasm_tid));
+  CHECK(ni->state->reasm_tid.time, ==, 100);
+  pkt = reasm_test_frag(ni, dgram, 1, 1480, 1480, 1);
+  CHECK_REASM_RX(ni, pkt, NULL);
+  CHECK(ni->state->reasm_n_pkts, ==, 2);
+
+  pkt = reasm_test_frag(ni, dgram, 1, 2960, 40, 0);
+  CHECK_REASM_RX(ni, pkt, head);
+  CHECK_TRUE(reasm_test_chain_matches(ni, head, dgram, 3000));
+  CHECK(head->pay_len, ==, 14 + 20 + 3000);
+  CHECK(ni->state->reasm_n_pkts, ==, 0);
+  CHECK_FALSE(ci_ip_timer_pending(ni, &ni->state->reasm_tid));
+  CHECK(ni->state->stats.ip_reasm_frags, ==, 3);
+  CHECK(ni->state->stats.ip_reasm_oks, ==, 1);
+  CHECK(n_passed, ==, 0);
+  CHECK(n_freed, ==, 0);
+
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_reorder(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_uint8* dgram = reasm_test_dgram(4000);
+  ci_ip_pkt_fmt* head;
+  ci_ip_pkt_fmt* pkt;
+
+  /* Last first, then a duplicate of it, and the start in the middle */
+  pkt = reasm_test_frag(ni, dgram, 2, 3000, 1000, 0);
+  CHECK_REASM_RX(ni, pkt, NULL);
+  pkt = reasm_test_frag(ni, dgram, 2, 3000, 1000, 0);
+  CHECK_REASM_RX(ni, pkt, NULL);
+  CHECK(n_freed, ==, 1);
+  head = reasm_test_frag(ni, dgram, 2, 0, 1000, 1);
+  CHECK_REASM_RX(ni, head, NULL);
+  pkt = reasm_test_frag(ni, dgram, 2, 2000, 1000, 1);
+  CHECK_REASM_RX(ni, pkt, NULL);
+  pkt = reasm_test_frag(ni, dgram, 2, 1000, 1000, 1);
+  CHECK_REASM_RX(ni, pkt, head);
+  CHECK_TRUE(reasm_test_chain_matches(ni, head, dgram, 4000));
+  CHECK(head->n_buffers, ==, 4);
+  CHECK(ni->state->stats.ip_reasm_oks, ==, 1);
+
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_interleaved(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_uint8* dgram1 = reasm_test_dgram(2000);
+  ci_uint8* dgram2 = reasm_test_dgram(2400);
+  ci_ip_pkt_fmt* head1 = reasm_test_frag(ni, dgram1, 10, 0, 1000, 1);
+  ci_ip_pkt_fmt* head2 = reasm_test_frag(ni, dgram2, 11, 0, 1200, 1);
+
+  CHECK_REASM_RX(ni, head1, NULL);
+  CHECK_REASM_RX(ni, head2, NULL);
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram2, 11, 1200, 1200, 0), head2);
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram1, 10, 1000, 1000, 0), head1);
+  CHECK_TRUE(reasm_test_chain_matches(ni, head1, dgram1, 2000));
+  CHECK_TRUE(reasm_test_chain_matches(ni, head2, dgram2, 2400));
+
+  free(dgram1);
+  free(dgram2);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_overlap(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_uint8* dgram = reasm_test_dgram(3000);
+
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 3, 0, 1480, 1), NULL);
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 3, 1000, 2000, 0), NULL);
+
+  /* Both fragments go to the kernel to deal with */
+  CHECK(n_passed, ==, 2);
+  CHECK(ni->state->stats.ip_reasm_fails, ==, 1);
+  CHECK(ni->state->reasm_n_pkts, ==, 0);
+  CHECK_FALSE(ci_ip_timer_pending(ni, &ni->state->reasm_tid));
+
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_bad_csum(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_uint8* dgram = reasm_test_dgram(2000);
+
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 4, 0, 1000, 1), NULL);
+  dgram[1500] ^= 0x40;
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 4, 1000, 1000, 0), NULL);
+  CHECK(ni->state->stats.ip_reasm_fails, ==, 1);
+  CHECK(n_freed, ==, 2);
+  CHECK(n_passed, ==, 0);
+
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_timeout(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_netif_state* ns = ni->state;
+  ci_uint8* dgram = reasm_test_dgram(3000);
+
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 5, 0, 1480, 1), NULL);
+  ns->iptimer_state.ci_ip_time_real_ticks = 50;
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 6, 0, 1480, 1), NULL);
+  CHECK(ns->reasm_tid.time, ==, 100);
+
+  /* The first datagram expires, and the timer moves on to the second */
+  ns->iptimer_state.ci_ip_time_real_ticks = 100;
+  oo_p_dllink_del_init(ni, oo_p_dllink_statep(ni, ns->reasm_tid.statep));
+  ci_ip_reasm_timeout(ni);
+  CHECK(n_passed, ==, 1);
+  CHECK(ns->stats.ip_reasm_timeouts, ==, 1);
+  CHECK(ns->reasm_n_pkts, ==, 1);
+  CHECK_TRUE(ci_ip_timer_pending(ni, &ns->reasm_tid));
+  CHECK(ns->reasm_tid.time, ==, 150);
+
+  ci_ip_reasm_flush(ni);
+  CHECK(n_freed, ==, 1);
+  CHECK(ns->reasm_n_pkts, ==, 0);
+  CHECK_FALSE(ci_ip_timer_pending(ni, &ns->reasm_tid));
+
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+static void test_ci_ip_reasm_limits(void)
+{
+  ci_netif* ni = reasm_test_init();
+  ci_netif_state* ns = ni->state;
+  ci_uint8* dgram = reasm_test_dgram(3000);
+  int i;
+
+  /* A full table makes room by passing the oldest datagram to the kernel */
+  for( i = 0; i <= CI_CFG_IP_REASM_SLOTS; ++i ) {
+    ns->iptimer_state.ci_ip_time_real_ticks = i;
+    CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 100 + i, 0, 1480, 1), NULL);
+  }
+  CHECK(ns->stats.ip_reasm_evictions, ==, 1);
+  CHECK(n_passed, ==, 1);
+  CHECK(ns->reasm_n_pkts, ==, CI_CFG_IP_REASM_SLOTS);
+
+  /* So does exceeding the share of receive buffers */
+  ns->opts.ip_reasm_max_fraction = 7;  /* 1024 >> 7 = 8 buffers */
+  CHECK_REASM_RX(ni, reasm_test_frag(ni, dgram, 101, 1480, 1480, 1), NULL);
+  CHECK(ns->reasm_n_pkts, ==, 8);
+  CHECK(ns->stats.ip_reasm_evictions, ==, 1 + CI_CFG_IP_REASM_SLOTS - 7);
+
+  ci_ip_reasm_flush(ni);
+  free(dgram);
+  reasm_test_fini(ni);
+}
+
+int main(void)
+{
+  TEST_RUN(test_ci_ip_reasm_in_order);
+  TEST_RUN(test_ci_ip_reasm_reorder);
+  TEST_RUN(test_ci_ip_reasm_interleaved);
+  TEST_RUN(test_ci_ip_reasm_overlap);
+  TEST_RUN(test_ci_ip_reasm_bad_csum);
+  TEST_RUN(test_ci_ip_reasm_timeout);
+  TEST_RUN(test_ci_ip_reasm_limits);
+  TEST_END();
+}
@@ -6,11 +6,14 @@
 
 /* Test infrastructure */
 #include "unit_test.h"
+#include <time.h>
 
 /* Expectations */
 static ci_netif* expect_ni;
 static ci_ip_pkt_fmt* expect_pkt;
 static ci_tcp_hdr* expect_tcp;
+/* Set by the fixtures that work on whole queues of packets */
+static int expect_any_pkt;
 
 /* Dependencies */
 /* TODO These should allow control of return value and side effects to exercise
@@ -21,11 +24,14 @@ void ci_assert_valid_pkt(ci_netif* ni, ci_ip_pkt_fmt* pkt,
                          const char* file, int line)
 {
   CHECK(ni, ==, expect_ni);
-  CHECK(pkt, ==, expect_pkt);
+  if( ! expect_any_pkt )
+    CHECK(pkt, ==, expect_pkt);
   CHECK_TRUE(ni_locked);
 }
 
 static int filter_count;
+/* Socket to which the filter delivers, if any */
+static ci_sock_cmn* filter_sock;
 
 int
 ci_netif_filter_for_each_match(ci_netif* ni,
@@ -40,13 +46,15 @@ ci_netif_filter_for_each_match(ci_netif* ni,
   CHECK(intf_i, ==, expect_pkt->intf_i);
   CHECK(vlan, ==, expect_pkt->vlan);
 
-  switch( filter_count++ ) {
+  switch( filter_count++ % 3 ) {
   case 0:
     /* First attempt: established connections with src->dest addr/port */
     CHECK(laddr, ==, oo_ip_hdr(expect_pkt)->ip_daddr_be32);
     CHECK(lport, ==, expect_tcp->tcp_dest_be16);
     CHECK(raddr, ==, oo_ip_hdr(expect_pkt)->ip_saddr_be32);
     CHECK(rport, ==, expect_tcp->tcp_source_be16);
+    if( filter_sock != NULL )
+      return callback(filter_sock, callback_arg);
     break;
 
   case 1:
@@ -69,14 +77,31 @@ ci_netif_filter_for_each_match(ci_netif* ni,
   return 0;
 }
 
+/* Packets passed to the kernel by the tests that expect any packet */
+#define KERNEL_PKTS_MAX 8
+static ci_ip_pkt_fmt* kernel_pkts[KERNEL_PKTS_MAX];
+static int kernel_count;
+
 int ci_netif_pkt_pass_to_kernel(ci_netif* ni, ci_ip_pkt_fmt* pkt)
 {
   CHECK(ni, ==, expect_ni);
-  CHECK(pkt, ==, expect_pkt);
+  if( ! expect_any_pkt )
+    CHECK(pkt, ==, expect_pkt);
+  else if( kernel_count < KERNEL_PKTS_MAX )
+    kernel_pkts[kernel_count++] = pkt;
 
   return 1;
 }
 
+int ci_tcp_parse_options(ci_netif* ni, ciip_tcp_rx_pkt* rxp,
+                         ci_tcp_options* topts)
+{
+  /* The tests send no options */
+  CHECK(CI_TCP_HDR_LEN(rxp->tcp), ==, sizeof(ci_tcp_hdr));
+  rxp->flags = 0;
+  return 0;
+}
+
 /* TODO parametrise, or have multiple variants, to test multiple control paths.
  * This just tests a simple path: a TCP/IPv4 packet with no matching filter is
  * passed to the kernel. */
@@ -130,9 +155,637 @@ static void test_ci_tcp_handle_rx(void)
   STATE_FREE(tcp);
 }
 
+/* A locked stack with a socket whose retransmit queue holds [n] packets of
+ * [len] bytes each, starting at [seq].  The socket and an aux buffer share
+ * an allocation with the stack's state, and the packet buffers are laid out
+ * as the stack's packet sets would be. */
+#define SACK_TEST_SEQ 1000
+#define SACK_TEST_LEN 1000
+
+struct sack_test_state {
+  ci_netif_state ns;
+  ci_tcp_state ts;
+  ci_ni_aux_mem aux;
+};
+
+static char* sack_test_bufs;
+
+static ci_netif* sack_test_init(ci_tcp_state** ts_out, int n)
+{
+  int i, n_sets = (n + PKTS_PER_SET - 1) / PKTS_PER_SET;
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  struct sack_test_state* st = calloc(1, sizeof(*st));
+  ci_tcp_state* ts = &st->ts;
+  ci_ip_pkt_fmt* pkt;
+
+  ni->state = &st->ns;
+  sack_test_bufs = calloc(n_sets << CI_CFG_PKTS_PER_SET_S,
+                          CI_CFG_PKT_BUF_SIZE);
+  ni->pkt_bufs = calloc(n_sets, sizeof(ni->pkt_bufs[0]));
+  ni->packets = calloc(1, sizeof(*ni->packets));
+  for( i = 0; i < n_sets; ++i )
+    ni->pkt_bufs[i] = sack_test_bufs +
+                      ((size_t) i << CI_CFG_PKTS_PER_SET_S) *
+                      CI_CFG_PKT_BUF_SIZE;
+  *(ci_uint32*) &ni->packets->sets_n = n_sets;
+  *(ci_int32*) &ni->packets->n_pkts_allocated =
+                                        n_sets << CI_CFG_PKTS_PER_SET_S;
+  ni->state->lock.lock = CI_EPLOCK_LOCKED;
+  expect_ni = ni;
+  expect_any_pkt = 1;
+
+  ci_ip_queue_init(&ts->retrans);
+  for( i = 0; i < n; ++i ) {
+    pkt = (ci_ip_pkt_fmt*) (sack_test_bufs + (size_t) i * CI_CFG_PKT_BUF_SIZE);
+    OO_PKT_PP_INIT(pkt, i);
+    pkt->next = OO_PP_NULL;
+    pkt->pf.tcp_tx.start_seq = SACK_TEST_SEQ + i * SACK_TEST_LEN;
+    pkt->pf.tcp_tx.end_seq = SACK_TEST_SEQ + (i + 1) * SACK_TEST_LEN;
+    pkt->pf.tcp_tx.block_end = OO_PP_NULL;
+    pkt->pf.tcp_tx.sock_id = ts->s.b.bufid;
+    if( i > 0 )
+      PKT(ni, i - 1)->next = OO_PKT_P(pkt);
+  }
+  OO_PP_INIT(ni, ts->retrans.head, 0);
+  OO_PP_INIT(ni, ts->retrans.tail, n - 1);
+  ts->retrans.num = n;
+  ts->snd_una = SACK_TEST_SEQ;
+  ts->snd_nxt = SACK_TEST_SEQ + n * SACK_TEST_LEN;
+  ts->tcpflags = CI_TCPT_FLAG_SACK;
+  ts->sack_hint = OO_PP_NULL;
+  ts->cc_state = OO_P_NULL;
+  ts->rob_index = OO_P_NULL;
+  *ts_out = ts;
+  return ni;
+}
+
+static void sack_test_fini(ci_netif* ni)
+{
+  expect_any_pkt = 0;
+  free(ni->packets);
+  free(ni->pkt_bufs);
+  free(sack_test_bufs);
+  free(ni->state);
+  free(ni);
+}
+
+static unsigned sack_seq(int i)
+{
+  return SACK_TEST_SEQ + i * SACK_TEST_LEN;
+}
+
+/* Process an ACK for the head of the queue carrying SACK blocks, given as
+ * pairs of first and last packet index, most recent first as a peer sends
+ * them.  Returns non-zero if anything new was SACKed. */
+static int sack_ack(ci_netif* ni, ci_tcp_state* ts, int n_blocks,
+                    const int* blocks)
+{
+  ciip_tcp_rx_pkt rxp;
+  ci_tcp_hdr tcp;
+  int i;
+
+  memset(&rxp, 0, sizeof(rxp));
+  memset(&tcp, 0, sizeof(tcp));
+  rxp.tcp = &tcp;
+  rxp.flags = CI_TCPT_FLAG_SACK;
+  rxp.ack = tcp_snd_una(ts);
+  rxp.sack_blocks = n_blocks;
+  for( i = 0; i < n_blocks; ++i ) {
+    rxp.sack[2 * i] = sack_seq(blocks[2 * i]);
+    rxp.sack[2 * i + 1] = sack_seq(blocks[2 * i + 1] + 1);
+  }
+  ci_tcp_rx_sack_process(ni, ts, &rxp);
+  return (rxp.flags & CI_TCP_SACKED) != 0;
+}
+
+static int sack_block(ci_netif* ni, ci_tcp_state* ts, int first, int last)
+{
+  int block[2] = { first, last };
+  return sack_ack(ni, ts, 1, block);
+}
+
+static int sack_block_end(ci_netif* ni, int i)
+{
+  return OO_PKT_ID(ci_tcp_rtq_block_end(ni, PKT(ni, i)));
+}
+
+static int sack_is_sacked(ci_netif* ni, int i)
+{
+  return (PKT(ni, i)->flags & CI_PKT_FLAG_RTQ_SACKED) != 0;
+}
+
+static void test_ci_tcp_rx_sack_process_block(void)
+{
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  int i, rc;
+
+  ni = sack_test_init(&ts, 8);
+
+  /* A new block splits the unSACKed region */
+  rc = sack_block(ni, ts, 2, 3);
+  CHECK(rc, ==, 1);
+  CHECK_FALSE(sack_is_sacked(ni, 1));
+  CHECK_TRUE(sack_is_sacked(ni, 2));
+  CHECK_TRUE(sack_is_sacked(ni, 3));
+  CHECK_FALSE(sack_is_sacked(ni, 4));
+  CHECK(sack_block_end(ni, 0), ==, 1);
+  CHECK(sack_block_end(ni, 2), ==, 3);
+  CHECK_TRUE(OO_PP_IS_NULL(PKT(ni, 4)->pf.tcp_tx.block_end));
+
+  /* Extending it reaches the new end from every packet of the block */
+  rc = sack_block(ni, ts, 2, 4);
+  CHECK(rc, ==, 1);
+  CHECK(sack_block_end(ni, 2), ==, 4);
+  CHECK(sack_block_end(ni, 3), ==, 4);
+
+  /* Nothing new */
+  rc = sack_block(ni, ts, 3, 4);
+  CHECK(rc, ==, 0);
+
+  /* A second block, then the hole between them is filled */
+  rc = sack_block(ni, ts, 6, 6);
+  CHECK(rc, ==, 1);
+  CHECK(sack_block_end(ni, 5), ==, 5);
+  rc = sack_block(ni, ts, 5, 5);
+  CHECK(rc, ==, 1);
+  for( i = 2; i <= 6; ++i ) {
+    CHECK_TRUE(sack_is_sacked(ni, i));
+    CHECK(sack_block_end(ni, i), ==, 6);
+  }
+  CHECK_FALSE(sack_is_sacked(ni, 7));
+
+  /* A block that starts before the hint is found from the head */
+  rc = sack_block(ni, ts, 1, 1);
+  CHECK(rc, ==, 1);
+  CHECK(sack_block_end(ni, 0), ==, 0);
+  CHECK(sack_block_end(ni, 1), ==, 6);
+
+  sack_test_fini(ni);
+}
+
+static long long sack_test_usec(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000LL + t.tv_nsec / 1000;
+}
+
+/* Heavy loss on a large window: the first segment is lost and every later
+ * one is SACKed by its own ACK, and then one segment in eight is lost with
+ * the peer reporting the three most recent blocks on each ACK.  Reports the
+ * time taken; the scoreboard used to rewrite the whole SACKed block on each
+ * ACK, so the first case was quadratic in the window. */
+static void test_ci_tcp_rx_sack_heavy_loss(void)
+{
+  const int n = 8192;
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  long long t;
+  int blocks[6];
+  int i, j, k, ok;
+
+  ni = sack_test_init(&ts, n);
+  t = sack_test_usec();
+  for( i = 1; i < n; ++i )
+    sack_block(ni, ts, 1, i);
+  t = sack_test_usec() - t;
+  fprintf(stderr, "  SACK extend: %d ACKs over %d segments in %lld us\n",
+          n - 1, n, t);
+  for( i = 1, ok = 1; i < n; ++i )
+    ok &= sack_is_sacked(ni, i);
+  CHECK_TRUE(ok);
+  CHECK_FALSE(sack_is_sacked(ni, 0));
+  CHECK(sack_block_end(ni, 1), ==, n - 1);
+  sack_test_fini(ni);
+
+  ni = sack_test_init(&ts, n);
+  t = sack_test_usec();
+  for( i = 1; i < n; ++i ) {
+    if( i % 8 == 0 )
+      continue;
+    for( j = 0, k = i / 8; j < 3 && k >= 0; ++j, --k ) {
+      blocks[2 * j] = k * 8 + 1;
+      blocks[2 * j + 1] = k == i / 8 ? i : k * 8 + 7;
+    }
+    sack_ack(ni, ts, j, blocks);
+  }
+  t = sack_test_usec() - t;
+  fprintf(stderr, "  SACK scatter: %d ACKs over %d segments in %lld us\n",
+          n - n / 8, n, t);
+  for( i = 0, ok = 1; i < n; ++i ) {
+    ok &= sack_is_sacked(ni, i) == (i % 8 != 0);
+    if( i % 8 != 0 )
+      ok &= sack_block_end(ni, i) == (i | 7);
+  }
+  CHECK_TRUE(ok);
+  sack_test_fini(ni);
+}
+
+/* A re-order buffer fed from [n] packets: packet [i] carries the segment
+ * at sack_seq(i), and everything before packet 0 has been received.  The
+ * stack has one free aux buffer for the ROB index. */
+static ci_netif* rob_test_init(ci_tcp_state** ts_out, int n)
+{
+  ci_netif* ni = sack_test_init(ts_out, n);
+  ci_tcp_state* ts = *ts_out;
+  struct sack_test_state* st = CI_CONTAINER(struct sack_test_state, ts, ts);
+  struct oo_p_dllink_state free_aux_mem =
+                           oo_p_dllink_ptr(ni, &ni->state->free_aux_mem);
+  ci_ip_pkt_fmt* pkt;
+  int i;
+
+  oo_p_dllink_init(ni, free_aux_mem);
+  oo_p_dllink_add(ni, free_aux_mem,
+                  oo_p_dllink_statep(ni, oo_ptr_to_statep(ni, &st->aux)));
+  ni->state->n_free_aux_bufs = 1;
+  *(ci_uint32*) &ni->state->max_aux_bufs[CI_TCP_AUX_TYPE_ROB_INDEX] = 1;
+
+  ts->tcpflags = 0;
+  ts->local_peer = OO_SP_NULL;
+  ci_ip_queue_init(&ts->rob);
+  tcp_rcv_nxt(ts) = sack_seq(0);
+  for( i = 0; i < n; ++i ) {
+    pkt = PKT(ni, i);
+    pkt->pkt_eth_payload_off = 14;
+    oo_ip_hdr(pkt)->ip_ihl_version = CI_IP4_IHL_VERSION(sizeof(ci_ip4_hdr));
+    PKT_TCP_HDR(pkt)->tcp_seq_be32 = CI_BSWAP_BE32(sack_seq(i));
+    pkt->pf.tcp_rx.end_seq = sack_seq(i + 1);
+    pkt->pf.tcp_rx.pay_len = SACK_TEST_LEN;
+  }
+  return ni;
+}
+
+static void rob_enqueue(ci_netif* ni, ci_tcp_state* ts, int i)
+{
+  ciip_tcp_rx_pkt rxp;
+
+  memset(&rxp, 0, sizeof(rxp));
+  rxp.pkt = PKT(ni, i);
+  rxp.tcp = PKT_TCP_HDR(rxp.pkt);
+  rxp.seq = sack_seq(i);
+  ci_tcp_rx_enqueue_ooo(ni, ts, &rxp);
+}
+
+/* The socket's ROB index, which the tests expect to have been allocated */
+static ci_tcp_rob_index* rob_index(ci_netif* ni, ci_tcp_state* ts)
+{
+  CHECK_TRUE(OO_P_NOT_NULL(ts->rob_index));
+  return ci_ni_aux_p2rob_index(ni, ts->rob_index);
+}
+
+/* Returns the number of blocks in the ROB, or -1 if the blocks or the
+ * index are inconsistent. */
+static int rob_blocks(ci_netif* ni, ci_tcp_state* ts)
+{
+  ci_tcp_rob_index* ri = NULL;
+  ci_ip_pkt_fmt* block;
+  int blocks = 0, indexed = 0, num = 0, slot;
+  oo_pkt_p id;
+
+  if( OO_P_NOT_NULL(ts->rob_index) )
+    ri = ci_ni_aux_p2rob_index(ni, ts->rob_index);
+  for( id = ts->rob.head; OO_PP_NOT_NULL(id);
+       id = PKT_TCP_RX_ROB(block)->next_block ) {
+    block = PKT(ni, id);
+    if( ri != NULL && indexed < ri->n &&
+        OO_PP_EQ(ri->blk[slot = CI_TCP_ROB_INDEX_SLOT(ri, indexed)], id) ) {
+      if( ri->seq[slot] !=
+          CI_BSWAP_BE32(PKT_TCP_HDR(block)->tcp_seq_be32) )
+        return -1;
+      ++indexed;
+    }
+    if( PKT(ni, PKT_TCP_RX_ROB(block)->end_block)->pf.tcp_rx.end_seq !=
+        PKT_TCP_RX_ROB(block)->end_block_seq )
+      return -1;
+    num += PKT_TCP_RX_ROB(block)->num;
+    ++blocks;
+  }
+  if( num != ts->rob.num ||
+      (ri != NULL && (indexed != ri->n || blocks != ri->blocks)) )
+    return -1;
+  return blocks;
+}
+
+static void test_ci_tcp_rx_enqueue_ooo(void)
+{
+  const int n = 4 * CI_CFG_TCP_ROB_INDEX_SIZE;
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  int i, rc;
+
+  ni = rob_test_init(&ts, 16);
+
+  /* Separate segments make separate blocks */
+  rob_enqueue(ni, ts, 2);
+  rob_enqueue(ni, ts, 6);
+  rob_enqueue(ni, ts, 4);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 3);
+  CHECK(rob_index(ni, ts)->n, ==, 3);
+
+  /* Filling the holes glues them */
+  rob_enqueue(ni, ts, 3);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 2);
+  rob_enqueue(ni, ts, 5);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 1);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 2))->num, ==, 5);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 2))->end_block_seq, ==, sack_seq(7));
+
+  /* A segment before the head block becomes the new head */
+  rob_enqueue(ni, ts, 9);
+  rob_enqueue(ni, ts, 1);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 2);
+  CHECK(OO_PP_ID(ts->rob.head), ==, 1);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 1))->num, ==, 6);
+  sack_test_fini(ni);
+
+  /* More blocks than the index holds */
+  ni = rob_test_init(&ts, n);
+  for( i = 2; i < n; i += 2 )
+    rob_enqueue(ni, ts, i);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, n / 2 - 1);
+  CHECK(rob_index(ni, ts)->n, <=, CI_CFG_TCP_ROB_INDEX_SIZE);
+  for( i = n - 1; i > 2; i -= 2 ) {
+    rob_enqueue(ni, ts, i);
+    rc = rob_blocks(ni, ts);
+    CHECK(rc, ==, i / 2);
+  }
+  CHECK(OO_PP_ID(ts->rob.head), ==, 2);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 2))->num, ==, n - 2);
+  sack_test_fini(ni);
+
+  /* With no aux buffer for the index, the ROB is walked from the head */
+  ni = rob_test_init(&ts, 16);
+  *(ci_uint32*) &ni->state->max_aux_bufs[CI_TCP_AUX_TYPE_ROB_INDEX] = 0;
+  rob_enqueue(ni, ts, 6);
+  rob_enqueue(ni, ts, 2);
+  rob_enqueue(ni, ts, 4);
+  CHECK_TRUE(OO_P_IS_NULL(ts->rob_index));
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 3);
+  rob_enqueue(ni, ts, 3);
+  rob_enqueue(ni, ts, 5);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 1);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 2))->num, ==, 5);
+  sack_test_fini(ni);
+}
+
+/* Heavy reordering on a large window: every other segment is delayed and
+ * the gaps are then filled in scattered order.  Reports the time taken;
+ * the re-order buffer used to be a list of blocks walked from the head on
+ * each arrival. */
+static void test_ci_tcp_rx_ooo_heavy_reorder(void)
+{
+  const int n = 8192;
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  long long t;
+  int i, rc;
+
+  ni = rob_test_init(&ts, n);
+  t = sack_test_usec();
+  for( i = 2; i < n; i += 2 )
+    rob_enqueue(ni, ts, i);
+  /* 1021 is coprime to 4095, so this visits each odd segment from 3 once */
+  for( i = 0; i < n / 2 - 1; ++i )
+    rob_enqueue(ni, ts, 3 + 2 * ((i * 1021) % (n / 2 - 1)));
+  t = sack_test_usec() - t;
+  fprintf(stderr, "  ROB reorder: %d segments around %d holes in %lld us\n",
+          n - 2, n / 2 - 1, t);
+  rc = rob_blocks(ni, ts);
+  CHECK(rc, ==, 1);
+  CHECK(PKT_TCP_RX_ROB(PKT(ni, 2))->num, ==, n - 2);
+  sack_test_fini(ni);
+}
+
+/* [n] in-order segments of one connection, each carrying a whole packet
+ * from the re-order buffer fixture, as received from the NIC.  The socket
+ * is connected to the segments' addresses and ports. */
+#define LRO_TEST_LADDR     CI_BSWAP_BE32(0x0a000001)
+#define LRO_TEST_RADDR     CI_BSWAP_BE32(0x0a000002)
+#define LRO_TEST_LPORT     CI_BSWAP_BE16(5001)
+#define LRO_TEST_RPORT     CI_BSWAP_BE16(40000)
+#define LRO_TEST_IP_PAYLEN ((int) sizeof(ci_tcp_hdr) + SACK_TEST_LEN)
+
+static ci_netif* lro_test_init(ci_tcp_state** ts_out, int n)
+{
+  ci_netif* ni = rob_test_init(ts_out, n);
+  ci_tcp_state* ts = *ts_out;
+  ci_ip_pkt_fmt* pkt;
+  ci_ip4_hdr* ip;
+  ci_tcp_hdr* tcp;
+  int i;
+
+  for( i = 0; i < n; ++i ) {
+    pkt = PKT(ni, i);
+    pkt->next = OO_PP_NULL;
+    pkt->frag_next = OO_PP_NULL;
+    pkt->pay_len = pkt->pkt_eth_payload_off + sizeof(ci_ip4_hdr) +
+                   LRO_TEST_IP_PAYLEN;
+    pkt->pf.tcp_rx.pay_len = 0;
+    pkt->pf.tcp_rx.end_seq = 0;
+    ip = oo_ip_hdr(pkt);
+    ip->ip_tot_len_be16 = CI_BSWAP_BE16(sizeof(ci_ip4_hdr) +
+                                        LRO_TEST_IP_PAYLEN);
+    ip->ip_protocol = IPPROTO_TCP;
+    ip->ip_saddr_be32 = LRO_TEST_RADDR;
+    ip->ip_daddr_be32 = LRO_TEST_LADDR;
+    tcp = PKT_TCP_HDR(pkt);
+    CI_TCP_HDR_SET_LEN(tcp, sizeof(ci_tcp_hdr));
+    tcp->tcp_flags = CI_TCP_FLAG_ACK;
+    tcp->tcp_source_be16 = LRO_TEST_RPORT;
+    tcp->tcp_dest_be16 = LRO_TEST_LPORT;
+    tcp->tcp_ack_be32 = CI_BSWAP_BE32(tcp_snd_una(ts));
+    tcp->tcp_window_be16 = CI_BSWAP_BE16(0x8000);
+  }
+
+  ts->s.pkt.ether_type = CI_ETHERTYPE_IP;
+  ts->s.pkt.ipx.ip4.ip_saddr_be32 = LRO_TEST_LADDR;
+  expect_pkt = PKT(ni, 0);
+  expect_tcp = PKT_TCP_HDR(expect_pkt);
+  filter_count = 0;
+  kernel_count = 0;
+  return ni;
+}
+
+/* Makes [ts] an established connection on the fast path, receiving up to
+ * [rcv_wnd_right_edge] from the filters. */
+static void lro_test_connect(ci_netif* ni, ci_tcp_state* ts,
+                             ci_uint32 rcv_wnd_right_edge)
+{
+  ts->s.b.state = CI_TCP_ESTABLISHED;
+  ci_ip_queue_init(&ts->recv1);
+  ts->recv1_extract = OO_PP_NULL;
+  TS_QUEUE_RX_SET(ts, recv1);
+  ts->dsack_block = OO_PP_INVALID;
+  ts->incoming_tcp_hdr_len = sizeof(ci_tcp_hdr);
+  tcp_rcv_wnd_right_edge_sent(ts) = rcv_wnd_right_edge;
+  tcp_rcv_wnd_advertised(ts) = rcv_wnd_right_edge - tcp_rcv_nxt(ts);
+  ci_tcp_fast_path_enable(ts);
+
+  oo_p_dllink_init(ni, oo_p_dllink_ptr(ni, &ni->state->post_poll_list));
+  oo_p_dllink_init(ni, oo_p_dllink_sb(ni, &ts->s.b,
+                                      &ts->s.b.post_poll_link));
+  ni->state->in_poll = 1;
+  filter_sock = &ts->s;
+}
+
+static void lro_test_fini(ci_netif* ni)
+{
+  filter_sock = NULL;
+  expect_pkt = NULL;
+  expect_tcp = NULL;
+  sack_test_fini(ni);
+}
+
+static void lro_rx(ci_netif* ni, struct ci_netif_poll_state* ps, int i)
+{
+  ci_tcp_handle_rx_lro(ni, ps, PKT(ni, i), PKT_TCP_HDR(PKT(ni, i)),
+                       LRO_TEST_IP_PAYLEN);
+}
+
+/* In-order segments of one connection are gathered into a single train
+ * linked from the head segment. */
+static void test_ci_tcp_handle_rx_lro(void)
+{
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  struct ci_netif_poll_state ps;
+  int i, n = 3;
+
+  ni = lro_test_init(&ts, n);
+  memset(&ps, 0, sizeof(ps));
+
+  /* Holding the first segment starts a train */
+  lro_rx(ni, &ps, 0);
+  CHECK(ps.lro_head, ==, PKT(ni, 0));
+  CHECK(ps.lro_rest, ==, NULL);
+  CHECK(ps.lro_n, ==, 1);
+  CHECK(ps.lro_next_seq, ==, sack_seq(1));
+
+  /* Following in-order segments join it */
+  for( i = 1; i < n; ++i )
+    lro_rx(ni, &ps, i);
+  CHECK(ps.lro_head, ==, PKT(ni, 0));
+  CHECK(ps.lro_rest, ==, PKT(ni, 1));
+  CHECK(ps.lro_tail, ==, PKT(ni, 2));
+  CHECK(ps.lro_n, ==, n);
+  CHECK(ps.lro_next_seq, ==, sack_seq(n));
+  CHECK(OO_PP_ID(PKT(ni, 1)->next), ==, 2);
+  CHECK_TRUE(OO_PP_IS_NULL(PKT(ni, 2)->next));
+
+  lro_test_fini(ni);
+}
+
+/* A train that the connection can take whole is delivered on the fast
+ * path as one chain onto its receive queue. */
+static void test_ci_tcp_rx_lro_flush(void)
+{
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  struct ci_netif_poll_state ps;
+  ci_ip_pkt_fmt* pkt;
+  oo_pkt_p id;
+  int i, n = 4;
+
+  ni = lro_test_init(&ts, n);
+  lro_test_connect(ni, ts, sack_seq(n));
+  memset(&ps, 0, sizeof(ps));
+  for( i = 0; i < n; ++i )
+    lro_rx(ni, &ps, i);
+
+  ci_tcp_rx_lro_flush(ni, &ps);
+  CHECK(ps.lro_head, ==, NULL);
+  CHECK(ps.lro_rest, ==, NULL);
+
+  /* Only the head went through the filters */
+  CHECK(filter_count, ==, 1);
+
+  /* post: the segments are on the receive queue in order, each with its
+   * own payload */
+  CHECK(ts->recv1.num, ==, n);
+  CHECK(OO_PP_ID(ts->recv1_extract), ==, 0);
+  for( i = 0, id = ts->recv1.head; i < n; ++i, id = pkt->next ) {
+    CHECK_TRUE(OO_PP_NOT_NULL(id));
+    if( OO_PP_IS_NULL(id) )
+      break;
+    pkt = PKT(ni, id);
+    CHECK(OO_PP_ID(id), ==, i);
+    CHECK(pkt->pf.tcp_rx.pay_len, ==, SACK_TEST_LEN);
+    CHECK(pkt->pf.tcp_rx.end_seq, ==, sack_seq(i + 1));
+    CHECK(oo_offbuf_left(&pkt->buf), ==, SACK_TEST_LEN);
+    CHECK(oo_offbuf_ptr(&pkt->buf), ==,
+          (char*) PKT_TCP_HDR(pkt) + sizeof(ci_tcp_hdr));
+  }
+  CHECK(OO_PP_ID(ts->recv1.tail), ==, n - 1);
+  CHECK_TRUE(OO_PP_IS_NULL(PKT(ni, n - 1)->next));
+
+  /* post: the connection has received the whole train */
+  CHECK(tcp_rcv_nxt(ts), ==, sack_seq(n));
+  CHECK(ts->rcv_added, ==, n * SACK_TEST_LEN);
+  CHECK(ts->stats.rx_pkts, ==, n);
+  CHECK_TRUE(ts->s.b.sb_flags & CI_SB_FLAG_WAKE_RX);
+
+  /* post: statistics count one train of [n] segments */
+  CHECK(ni->state->stats.tcp_lro_trains, ==, 1);
+  CHECK(ni->state->stats.tcp_lro_segs, ==, n);
+  CHECK(ni->state->stats_snapshot.tcp.tcp_in_segs, ==, n);
+
+  lro_test_fini(ni);
+}
+
+/* A train that no connection takes whole is split, and its segments are
+ * handled one by one, in order. */
+static void test_ci_tcp_rx_lro_flush_split(void)
+{
+  ci_netif* ni;
+  ci_tcp_state* ts;
+  struct ci_netif_poll_state ps;
+  int i, n = 4;
+
+  ni = lro_test_init(&ts, n);
+  memset(&ps, 0, sizeof(ps));
+  for( i = 0; i < n; ++i )
+    lro_rx(ni, &ps, i);
+
+  ci_tcp_rx_lro_flush(ni, &ps);
+  CHECK(ps.lro_head, ==, NULL);
+  CHECK(ps.lro_rest, ==, NULL);
+
+  /* post: each segment was looked up and passed on by itself */
+  CHECK(filter_count, ==, 3 * n);
+  CHECK(kernel_count, ==, n);
+  for( i = 0; i < n; ++i ) {
+    CHECK(kernel_pkts[i], ==, PKT(ni, i));
+    CHECK_TRUE(OO_PP_IS_NULL(PKT(ni, i)->next));
+    CHECK(PKT(ni, i)->pf.tcp_rx.pay_len, ==, LRO_TEST_IP_PAYLEN);
+  }
+
+  /* post: no train was delivered */
+  CHECK(ni->state->stats.tcp_lro_trains, ==, 0);
+  CHECK(ni->state->stats.tcp_lro_segs, ==, 0);
+  CHECK(ni->state->stats.no_match_pass_to_kernel_tcp, ==, n);
+  CHECK(ni->state->stats_snapshot.tcp.tcp_in_segs, ==, n);
+
+  lro_test_fini(ni);
+}
+
 int main(void)
 {
   TEST_RUN(test_ci_tcp_handle_rx);
+  TEST_RUN(test_ci_tcp_rx_sack_process_block);
+  TEST_RUN(test_ci_tcp_rx_sack_heavy_loss);
+  TEST_RUN(test_ci_tcp_rx_enqueue_ooo);
+  TEST_RUN(test_ci_tcp_rx_ooo_heavy_reorder);
+  TEST_RUN(test_ci_tcp_handle_rx_lro);
+  TEST_RUN(test_ci_tcp_rx_lro_flush);
+  TEST_RUN(test_ci_tcp_rx_lro_flush_split);
   TEST_END();
 }
 
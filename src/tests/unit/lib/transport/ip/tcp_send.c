@@ -0,0 +1,391 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Functions under test */
+#include <ci/internal/ip.h>
+#include <onload/ul/per_thread.h>
+
+/* Test infrastructure */
+#include "unit_test.h"
+
+
+/* Dependencies */
+__thread struct oo_per_thread oo_per_thread;
+
+void ci_tcp_set_sndbuf(ci_netif* ni, ci_tcp_state* ts)
+{
+}
+
+
+/* An EF_TCP_GSO send queue: a super-segment made of packets 0 to [n] - 1,
+ * each holding a full segment, followed by packet [n] as an ordinary tail
+ * holding GSO_TEST_TAIL bytes.  Packet [i] starts at gso_seq(i). */
+#define GSO_TEST_SEQ   1000
+#define GSO_TEST_MSS   1460
+#define GSO_TEST_TAIL  100
+#define GSO_TEST_HDRS  ((int) (sizeof(ci_ip4_hdr) + sizeof(ci_tcp_hdr)))
+
+static char* gso_test_bufs;
+
+static unsigned gso_seq(int i)
+{
+  return GSO_TEST_SEQ + i * GSO_TEST_MSS;
+}
+
+/* Lay out [pkt] holding [len] bytes as ci_tcp_sendmsg_fill_pkt() does */
+static void gso_test_fill(ci_ip_pkt_fmt* pkt, int len)
+{
+  pkt->pkt_start_off = PKT_START_OFF_BAD;
+  pkt->pkt_eth_payload_off = PKT_START_OFF_BAD;
+  oo_tx_pkt_layout_init(pkt);
+  oo_offbuf_init(&pkt->buf, (uint8_t*) oo_tx_l3_hdr(pkt) + GSO_TEST_HDRS,
+                 GSO_TEST_MSS);
+  oo_offbuf_advance(&pkt->buf, len);
+  pkt->buf_len = pkt->pay_len = oo_tx_ether_hdr_size(pkt) + GSO_TEST_HDRS +
+                                len;
+  pkt->pf.tcp_tx.start_seq = GSO_TEST_HDRS;
+  pkt->pf.tcp_tx.end_seq = len;
+}
+
+/* Copy in the headers and sequence numbers, as ci_tcp_sendmsg_prep_pkt()
+ * does */
+static void gso_test_prep(ci_tcp_state* ts, ci_ip_pkt_fmt* pkt, unsigned seq)
+{
+  ci_pkt_init_from_ipcache(pkt, &ts->s.pkt);
+  pkt->pf.tcp_tx.start_seq = seq;
+  pkt->pf.tcp_tx.end_seq += seq;
+  pkt->pf.tcp_tx.block_end = OO_PP_NULL;
+}
+
+static void gso_test_init(ci_netif* ni, ci_tcp_state* ts, int n)
+{
+  ci_tcp_hdr* tcp = TS_TCP(ts);
+  ci_ip_pkt_fmt* head;
+  ci_ip_pkt_fmt* pkt;
+  int i;
+
+  gso_test_bufs = calloc(1 << CI_CFG_PKTS_PER_SET_S, CI_CFG_PKT_BUF_SIZE);
+  ni->pkt_bufs = calloc(1, sizeof(ni->pkt_bufs[0]));
+  ni->packets = calloc(1, sizeof(*ni->packets));
+  ni->pkt_bufs[0] = gso_test_bufs;
+  *(ci_uint32*) &ni->packets->sets_n = 1;
+  *(ci_int32*) &ni->packets->n_pkts_allocated = 1 << CI_CFG_PKTS_PER_SET_S;
+  ni->state->lock.lock = CI_EPLOCK_LOCKED;
+  NI_OPTS(ni).tcp_gso = 1;
+
+  ts->s.b.state = CI_TCP_ESTABLISHED;
+  ts->s.pkt.ether_offset = ETH_VLAN_HLEN;
+  ts->s.pkt.ether_type = CI_ETHERTYPE_IP;
+  ts->s.pkt.ipx.ip4.ip_ihl_version = CI_IP4_IHL_VERSION(sizeof(ci_ip4_hdr));
+  ts->s.pkt.mtu = GSO_TEST_HDRS + GSO_TEST_MSS;
+  CI_TCP_HDR_SET_LEN(tcp, sizeof(ci_tcp_hdr));
+  tcp->tcp_flags = CI_TCP_FLAG_ACK;
+  ts->outgoing_hdrs_len = GSO_TEST_HDRS;
+  ts->smss = ts->eff_mss = GSO_TEST_MSS;
+  ts->cwnd = ts->ssthresh = 64 * GSO_TEST_MSS;
+  ts->pmtus = OO_PP_NULL;
+  ci_ip_queue_init(&ts->send);
+  ci_ip_queue_init(&ts->retrans);
+
+  for( i = 0; i <= n; ++i ) {
+    pkt = (ci_ip_pkt_fmt*) (gso_test_bufs + (size_t) i * CI_CFG_PKT_BUF_SIZE);
+    OO_PKT_PP_INIT(pkt, i);
+    pkt->next = OO_PP_NULL;
+    pkt->netif.tcp_gso_next = OO_PP_NULL;
+    gso_test_fill(pkt, i < n ? GSO_TEST_MSS : GSO_TEST_TAIL);
+    if( i > 0 && i < n )
+      PKT(ni, i - 1)->netif.tcp_gso_next = OO_PKT_P(pkt);
+  }
+
+  /* Only the head and the tail are prepared and on the queue */
+  head = PKT(ni, 0);
+  gso_test_prep(ts, head, gso_seq(0));
+  head->pf.tcp_tx.end_seq = gso_seq(n);
+  TX_PKT_TCP(head)->tcp_flags |= CI_TCP_FLAG_PSH;
+  pkt = PKT(ni, n);
+  gso_test_prep(ts, pkt, gso_seq(n));
+  TX_PKT_TCP(pkt)->tcp_flags |= CI_TCP_FLAG_PSH;
+  head->next = OO_PKT_P(pkt);
+  OO_PP_INIT(ni, ts->send.head, 0);
+  OO_PP_INIT(ni, ts->send.tail, n);
+  ts->send.num = 2;
+}
+
+static void gso_test_fini(ci_netif* ni)
+{
+  free(ni->packets);
+  free(ni->pkt_bufs);
+  free(gso_test_bufs);
+}
+
+/* Check that the send queue holds packets 0 to [n] in order, each covering
+ * its own payload and nothing more. */
+static void gso_test_check_split(ci_netif* ni, ci_tcp_state* ts, int n)
+{
+  ci_ip_pkt_fmt* pkt;
+  oo_pkt_p id;
+  int i = 0;
+
+  CHECK(ts->send.num, ==, n + 1);
+  for( id = ts->send.head; OO_PP_NOT_NULL(id); id = pkt->next, ++i ) {
+    pkt = PKT(ni, OO_PP_ID(id));
+    CHECK(OO_PP_ID(id), ==, i);
+    CHECK(pkt->pf.tcp_tx.start_seq, ==, gso_seq(i));
+    CHECK(pkt->pf.tcp_tx.end_seq, ==,
+          i < n ? gso_seq(i + 1) : gso_seq(n) + GSO_TEST_TAIL);
+    CHECK(ci_tcp_tx_pkt_own_paylen(AF_INET, pkt), ==,
+          i < n ? GSO_TEST_MSS : GSO_TEST_TAIL);
+    CHECK_FALSE(ci_tcp_tx_pkt_is_gso(AF_INET, pkt));
+  }
+  CHECK(i, ==, n + 1);
+  CHECK(OO_PP_ID(ts->send.tail), ==, n);
+  CHECK_TRUE(OO_PP_IS_NULL(PKT(ni, 0)->netif.tcp_gso_next));
+}
+
+static void test_ci_tcp_tx_gso_segment(void)
+{
+  const int n = 4;
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_tcp_state* ts = calloc(1, sizeof(*ts));
+  ci_ip_pkt_fmt* head;
+  int i, rc;
+
+  ni->state = calloc(1, sizeof(*ni->state));
+  gso_test_init(ni, ts, n);
+  head = PKT(ni, 0);
+
+  /* The head covers the whole super-segment, but only its first segment
+   * counts when deciding whether the next segment may be sent */
+  CHECK_TRUE(ci_tcp_tx_pkt_is_gso(AF_INET, head));
+  CHECK_FALSE(ci_tcp_tx_pkt_is_gso(AF_INET, PKT(ni, n)));
+  CHECK(ci_tcp_sendq_head_end_seq(ni, ts), ==, gso_seq(1));
+
+  rc = ci_tcp_tx_gso_segment(ni, ts, head);
+  CHECK(rc, ==, n - 1);
+  gso_test_check_split(ni, ts, n);
+  CHECK(ci_tcp_sendq_head_end_seq(ni, ts), ==, gso_seq(1));
+
+  /* The followers get the headers, and PSH moves to the last of them */
+  for( i = 0; i < n; ++i ) {
+    CHECK(CI_TCP_HDR_LEN(TX_PKT_TCP(PKT(ni, i))), ==, sizeof(ci_tcp_hdr));
+    CHECK(TX_PKT_TCP(PKT(ni, i))->tcp_flags, ==,
+          CI_TCP_FLAG_ACK | (i == n - 1 ? CI_TCP_FLAG_PSH : 0));
+  }
+
+  gso_test_fini(ni);
+  free(ts);
+  free(ni->state);
+  free(ni);
+}
+
+/* A super-segment split after the MSS has shrunk keeps the segments at the
+ * size they were filled at; ci_tcp_tx_advance_to() splits them further. */
+static void test_ci_tcp_tx_gso_segment_mss_shrunk(void)
+{
+  const int n = 3;
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_tcp_state* ts = calloc(1, sizeof(*ts));
+
+  ni->state = calloc(1, sizeof(*ni->state));
+  gso_test_init(ni, ts, n);
+  ts->eff_mss = GSO_TEST_MSS / 2;
+
+  ci_tcp_sendq_gso_segment_all(ni, ts);
+  gso_test_check_split(ni, ts, n);
+
+  gso_test_fini(ni);
+  free(ts);
+  free(ni->state);
+  free(ni);
+}
+
+/* Changing the MSS splits the super-segments on the send queue, and sets
+ * the end of every buffer from the new MSS */
+static void test_ci_tcp_tx_change_mss(void)
+{
+  const int n = 5;
+  const int mss = 1000 - GSO_TEST_HDRS;
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_tcp_state* ts = calloc(1, sizeof(*ts));
+  ci_ip_pkt_fmt* pkt;
+  int i;
+
+  ni->state = calloc(1, sizeof(*ni->state));
+  gso_test_init(ni, ts, n);
+  ts->s.pkt.mtu = 1000;
+
+  ci_tcp_tx_change_mss(ni, ts);
+  CHECK(tcp_eff_mss(ts), ==, mss);
+  gso_test_check_split(ni, ts, n);
+  for( i = 0; i <= n; ++i ) {
+    pkt = PKT(ni, i);
+    CHECK(oo_offbuf_end(&pkt->buf), ==,
+          (char*) oo_tx_l3_hdr(pkt) + GSO_TEST_HDRS + mss);
+  }
+
+  /* Growing it again leaves the queue alone */
+  ts->s.pkt.mtu = GSO_TEST_HDRS + GSO_TEST_MSS;
+  ci_tcp_tx_change_mss(ni, ts);
+  CHECK(tcp_eff_mss(ts), ==, GSO_TEST_MSS);
+  gso_test_check_split(ni, ts, n);
+
+  gso_test_fini(ni);
+  free(ts);
+  free(ni->state);
+  free(ni);
+}
+
+/* TCP_NOTSENT_LOWAT withholds send space, in both sndbuf modes, once the
+ * bytes queued but not sent reach the limit, and gives it back as soon as
+ * sending brings them below it */
+static void test_ci_tcp_notsent_lowat(void)
+{
+  const unsigned lowat = 4000;
+  const unsigned snd_nxt = 0xfffff000u;  /* enq_nxt wraps past 0 */
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_tcp_state* ts = calloc(1, sizeof(*ts));
+  int mode;
+
+  ni->state = calloc(1, sizeof(*ni->state));
+  ts->s.pkt.ether_offset = ETH_VLAN_HLEN;
+  ts->s.pkt.ether_type = CI_ETHERTYPE_IP;
+  ts->s.pkt.ipx.ip4.ip_ihl_version = CI_IP4_IHL_VERSION(sizeof(ci_ip4_hdr));
+  ts->s.so.sndbuf = 1 << 20;
+  ts->so_sndbuf_pkts = 1024;
+  ci_ip_queue_init(&ts->retrans);
+  ts->snd_nxt = snd_nxt;
+
+  for( mode = 0; mode <= 1; ++mode ) {
+    NI_OPTS(ni).tcp_sndbuf_mode = mode;
+
+    /* No limit: only the send buffer counts */
+    ts->c.notsent_lowat = 0;
+    tcp_enq_nxt(ts) = snd_nxt + 2 * lowat;
+    CHECK_FALSE(ci_tcp_notsent_over_lowat(ts));
+    CHECK_TRUE(ci_tcp_tx_advertise_space(ni, ts));
+    CHECK(ci_tcp_tx_send_space(ni, ts), >, 0);
+
+    ts->c.notsent_lowat = lowat;
+
+    /* Just below the limit */
+    tcp_enq_nxt(ts) = snd_nxt + lowat - 1;
+    CHECK_FALSE(ci_tcp_notsent_over_lowat(ts));
+    CHECK_TRUE(ci_tcp_tx_advertise_space(ni, ts));
+    CHECK(ci_tcp_tx_send_space(ni, ts), >, 0);
+
+    /* At and above it */
+    tcp_enq_nxt(ts) = snd_nxt + lowat;
+    CHECK_TRUE(ci_tcp_notsent_over_lowat(ts));
+    CHECK_FALSE(ci_tcp_tx_advertise_space(ni, ts));
+    CHECK(ci_tcp_tx_send_space(ni, ts), ==, 0);
+    tcp_enq_nxt(ts) = snd_nxt + 2 * lowat;
+    CHECK_TRUE(ci_tcp_notsent_over_lowat(ts));
+    CHECK_FALSE(ci_tcp_tx_advertise_space(ni, ts));
+    CHECK(ci_tcp_tx_send_space(ni, ts), ==, 0);
+
+    /* Sending drains the backlog below the limit */
+    ts->snd_nxt = snd_nxt + lowat + 1;
+    CHECK_FALSE(ci_tcp_notsent_over_lowat(ts));
+    CHECK_TRUE(ci_tcp_tx_advertise_space(ni, ts));
+    CHECK(ci_tcp_tx_send_space(ni, ts), >, 0);
+    ts->snd_nxt = snd_nxt;
+  }
+
+  free(ts);
+  free(ni->state);
+  free(ni);
+}
+
+/* A Fast Open SYN whose data the peer did not accept: it acknowledged only
+ * the SYN, so the data goes again once the connection is established.  The
+ * SYN carried ECE and CWR to negotiate ECN, and TFO_TEST_OPTS bytes of
+ * options before TFO_TEST_LEN bytes of data. */
+#define TFO_TEST_ISS   5000
+#define TFO_TEST_ACK   7000
+#define TFO_TEST_OPTS  8
+#define TFO_TEST_LEN   100
+
+static void test_ci_tcp_retrans_fastopen_syn(void)
+{
+  struct {
+    ci_netif_state ns;
+    ci_tcp_state ts;
+  }* st = calloc(1, sizeof(*st));
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  ci_tcp_state* ts = &st->ts;
+  ci_uint8 data[TFO_TEST_LEN];
+  ci_ip_pkt_fmt* pkt;
+  ci_tcp_hdr* tcp;
+  ci_uint8* opt;
+  int i, rc;
+
+  ni->state = &st->ns;
+  gso_test_init(ni, ts, 1);
+  ci_ip_queue_init(&ts->send);
+
+  /* The SYN is the only packet on the retransmit queue */
+  pkt = PKT(ni, 0);
+  gso_test_fill(pkt, 0);
+  ci_pkt_init_from_ipcache(pkt, &ts->s.pkt);
+  tcp = TX_PKT_TCP(pkt);
+  CI_TCP_HDR_SET_LEN(tcp, sizeof(ci_tcp_hdr) + TFO_TEST_OPTS);
+  tcp->tcp_flags = CI_TCP_FLAG_SYN | CI_TCP_FLAG_ECE | CI_TCP_FLAG_CWR;
+  opt = CI_TCP_HDR_OPTS(tcp);
+  memset(opt, CI_TCP_OPT_NOP, TFO_TEST_OPTS);
+  for( i = 0; i < TFO_TEST_LEN; ++i )
+    data[i] = i;
+  memcpy(CI_TCP_PAYLOAD(tcp), data, TFO_TEST_LEN);
+  pkt->buf_len = pkt->pay_len = oo_tx_ether_hdr_size(pkt) + GSO_TEST_HDRS +
+                                TFO_TEST_OPTS + TFO_TEST_LEN;
+  pkt->pf.tcp_tx.start_seq = TFO_TEST_ISS;
+  pkt->pf.tcp_tx.end_seq = TFO_TEST_ISS + 1 + TFO_TEST_LEN;
+  pkt->refcount = 1;
+  ci_ip_queue_enqueue(ni, &ts->retrans, pkt);
+
+  ts->tcpflags = CI_TCPT_FLAG_FASTOPEN | CI_TCPT_FLAG_FASTOPEN_DATA;
+  ts->snd_una = ts->snd_up = TFO_TEST_ISS + 1;
+  ts->snd_nxt = TFO_TEST_ISS + 1 + TFO_TEST_LEN;
+  tcp_rcv_nxt(ts) = TFO_TEST_ACK;
+
+  /* The retransmission is sent over loopback, with the RTO timer armed */
+  ts->s.pkt.flags |= CI_IP_CACHE_IS_LOCALROUTE;
+  ts->local_peer = OO_SP_FROM_INT(ni, 1);
+  ci_ip_timer_init(ni, &ts->rto_tid,
+                   oo_state_ptr_to_statep(ni, &ts->rto_tid), "rto");
+  ci_ip_timer_init(ni, &ts->delack_tid,
+                   oo_state_ptr_to_statep(ni, &ts->delack_tid), "delack");
+  oo_p_dllink_add(ni, oo_p_dllink_statep(ni, ts->delack_tid.statep),
+                  oo_p_dllink_statep(ni, ts->rto_tid.statep));
+
+  rc = ci_tcp_retrans_one(ts, ni, pkt);
+  CHECK(rc, ==, 0);
+  CHECK(OO_PP_ID(ni->state->looppkts), ==, 0);
+  CHECK(ni->state->n_looppkts, ==, 1);
+
+  /* post: the data goes as a plain segment after the SYN */
+  CHECK(tcp->tcp_flags, ==, CI_TCP_FLAG_ACK);
+  CHECK(CI_TCP_HDR_LEN(tcp), ==, sizeof(ci_tcp_hdr));
+  CHECK(CI_BSWAP_BE32(tcp->tcp_seq_be32), ==, TFO_TEST_ISS + 1);
+  CHECK(CI_BSWAP_BE32(tcp->tcp_ack_be32), ==, TFO_TEST_ACK);
+  CHECK(pkt->pf.tcp_tx.start_seq, ==, TFO_TEST_ISS + 1);
+  CHECK(pkt->pf.tcp_tx.end_seq, ==, TFO_TEST_ISS + 1 + TFO_TEST_LEN);
+  CHECK(pkt->pay_len, ==, oo_tx_ether_hdr_size(pkt) + GSO_TEST_HDRS +
+                          TFO_TEST_LEN);
+  CHECK(ci_tx_pkt_ipx_tcp_payload_len(AF_INET, pkt), ==, TFO_TEST_LEN);
+  CHECK_MEM(CI_TCP_PAYLOAD(tcp), data, TFO_TEST_LEN);
+  CHECK_FALSE(ts->tcpflags & CI_TCPT_FLAG_FASTOPEN_DATA);
+
+  gso_test_fini(ni);
+  free(st);
+  free(ni);
+}
+
+int main(void)
+{
+  TEST_RUN(test_ci_tcp_tx_gso_segment);
+  TEST_RUN(test_ci_tcp_tx_gso_segment_mss_shrunk);
+  TEST_RUN(test_ci_tcp_tx_change_mss);
+  TEST_RUN(test_ci_tcp_notsent_lowat);
+  TEST_RUN(test_ci_tcp_retrans_fastopen_syn);
+  TEST_END();
+}
@@ -0,0 +1,240 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Functions under test */
+#include <ci/internal/ip.h>
+
+/* Test infrastructure */
+#include "unit_test.h"
+
+
+/* A datagram with the sequence number [ARB_TEST_OFF] bytes into its
+ * payload, and a socket arbitrating on it. */
+#define ARB_TEST_OFF  6
+#define ARB_TEST_LEN  32
+
+static ci_ip_pkt_fmt* arb_test_pkt;
+static ci_uint8* arb_test_pay;
+
+static ci_udp_state* arb_test_init(int seq_len, int flags)
+{
+  ci_udp_state* us = calloc(1, sizeof(*us));
+
+  arb_test_pkt = calloc(1, CI_CFG_PKT_BUF_SIZE);
+  arb_test_pay = (ci_uint8*) arb_test_pkt + CI_CFG_PKT_BUF_SIZE / 2;
+  us->arb_seq_offset = ARB_TEST_OFF;
+  us->arb_seq_len = seq_len;
+  us->arb_flags = flags;
+  return us;
+}
+
+static void arb_test_fini(ci_udp_state* us)
+{
+  free(arb_test_pkt);
+  free(us);
+}
+
+/* Receives a datagram of [pay_len] bytes carrying [seq], returning true if
+ * it is dropped. */
+static int arb_rx_len(ci_udp_state* us, ci_uint64 seq, int pay_len)
+{
+  unsigned len = us->arb_seq_len;
+  unsigned i;
+
+  memset(arb_test_pay, 0xa5, ARB_TEST_LEN);
+  for( i = 0; i < len; ++i ) {
+    ci_uint8 b = seq >> (8 * i);
+    if( us->arb_flags & CI_UDP_ARB_LITTLE_ENDIAN )
+      arb_test_pay[ARB_TEST_OFF + i] = b;
+    else
+      arb_test_pay[ARB_TEST_OFF + len - 1 - i] = b;
+  }
+  arb_test_pkt->pf.udp.pay_len = pay_len;
+  oo_offbuf_init(&arb_test_pkt->buf, arb_test_pay, pay_len);
+  return ci_udp_arb_drop(us, arb_test_pkt);
+}
+
+static int arb_rx(ci_udp_state* us, ci_uint64 seq)
+{
+  return arb_rx_len(us, seq, ARB_TEST_LEN);
+}
+
+/* Receives [first] to [last] in order, none of which is dropped */
+static void arb_rx_run(ci_udp_state* us, ci_uint64 first, ci_uint64 last)
+{
+  ci_uint64 seq;
+
+  for( seq = first; seq <= last; ++seq )
+    CHECK_FALSE(arb_rx(us, seq));
+}
+
+
+/* In order, duplicates, and gaps filled late */
+static void test_ci_udp_arb_drop(void)
+{
+  ci_udp_state* us = arb_test_init(4, 0);
+
+  /* The first datagram starts the feed without counting as a restart */
+  CHECK_FALSE(arb_rx(us, 1000));
+  CHECK(us->arb_last, ==, 1000);
+  CHECK(us->stats.n_rx_arb_reset, ==, 0);
+
+  /* Copies from the other feed are dropped */
+  CHECK_FALSE(arb_rx(us, 1001));
+  CHECK_TRUE(arb_rx(us, 1001));
+  CHECK_TRUE(arb_rx(us, 1000));
+  CHECK(us->stats.n_rx_arb_dup, ==, 2);
+
+  /* 1002 and 1003 are missing, and arrive late, once */
+  CHECK_FALSE(arb_rx(us, 1004));
+  CHECK_FALSE(arb_rx(us, 1003));
+  CHECK(us->stats.n_rx_arb_late, ==, 1);
+  CHECK_TRUE(arb_rx(us, 1003));
+  CHECK(us->stats.n_rx_arb_dup, ==, 3);
+
+  /* 1002 can still arrive at the back of the window */
+  arb_rx_run(us, 1005, 1002 + CI_UDP_ARB_WINDOW - 1);
+  CHECK_FALSE(arb_rx(us, 1002));
+  CHECK(us->stats.n_rx_arb_late, ==, 2);
+  CHECK_FALSE(arb_rx(us, 1002 + CI_UDP_ARB_WINDOW));
+
+  CHECK(us->stats.n_rx_arb_gap, ==, 0);
+  CHECK(us->stats.n_rx_arb_dup, ==, 3);
+  CHECK(us->stats.n_rx_arb_old, ==, 0);
+
+  arb_test_fini(us);
+}
+
+/* Sequence numbers that leave the window unfilled are counted as lost */
+static void test_ci_udp_arb_drop_gap(void)
+{
+  ci_udp_state* us = arb_test_init(4, 0);
+
+  /* 1001 to 1004 are missing */
+  CHECK_FALSE(arb_rx(us, 1000));
+  arb_rx_run(us, 1005, 1000 + CI_UDP_ARB_WINDOW);
+  CHECK(us->stats.n_rx_arb_gap, ==, 0);
+
+  /* Moving on by less than a window: 1001 leaves, 1002 to 1004 stay */
+  CHECK_FALSE(arb_rx(us, 1001 + CI_UDP_ARB_WINDOW));
+  CHECK(us->stats.n_rx_arb_gap, ==, 1);
+  CHECK_TRUE(arb_rx(us, 1001));
+  CHECK(us->stats.n_rx_arb_old, ==, 1);
+  CHECK_FALSE(arb_rx(us, 1002));
+  CHECK(us->stats.n_rx_arb_late, ==, 1);
+
+  /* Moving on by more than a window: 1003 and 1004 leave, as do the
+   * sequence numbers skipped that never entered it */
+  CHECK_FALSE(arb_rx(us, 1065 + 200));
+  CHECK(us->stats.n_rx_arb_gap, ==, 1 + 2 + (200 - CI_UDP_ARB_WINDOW));
+
+  /* The last 63 of those skipped can still arrive late */
+  CHECK_FALSE(arb_rx(us, 1265 - (CI_UDP_ARB_WINDOW - 1)));
+  CHECK(us->stats.n_rx_arb_late, ==, 2);
+  CHECK_TRUE(arb_rx(us, 1265 - CI_UDP_ARB_WINDOW));
+  CHECK(us->stats.n_rx_arb_old, ==, 2);
+
+  arb_test_fini(us);
+}
+
+/* A sequence number far enough behind restarts the feed */
+static void test_ci_udp_arb_drop_reset(void)
+{
+  const ci_uint64 last = 100000;
+  ci_udp_state* us = arb_test_init(4, 0);
+
+  CHECK_FALSE(arb_rx(us, last));
+  CHECK_TRUE(arb_rx(us, last - (CI_CFG_UDP_ARB_RESET - 1)));
+  CHECK(us->stats.n_rx_arb_old, ==, 1);
+  CHECK(us->stats.n_rx_arb_reset, ==, 0);
+  CHECK(us->arb_last, ==, last);
+
+  CHECK_FALSE(arb_rx(us, last - CI_CFG_UDP_ARB_RESET));
+  CHECK(us->stats.n_rx_arb_reset, ==, 1);
+  CHECK(us->arb_last, ==, last - CI_CFG_UDP_ARB_RESET);
+
+  /* Everything before the restart counts as delivered */
+  CHECK_TRUE(arb_rx(us, last - CI_CFG_UDP_ARB_RESET - 1));
+  CHECK(us->stats.n_rx_arb_dup, ==, 1);
+  CHECK_FALSE(arb_rx(us, last - CI_CFG_UDP_ARB_RESET + 1));
+  CHECK(us->stats.n_rx_arb_gap, ==, 0);
+
+  arb_test_fini(us);
+}
+
+/* Sequence numbers wrap at each width */
+static void test_ci_udp_arb_drop_wrap(void)
+{
+  static const int lens[] = { 2, 4, 8 };
+  ci_udp_state* us;
+  ci_uint64 max;
+  unsigned i;
+
+  for( i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i ) {
+    us = arb_test_init(lens[i], 0);
+    max = lens[i] == 8 ? ~0ull : (1ull << (8 * lens[i])) - 1;
+
+    CHECK_FALSE(arb_rx(us, max - 1));
+    CHECK_FALSE(arb_rx(us, 0));
+    CHECK_FALSE(arb_rx(us, max));
+    CHECK(us->stats.n_rx_arb_late, ==, 1);
+    CHECK_TRUE(arb_rx(us, max - 1));
+    CHECK_FALSE(arb_rx(us, 1));
+    CHECK(us->arb_last, ==, 1);
+    CHECK(us->stats.n_rx_arb_gap, ==, 0);
+
+    /* Behind across the wrap */
+    CHECK_TRUE(arb_rx(us, max - CI_UDP_ARB_WINDOW));
+    CHECK(us->stats.n_rx_arb_old, ==, 1);
+    CHECK(us->stats.n_rx_arb_reset, ==, 0);
+
+    arb_test_fini(us);
+  }
+}
+
+/* Little-endian sequence numbers */
+static void test_ci_udp_arb_drop_little_endian(void)
+{
+  ci_udp_state* us = arb_test_init(4, CI_UDP_ARB_LITTLE_ENDIAN);
+
+  CHECK_FALSE(arb_rx(us, 0x01020304));
+  CHECK(arb_test_pay[ARB_TEST_OFF], ==, 0x04);
+  CHECK(us->arb_last, ==, 0x01020304);
+  CHECK_FALSE(arb_rx(us, 0x01020305));
+  CHECK_TRUE(arb_rx(us, 0x01020304));
+  CHECK(us->stats.n_rx_arb_dup, ==, 1);
+
+  /* A carry into the next byte */
+  CHECK_FALSE(arb_rx(us, 0x01020400));
+  CHECK(us->arb_last, ==, 0x01020400);
+
+  arb_test_fini(us);
+}
+
+/* Datagrams too short for the sequence number are delivered, and leave
+ * the arbitration state alone */
+static void test_ci_udp_arb_drop_short(void)
+{
+  ci_udp_state* us = arb_test_init(4, 0);
+
+  CHECK_FALSE(arb_rx(us, 1000));
+  CHECK_FALSE(arb_rx_len(us, 1000, ARB_TEST_OFF + 3));
+  CHECK_FALSE(arb_rx_len(us, 1000, 0));
+  CHECK(us->arb_last, ==, 1000);
+  CHECK(us->stats.n_rx_arb_dup, ==, 0);
+  CHECK_TRUE(arb_rx_len(us, 1000, ARB_TEST_OFF + 4));
+  CHECK(us->stats.n_rx_arb_dup, ==, 1);
+
+  arb_test_fini(us);
+}
+
+int main(void)
+{
+  TEST_RUN(test_ci_udp_arb_drop);
+  TEST_RUN(test_ci_udp_arb_drop_gap);
+  TEST_RUN(test_ci_udp_arb_drop_reset);
+  TEST_RUN(test_ci_udp_arb_drop_wrap);
+  TEST_RUN(test_ci_udp_arb_drop_little_endian);
+  TEST_RUN(test_ci_udp_arb_drop_short);
+  TEST_END();
+}
@@ -0,0 +1,350 @@
+/* SPDX-License-Identifier: GPL-2.0 OR BSD-2-Clause */
+/* X-SPDX-Copyright-Text: (c) Copyright 2026 Advanced Micro Devices, Inc. */
+
+/* Functions under test */
+#include <ci/internal/ip.h>
+
+/* Test infrastructure */
+#include "unit_test.h"
+
+
+/* Dependencies */
+#define TXTIME_TEST_PKTS  16
+
+static int sent[TXTIME_TEST_PKTS], sent_flags[TXTIME_TEST_PKTS], n_sent;
+static int dropped[TXTIME_TEST_PKTS], n_dropped;
+static int n_freed;
+static int n_woken;
+
+void ci_udp_sendmsg_send_held(ci_netif* ni, ci_udp_state* us,
+                              ci_ip_pkt_fmt* pkt, int flags)
+{
+  CHECK(pkt->tstamp_frc, ==, 0);
+  /* Only the reference taken when it was held */
+  CHECK(pkt->refcount, ==, 1);
+  sent_flags[n_sent] = flags;
+  sent[n_sent++] = OO_PP_ID(OO_PKT_P(pkt));
+}
+
+void ci_udp_fixup_pkt_not_transmitted(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  dropped[n_dropped++] = OO_PP_ID(OO_PKT_P(pkt));
+}
+
+void ci_netif_pkt_free(ci_netif* ni, ci_ip_pkt_fmt* pkt)
+{
+  ++n_freed;
+}
+
+void citp_waitable_wake_not_in_poll(ci_netif* ni, citp_waitable* sb,
+                                    unsigned what)
+{
+  CHECK(what, ==, CI_SB_FLAG_WAKE_TX);
+  ++n_woken;
+}
+
+/* Timers are "pending" while linked on a list of their own. */
+void __ci_ip_timer_set(ci_netif* ni, ci_ip_timer* ts, ci_iptime_t t)
+{
+  ts->time = t;
+  oo_p_dllink_add(ni, oo_p_dllink_ptr(ni, &ni->state->timeout_q[0]),
+                  oo_p_dllink_statep(ni, ts->statep));
+}
+
+
+/* The socket lives in the stack state so that its timer can be linked
+ * there.  Launch times are given against the real FRC, so they are kept
+ * well clear of the slack (half a tick) and of the late limit:
+ *   slack << TXTIME_TEST_STEP << late limit
+ */
+#define TXTIME_TEST_KHZ       100000000
+#define TXTIME_TEST_FRC2TICK  20
+#define TXTIME_TEST_STEP      (1ull << 26)
+#define TXTIME_TEST_LEN(i)    (100 + (i))
+#define TXTIME_TEST_LATE  \
+  ((ci_uint64) CI_CFG_UDP_TXTIME_LATE_US * TXTIME_TEST_KHZ / 1000)
+
+struct txtime_test_state {
+  ci_netif_state ns;
+  ci_udp_state us;
+};
+
+static char* txtime_test_bufs;
+
+static ci_netif* txtime_test_init(ci_udp_state** us_out)
+{
+  ci_netif* ni = calloc(1, sizeof(*ni));
+  struct txtime_test_state* s = calloc(1, sizeof(*s));
+  ci_netif_state* ns = &s->ns;
+  ci_udp_state* us = &s->us;
+  ci_uint64 now;
+  int i;
+
+  ni->state = ns;
+  txtime_test_bufs = calloc(1 << CI_CFG_PKTS_PER_SET_S, CI_CFG_PKT_BUF_SIZE);
+  ni->pkt_bufs = calloc(1, sizeof(ni->pkt_bufs[0]));
+  ni->packets = calloc(1, sizeof(*ni->packets));
+  ni->pkt_bufs[0] = txtime_test_bufs;
+  *(ci_uint32*) &ni->packets->sets_n = 1;
+  *(ci_int32*) &ni->packets->n_pkts_allocated = 1 << CI_CFG_PKTS_PER_SET_S;
+  for( i = 0; i < TXTIME_TEST_PKTS; ++i )
+    OO_PKT_PP_INIT(PKT(ni, i), i);
+  n_sent = n_dropped = n_freed = n_woken = 0;
+
+  ns->lock.lock = CI_EPLOCK_LOCKED;
+  ci_frc64(&now);
+  ns->iptimer_state.khz = TXTIME_TEST_KHZ;
+  ns->iptimer_state.ci_ip_time_frc2tick = TXTIME_TEST_FRC2TICK;
+  ns->iptimer_state.ci_ip_time_real_ticks = now >> TXTIME_TEST_FRC2TICK;
+
+  oo_p_dllink_init(ni, oo_p_dllink_ptr(ni, &ns->timeout_q[0]));
+  ci_ip_timer_init(ni, &us->txtime_tid, oo_ptr_to_statep(ni, &us->txtime_tid),
+                   "txtm");
+  us->txtime_tid.fn = CI_IP_TIMER_UDP_TXTIME;
+  us->udpflags = CI_UDPF_TXTIME;
+  us->s.so.sndbuf = 1 << 16;
+  us->txtime_head = us->txtime_tail = OO_PP_NULL;
+  *us_out = us;
+  return ni;
+}
+
+static void txtime_test_fini(ci_netif* ni)
+{
+  free(ni->packets);
+  free(ni->pkt_bufs);
+  free(txtime_test_bufs);
+  free(ni->state);
+  free(ni);
+}
+
+/* Packet [i] as handed to ci_udp_txtime_hold() by a send, launching at
+ * [launch].  The sender's reference is dropped once the call returns. */
+static int txtime_test_send(ci_netif* ni, ci_udp_state* us, int i,
+                            ci_uint64 launch, int flags)
+{
+  ci_ip_pkt_fmt* pkt = PKT(ni, i);
+  int rc;
+
+  pkt->refcount = 1;
+  pkt->n_buffers = 1;
+  pkt->flags = 0;
+  pkt->next = OO_PP_NULL;
+  pkt->tstamp_frc = launch;
+  pkt->pf.udp.tx_length = TXTIME_TEST_LEN(i);
+  rc = ci_udp_txtime_hold(ni, us, pkt, flags);
+  ci_netif_pkt_release(ni, pkt);
+  return rc;
+}
+
+/* Returns true if the held datagrams are exactly [ids], in order. */
+static int txtime_test_queue_is(ci_netif* ni, ci_udp_state* us,
+                                const int* ids, int n)
+{
+  oo_pkt_p pp = us->txtime_head;
+  int i;
+
+  for( i = 0; i < n; ++i ) {
+    if( OO_PP_IS_NULL(pp) || OO_PP_ID(pp) != ids[i] )
+      return 0;
+    if( OO_PP_IS_NULL(PKT(ni, pp)->netif.tx.dmaq_next) &&
+        ! OO_PP_EQ(pp, us->txtime_tail) )
+      return 0;
+    pp = PKT(ni, pp)->netif.tx.dmaq_next;
+  }
+  return OO_PP_IS_NULL(pp);
+}
+
+/* Moves every held launch time [by] cycles earlier, as if time had passed */
+static void txtime_test_advance(ci_netif* ni, ci_udp_state* us, ci_uint64 by)
+{
+  oo_pkt_p pp;
+
+  for( pp = us->txtime_head; OO_PP_NOT_NULL(pp);
+       pp = PKT(ni, pp)->netif.tx.dmaq_next )
+    PKT(ni, pp)->tstamp_frc -= by;
+}
+
+static ci_iptime_t txtime_test_tick(ci_uint64 launch)
+{
+  return (launch + (1ull << (TXTIME_TEST_FRC2TICK - 1))) >>
+         TXTIME_TEST_FRC2TICK;
+}
+
+
+/* Datagrams are held in launch time order, those with equal launch times
+ * in the order they were sent, and the timer follows the head. */
+static void test_ci_udp_txtime_hold_sorted(void)
+{
+  static const int order[] = { 1, 3, 5, 0, 2, 4 };
+  static const int k[] = { 5, 3, 7, 4, 9, 4 };
+  ci_udp_state* us;
+  ci_netif* ni = txtime_test_init(&us);
+  ci_uint64 now, launch[6];
+  int i;
+
+  ci_frc64(&now);
+  for( i = 0; i < 6; ++i ) {
+    launch[i] = now + k[i] * TXTIME_TEST_STEP;
+    CHECK_TRUE(txtime_test_send(ni, us, i, launch[i],
+                                i == 3 ? MSG_CONFIRM : 0));
+    CHECK(PKT(ni, i)->refcount, ==, 1);
+  }
+  CHECK_TRUE(txtime_test_queue_is(ni, us, order, 6));
+  /* Held datagrams count against SO_SNDBUF */
+  CHECK(us->tx_count, ==, 6 * TXTIME_TEST_LEN(0) + 15);
+  CHECK_TRUE(ci_ip_timer_pending(ni, &us->txtime_tid));
+  CHECK(us->txtime_tid.time, ==, txtime_test_tick(launch[1]));
+  CHECK(n_sent, ==, 0);
+  CHECK(n_dropped, ==, 0);
+
+  /* Nothing is due yet */
+  ci_udp_timeout_txtime(ni, us);
+  CHECK(n_sent, ==, 0);
+  CHECK_TRUE(txtime_test_queue_is(ni, us, order, 6));
+
+  /* Time passes: launch times of 3 and 4 steps are now in the past, and
+   * the timer sends those datagrams in order */
+  txtime_test_advance(ni, us, 4 * TXTIME_TEST_STEP + TXTIME_TEST_STEP / 2);
+  ci_udp_timeout_txtime(ni, us);
+  CHECK(n_sent, ==, 3);
+  CHECK(sent[0], ==, 1);
+  CHECK(sent[1], ==, 3);
+  CHECK(sent_flags[1], ==, MSG_CONFIRM);
+  CHECK(sent[2], ==, 5);
+  CHECK(sent_flags[2], ==, 0);
+  CHECK(n_freed, ==, 3);
+  CHECK(us->stats.n_tx_txtime_late, ==, 3);
+  CHECK_TRUE(txtime_test_queue_is(ni, us, order + 3, 3));
+  /* Sending releases the charge; the send path charges again */
+  CHECK(us->tx_count, ==, 3 * TXTIME_TEST_LEN(0) + 6);
+  CHECK_TRUE(ci_ip_timer_pending(ni, &us->txtime_tid));
+  CHECK(us->txtime_tid.time, ==, txtime_test_tick(PKT(ni, 0)->tstamp_frc));
+
+  /* A datagram that is due now sends those held ones that are due first */
+  txtime_test_advance(ni, us, TXTIME_TEST_STEP);
+  ci_frc64(&now);
+  CHECK_FALSE(txtime_test_send(ni, us, 6, now, 0));
+  CHECK(PKT(ni, 6)->tstamp_frc, ==, 0);
+  CHECK(n_sent, ==, 4);
+  CHECK(sent[3], ==, 0);
+  CHECK_TRUE(txtime_test_queue_is(ni, us, order + 4, 2));
+  CHECK(us->tx_count, ==, TXTIME_TEST_LEN(2) + TXTIME_TEST_LEN(4));
+  CHECK(n_woken, ==, 0);
+
+  txtime_test_fini(ni);
+}
+
+/* In launch mode a datagram is dropped once it is too late to send,
+ * whether it was late when sent or became late while held. */
+static void test_ci_udp_txtime_launch_late(void)
+{
+  static const int held[] = { 2 };
+  ci_udp_state* us;
+  ci_netif* ni = txtime_test_init(&us);
+  ci_uint64 now;
+
+  ci_frc64(&now);
+  CHECK_FALSE(txtime_test_send(ni, us, 0, now - TXTIME_TEST_LATE / 2, 0));
+  CHECK(us->stats.n_tx_txtime_late, ==, 1);
+  CHECK_TRUE(txtime_test_send(ni, us, 1, now - 2 * TXTIME_TEST_LATE, 0));
+  CHECK(n_dropped, ==, 1);
+  CHECK(dropped[0], ==, 1);
+  CHECK(us->stats.n_tx_txtime_drop, ==, 1);
+  CHECK(n_freed, ==, 2);
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_head));
+  CHECK_FALSE(ci_ip_timer_pending(ni, &us->txtime_tid));
+
+  CHECK(us->tx_count, ==, 0);
+
+  CHECK_TRUE(txtime_test_send(ni, us, 2, now + TXTIME_TEST_STEP, 0));
+  CHECK_TRUE(txtime_test_queue_is(ni, us, held, 1));
+  CHECK(us->tx_count, ==, TXTIME_TEST_LEN(2));
+  txtime_test_advance(ni, us, TXTIME_TEST_STEP + 2 * TXTIME_TEST_LATE);
+  ci_udp_timeout_txtime(ni, us);
+  CHECK(n_sent, ==, 0);
+  CHECK(n_dropped, ==, 2);
+  CHECK(dropped[1], ==, 2);
+  CHECK(us->stats.n_tx_txtime_drop, ==, 2);
+  CHECK(n_freed, ==, 3);
+  /* The space the dropped datagram held is free again */
+  CHECK(us->tx_count, ==, 0);
+  CHECK(n_woken, ==, 1);
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_head));
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_tail));
+  CHECK_FALSE(ci_ip_timer_pending(ni, &us->txtime_tid));
+
+  txtime_test_fini(ni);
+}
+
+/* In deadline mode nothing is held: a datagram goes at once unless its
+ * deadline has passed, however recently. */
+static void test_ci_udp_txtime_deadline(void)
+{
+  ci_udp_state* us;
+  ci_netif* ni = txtime_test_init(&us);
+  ci_uint64 now;
+
+  us->txtime_flags = CI_UDP_TXTIME_DEADLINE_MODE;
+  ci_frc64(&now);
+  CHECK_FALSE(txtime_test_send(ni, us, 0, now + 5 * TXTIME_TEST_STEP, 0));
+  CHECK(PKT(ni, 0)->tstamp_frc, ==, 0);
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_head));
+  CHECK_FALSE(ci_ip_timer_pending(ni, &us->txtime_tid));
+
+  CHECK_TRUE(txtime_test_send(ni, us, 1, now - TXTIME_TEST_LATE / 2, 0));
+  CHECK(n_dropped, ==, 1);
+  CHECK(dropped[0], ==, 1);
+  CHECK(us->stats.n_tx_txtime_drop, ==, 1);
+  CHECK(us->stats.n_tx_txtime_early, ==, 0);
+  CHECK(us->stats.n_tx_txtime_late, ==, 0);
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_head));
+
+  txtime_test_fini(ni);
+}
+
+/* On close every held datagram is dropped rather than sent early. */
+static void test_ci_udp_txtime_flush(void)
+{
+  ci_udp_state* us;
+  ci_netif* ni = txtime_test_init(&us);
+  ci_uint64 now;
+
+  ci_frc64(&now);
+  CHECK_TRUE(txtime_test_send(ni, us, 0, now + 3 * TXTIME_TEST_STEP, 0));
+  CHECK_TRUE(txtime_test_send(ni, us, 1, now + 2 * TXTIME_TEST_STEP, 0));
+  CHECK_TRUE(txtime_test_send(ni, us, 2, now + 4 * TXTIME_TEST_STEP, 0));
+  CHECK_TRUE(ci_ip_timer_pending(ni, &us->txtime_tid));
+  CHECK(us->tx_count, ==, 3 * TXTIME_TEST_LEN(0) + 3);
+
+  us->s.b.sb_aflags |= CI_SB_AFLAG_ORPHAN;
+  ci_udp_txtime_flush(ni, us);
+  CHECK(n_sent, ==, 0);
+  CHECK(n_dropped, ==, 3);
+  CHECK(dropped[0], ==, 1);
+  CHECK(dropped[1], ==, 0);
+  CHECK(dropped[2], ==, 2);
+  CHECK(n_freed, ==, 3);
+  CHECK(us->stats.n_tx_txtime_drop, ==, 3);
+  CHECK(us->stats.n_tx_txtime_early, ==, 0);
+  CHECK(us->tx_count, ==, 0);
+  /* Nobody is left to wake */
+  CHECK(n_woken, ==, 0);
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_head));
+  CHECK_TRUE(OO_PP_IS_NULL(us->txtime_tail));
+  CHECK_FALSE(ci_ip_timer_pending(ni, &us->txtime_tid));
+
+  /* Nothing held: nothing to do */
+  ci_udp_txtime_flush(ni, us);
+  CHECK(n_dropped, ==, 3);
+
+  txtime_test_fini(ni);
+}
+
+int main(void)
+{
+  TEST_RUN(test_ci_udp_txtime_hold_sorted);
+  TEST_RUN(test_ci_udp_txtime_launch_late);
+  TEST_RUN(test_ci_udp_txtime_deadline);
+  TEST_RUN(test_ci_udp_txtime_flush);
+  TEST_END();
+}
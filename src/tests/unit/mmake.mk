@@ -13,8 +13,12 @@ UNIT_TEST_WRAPPER ?=
 # In principle, this could be autogenerated by searching the source directory.
 ALL_UNIT_TESTS := \
   header/ci/internal/ip_timestamp \
+  lib/transport/ip/ip_reasm \
   lib/transport/ip/netif_init \
   lib/transport/ip/tcp_rx \
+  lib/transport/ip/tcp_send \
+  lib/transport/ip/udp_rx \
+  lib/transport/ip/udp_txtime \
 
 # The tests to be run, and their corresponding files
 TESTS := $(filter $(UNIT_TEST_FILTER)%, $(ALL_UNIT_TESTS))
@@ -62,6 +66,8 @@ NO_PIE = $(shell echo 'int main(void){return 0;}' | \
 # invididual test without waiting for several seconds of flappery first.
 $(TARGETS): MMAKE_DIR_LINKFLAGS += -Wl,--unresolved-symbols=ignore-all $(NO_PIE)
 $(filter lib/%, $(TARGETS)): $$(call lib_object,$$@)
+# ci_tcp_tx_change_mss() is tested along with the EF_TCP_GSO send queue
+lib/transport/ip/tcp_send: $(call lib_object,lib/transport/ip/tcp_tx)
 $(TARGETS): %: %.o stubs.o
 	$(MMakeLinkCApp)
 
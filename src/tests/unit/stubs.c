@@ -4,12 +4,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <ci/internal/ip.h>
 
 /* Resolve references to global variables */
 __attribute__ ((weak)) unsigned ci_tp_log = 0;
 __attribute__ ((weak)) unsigned ci_tp_max_dump = 0;
 __attribute__ ((weak)) void (*ci_log_fn)(const char* msg) = NULL;
 __attribute__ ((weak)) int  (*ci_sys_ioctl)(int, long unsigned int, ...) = NULL;
+__attribute__ ((weak))
+const ci_tcp_cong_ops* const ci_tcp_cong_ops_tbl[CI_TCP_CONG_NUM] = {NULL};
 
 /* Allow the unit under test to call ci_log (with no effect) */
 __attribute__ ((weak)) void ci_log(const char* fmt, ...) {}
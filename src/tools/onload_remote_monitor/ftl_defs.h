@@ -546,6 +546,8 @@ typedef struct oo_p_dllink oo_p_dllink_t;
                                                              ORM_OUTPUT_STACK)            \
   FTL_TFIELD_ARRAYOFINT(ctx, ci_uint32, max_aux_bufs, CI_TCP_AUX_TYPE_NUM,\
                                                              ORM_OUTPUT_STACK)            \
+  FTL_TFIELD_INT(ctx, ci_uint32, mcast_index_missing, ORM_OUTPUT_STACK)   \
+  FTL_TFIELD_INT(ctx, ci_uint32, reasm_n_pkts, ORM_OUTPUT_STACK)          \
   ON_CI_CFG_FD_CACHING(                                                 \
     FTL_TFIELD_INT(ctx, ci_uint32, passive_cache_avail_stack, ORM_OUTPUT_STACK)  \
   )                                                                     \
@@ -866,6 +868,15 @@ typedef struct oo_sock_cplane oo_sock_cplane_t;
   FTL_TFIELD_INT(ctx, ci_uint32, n_tx_msg_confirm, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
   FTL_TFIELD_INT(ctx, ci_uint32, n_tx_os_late, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))     \
   FTL_TFIELD_INT(ctx, ci_uint32, n_tx_unconnect_late, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_tx_txtime_early, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_tx_txtime_late, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_tx_txtime_drop, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_tx_cp_dest_hit, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_rx_arb_dup, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_rx_arb_late, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_rx_arb_gap, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_rx_arb_old, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
+  FTL_TFIELD_INT(ctx, ci_uint32, n_rx_arb_reset, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
   FTL_TSTRUCT_END(ctx)
 
 typedef struct oo_tcp_socket_stats oo_tcp_socket_stats;
@@ -881,6 +892,9 @@ typedef struct oo_tcp_socket_stats oo_tcp_socket_stats;
   ON_CI_CFG_BURST_CONTROL(                                              \
      FTL_TFIELD_INT(ctx, ci_uint32, tx_stop_burst, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
                                                                         ) \
+  FTL_TFIELD_INT(ctx, ci_uint32, tx_stop_pace, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))     \
+  FTL_TFIELD_INT(ctx, ci_uint32, rack_lost, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))        \
+  FTL_TFIELD_INT(ctx, ci_uint32, tlp_probes, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))       \
   FTL_TFIELD_INT(ctx, ci_uint32, tx_nomac_defer, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))   \
   FTL_TFIELD_INT(ctx, ci_uint32, tx_defer, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))         \
   FTL_TFIELD_INT(ctx, ci_uint32, tx_msg_warm_abort, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
@@ -1002,6 +1016,8 @@ typedef struct oo_tcp_socket_stats oo_tcp_socket_stats;
     FTL_TFIELD_INT(ctx, ci_iptime_t, t_ka_intvl_in_secs, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS)) \
     FTL_TFIELD_INT(ctx, ci_uint16, user_mss, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))               \
     FTL_TFIELD_INT(ctx, ci_uint8, tcp_defer_accept, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))	      \
+    FTL_TFIELD_INT(ctx, ci_uint8, cc_alg, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                  \
+    FTL_TFIELD_INT(ctx, ci_uint64, max_pacing_rate, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))        \
     FTL_TSTRUCT_END(ctx)
 
 #define STRUCT_TCP(ctx) \
@@ -1067,6 +1083,8 @@ typedef struct oo_tcp_socket_stats oo_tcp_socket_stats;
     FTL_TFIELD_INT(ctx, ci_uint32, ssthresh, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                    \
     FTL_TFIELD_INT(ctx, ci_uint32, bytes_acked, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                 \
     FTL_TFIELD_INT(ctx, ci_uint8, dup_acks, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                    \
+    FTL_TFIELD_INT(ctx, ci_uint32, pace_rate, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                   \
+    FTL_TFIELD_INT(ctx, ci_uint32, pace_next, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))                   \
     ON_CI_CFG_TCP_FASTSTART(                                                  \
       FTL_TFIELD_INT(ctx, ci_uint32, faststart_acks, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))            \
     )                                                                         \
@@ -1106,6 +1124,8 @@ typedef struct oo_tcp_socket_stats oo_tcp_socket_stats;
       FTL_TFIELD_STRUCT(ctx, ci_ip_timer, stats_tid, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))            \
     )                                                                         \
     FTL_TFIELD_STRUCT(ctx, ci_ip_timer, cork_tid, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))               \
+    FTL_TFIELD_STRUCT(ctx, ci_ip_timer, pace_tid, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))               \
+    FTL_TFIELD_STRUCT(ctx, ci_ip_timer, rack_tid, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))               \
     ON_CI_CFG_TCP_SOCK_STATS(                                                 \
       FTL_TFIELD_STRUCT(ctx, ci_ip_sock_stats, stats_snapshot, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))  \
       FTL_TFIELD_STRUCT(ctx, ci_ip_sock_stats, stats_cumulative, (ORM_OUTPUT_STACK | ORM_OUTPUT_SOCKETS))\